@@ -0,0 +1,35 @@
+#include "alloc_tracker.hpp"
+#include <cstdlib>
+#include <new>
+
+// Counting replacement for the global allocator, linked into the benchmark binaries so they can
+// report allocations per operation and, with G923_ALLOC_CHECKS, enforce NoAllocScope.
+
+void* operator new(std::size_t size) {
+    alloc_tracker::note_allocation();
+    void* memory = std::malloc(size ? size : 1);
+    if (!memory) {
+        std::abort();
+    }
+    return memory;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
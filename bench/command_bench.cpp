@@ -0,0 +1,99 @@
+#include "command_encoder.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace {
+
+std::atomic<std::uint64_t> g_allocations{0};
+
+using bench_clock = std::chrono::steady_clock;
+
+constexpr int kIterations = 2000000;
+
+// The encoder as it was before: parameters went through a temporary std::vector
+Command legacy_force_effect(std::uint8_t effect_type, const std::vector<std::uint8_t>& params) {
+    Command command;
+    command[0] = g923_commands::SET_FORCE_EFFECT;
+    command[1] = effect_type;
+
+    std::size_t param_index = 2;
+    for (std::size_t i = 0; i < params.size() && param_index < COMMAND_MAX_LENGTH; ++i) {
+        command[param_index++] = params[i];
+    }
+
+    return command;
+}
+
+Command legacy_custom_spring(std::uint8_t d1, std::uint8_t d2, std::uint8_t k1, std::uint8_t k2, std::uint8_t s1,
+                             std::uint8_t s2, std::uint8_t clip) {
+    return legacy_force_effect(g923_commands::EFFECT_SPRING,
+                               {d1, d2, static_cast<std::uint8_t>((k2 << 4) | k1),
+                                static_cast<std::uint8_t>((s2 << 4) | s1), clip});
+}
+
+Command legacy_constant_force(std::uint8_t level) {
+    return legacy_force_effect(g923_commands::EFFECT_CONSTANT, {level, level, level, level, 0x00});
+}
+
+template <typename Encode>
+void run(const char* name, Encode encode) {
+    std::uint32_t checksum = 0;
+    const std::uint64_t allocations_before = g_allocations.load(std::memory_order_relaxed);
+    const bench_clock::time_point start = bench_clock::now();
+
+    for (int i = 0; i < kIterations; ++i) {
+        const Command command = encode(static_cast<std::uint8_t>(i));
+        for (std::size_t byte = 0; byte < command.size(); ++byte) {
+            checksum = checksum * 31 + command[byte];
+        }
+    }
+
+    const bench_clock::time_point end = bench_clock::now();
+    const std::uint64_t allocations = g_allocations.load(std::memory_order_relaxed) - allocations_before;
+    const double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count() / kIterations;
+
+    std::printf("%-28s %7.2f ns/op %7.2f allocs/op   (checksum %08x)\n", name, nanoseconds,
+                static_cast<double>(allocations) / kIterations, checksum);
+}
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* memory = std::malloc(size ? size : 1);
+    if (!memory) {
+        std::abort();
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+int main() {
+    std::printf("%d commands per encoder\n\n", kIterations);
+
+    run("spring (constexpr)", [](std::uint8_t i) {
+        return CommandBuilder::create_custom_spring(i, i, i & 0x0F, 0x03, 0x0F, i & 0x0F, 0x7F);
+    });
+    run("spring (legacy vector)", [](std::uint8_t i) {
+        return legacy_custom_spring(i, i, i & 0x0F, 0x03, 0x0F, i & 0x0F, 0x7F);
+    });
+    run("constant (constexpr)", [](std::uint8_t i) { return CommandBuilder::create_constant_force(i); });
+    run("constant (legacy vector)", [](std::uint8_t i) { return legacy_constant_force(i); });
+    run("damper (constexpr)", [](std::uint8_t i) { return CommandBuilder::create_damper(i, i, 0x40, 0x40); });
+    run("led pattern (constexpr)", [](std::uint8_t i) { return CommandBuilder::create_led_pattern(i & 0x1F); });
+
+    return 0;
+}
@@ -0,0 +1,425 @@
+#include "bridge_server.hpp"
+#include "fake_hid_backend.hpp"
+#include "ffb_bridge_protocol.hpp"
+#include "latency_histogram.hpp"
+#include "logger.hpp"
+#include "trace_zones.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <netinet/in.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// End-to-end latency harness. A real BridgeServer runs on a loopback port against a fake G923
+// whose writes are timestamped; a client with BridgeClient's framing streams wheel states at a
+// fixed rate. Each state carries a sequence number in the spring deadband bytes, which the
+// classic spring command copies verbatim, so every report reaching the fake can be matched to
+// the state that caused it.
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+constexpr std::size_t kSequenceSpace = 1 << 16;
+constexpr double kTwoPi = 6.28318530717958647692;
+
+enum class EffectMix {
+    spring,
+    constant,
+    full,
+};
+
+const char* mix_name(EffectMix mix) {
+    switch (mix) {
+        case EffectMix::spring:
+            return "spring";
+        case EffectMix::constant:
+            return "constant";
+        case EffectMix::full:
+            return "full";
+    }
+    return "?";
+}
+
+bool parse_mix(const char* name, EffectMix& mix) {
+    for (EffectMix candidate : {EffectMix::spring, EffectMix::constant, EffectMix::full}) {
+        if (std::strcmp(name, mix_name(candidate)) == 0) {
+            mix = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct Options {
+    std::uint16_t port = g923bridge::kDefaultPort + 100;
+    std::vector<int> rates_hz;
+    std::vector<EffectMix> mixes;
+    double duration_s = 3.0;
+    int service_us = 1000;
+    const char* zones_path = nullptr;
+};
+
+// Send and receive times per sequence number, shared with the fake wheel's write observer
+class SequenceTracker {
+public:
+    void reset() {
+        for (std::size_t i = 0; i < kSequenceSpace; ++i) {
+            sent_ns_[i].store(0, std::memory_order_relaxed);
+            delivered_[i].store(false, std::memory_order_relaxed);
+        }
+        latency_.reset();
+        last_delivered_.store(0, std::memory_order_relaxed);
+    }
+
+    void mark_sent(std::uint16_t sequence, std::uint64_t now_ns) {
+        sent_ns_[sequence].store(now_ns, std::memory_order_release);
+    }
+
+    void mark_delivered(std::uint16_t sequence, std::uint64_t now_ns) {
+        const std::uint64_t sent_ns = sent_ns_[sequence].load(std::memory_order_acquire);
+        if (sent_ns == 0) {
+            return;
+        }
+        if (delivered_[sequence].exchange(true, std::memory_order_relaxed)) {
+            return;
+        }
+        latency_.record(now_ns > sent_ns ? now_ns - sent_ns : 0);
+        last_delivered_.store(sequence, std::memory_order_relaxed);
+    }
+
+    bool delivered(std::uint16_t sequence) const { return delivered_[sequence].load(std::memory_order_relaxed); }
+    std::uint16_t last_delivered() const { return last_delivered_.load(std::memory_order_relaxed); }
+    LatencyHistogram::Snapshot latency() const { return latency_.snapshot(); }
+
+private:
+    std::atomic<std::uint64_t> sent_ns_[kSequenceSpace];
+    std::atomic<bool> delivered_[kSequenceSpace];
+    std::atomic<std::uint16_t> last_delivered_{0};
+    LatencyHistogram latency_;
+};
+
+std::uint64_t now_ns() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now().time_since_epoch()).count());
+}
+
+double cpu_seconds() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+}
+
+bool send_exact(int fd, const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    std::size_t sent = 0;
+    while (sent < size) {
+        const ssize_t chunk = send(fd, bytes + sent, size - sent, MSG_NOSIGNAL);
+        if (chunk < 0 && errno == EINTR) {
+            continue;
+        }
+        if (chunk <= 0) {
+            return false;
+        }
+        sent += static_cast<std::size_t>(chunk);
+    }
+    return true;
+}
+
+bool recv_exact(int fd, void* data, std::size_t size) {
+    auto* bytes = static_cast<std::uint8_t*>(data);
+    std::size_t received = 0;
+    while (received < size) {
+        const ssize_t chunk = recv(fd, bytes + received, size - received, 0);
+        if (chunk < 0 && errno == EINTR) {
+            continue;
+        }
+        if (chunk <= 0) {
+            return false;
+        }
+        received += static_cast<std::size_t>(chunk);
+    }
+    return true;
+}
+
+// Portable stand-in for the proxy's BridgeClient: header and payload go out as two sends
+class LoopbackClient {
+public:
+    ~LoopbackClient() { disconnect(); }
+
+    bool connect_to(std::uint16_t port) {
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            fd_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (fd_ >= 0 && connect(fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0) {
+                return hello();
+            }
+            disconnect();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        return false;
+    }
+
+    bool send_state(const g923bridge::WheelStatePayload& state) {
+        return send_message(g923bridge::MessageType::apply_wheel_state, &state, sizeof(state));
+    }
+
+    bool send_stop_all() { return send_message(g923bridge::MessageType::stop_all, nullptr, 0); }
+
+    void disconnect() {
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+private:
+    int fd_ = -1;
+
+    bool send_message(g923bridge::MessageType type, const void* payload, std::uint32_t payload_size) {
+        g923bridge::MessageHeader header{};
+        header.type = static_cast<std::uint16_t>(type);
+        header.payload_size = payload_size;
+        if (!send_exact(fd_, &header, sizeof(header))) {
+            return false;
+        }
+        return payload_size == 0 || send_exact(fd_, payload, payload_size);
+    }
+
+    bool hello() {
+        g923bridge::HelloPayload payload{};
+        std::snprintf(payload.client_name, sizeof(payload.client_name), "g923_e2e_latency");
+        payload.process_id = static_cast<std::uint32_t>(getpid());
+        if (!send_message(g923bridge::MessageType::hello, &payload, sizeof(payload))) {
+            return false;
+        }
+
+        g923bridge::MessageHeader header{};
+        g923bridge::HelloAckPayload ack{};
+        return recv_exact(fd_, &header, sizeof(header)) && header.magic == g923bridge::kProtocolMagic &&
+               header.type == static_cast<std::uint16_t>(g923bridge::MessageType::hello_ack) &&
+               header.payload_size == sizeof(ack) && recv_exact(fd_, &ack, sizeof(ack)) && ack.accepted;
+    }
+};
+
+g923bridge::WheelStatePayload make_state(EffectMix mix, std::uint16_t sequence, std::uint64_t update) {
+    g923bridge::WheelStatePayload state;
+    state.custom_spring_enabled = 1;
+    state.spring_deadband_left = static_cast<std::uint8_t>(sequence & 0xFF);
+    state.spring_deadband_right = static_cast<std::uint8_t>(sequence >> 8);
+    state.spring_k1 = 8;
+    state.spring_k2 = 8;
+    state.spring_sat1 = 15;
+    state.spring_sat2 = 15;
+    state.spring_clip = 200;
+
+    if (mix == EffectMix::constant || mix == EffectMix::full) {
+        // A slow sine keeps the slew limiter engaged part of the time, like a real game
+        state.constant_force_enabled = 1;
+        state.constant_force_magnitude =
+            static_cast<std::int16_t>(6000.0 * std::sin(kTwoPi * static_cast<double>(update) / 400.0));
+    }
+
+    if (mix == EffectMix::full) {
+        state.damper_enabled = 1;
+        state.damper_force_positive = static_cast<std::uint8_t>(64 + update % 64);
+        state.damper_force_negative = state.damper_force_positive;
+        state.damper_saturation_positive = 255;
+        state.damper_saturation_negative = 255;
+        state.led_pattern_enabled = 1;
+        state.led_pattern = static_cast<std::uint8_t>((update / 8) & 0x1F);
+    }
+
+    return state;
+}
+
+struct RunResult {
+    std::uint64_t sent = 0;
+    std::uint64_t delivered = 0;
+    std::uint64_t coalesced = 0;
+    std::uint64_t lost = 0;
+    std::uint64_t server_coalesced = 0;
+    double cpu_us_per_update = 0.0;
+    LatencyHistogram::Snapshot latency;
+};
+
+bool run_once(BridgeServer& server, SequenceTracker& tracker, const Options& options, EffectMix mix, int rate_hz,
+              std::uint16_t& next_sequence, RunResult& result) {
+    LoopbackClient client;
+    if (!client.connect_to(options.port)) {
+        std::fprintf(stderr, "g923_e2e_latency: cannot connect to the bridge on port %hu\n", options.port);
+        return false;
+    }
+
+    tracker.reset();
+    const std::uint64_t server_coalesced_before = server.status().output_total.coalesced;
+    const auto period = std::chrono::nanoseconds(1000000000LL / rate_hz);
+    const auto updates = static_cast<std::uint64_t>(options.duration_s * rate_hz);
+    const std::uint16_t first_sequence = next_sequence;
+
+    const double cpu_before = cpu_seconds();
+    bench_clock::time_point next_send = bench_clock::now();
+    for (std::uint64_t update = 0; update < updates; ++update) {
+        std::this_thread::sleep_until(next_send);
+        next_send += period;
+
+        // Sequence 0 is reserved so an idle deadband never matches a sent state
+        const std::uint16_t sequence = next_sequence == 0 ? ++next_sequence : next_sequence;
+        ++next_sequence;
+        tracker.mark_sent(sequence, now_ns());
+        if (!client.send_state(make_state(mix, sequence, update))) {
+            std::fprintf(stderr, "g923_e2e_latency: bridge closed the connection\n");
+            return false;
+        }
+        ++result.sent;
+    }
+
+    // Let the output queues drain before counting what arrived
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    const double cpu_after = cpu_seconds();
+
+    std::uint16_t sequence = first_sequence;
+    const std::uint16_t last_delivered = tracker.last_delivered();
+    bool after_last_delivered = false;
+    for (std::uint64_t i = 0; i < result.sent; ++i, ++sequence) {
+        if (sequence == 0) {
+            ++sequence;
+        }
+        if (tracker.delivered(sequence)) {
+            ++result.delivered;
+        } else if (after_last_delivered) {
+            ++result.lost;
+        } else {
+            ++result.coalesced;
+        }
+        after_last_delivered = after_last_delivered || sequence == last_delivered;
+    }
+
+    client.send_stop_all();
+    client.disconnect();
+
+    result.server_coalesced = server.status().output_total.coalesced - server_coalesced_before;
+    result.cpu_us_per_update =
+        (cpu_after - cpu_before) * 1e6 / static_cast<double>(std::max<std::uint64_t>(result.sent, 1));
+    result.latency = tracker.latency();
+    return true;
+}
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--port") == 0 && has_value) {
+            options.port = static_cast<std::uint16_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--rate") == 0 && has_value) {
+            options.rates_hz.push_back(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--mix") == 0 && has_value) {
+            EffectMix mix;
+            if (!parse_mix(argv[++i], mix)) {
+                return false;
+            }
+            options.mixes.push_back(mix);
+        } else if (std::strcmp(argv[i], "--duration") == 0 && has_value) {
+            options.duration_s = std::max(0.1, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--service-us") == 0 && has_value) {
+            options.service_us = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--zones") == 0 && has_value) {
+            options.zones_path = argv[++i];
+        } else {
+            return false;
+        }
+    }
+
+    if (options.rates_hz.empty()) {
+        options.rates_hz = {125, 500, 1000};
+    }
+    if (options.mixes.empty()) {
+        options.mixes = {EffectMix::spring, EffectMix::constant, EffectMix::full};
+    }
+    return options.port != 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: %s [--rate HZ]... [--mix spring|constant|full]... [--duration S]\n"
+                     "       [--service-us US] [--port N] [--zones FILE]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    Logger::set_enabled(false);
+
+    auto tracker = std::make_unique<SequenceTracker>();
+    tracker->reset();
+    auto hid_backend = std::make_unique<FakeHidBackend>();
+    auto wheel = hid_backend->add_g923();
+    wheel->set_service_time(std::chrono::microseconds(options.service_us));
+    wheel->set_write_observer([&tracker](const std::uint8_t* data, std::size_t length, bool numbered) {
+        if (!numbered && length >= 4 && data[0] == g923_commands::SET_FORCE_EFFECT &&
+            data[1] == g923_commands::EFFECT_SPRING) {
+            tracker->mark_delivered(static_cast<std::uint16_t>(data[2] | (data[3] << 8)), now_ns());
+        }
+    });
+
+    BridgeServer server(options.port, WheelBackend::classic, 0, std::move(hid_backend));
+    if (!server.reconnect_wheel() || !server.start()) {
+        std::fprintf(stderr, "g923_e2e_latency: failed to start the bridge with a fake wheel\n");
+        return 1;
+    }
+
+    std::printf("fake wheel service time %d us, %.1f s per run\n\n", options.service_us, options.duration_s);
+    std::printf("%-9s %6s %7s %9s %9s %6s %8s %8s %8s %8s %9s %10s\n", "mix", "rate", "sent", "delivered",
+                "coalesced", "lost", "p50 us", "p90 us", "p99 us", "max us", "srv coal", "cpu us/upd");
+
+    std::uint16_t next_sequence = 1;
+    bool ok = true;
+    for (EffectMix mix : options.mixes) {
+        for (int rate_hz : options.rates_hz) {
+            RunResult result;
+            if (!run_once(server, *tracker, options, mix, rate_hz, next_sequence, result)) {
+                ok = false;
+                break;
+            }
+            const auto us = [&result](double percentile) {
+                return static_cast<double>(result.latency.percentile_ns(percentile)) / 1000.0;
+            };
+            std::printf("%-9s %6d %7llu %9llu %9llu %6llu %8.1f %8.1f %8.1f %8.1f %9llu %10.1f\n", mix_name(mix),
+                        rate_hz, static_cast<unsigned long long>(result.sent),
+                        static_cast<unsigned long long>(result.delivered),
+                        static_cast<unsigned long long>(result.coalesced), static_cast<unsigned long long>(result.lost),
+                        us(50.0), us(90.0), us(99.0), static_cast<double>(result.latency.max_ns) / 1000.0,
+                        static_cast<unsigned long long>(result.server_coalesced), result.cpu_us_per_update);
+            std::fflush(stdout);
+        }
+        if (!ok) {
+            break;
+        }
+    }
+
+    server.stop();
+    if (options.zones_path && !trace_zones::write_chrome_trace(options.zones_path)) {
+        std::fprintf(stderr, "g923_e2e_latency: failed to write trace zones to %s\n", options.zones_path);
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
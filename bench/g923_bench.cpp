@@ -0,0 +1,720 @@
+#include "alloc_tracker.hpp"
+#include "bridge_server.hpp"
+#include "command_encoder.hpp"
+#include "effect_engine.hpp"
+#include "fake_hid_backend.hpp"
+#include "ffb_bridge_protocol.hpp"
+#include "force_curve.hpp"
+#include "line_ring.hpp"
+#include "logger.hpp"
+#include "slot_map.hpp"
+#include "state_mailbox.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Force pipeline micro-benchmarks. Every case runs in batches; the table reports the mean
+// and the p50/p99 of per-batch ns/op, plus heap allocations per operation.
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+std::uint64_t g_sink = 0;
+
+template <typename Operation>
+void run(const char* name, std::size_t batches, std::size_t batch_size, Operation operation) {
+    std::vector<double> samples;
+    samples.reserve(batches);
+
+    // Warm caches and lazily initialised state before measuring
+    for (std::size_t i = 0; i < batch_size; ++i) {
+        operation(i);
+    }
+
+    const std::uint64_t allocations_before = alloc_tracker::total_allocations();
+    double total_ns = 0.0;
+    std::size_t index = 0;
+    for (std::size_t batch = 0; batch < batches; ++batch) {
+        const bench_clock::time_point start = bench_clock::now();
+        for (std::size_t i = 0; i < batch_size; ++i) {
+            operation(index++);
+        }
+        const double batch_ns = std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+        total_ns += batch_ns;
+        samples.push_back(batch_ns / static_cast<double>(batch_size));
+    }
+    const std::uint64_t allocations = alloc_tracker::total_allocations() - allocations_before;
+
+    std::sort(samples.begin(), samples.end());
+    const auto percentile = [&samples](double fraction) {
+        return samples[std::min(samples.size() - 1, static_cast<std::size_t>(fraction * samples.size()))];
+    };
+
+    std::printf("%-34s %10.1f %10.1f %10.1f %10.3f\n", name, total_ns / static_cast<double>(index),
+                percentile(0.50), percentile(0.99), static_cast<double>(allocations) / static_cast<double>(index));
+}
+
+void print_header(const char* section) {
+    std::printf("\n%-34s %10s %10s %10s %10s\n", section, "ns/op", "p50", "p99", "allocs/op");
+}
+
+// --- Constant force curve ---------------------------------------------------------------
+
+void bench_force_curve() {
+    print_header("force curve");
+
+    run("map_constant_magnitude_to_level", 2000, 1024, [](std::size_t i) {
+        const auto magnitude = static_cast<std::int16_t>(static_cast<int>(i * 37 % 20001) - 10000);
+        g_sink += static_cast<std::uint64_t>(g923bridge::map_constant_magnitude_to_level(magnitude));
+    });
+
+    int last_level = 0;
+    run("apply_constant_slew_limiter", 2000, 1024, [&last_level](std::size_t i) {
+        const int target = static_cast<int>((i * 7919) % 255) - 127;
+        last_level = g923bridge::apply_constant_slew_limiter(target, i != 0, last_level);
+        g_sink += static_cast<std::uint64_t>(last_level);
+    });
+}
+
+// --- Command encoding -------------------------------------------------------------------
+
+void bench_command_builder() {
+    print_header("command builder");
+
+    const auto consume = [](const Command& command) {
+        for (std::size_t byte = 0; byte < command.size(); ++byte) {
+            g_sink = g_sink * 31 + command[byte];
+        }
+    };
+
+    run("create_constant_force", 2000, 1024, [&consume](std::size_t i) {
+        consume(CommandBuilder::create_constant_force(static_cast<std::uint8_t>(i)));
+    });
+    run("create_custom_spring", 2000, 1024, [&consume](std::size_t i) {
+        const auto value = static_cast<std::uint8_t>(i);
+        consume(CommandBuilder::create_custom_spring(value, value, value & 0x0F, 0x03, 0x0F, value & 0x0F, 0x7F));
+    });
+    run("create_damper", 2000, 1024, [&consume](std::size_t i) {
+        const auto value = static_cast<std::uint8_t>(i);
+        consume(CommandBuilder::create_damper(value, value, 0x40, 0x40));
+    });
+    run("create_led_pattern", 2000, 1024, [&consume](std::size_t i) {
+        consume(CommandBuilder::create_led_pattern(static_cast<std::uint8_t>(i & 0x1F)));
+    });
+}
+
+// --- Protocol parsing -------------------------------------------------------------------
+
+template <typename Payload>
+void append_message(std::vector<std::uint8_t>& stream, g923bridge::MessageType type, const Payload& payload) {
+    g923bridge::MessageHeader header;
+    header.type = static_cast<std::uint16_t>(type);
+    header.payload_size = sizeof(Payload);
+    const auto* header_bytes = reinterpret_cast<const std::uint8_t*>(&header);
+    const auto* payload_bytes = reinterpret_cast<const std::uint8_t*>(&payload);
+    stream.insert(stream.end(), header_bytes, header_bytes + sizeof(header));
+    stream.insert(stream.end(), payload_bytes, payload_bytes + sizeof(payload));
+}
+
+// Applies the same header checks and payload size validation as BridgeServer's session loop
+std::size_t parse_message(const std::uint8_t* data, std::size_t available, std::uint64_t& checksum) {
+    g923bridge::MessageHeader header;
+    if (available < sizeof(header)) {
+        return 0;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != g923bridge::kProtocolMagic || header.version != g923bridge::kProtocolVersion ||
+        available < sizeof(header) + header.payload_size) {
+        return 0;
+    }
+
+    const std::uint8_t* payload = data + sizeof(header);
+    switch (static_cast<g923bridge::MessageType>(header.type)) {
+        case g923bridge::MessageType::apply_wheel_state: {
+            if (header.payload_size != sizeof(g923bridge::WheelStatePayload)) {
+                return 0;
+            }
+            g923bridge::WheelStatePayload state;
+            std::memcpy(&state, payload, sizeof(state));
+            checksum += static_cast<std::uint64_t>(state.constant_force_magnitude) + state.spring_k1;
+            break;
+        }
+        case g923bridge::MessageType::set_led_pattern: {
+            if (header.payload_size != sizeof(g923bridge::LedPatternPayload)) {
+                return 0;
+            }
+            g923bridge::LedPatternPayload led;
+            std::memcpy(&led, payload, sizeof(led));
+            checksum += led.pattern;
+            break;
+        }
+        default:
+            checksum += header.type;
+            break;
+    }
+
+    return sizeof(header) + header.payload_size;
+}
+
+void bench_protocol_parsing() {
+    print_header("protocol parsing");
+
+    constexpr std::size_t kMessages = 1024;
+    std::vector<std::uint8_t> stream;
+    for (std::size_t i = 0; i < kMessages; ++i) {
+        if (i % 16 == 15) {
+            g923bridge::LedPatternPayload led;
+            led.pattern = static_cast<std::uint8_t>(i & 0x1F);
+            append_message(stream, g923bridge::MessageType::set_led_pattern, led);
+        } else {
+            g923bridge::WheelStatePayload state;
+            state.constant_force_enabled = 1;
+            state.constant_force_magnitude = static_cast<std::int16_t>(i * 13 % 10000);
+            state.custom_spring_enabled = 1;
+            state.spring_k1 = static_cast<std::uint8_t>(i & 0x0F);
+            append_message(stream, g923bridge::MessageType::apply_wheel_state, state);
+        }
+    }
+
+    std::size_t offset = 0;
+    run("parse message", 2000, kMessages, [&stream, &offset](std::size_t) {
+        if (offset >= stream.size()) {
+            offset = 0;
+        }
+        const std::size_t consumed = parse_message(stream.data() + offset, stream.size() - offset, g_sink);
+        offset = consumed == 0 ? stream.size() : offset + consumed;
+    });
+}
+
+// --- DirectInput effect evaluation -----------------------------------------------------
+
+// Effects go through effect_engine::Effect, the same code the Windows proxy runs, so this
+// measures the cost of folding N DirectInput effects into one WheelStatePayload.
+using effect_engine::kNominalMax;
+
+constexpr effect_engine::EffectType kEffectTypes[] = {
+    effect_engine::EffectType::constant_force, effect_engine::EffectType::ramp_force,
+    effect_engine::EffectType::sine,           effect_engine::EffectType::square,
+    effect_engine::EffectType::triangle,       effect_engine::EffectType::sawtooth_up,
+    effect_engine::EffectType::spring,         effect_engine::EffectType::damper,
+};
+constexpr std::size_t kEffectTypeCount = sizeof(kEffectTypes) / sizeof(kEffectTypes[0]);
+
+effect_engine::Effect make_effect(effect_engine::EffectType type, std::size_t i) {
+    effect_engine::Effect effect(type);
+
+    const std::int32_t magnitude = static_cast<std::int32_t>(1000 + (i * 523) % 8000);
+    effect_engine::ConstantForce constant;
+    constant.magnitude = magnitude;
+    effect_engine::RampForce ramp;
+    ramp.start = magnitude;
+    ramp.end = -magnitude;
+    effect_engine::Periodic periodic;
+    periodic.magnitude = static_cast<std::uint32_t>(magnitude);
+    periodic.period = static_cast<std::uint32_t>(20000 + i * 1000);
+    effect_engine::Condition conditions[2];
+    for (effect_engine::Condition& condition : conditions) {
+        condition.positive_coefficient = 6000;
+        condition.negative_coefficient = 5000;
+        condition.positive_saturation = 8000;
+        condition.negative_saturation = 8000;
+        condition.dead_band = 500;
+    }
+    effect_engine::Envelope envelope;
+    envelope.attack_level = 2000;
+    envelope.attack_time = 200000;
+
+    effect_engine::EffectUpdate update;
+    update.flags = effect_engine::kParamAll;
+    update.effect_flags = effect_engine::kDirectionPolar;
+    update.gain = kNominalMax;
+    update.duration = i % 3 == 0 ? effect_engine::kInfinite : 5000000;
+    update.axis_count = 1;
+    update.has_direction = true;
+    update.direction[0] = static_cast<std::int32_t>((i * 4500) % 36000);
+    update.envelope = i % 2 == 0 ? &envelope : nullptr;
+    if (effect_engine::is_condition(type)) {
+        update.type_specific = conditions;
+        update.type_specific_size = sizeof(conditions);
+    } else if (effect_engine::is_periodic(type)) {
+        update.type_specific = &periodic;
+        update.type_specific_size = sizeof(periodic);
+    } else if (type == effect_engine::EffectType::ramp_force) {
+        update.type_specific = &ramp;
+        update.type_specific_size = sizeof(ramp);
+    } else {
+        update.type_specific = &constant;
+        update.type_specific_size = sizeof(constant);
+    }
+
+    effect.set_parameters(update, 0);
+    effect.start(1, 0);
+    return effect;
+}
+
+std::vector<effect_engine::Effect> make_effects(std::size_t count) {
+    std::vector<effect_engine::Effect> effects;
+    effects.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        effects.push_back(make_effect(kEffectTypes[i % kEffectTypeCount], i));
+    }
+    return effects;
+}
+
+void bench_effect_evaluation() {
+    print_header("effect evaluation");
+
+    for (const effect_engine::EffectType type : kEffectTypes) {
+        const effect_engine::Effect effect = make_effect(type, 1);
+        char name[48];
+        std::snprintf(name, sizeof(name), "apply %s", effect_engine::effect_type_name(type));
+        run(name, 2000, 256, [&effect](std::size_t i) {
+            g923bridge::WheelStatePayload payload{};
+            effect.apply(payload, kNominalMax, static_cast<std::uint64_t>(i) * 1000);
+            g_sink += static_cast<std::uint64_t>(payload.constant_force_magnitude) + payload.spring_k1;
+        });
+    }
+
+    for (std::size_t count = 1; count <= 64; count *= 2) {
+        const std::vector<effect_engine::Effect> effects = make_effects(count);
+        char name[48];
+        std::snprintf(name, sizeof(name), "rebuild payload (%zu effects)", count);
+        run(name, 2000, 256, [&effects](std::size_t i) {
+            g923bridge::WheelStatePayload payload{};
+            const std::uint64_t now = static_cast<std::uint64_t>(i) * 1000;
+            for (const effect_engine::Effect& effect : effects) {
+                effect.apply(payload, kNominalMax, now);
+            }
+            g_sink += static_cast<std::uint64_t>(payload.constant_force_magnitude) + payload.spring_k1;
+        });
+    }
+
+    for (std::size_t count = 1; count <= 64; count *= 2) {
+        const std::vector<effect_engine::Effect> effects = make_effects(count);
+        effect_engine::EffectBatch batch;
+        for (const effect_engine::Effect& effect : effects) {
+            batch.add(effect, kNominalMax);
+        }
+        char name[48];
+        std::snprintf(name, sizeof(name), "evaluate batch (%zu effects)", count);
+        run(name, 2000, 256, [&batch](std::size_t i) {
+            g923bridge::WheelStatePayload payload{};
+            batch.evaluate(payload, static_cast<std::uint64_t>(i) * 1000);
+            g_sink += static_cast<std::uint64_t>(payload.constant_force_magnitude) + payload.spring_k1;
+        });
+    }
+
+    {
+        const std::vector<effect_engine::Effect> effects = make_effects(64);
+        effect_engine::EffectBatch batch;
+        run("build batch (64 effects)", 2000, 64, [&effects, &batch](std::size_t) {
+            batch.clear();
+            for (const effect_engine::Effect& effect : effects) {
+                batch.add(effect, kNominalMax);
+            }
+            g_sink += batch.size();
+        });
+    }
+
+    effect_engine::OutputFilter filter;
+    g923bridge::WheelStatePayload state{};
+    state.constant_force_enabled = 1;
+    run("output filter", 2000, 256, [&filter, &state](std::size_t i) {
+        state.constant_force_magnitude = static_cast<std::int16_t>((i >> 2) & 0xFF);
+        g_sink += static_cast<std::uint64_t>(filter.filter(state));
+    });
+}
+
+// --- Effect timing accuracy -------------------------------------------------------------
+
+// The proxy's former time base: GetTickCount64 advances in 15.625 ms steps
+std::uint64_t system_tick_us(std::uint64_t now_us) {
+    return now_us / 15625 * 15625;
+}
+
+struct AccuracyCase {
+    const char* name;
+    effect_engine::EffectType type;
+    std::uint32_t period_us;
+    std::uint32_t attack_us;
+    std::uint32_t fade_us;
+    std::uint32_t duration_us;
+};
+
+// Evaluates each effect every 250 us through the clock under test and reports the largest
+// force error against the ideal curve; the second column reads a system-tick clock instead
+void bench_effect_timing_accuracy() {
+    constexpr std::uint64_t kStepUs = 250;
+    std::printf("\n%-34s %10s %10s\n", "effect timing (250 us steps)", "max err", "tick err");
+
+    const AccuracyCase cases[] = {
+        {"sine 2 ms period", effect_engine::EffectType::sine, 2000, 0, 0, 40000},
+        {"sine 8 ms period", effect_engine::EffectType::sine, 8000, 0, 0, 40000},
+        {"triangle 5 ms period", effect_engine::EffectType::triangle, 5000, 0, 0, 40000},
+        {"constant, 5 ms attack", effect_engine::EffectType::constant_force, 0, 5000, 0, 40000},
+        {"constant, 3 ms fade", effect_engine::EffectType::constant_force, 0, 0, 3000, 20000},
+    };
+
+    for (const AccuracyCase& test : cases) {
+        effect_engine::Periodic periodic;
+        periodic.period = test.period_us;
+        effect_engine::ConstantForce constant;
+        constant.magnitude = kNominalMax;
+        effect_engine::Envelope envelope;
+        envelope.attack_time = test.attack_us;
+        envelope.fade_time = test.fade_us;
+
+        effect_engine::EffectUpdate update;
+        update.flags = effect_engine::kParamAll;
+        update.gain = kNominalMax;
+        update.duration = test.duration_us;
+        update.envelope = test.attack_us || test.fade_us ? &envelope : nullptr;
+        update.type_specific = effect_engine::is_periodic(test.type) ? static_cast<const void*>(&periodic) : &constant;
+        update.type_specific_size = effect_engine::is_periodic(test.type) ? sizeof(periodic) : sizeof(constant);
+
+        effect_engine::Effect effect(test.type);
+        effect.set_parameters(update, 0);
+        effect.start(1, 0);
+
+        // Linear envelope ramps and the analytic waveform at time t
+        const auto ideal = [&test](std::uint64_t t) {
+            double level = 1.0;
+            if (t < test.attack_us) {
+                level = static_cast<double>(t) / test.attack_us;
+            } else if (test.fade_us && t >= test.duration_us - test.fade_us) {
+                level = 1.0 - static_cast<double>(t - (test.duration_us - test.fade_us)) / test.fade_us;
+            }
+            if (!effect_engine::is_periodic(test.type)) {
+                return level * kNominalMax;
+            }
+            const double phase = static_cast<double>(t % test.period_us) / test.period_us;
+            const double wave = test.type == effect_engine::EffectType::sine ? std::sin(phase * 6.28318530717958647692)
+                                                                             : 1.0 - 4.0 * std::fabs(phase - 0.5);
+            return level * kNominalMax * wave;
+        };
+
+        double max_error = 0.0;
+        double max_tick_error = 0.0;
+        for (std::uint64_t t = 0; t < test.duration_us; t += kStepUs) {
+            const double expected = ideal(t);
+            max_error = std::max(max_error, std::fabs(effect.compute_force(t, kNominalMax) - expected));
+            max_tick_error =
+                std::max(max_tick_error, std::fabs(effect.compute_force(system_tick_us(t), kNominalMax) - expected));
+        }
+        std::printf("%-34s %10.1f %10.1f\n", test.name, max_error, max_tick_error);
+    }
+}
+
+// --- Periodic oscillators ---------------------------------------------------------------
+
+effect_engine::Effect make_sine(std::uint32_t period_us) {
+    effect_engine::Periodic periodic;
+    periodic.period = period_us;
+    effect_engine::EffectUpdate update;
+    update.flags = effect_engine::kParamAll;
+    update.gain = kNominalMax;
+    update.duration = effect_engine::kInfinite;
+    update.type_specific = &periodic;
+    update.type_specific_size = sizeof(periodic);
+
+    effect_engine::Effect effect(effect_engine::EffectType::sine);
+    effect.set_parameters(update, 0);
+    effect.start(1, 0);
+    return effect;
+}
+
+void retune_sine(effect_engine::Effect& effect, std::uint32_t period_us, std::uint64_t now_us) {
+    effect_engine::Periodic periodic;
+    periodic.period = period_us;
+    effect_engine::EffectUpdate update;
+    update.flags = effect_engine::kParamTypeSpecific;
+    update.type_specific = &periodic;
+    update.type_specific_size = sizeof(periodic);
+    effect.set_parameters(update, now_us);
+}
+
+std::int16_t evaluate_one(const effect_engine::Effect& effect, std::uint64_t now_us) {
+    effect_engine::EffectBatch batch;
+    batch.add(effect, kNominalMax);
+    g923bridge::WheelStatePayload payload{};
+    batch.evaluate(payload, now_us);
+    return payload.constant_force_magnitude;
+}
+
+// Full-magnitude sines through the batch's table oscillators against std::sin, sampled every
+// 250 us; "max jump" is the largest change between neighbouring samples. The retune cases move
+// the period from 20 ms to 13 ms mid-effect, once through the engine and once with the phase
+// taken from elapsed % period as the engine used to.
+void bench_oscillators() {
+    print_header("periodic oscillators");
+
+    std::vector<effect_engine::Effect> sines;
+    effect_engine::EffectBatch batch;
+    for (std::size_t i = 0; i < 64; ++i) {
+        sines.push_back(make_sine(static_cast<std::uint32_t>(20000 + i * 997)));
+        batch.add(sines.back(), kNominalMax);
+    }
+    run("evaluate 64 sines (batch)", 2000, 256, [&batch](std::size_t i) {
+        g923bridge::WheelStatePayload payload{};
+        batch.evaluate(payload, static_cast<std::uint64_t>(i) * 250);
+        g_sink += static_cast<std::uint64_t>(payload.constant_force_magnitude);
+    });
+    run("apply 64 sines (Effect::apply)", 2000, 256, [&sines](std::size_t i) {
+        g923bridge::WheelStatePayload payload{};
+        for (const effect_engine::Effect& effect : sines) {
+            effect.apply(payload, kNominalMax, static_cast<std::uint64_t>(i) * 250);
+        }
+        g_sink += static_cast<std::uint64_t>(payload.constant_force_magnitude);
+    });
+
+    constexpr std::uint64_t kStepUs = 250;
+    constexpr std::uint64_t kRunUs = 10000000;
+    constexpr double kTwoPi = 6.28318530717958647692;
+    std::printf("\n%-34s %10s %10s\n", "oscillator accuracy (250 us steps)", "max err", "max jump");
+
+    const auto report = [](const char* name, const auto& actual, const auto& ideal) {
+        double max_error = 0.0;
+        double max_jump = 0.0;
+        double previous = actual(0);
+        for (std::uint64_t t = 0; t < kRunUs; t += kStepUs) {
+            const double value = actual(t);
+            max_error = std::max(max_error, std::fabs(value - ideal(t)));
+            max_jump = std::max(max_jump, std::fabs(value - previous));
+            previous = value;
+        }
+        std::printf("%-34s %10.1f %10.1f\n", name, max_error, max_jump);
+    };
+
+    for (const std::uint32_t period : {1000u, 4000u, 20000u, 100000u}) {
+        const effect_engine::Effect effect = make_sine(period);
+        char name[48];
+        std::snprintf(name, sizeof(name), "sine %u us period", static_cast<unsigned>(period));
+        report(
+            name, [&effect](std::uint64_t t) { return static_cast<double>(evaluate_one(effect, t)); },
+            [period](std::uint64_t t) {
+                return kNominalMax * std::sin(kTwoPi * static_cast<double>(t % period) / period);
+            });
+    }
+
+    constexpr std::uint64_t kRetuneUs = 103300;
+    const effect_engine::Effect before = make_sine(20000);
+    effect_engine::Effect after = before;
+    retune_sine(after, 13000, kRetuneUs);
+    const auto continuous = [](std::uint64_t t) {
+        const double cycles = t < kRetuneUs ? t / 20000.0 : kRetuneUs / 20000.0 + (t - kRetuneUs) / 13000.0;
+        return kNominalMax * std::sin(kTwoPi * cycles);
+    };
+    report(
+        "retune 20 -> 13 ms",
+        [&before, &after](std::uint64_t t) {
+            return static_cast<double>(evaluate_one(t < kRetuneUs ? before : after, t));
+        },
+        continuous);
+    report(
+        "retune, phase from elapsed % period",
+        [](std::uint64_t t) {
+            const std::uint64_t period = t < kRetuneUs ? 20000 : 13000;
+            return kNominalMax * std::sin(kTwoPi * static_cast<double>(t % period) / period);
+        },
+        continuous);
+}
+
+// --- Effect table -----------------------------------------------------------------------
+
+// The proxy keeps its effects in a SlotMap; games that create and release effects every frame
+// churn it constantly. tests/effect_engine_test.cpp checks its handles under the same churn.
+void bench_effect_table() {
+    print_header("effect table (slot map)");
+
+    SlotMap<std::uint32_t> table;
+    std::vector<SlotMap<std::uint32_t>::Handle> ring;
+    for (std::uint32_t i = 0; i < 64; ++i) {
+        ring.push_back(table.insert(i));
+    }
+    run("release + create (64 live)", 2000, 256, [&table, &ring](std::size_t i) {
+        SlotMap<std::uint32_t>::Handle& handle = ring[i % ring.size()];
+        table.erase(handle);
+        handle = table.insert(static_cast<std::uint32_t>(i));
+    });
+    run("iterate 64 live", 2000, 256, [&table](std::size_t) {
+        for (const std::uint32_t value : table) {
+            g_sink += value;
+        }
+    });
+
+    const std::vector<effect_engine::Effect> effects = make_effects(256);
+    effect_engine::EffectBatch batch;
+    for (const effect_engine::Effect& effect : effects) {
+        batch.add(effect, kNominalMax);
+    }
+    run("evaluate batch (256 effects)", 500, 64, [&batch](std::size_t i) {
+        g923bridge::WheelStatePayload payload{};
+        batch.evaluate(payload, static_cast<std::uint64_t>(i) * 1000);
+        g_sink += static_cast<std::uint64_t>(payload.constant_force_magnitude) + payload.spring_k1;
+    });
+}
+
+// --- Bridge state application -----------------------------------------------------------
+
+void bench_apply_wheel_state() {
+    print_header("apply_wheel_state (fake wheel)");
+
+    auto hid_backend = std::make_unique<FakeHidBackend>();
+    hid_backend->add_g923();
+    BridgeServer server(0, WheelBackend::classic, 0, std::move(hid_backend));
+    if (!server.reconnect_wheel()) {
+        std::printf("%-34s failed to connect the fake wheel\n", "apply_wheel_state");
+        return;
+    }
+
+    g923bridge::WheelStatePayload state;
+    state.autocenter_enabled = 1;
+    state.autocenter_force = 40;
+    state.autocenter_slope = 4;
+    state.damper_enabled = 1;
+    state.damper_force_positive = 80;
+    state.damper_force_negative = 80;
+    state.constant_force_enabled = 1;
+
+    run("changing constant force", 200, 64, [&server, &state](std::size_t i) {
+        state.constant_force_magnitude = static_cast<std::int16_t>((i * 997) % 10000) - 5000;
+        g_sink += server.apply_wheel_state(state) ? 1 : 0;
+    });
+
+    run("deduplicated state", 200, 64, [&server, &state](std::size_t) {
+        g_sink += server.apply_wheel_state(state) ? 1 : 0;
+    });
+
+    run("spring + damper + led change", 200, 64, [&server, &state](std::size_t i) {
+        state.custom_spring_enabled = 1;
+        state.spring_k1 = static_cast<std::uint8_t>(i & 0x0F);
+        state.damper_force_positive = static_cast<std::uint8_t>(i);
+        state.led_pattern_enabled = 1;
+        state.led_pattern = static_cast<std::uint8_t>(i & 0x1F);
+        g_sink += server.apply_wheel_state(state) ? 1 : 0;
+    });
+}
+
+// --- Proxy state mailbox ----------------------------------------------------------------
+
+void bench_state_mailbox() {
+    print_header("state mailbox");
+
+    StateMailbox mailbox;
+    g923bridge::WheelStatePayload state;
+    state.constant_force_enabled = 1;
+    StateMailbox::Taken taken;
+
+    run("publish", 2000, 1024, [&mailbox, &state](std::size_t i) {
+        state.constant_force_magnitude = static_cast<std::int16_t>(i);
+        mailbox.publish(state);
+    });
+
+    run("publish + take", 2000, 1024, [&mailbox, &state, &taken](std::size_t i) {
+        state.constant_force_magnitude = static_cast<std::int16_t>(i);
+        mailbox.publish(state);
+        g_sink += mailbox.take(taken) ? static_cast<std::uint64_t>(taken.state.constant_force_magnitude) : 0;
+    });
+
+    // What a game thread pays while the sender thread keeps draining the mailbox
+    std::atomic<bool> draining{true};
+    std::thread sender([&mailbox, &draining] {
+        StateMailbox::Taken sent;
+        std::uint64_t checksum = 0;
+        while (draining.load(std::memory_order_relaxed)) {
+            if (mailbox.take(sent)) {
+                checksum += static_cast<std::uint64_t>(sent.state.constant_force_magnitude);
+            }
+        }
+        g_sink += checksum;
+    });
+    run("publish (sender draining)", 2000, 1024, [&mailbox, &state](std::size_t i) {
+        state.constant_force_magnitude = static_cast<std::int16_t>(i);
+        mailbox.publish(state);
+    });
+    draining.store(false);
+    sender.join();
+}
+
+// --- Proxy log line ring ----------------------------------------------------------------
+
+bool push_line(LineRing& ring, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    const bool pushed = ring.push_format(format, args);
+    va_end(args);
+    return pushed;
+}
+
+void bench_line_ring() {
+    print_header("proxy log line ring");
+
+    LineRing ring;
+    std::size_t length = 0;
+    run("push_format + take", 2000, 256, [&ring, &length](std::size_t i) {
+        push_line(ring, "EffectProxy::Periodic magnitude=%lu offset=%ld period=%lu", static_cast<unsigned long>(i),
+                  -static_cast<long>(i), 20000ul);
+        if (const char* line = ring.front(length)) {
+            g_sink += static_cast<std::uint64_t>(line[length - 1]);
+            ring.pop();
+        }
+    });
+
+    // The proxy log used to open, append to and close its file for every line
+    const char* path = "g923_bench_proxy.log";
+    run("open + append + close per line", 200, 16, [path](std::size_t i) {
+        std::FILE* file = std::fopen(path, "ab");
+        if (file) {
+            std::fprintf(file, "EffectProxy::Periodic magnitude=%lu offset=%ld period=%lu\r\n",
+                         static_cast<unsigned long>(i), -static_cast<long>(i), 20000ul);
+            std::fclose(file);
+        }
+    });
+    std::remove(path);
+
+    // A writer that falls behind costs lines, counted, never a blocked caller
+    std::size_t pushed = 0;
+    for (std::size_t i = 0; i < LineRing::kSlots * 3; ++i) {
+        pushed += push_line(ring, "line %zu", i) ? 1 : 0;
+    }
+    const std::uint64_t dropped = ring.take_dropped();
+    std::size_t in_order = 0;
+    char expected[32];
+    for (std::size_t i = 0; const char* line = ring.front(length); ++i) {
+        std::snprintf(expected, sizeof(expected), "line %zu", i);
+        in_order += std::strcmp(line, expected) == 0 ? 1 : 0;
+        ring.pop();
+    }
+    std::printf("%-34s %zu lines, %zu accepted, %zu read back in order, %llu dropped\n",
+                "overflow (no writer)", LineRing::kSlots * 3, pushed, in_order,
+                static_cast<unsigned long long>(dropped));
+}
+
+}  // namespace
+
+int main() {
+    Logger::set_enabled(false);
+
+    bench_force_curve();
+    bench_command_builder();
+    bench_protocol_parsing();
+    bench_effect_evaluation();
+    bench_effect_timing_accuracy();
+    bench_oscillators();
+    bench_effect_table();
+    bench_apply_wheel_state();
+    bench_state_mailbox();
+    bench_line_ring();
+
+    std::printf("\n(sink %llu)\n", static_cast<unsigned long long>(g_sink));
+    return 0;
+}
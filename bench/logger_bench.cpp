@@ -0,0 +1,90 @@
+#include "logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+constexpr int kBatchSize = 512;
+constexpr int kBatches = 400;
+
+std::FILE* g_null_output = nullptr;
+
+// Times kBatchSize calls at a time and drains the ring between batches, so every measured
+// call takes the enqueue path instead of the cheaper drop path.
+template <typename Body>
+double nanoseconds_per_call(Body body) {
+    std::vector<double> samples;
+    samples.reserve(kBatches);
+
+    for (int batch = 0; batch < kBatches; ++batch) {
+        const bench_clock::time_point start = bench_clock::now();
+        for (int i = 0; i < kBatchSize; ++i) {
+            body(i);
+        }
+        const bench_clock::time_point end = bench_clock::now();
+        samples.push_back(std::chrono::duration<double, std::nano>(end - start).count() / kBatchSize);
+        Logger::flush();
+    }
+
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+void report(const char* name, double nanoseconds) {
+    std::printf("%-36s %9.1f ns/call\n", name, nanoseconds);
+}
+
+}  // namespace
+
+int main() {
+    g_null_output = std::fopen("/dev/null", "w");
+    if (!g_null_output) {
+        std::fprintf(stderr, "cannot open /dev/null\n");
+        return 1;
+    }
+    Logger::set_output(g_null_output);
+
+    std::printf("G923_LOG_MIN_LEVEL=%d, %d batches of %d calls, median per batch\n\n", G923_LOG_MIN_LEVEL, kBatches,
+                kBatchSize);
+
+    report("debug (compiled out in release)", nanoseconds_per_call([](int i) {
+        Logger::debug("Command sent successfully %d", i);
+    }));
+
+    Logger::set_enabled(false);
+    report("info (disabled at runtime)", nanoseconds_per_call([](int i) {
+        Logger::info("Found %d HID devices", i);
+    }));
+    Logger::set_enabled(true);
+
+    report("info, no arguments", nanoseconds_per_call([](int) {
+        Logger::info("Wheel controller initialized successfully");
+    }));
+
+    report("info, two integers", nanoseconds_per_call([](int i) {
+        Logger::info("Found %d HID devices on interface %u", i, 3u);
+    }));
+
+    report("error, two strings and a hex code", nanoseconds_per_call([](int i) {
+        Logger::error("%s failed with error code 0x%x (%s)", "IOHIDDeviceSetReport", i, "(iokit/common) not ready");
+    }));
+
+    // What the synchronous logger paid per call: build std::strings and printf them
+    report("synchronous std::string + fprintf", nanoseconds_per_call([](int i) {
+        const std::string message = "Found " + std::to_string(i) + " HID devices";
+        const std::string prefix = "g923mac::info";
+        std::fprintf(g_null_output, "\033[1;%dm=== %s \033[0m: %s\n", 32, prefix.c_str(), message.c_str());
+    }));
+
+    Logger::flush();
+    std::printf("\ndropped records: %llu\n", static_cast<unsigned long long>(Logger::dropped_records()));
+    Logger::set_output(nullptr);
+    std::fclose(g_null_output);
+    return 0;
+}
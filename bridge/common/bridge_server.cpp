@@ -0,0 +1,884 @@
+#include "bridge_server.hpp"
+#include "alloc_tracker.hpp"
+#include "force_curve.hpp"
+#include "trace_zones.hpp"
+#include "utilities.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+bool recv_exact(int fd, void* buffer, std::size_t size) {
+    auto* out = static_cast<std::uint8_t*>(buffer);
+    std::size_t received = 0;
+
+    while (received < size) {
+        const ssize_t chunk = recv(fd, out + received, size - received, 0);
+        if (chunk == 0) {
+            return false;
+        }
+        if (chunk < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        received += static_cast<std::size_t>(chunk);
+    }
+
+    return true;
+}
+
+bool send_exact(int fd, const void* buffer, std::size_t size) {
+    const auto* data = static_cast<const std::uint8_t*>(buffer);
+    std::size_t sent = 0;
+
+    while (sent < size) {
+        const ssize_t chunk = send(fd, data + sent, size - sent, 0);
+        if (chunk < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        sent += static_cast<std::size_t>(chunk);
+    }
+
+    return true;
+}
+
+bool discard_exact(int fd, std::size_t size) {
+    std::array<std::uint8_t, 256> discard{};
+    while (size > 0) {
+        const std::size_t chunk = std::min(size, discard.size());
+        if (!recv_exact(fd, discard.data(), chunk)) {
+            return false;
+        }
+        size -= chunk;
+    }
+    return true;
+}
+
+int open_loopback_listener(std::uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 1) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// Waits up to 250 ms for fd to become readable; returns <0 on error, 0 on timeout
+int wait_readable(int fd) {
+    fd_set read_fds;
+    FD_ZERO(&read_fds);
+    FD_SET(fd, &read_fds);
+
+    timeval timeout{};
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 250000;
+
+    const int ready = select(fd + 1, &read_fds, nullptr, nullptr, &timeout);
+    if (ready < 0 && errno == EINTR) {
+        return 0;
+    }
+    return ready;
+}
+
+static_assert(BridgeMetrics::kCommandTypeCount == g923bridge::kStatsCommandTypes,
+              "Stats reply must carry every command counter");
+
+void copy_histogram(const LatencyHistogram::Snapshot& source, g923bridge::StatsHistogram& target) {
+    static_assert(LatencyHistogram::kBucketCount == g923bridge::kStatsHistogramBuckets,
+                  "Stats reply must carry every histogram bucket");
+    target.count = source.count;
+    target.total_ns = source.total_ns;
+    target.max_ns = source.max_ns;
+    std::copy(source.buckets.begin(), source.buckets.end(), target.buckets);
+}
+
+void close_if_open(int& fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+}  // namespace
+
+BridgeServer::BridgeServer(std::uint16_t port, WheelBackend wheel_backend, std::uint16_t stats_port,
+                           std::unique_ptr<HidBackend> hid_backend)
+    : port_(port), stats_port_(stats_port), wheel_backend_(wheel_backend), stop_requested_(false), listen_fd_(-1),
+        stats_listen_fd_(-1), device_manager_(std::move(hid_backend)) {
+    status_.port = port_;
+    status_.wheel_name = "Starting wheel service...";
+}
+
+BridgeServer::~BridgeServer() {
+    stop();
+}
+
+bool BridgeServer::start() {
+    if (server_thread_.joinable()) {
+        return true;
+    }
+
+    stop_requested_.store(false);
+    server_thread_ = std::thread(&BridgeServer::server_loop, this);
+    stats_thread_ = std::thread(&BridgeServer::stats_loop, this);
+    return true;
+}
+
+void BridgeServer::stop() {
+    stop_requested_.store(true);
+
+    if (listen_fd_ >= 0) {
+        shutdown(listen_fd_, SHUT_RDWR);
+    }
+    if (stats_listen_fd_ >= 0) {
+        shutdown(stats_listen_fd_, SHUT_RDWR);
+    }
+
+    if (server_thread_.joinable()) {
+        server_thread_.join();
+    }
+    if (stats_thread_.joinable()) {
+        stats_thread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    status_.listening = false;
+    status_.client_connected = false;
+    status_.client_name.clear();
+    stop_wheel_forces_locked();
+    disconnect_wheel_locked();
+}
+
+bool BridgeServer::reconnect_wheel() {
+    return complete_wheel_connect_cycle(true);
+}
+
+bool BridgeServer::apply_wheel_state(const g923bridge::WheelStatePayload& payload) {
+    auto lock = lock_hot_path();
+    return apply_wheel_state_locked(payload);
+}
+
+bool BridgeServer::apply_led_pattern(std::uint8_t pattern) {
+    auto lock = lock_hot_path();
+    return apply_led_pattern_locked(pattern);
+}
+
+void BridgeServer::stop_wheel_forces() {
+    auto lock = lock_hot_path();
+    stop_wheel_forces_locked();
+}
+
+bool BridgeServer::start_capture(const std::string& path) {
+    return capture_.open(path);
+}
+
+void BridgeServer::stop_capture() {
+    capture_.close();
+}
+
+BridgeServer::Status BridgeServer::status() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Status snapshot = status_;
+    snapshot.output_total = WheelOutputStats{};
+    snapshot.interface_output.clear();
+    for (const auto& worker : wheel_workers_) {
+        const WheelOutputStats stats = worker->stats();
+        snapshot.output_total.accumulate(stats);
+        snapshot.interface_output.push_back(stats);
+    }
+    snapshot.metrics = metrics_.snapshot();
+    return snapshot;
+}
+
+BridgeServer::WheelConnectResult BridgeServer::ensure_wheel_connected() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!wheel_workers_.empty()) {
+            status_.wheel_connected = true;
+            return WheelConnectResult::connected;
+        }
+
+        if (wheel_operation_in_progress_) {
+            return WheelConnectResult::busy;
+        }
+    }
+
+    if (complete_wheel_connect_cycle(false)) {
+        return WheelConnectResult::connected;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return wheel_operation_in_progress_ ? WheelConnectResult::busy : WheelConnectResult::unavailable;
+}
+
+bool BridgeServer::complete_wheel_connect_cycle(bool force_reconnect) {
+    std::vector<std::unique_ptr<WheelOutputWorker>> previous_workers;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!force_reconnect && !wheel_workers_.empty()) {
+            status_.wheel_connected = true;
+            if (status_.wheel_name.empty()) {
+                status_.wheel_name = "Logitech G923";
+            }
+            return true;
+        }
+
+        if (wheel_operation_in_progress_) {
+            return false;
+        }
+
+        begin_wheel_operation_locked(force_reconnect ? "Reconnecting G923..." : "Connecting to G923...");
+        if (force_reconnect) {
+            previous_workers = std::move(wheel_workers_);
+        }
+    }
+
+    previous_workers.clear();
+
+    auto wheels = device_manager_.find_known_wheels();
+    if (wheels.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finish_wheel_operation_locked({}, "No G923 detected");
+        return false;
+    }
+
+    std::vector<std::unique_ptr<WheelController>> initialized_wheels;
+
+    for (const auto& device : wheels) {
+        auto controller =
+            std::make_unique<WheelController>(device, device_manager_.create_transport(device), wheel_backend_);
+        if (!controller->initialize()) {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            status_.wheel_name = "Calibrating G923...";
+        }
+
+        if (!controller->calibrate()) {
+            continue;
+        }
+        initialized_wheels.push_back(std::move(controller));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!initialized_wheels.empty()) {
+        const bool high_resolution = std::any_of(
+            initialized_wheels.begin(), initialized_wheels.end(),
+            [](const std::unique_ptr<WheelController>& wheel) { return wheel->has_high_resolution_forces(); });
+        std::string wheel_name = initialized_wheels.size() > 1
+                                     ? "Logitech G923 (" + std::to_string(initialized_wheels.size()) + " interfaces)"
+                                     : "Logitech G923";
+        if (high_resolution) {
+            wheel_name += " [HID++]";
+        }
+        finish_wheel_operation_locked(std::move(initialized_wheels), wheel_name);
+        return true;
+    }
+
+    finish_wheel_operation_locked({}, "Failed to calibrate G923");
+    return false;
+}
+
+void BridgeServer::begin_wheel_operation_locked(const std::string& status_text) {
+    wheel_operation_in_progress_ = true;
+    status_.wheel_connected = false;
+    status_.wheel_name = status_text;
+}
+
+void BridgeServer::finish_wheel_operation_locked(std::vector<std::unique_ptr<WheelController>> wheels,
+                                                 const std::string& status_text) {
+    uses_high_resolution_forces_ = std::any_of(
+        wheels.begin(), wheels.end(),
+        [](const std::unique_ptr<WheelController>& wheel) { return wheel && wheel->has_high_resolution_forces(); });
+
+    wheel_workers_.clear();
+    for (auto& wheel : wheels) {
+        if (wheel && wheel->is_initialized()) {
+            wheel_workers_.push_back(std::make_unique<WheelOutputWorker>(std::move(wheel), wheel_workers_.size(), &metrics_));
+        }
+    }
+
+    wheel_operation_in_progress_ = false;
+    status_.wheel_connected = !wheel_workers_.empty();
+    status_.wheel_name = status_text;
+    have_last_wheel_state_ = false;
+    last_wheel_state_ = g923bridge::WheelStatePayload{};
+    last_constant_force_active_ = false;
+    have_last_constant_level_ = false;
+    last_constant_level_ = 0;
+    last_constant_hires_level_ = 0;
+}
+
+void BridgeServer::disconnect_wheel_locked() {
+    wheel_workers_.clear();
+    wheel_operation_in_progress_ = false;
+    status_.wheel_connected = false;
+    uses_high_resolution_forces_ = false;
+    last_constant_force_active_ = false;
+    have_last_constant_level_ = false;
+    last_constant_level_ = 0;
+    last_constant_hires_level_ = 0;
+    have_last_wheel_state_ = false;
+    last_wheel_state_ = g923bridge::WheelStatePayload{};
+    if (status_.wheel_name.empty()) {
+        status_.wheel_name = "Disconnected";
+    }
+}
+
+void BridgeServer::stop_wheel_forces_locked() {
+    if (wheel_workers_.empty()) {
+        return;
+    }
+
+    const WheelCommand commands[] = {
+        WheelCommand::stop_forces(),
+        WheelCommand::disable_autocenter(),
+        WheelCommand::custom_spring(0, 0, 0, 0, 0, 0, 0),
+        WheelCommand::damper(0, 0, 0, 0),
+    };
+    for (auto& worker : wheel_workers_) {
+        worker->submit(commands, sizeof(commands) / sizeof(commands[0]));
+    }
+    last_constant_force_active_ = false;
+    have_last_constant_level_ = false;
+    last_constant_level_ = 0;
+    last_constant_hires_level_ = 0;
+    have_last_wheel_state_ = false;
+    last_wheel_state_ = g923bridge::WheelStatePayload{};
+}
+
+void BridgeServer::server_loop() {
+    trace_zones::prepare_thread("bridge server");
+    listen_fd_ = open_loopback_listener(port_);
+    if (listen_fd_ < 0) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_.listening = true;
+    }
+
+    complete_wheel_connect_cycle(false);
+
+    while (!stop_requested_.load()) {
+        const int ready = wait_readable(listen_fd_);
+        if (ready < 0) {
+            break;
+        }
+        if (ready == 0) {
+            continue;
+        }
+
+        int client_fd = -1;
+        {
+            TraceZone zone("BridgeServer::accept");
+            client_fd = accept(listen_fd_, nullptr, nullptr);
+            if (client_fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+
+            timeval client_timeout{};
+            client_timeout.tv_sec = 1;
+            client_timeout.tv_usec = 0;
+            setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &client_timeout, sizeof(client_timeout));
+            setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &client_timeout, sizeof(client_timeout));
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            status_.client_connected = true;
+            status_.client_name = "Connected";
+        }
+
+        run_client_session(client_fd);
+        close_if_open(client_fd);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_.client_connected = false;
+        status_.client_name.clear();
+        stop_wheel_forces_locked();
+    }
+
+    close_if_open(listen_fd_);
+}
+
+// Stats clients get their own listener so a monitor can watch a live game session
+void BridgeServer::stats_loop() {
+    stats_listen_fd_ = open_loopback_listener(stats_port_);
+    if (stats_listen_fd_ < 0) {
+        return;
+    }
+
+    while (!stop_requested_.load()) {
+        const int ready = wait_readable(stats_listen_fd_);
+        if (ready < 0) {
+            break;
+        }
+        if (ready == 0) {
+            continue;
+        }
+
+        int client_fd = accept(stats_listen_fd_, nullptr, nullptr);
+        if (client_fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        timeval client_timeout{};
+        client_timeout.tv_sec = 1;
+        client_timeout.tv_usec = 0;
+        setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &client_timeout, sizeof(client_timeout));
+        setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &client_timeout, sizeof(client_timeout));
+
+        run_stats_session(client_fd);
+        close_if_open(client_fd);
+    }
+
+    close_if_open(stats_listen_fd_);
+}
+
+void BridgeServer::run_stats_session(int client_fd) {
+    while (!stop_requested_.load()) {
+        const int ready = wait_readable(client_fd);
+        if (ready < 0) {
+            break;
+        }
+        if (ready == 0) {
+            continue;
+        }
+
+        g923bridge::MessageHeader header{};
+        if (!recv_exact(client_fd, &header, sizeof(header)) ||
+            header.magic != g923bridge::kProtocolMagic ||
+            header.version != g923bridge::kProtocolVersion ||
+            !discard_exact(client_fd, header.payload_size)) {
+            break;
+        }
+
+        const auto type = static_cast<g923bridge::MessageType>(header.type);
+        if (type == g923bridge::MessageType::stats_request) {
+            if (!send_stats_reply(client_fd)) {
+                break;
+            }
+        } else if (type != g923bridge::MessageType::ping) {
+            break;
+        }
+    }
+}
+
+void BridgeServer::run_client_session(int client_fd) {
+    while (!stop_requested_.load()) {
+        g923bridge::MessageHeader header{};
+        if (!recv_exact(client_fd, &header, sizeof(header))) {
+            break;
+        }
+        const auto received_at = std::chrono::steady_clock::now();
+
+        if (header.magic != g923bridge::kProtocolMagic ||
+            header.version != g923bridge::kProtocolVersion) {
+            break;
+        }
+
+        if (!handle_message(client_fd, header, received_at)) {
+            break;
+        }
+    }
+
+    capture_.flush();
+}
+
+bool BridgeServer::handle_message(int client_fd, const g923bridge::MessageHeader& header,
+                                  std::chrono::steady_clock::time_point received_at) {
+    TraceZone zone("BridgeServer::handle_message");
+    switch (static_cast<g923bridge::MessageType>(header.type)) {
+        case g923bridge::MessageType::hello: {
+            if (header.payload_size != sizeof(g923bridge::HelloPayload)) {
+                return false;
+            }
+
+            g923bridge::HelloPayload payload{};
+            if (!recv_exact(client_fd, &payload, sizeof(payload))) {
+                return false;
+            }
+            capture_.record(header.type, &payload, sizeof(payload), received_at);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                status_.client_name = payload.client_name;
+            }
+
+            return send_hello_ack(client_fd);
+        }
+
+        case g923bridge::MessageType::apply_wheel_state: {
+            if (header.payload_size != sizeof(g923bridge::WheelStatePayload)) {
+                return false;
+            }
+
+            g923bridge::WheelStatePayload payload{};
+            if (!recv_exact(client_fd, &payload, sizeof(payload))) {
+                return false;
+            }
+            capture_.record(header.type, &payload, sizeof(payload), received_at);
+            const auto decoded_at = std::chrono::steady_clock::now();
+            BridgeMetrics::record(metrics_.receive_to_decode, decoded_at - received_at);
+
+            const auto connect_result = ensure_wheel_connected();
+            if (connect_result == WheelConnectResult::unavailable) {
+                return false;
+            }
+            if (connect_result == WheelConnectResult::busy) {
+                return true;
+            }
+
+            NoAllocScope no_alloc("BridgeServer::handle_message(apply_wheel_state)");
+            auto lock = lock_hot_path();
+            const bool applied = apply_wheel_state_locked(payload);
+            BridgeMetrics::record(metrics_.decode_to_apply, std::chrono::steady_clock::now() - decoded_at);
+            return applied;
+        }
+
+        case g923bridge::MessageType::stop_all: {
+            if (!discard_exact(client_fd, header.payload_size)) {
+                return false;
+            }
+            capture_.record(header.type, nullptr, 0, received_at);
+
+            NoAllocScope no_alloc("BridgeServer::handle_message(stop_all)");
+            auto lock = lock_hot_path();
+            stop_wheel_forces_locked();
+            ++status_.packets_received;
+            return true;
+        }
+
+        case g923bridge::MessageType::ping: {
+            if (!discard_exact(client_fd, header.payload_size)) {
+                return false;
+            }
+            capture_.record(header.type, nullptr, 0, received_at);
+            return true;
+        }
+
+        case g923bridge::MessageType::stats_request: {
+            if (!discard_exact(client_fd, header.payload_size)) {
+                return false;
+            }
+            capture_.record(header.type, nullptr, 0, received_at);
+            return send_stats_reply(client_fd);
+        }
+
+        case g923bridge::MessageType::set_led_pattern: {
+            if (header.payload_size != sizeof(g923bridge::LedPatternPayload)) {
+                return false;
+            }
+
+            g923bridge::LedPatternPayload payload{};
+            if (!recv_exact(client_fd, &payload, sizeof(payload))) {
+                return false;
+            }
+            capture_.record(header.type, &payload, sizeof(payload), received_at);
+
+            const auto connect_result = ensure_wheel_connected();
+            if (connect_result == WheelConnectResult::unavailable) {
+                return false;
+            }
+            if (connect_result == WheelConnectResult::busy) {
+                return true;
+            }
+
+            NoAllocScope no_alloc("BridgeServer::handle_message(set_led_pattern)");
+            auto lock = lock_hot_path();
+            return apply_led_pattern_locked(payload.pattern);
+        }
+
+        default:
+            return false;
+    }
+}
+
+bool BridgeServer::send_stats_reply(int client_fd) {
+    const Status snapshot = status();
+
+    g923bridge::StatsReplyPayload payload{};
+    payload.server_time_ns = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+    payload.packets_received = snapshot.packets_received;
+    payload.deduplicated_states = snapshot.metrics.deduplicated_states;
+    payload.hid_errors = snapshot.metrics.hid_errors;
+    std::copy(snapshot.metrics.commands_sent.begin(), snapshot.metrics.commands_sent.end(), payload.commands_sent);
+
+    const WheelOutputStats& output = snapshot.output_total;
+    payload.output_batches = output.batches;
+    payload.output_commands = output.commands;
+    payload.output_failures = output.failures;
+    payload.output_coalesced = output.coalesced;
+    payload.output_deferrals = output.deferrals;
+    payload.output_queue_depth = static_cast<std::uint32_t>(output.queue_depth);
+    payload.device_capacity_hz = static_cast<std::uint32_t>(std::lround(output.device_capacity_hz));
+    payload.force_cap_hz = static_cast<std::uint32_t>(std::lround(output.force_cap_hz));
+    payload.led_cap_hz = static_cast<std::uint32_t>(std::lround(output.led_cap_hz));
+
+    payload.listening = snapshot.listening ? 1 : 0;
+    payload.client_connected = snapshot.client_connected ? 1 : 0;
+    payload.wheel_connected = snapshot.wheel_connected ? 1 : 0;
+    payload.wheel_interfaces = static_cast<std::uint8_t>(std::min<std::size_t>(255, snapshot.interface_output.size()));
+    std::strncpy(payload.client_name, snapshot.client_name.c_str(), sizeof(payload.client_name) - 1);
+    std::strncpy(payload.wheel_name, snapshot.wheel_name.c_str(), sizeof(payload.wheel_name) - 1);
+
+    copy_histogram(snapshot.metrics.receive_to_decode, payload.receive_to_decode);
+    copy_histogram(snapshot.metrics.decode_to_apply, payload.decode_to_apply);
+    copy_histogram(snapshot.metrics.hid_write, payload.hid_write);
+    copy_histogram(snapshot.metrics.lock_wait, payload.lock_wait);
+
+    g923bridge::MessageHeader header{};
+    header.type = static_cast<std::uint16_t>(g923bridge::MessageType::stats_reply);
+    header.payload_size = sizeof(payload);
+
+    return send_exact(client_fd, &header, sizeof(header)) &&
+            send_exact(client_fd, &payload, sizeof(payload));
+}
+
+std::unique_lock<std::mutex> BridgeServer::lock_hot_path() {
+    const auto wait_start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    BridgeMetrics::record(metrics_.lock_wait, std::chrono::steady_clock::now() - wait_start);
+    return lock;
+}
+
+bool BridgeServer::send_hello_ack(int client_fd) {
+    g923bridge::HelloAckPayload payload{};
+    payload.accepted = 1;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        payload.wheel_connected = status_.wheel_connected ? 1 : 0;
+        payload.server_port = port_;
+        std::strncpy(payload.wheel_name, status_.wheel_name.c_str(), sizeof(payload.wheel_name) - 1);
+    }
+
+    g923bridge::MessageHeader header{};
+    header.type = static_cast<std::uint16_t>(g923bridge::MessageType::hello_ack);
+    header.payload_size = sizeof(payload);
+
+    return send_exact(client_fd, &header, sizeof(header)) &&
+            send_exact(client_fd, &payload, sizeof(payload));
+}
+
+bool BridgeServer::apply_wheel_state_locked(const g923bridge::WheelStatePayload& payload) {
+    TraceZone zone("BridgeServer::apply_wheel_state_locked");
+    NoAllocScope no_alloc("BridgeServer::apply_wheel_state_locked");
+    if (wheel_operation_in_progress_) {
+        return true;
+    }
+
+    if (wheel_workers_.empty()) {
+        status_.wheel_connected = false;
+        return false;
+    }
+
+    const bool has_any_effect =
+        payload.autocenter_enabled || payload.custom_spring_enabled ||
+        payload.damper_enabled || payload.constant_force_enabled;
+    int desired_constant_level = 0;
+    int desired_constant_hires_level = 0;
+    if (payload.constant_force_enabled) {
+        const float curve = g923bridge::map_constant_magnitude_to_curve(payload.constant_force_magnitude);
+        const int target_level = g923bridge::map_constant_magnitude_to_level(payload.constant_force_magnitude);
+        desired_constant_level = g923bridge::apply_constant_slew_limiter(
+            target_level, have_last_constant_level_, last_constant_level_);
+        desired_constant_hires_level = desired_constant_level == target_level
+            ? g923bridge::map_constant_curve_to_hires_level(curve)
+            : g923bridge::map_constant_curve_to_hires_level(static_cast<float>(desired_constant_level));
+        if (desired_constant_level == 0) {
+            desired_constant_hires_level = 0;
+        }
+    }
+    const bool constant_active = desired_constant_level != 0;
+    const bool constant_level_changed = constant_active
+        ? (!have_last_constant_level_ || desired_constant_level != last_constant_level_ ||
+           (uses_high_resolution_forces_ && desired_constant_hires_level != last_constant_hires_level_))
+        : last_constant_force_active_;
+
+    if (!has_any_effect) {
+        stop_wheel_forces_locked();
+        have_last_wheel_state_ = true;
+        last_wheel_state_ = payload;
+        ++status_.packets_received;
+        return true;
+    }
+
+    if (have_last_wheel_state_ &&
+        std::memcmp(&payload, &last_wheel_state_, sizeof(payload)) == 0 &&
+        !constant_level_changed) {
+        BridgeMetrics::add(metrics_.deduplicated_states);
+        ++status_.packets_received;
+        return true;
+    }
+
+    const bool spring_changed =
+        !have_last_wheel_state_ ||
+        payload.custom_spring_enabled != last_wheel_state_.custom_spring_enabled ||
+        payload.spring_deadband_left != last_wheel_state_.spring_deadband_left ||
+        payload.spring_deadband_right != last_wheel_state_.spring_deadband_right ||
+        payload.spring_k1 != last_wheel_state_.spring_k1 ||
+        payload.spring_k2 != last_wheel_state_.spring_k2 ||
+        payload.spring_sat1 != last_wheel_state_.spring_sat1 ||
+        payload.spring_sat2 != last_wheel_state_.spring_sat2 ||
+        payload.spring_clip != last_wheel_state_.spring_clip;
+    const bool damper_changed =
+        !have_last_wheel_state_ ||
+        payload.damper_enabled != last_wheel_state_.damper_enabled ||
+        payload.damper_force_positive != last_wheel_state_.damper_force_positive ||
+        payload.damper_force_negative != last_wheel_state_.damper_force_negative ||
+        payload.damper_saturation_positive != last_wheel_state_.damper_saturation_positive ||
+        payload.damper_saturation_negative != last_wheel_state_.damper_saturation_negative;
+    const bool autocenter_changed =
+        !have_last_wheel_state_ ||
+        payload.autocenter_enabled != last_wheel_state_.autocenter_enabled ||
+        payload.autocenter_force != last_wheel_state_.autocenter_force ||
+        payload.autocenter_slope != last_wheel_state_.autocenter_slope;
+    const bool constant_command_changed = constant_level_changed;
+    const bool led_changed =
+        !have_last_wheel_state_ ||
+        payload.led_pattern_enabled != last_wheel_state_.led_pattern_enabled ||
+        payload.led_pattern != last_wheel_state_.led_pattern;
+
+    std::array<WheelCommand, 6> commands;
+    std::size_t command_count = 0;
+
+    if (spring_changed) {
+        commands[command_count++] = WheelCommand::custom_spring(
+            payload.spring_deadband_left,
+            payload.spring_deadband_right,
+            payload.custom_spring_enabled ? payload.spring_k1 : 0,
+            payload.custom_spring_enabled ? payload.spring_k2 : 0,
+            payload.custom_spring_enabled ? payload.spring_sat1 : 0,
+            payload.custom_spring_enabled ? payload.spring_sat2 : 0,
+            payload.custom_spring_enabled ? payload.spring_clip : 0);
+    }
+
+    if (damper_changed) {
+        commands[command_count++] = WheelCommand::damper(
+            payload.damper_enabled ? payload.damper_force_positive : 0,
+            payload.damper_enabled ? payload.damper_force_negative : 0,
+            payload.damper_enabled ? payload.damper_saturation_positive : 0,
+            payload.damper_enabled ? payload.damper_saturation_negative : 0);
+    }
+
+    if (autocenter_changed) {
+        if (payload.autocenter_enabled) {
+            commands[command_count++] = WheelCommand::enable_autocenter();
+            commands[command_count++] = WheelCommand::autocenter_spring(
+                payload.autocenter_slope, payload.autocenter_slope, payload.autocenter_force);
+        } else {
+            commands[command_count++] = WheelCommand::disable_autocenter();
+        }
+    }
+
+    if (constant_command_changed) {
+        if (constant_active) {
+            const auto raw_level = static_cast<std::uint8_t>(
+                std::max(0, std::min(255, 128 + desired_constant_level)));
+            commands[command_count++] = WheelCommand::constant_force(
+                raw_level, static_cast<std::int16_t>(desired_constant_hires_level));
+        } else if (last_constant_force_active_) {
+            commands[command_count++] = WheelCommand::constant_force(128, 0);
+        }
+    }
+
+    if (led_changed) {
+        commands[command_count++] = WheelCommand::led_pattern(payload.led_pattern_enabled ? payload.led_pattern : 0);
+    }
+
+    // Each interface drains its own queue; only interfaces that keep failing count as lost
+    bool applied_to_any_wheel = false;
+    for (auto& worker : wheel_workers_) {
+        worker->submit(commands.data(), command_count);
+        applied_to_any_wheel = worker->is_healthy() || applied_to_any_wheel;
+    }
+
+    if (!applied_to_any_wheel) {
+        status_.wheel_connected = false;
+        return false;
+    }
+
+    last_constant_force_active_ = constant_active;
+    if (constant_active) {
+        have_last_constant_level_ = true;
+        last_constant_level_ = desired_constant_level;
+        last_constant_hires_level_ = desired_constant_hires_level;
+    } else {
+        have_last_constant_level_ = false;
+        last_constant_level_ = 0;
+        last_constant_hires_level_ = 0;
+    }
+
+    have_last_wheel_state_ = true;
+    last_wheel_state_ = payload;
+    ++status_.packets_received;
+    return true;
+}
+
+bool BridgeServer::apply_led_pattern_locked(std::uint8_t pattern) {
+    if (wheel_operation_in_progress_) {
+        return true;
+    }
+
+    if (wheel_workers_.empty()) {
+        status_.wheel_connected = false;
+        return false;
+    }
+
+    const WheelCommand command = WheelCommand::led_pattern(pattern);
+    bool applied = false;
+    for (auto& worker : wheel_workers_) {
+        worker->submit(&command, 1);
+        applied = worker->is_healthy() || applied;
+    }
+
+    if (applied) {
+        if (!have_last_wheel_state_) {
+            last_wheel_state_ = g923bridge::WheelStatePayload{};
+        }
+        last_wheel_state_.led_pattern_enabled = 1;
+        last_wheel_state_.led_pattern = pattern;
+        have_last_wheel_state_ = true;
+    }
+
+    ++status_.packets_received;
+    return applied;
+}
@@ -0,0 +1,783 @@
+#include "effect_engine.hpp"
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace effect_engine {
+
+namespace {
+
+constexpr double kTwoPi = 6.28318530717958647692;
+constexpr std::int64_t kUnity = 1 << 16;
+
+constexpr int kSineTableBits = 9;
+constexpr std::size_t kSineTableSize = std::size_t{1} << kSineTableBits;
+
+// 16.16 sine over one period with a wrap-around entry for interpolation, built at compile time
+// so the proxy never evaluates it during DLL load
+struct SineTable {
+    std::int32_t values[kSineTableSize + 1];
+};
+
+constexpr double constexpr_sin(double angle) {
+    if (angle > kTwoPi / 2) {
+        angle -= kTwoPi;
+    }
+    double term = angle;
+    double sum = angle;
+    for (int n = 1; n < 20; ++n) {
+        term *= -angle * angle / static_cast<double>((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr SineTable make_sine_table() {
+    SineTable table{};
+    for (std::size_t i = 0; i <= kSineTableSize; ++i) {
+        const double value = constexpr_sin(kTwoPi * static_cast<double>(i % kSineTableSize) / kSineTableSize) * kUnity;
+        table.values[i] = static_cast<std::int32_t>(value < 0 ? value - 0.5 : value + 0.5);
+    }
+    return table;
+}
+
+constexpr SineTable kSineTable = make_sine_table();
+
+std::int32_t clamp_i32(std::int64_t value, std::int32_t minimum, std::int32_t maximum) {
+    if (value < minimum) {
+        return minimum;
+    }
+    if (value > maximum) {
+        return maximum;
+    }
+    return static_cast<std::int32_t>(value);
+}
+
+std::uint32_t clamp_nominal(std::uint32_t value) {
+    return value > static_cast<std::uint32_t>(kNominalMax) ? static_cast<std::uint32_t>(kNominalMax) : value;
+}
+
+std::int32_t abs_i32(std::int32_t value) {
+    return value < 0 ? -value : value;
+}
+
+std::uint8_t max_u8(std::uint8_t a, std::uint8_t b) {
+    return a > b ? a : b;
+}
+
+std::uint8_t scale_byte(std::int32_t value) {
+    return static_cast<std::uint8_t>((clamp_i32(value, 0, kNominalMax) * 255) / kNominalMax);
+}
+
+std::uint8_t scale_nibble(std::int32_t value) {
+    return static_cast<std::uint8_t>((clamp_i32(value, 0, kNominalMax) * 15) / kNominalMax);
+}
+
+std::uint32_t apply_unsigned_gain(std::uint32_t value, std::uint32_t gain) {
+    return static_cast<std::uint32_t>((static_cast<std::uint64_t>(value) * clamp_nominal(gain)) /
+                                      static_cast<std::uint64_t>(kNominalMax));
+}
+
+std::int32_t apply_signed_gain(std::int32_t value, std::uint32_t gain) {
+    const std::int64_t scaled = (static_cast<std::int64_t>(value) * clamp_nominal(gain)) / kNominalMax;
+    return clamp_i32(scaled, -kNominalMax, kNominalMax);
+}
+
+std::int32_t apply_combined_gain(std::int32_t value, std::uint32_t effect_gain, std::uint32_t device_gain) {
+    return apply_signed_gain(apply_signed_gain(value, effect_gain), device_gain);
+}
+
+std::uint32_t apply_combined_gain_unsigned(std::uint32_t value, std::uint32_t effect_gain, std::uint32_t device_gain) {
+    return apply_unsigned_gain(apply_unsigned_gain(value, effect_gain), device_gain);
+}
+
+// Multiplies by a 16.16 factor, truncating toward zero like the integer gain stages
+std::int64_t mul_q16(std::int64_t value, std::int64_t factor) {
+    const std::int64_t product = value * factor;
+    return product < 0 ? -((-product) >> 16) : product >> 16;
+}
+
+std::int64_t nominal_q16(std::uint32_t value) {
+    return static_cast<std::int64_t>(clamp_nominal(value)) * kUnity / kNominalMax;
+}
+
+std::int64_t clamp_nominal_force(std::int64_t value) {
+    return value < -kNominalMax ? -kNominalMax : (value > kNominalMax ? kNominalMax : value);
+}
+
+double periodic_wave_sample(EffectType type, double phase01) {
+    double normalized = std::fmod(phase01, 1.0);
+    if (normalized < 0.0) {
+        normalized += 1.0;
+    }
+
+    switch (type) {
+        case EffectType::square:
+            return (normalized < 0.5) ? 1.0 : -1.0;
+        case EffectType::triangle:
+            return 1.0 - 4.0 * std::abs(normalized - 0.5);
+        case EffectType::sawtooth_up:
+            return (2.0 * normalized) - 1.0;
+        case EffectType::sawtooth_down:
+            return 1.0 - (2.0 * normalized);
+        default:
+            return std::sin(normalized * kTwoPi);
+    }
+}
+
+// Games may pass a shorter block than the structure; the missing tail keeps its defaults
+template <typename T>
+void copy_type_specific(T& destination, const void* source, std::uint32_t size) {
+    destination = T{};
+    std::memcpy(&destination, source, size < sizeof(T) ? size : sizeof(T));
+}
+
+}  // namespace
+
+bool is_condition(EffectType type) noexcept {
+    return type == EffectType::spring || type == EffectType::damper || type == EffectType::inertia ||
+           type == EffectType::friction;
+}
+
+bool is_periodic(EffectType type) noexcept {
+    return type == EffectType::square || type == EffectType::sine || type == EffectType::triangle ||
+           type == EffectType::sawtooth_up || type == EffectType::sawtooth_down;
+}
+
+const char* effect_type_name(EffectType type) noexcept {
+    switch (type) {
+        case EffectType::constant_force:
+            return "ConstantForce";
+        case EffectType::ramp_force:
+            return "RampForce";
+        case EffectType::square:
+            return "Square";
+        case EffectType::sine:
+            return "Sine";
+        case EffectType::triangle:
+            return "Triangle";
+        case EffectType::sawtooth_up:
+            return "SawtoothUp";
+        case EffectType::sawtooth_down:
+            return "SawtoothDown";
+        case EffectType::spring:
+            return "Spring";
+        case EffectType::damper:
+            return "Damper";
+        case EffectType::inertia:
+            return "Inertia";
+        case EffectType::friction:
+            return "Friction";
+        default:
+            return "Unknown";
+    }
+}
+
+Effect::Effect(EffectType type) noexcept
+    : type_(type), started_(false), envelope_enabled_(false), iterations_(1), effect_gain_(kNominalMax),
+      duration_(kInfinite), start_delay_(0), direction_flags_(kDirectionPolar), direction_{0, 0}, start_time_us_(0),
+      envelope_{}, conditions_{}, constant_force_{}, ramp_force_{}, periodic_{}, direction_q16_(kUnity),
+      attack_level_q16_(kUnity), attack_slope_q16_(0), fade_slope_q16_(0), phase_step_(0), phase_offset_(0),
+      phase_anchor_us_(0), anchor_phase_(0) {
+    prepare_batch_factors();
+}
+
+void Effect::set_parameters(const EffectUpdate& update, std::uint64_t now_us) {
+    const bool all_params = (update.flags & kParamAll) == kParamAll;
+    // Engine-RPM rumble retunes the period every few frames; a running oscillator keeps its
+    // phase rather than jumping to wherever the new period would put it
+    const bool oscillating = started_ && is_periodic(type_) && now_us > phase_anchor_us_;
+    const std::uint32_t phase_before = phase_at(now_us);
+    const std::uint32_t phase_offset_before = phase_offset_;
+    bool restarted = false;
+    if (all_params || (update.flags & kParamGain) != 0) {
+        effect_gain_ = clamp_nominal(update.gain);
+    }
+    if (all_params || (update.flags & kParamDuration) != 0) {
+        duration_ = update.duration;
+    }
+    if (all_params || (update.flags & kParamStartDelay) != 0) {
+        start_delay_ = update.start_delay;
+    }
+    if ((all_params || (update.flags & kParamDirection) != 0) && update.axis_count > 0 && update.has_direction) {
+        direction_flags_ = update.effect_flags;
+        if ((direction_flags_ & (kDirectionCartesian | kDirectionPolar | kDirectionSpherical)) == 0) {
+            direction_flags_ |= kDirectionPolar;
+        }
+        direction_[0] = update.direction[0];
+        direction_[1] = update.direction[1];
+    }
+    if (all_params || (update.flags & kParamEnvelope) != 0) {
+        envelope_enabled_ = update.envelope != nullptr;
+        if (update.envelope) {
+            envelope_ = *update.envelope;
+        }
+    }
+
+    if ((all_params || (update.flags & kParamTypeSpecific) != 0) && update.type_specific &&
+        update.type_specific_size > 0) {
+        if (is_condition(type_)) {
+            std::uint32_t count = update.type_specific_size / sizeof(Condition);
+            count = count > 2 ? 2 : (count == 0 ? 1 : count);
+            const auto* bytes = static_cast<const std::uint8_t*>(update.type_specific);
+            for (std::uint32_t i = 0; i < count; ++i) {
+                const std::uint32_t offset = i * sizeof(Condition);
+                copy_type_specific(conditions_[i], bytes + offset,
+                                   update.type_specific_size > offset ? update.type_specific_size - offset : 0);
+            }
+            if (count == 1) {
+                conditions_[1] = conditions_[0];
+            }
+        } else if (type_ == EffectType::constant_force) {
+            copy_type_specific(constant_force_, update.type_specific, update.type_specific_size);
+        } else if (type_ == EffectType::ramp_force) {
+            copy_type_specific(ramp_force_, update.type_specific, update.type_specific_size);
+        } else {
+            copy_type_specific(periodic_, update.type_specific, update.type_specific_size);
+            if (periodic_.period == 0) {
+                periodic_.period = kDefaultPeriod;
+            }
+        }
+    }
+
+    if ((update.flags & kParamStart) != 0) {
+        started_ = true;
+        if ((update.flags & kParamNoRestart) == 0) {
+            start_time_us_ = now_us;
+            restarted = true;
+        }
+        if (iterations_ == 0) {
+            iterations_ = 1;
+        }
+    }
+    prepare_batch_factors();
+    if (oscillating && !restarted) {
+        phase_anchor_us_ = now_us;
+        anchor_phase_ = phase_before + (phase_offset_ - phase_offset_before);
+    } else {
+        restart_phase();
+    }
+
+    // Games commonly update a constant force without ever calling Start
+    if (type_ == EffectType::constant_force && constant_force_.magnitude != 0) {
+        started_ = true;
+        if (start_time_us_ == 0) {
+            start_time_us_ = now_us;
+        }
+    }
+}
+
+void Effect::start(std::uint32_t iterations, std::uint64_t now_us) noexcept {
+    iterations_ = (iterations == 0) ? 1 : iterations;
+    started_ = true;
+    start_time_us_ = now_us;
+    restart_phase();
+}
+
+void Effect::stop() noexcept {
+    started_ = false;
+    iterations_ = 1;
+}
+
+bool Effect::has_time_varying_force() const noexcept {
+    return started_ && (type_ == EffectType::ramp_force || is_periodic(type_));
+}
+
+void Effect::refresh_runtime(std::uint64_t now_us) noexcept {
+    if (started_ && has_expired(now_us)) {
+        stop();
+    }
+}
+
+bool Effect::runs_forever() const noexcept {
+    return duration_ == kInfinite || iterations_ == kInfinite || duration_ == 0;
+}
+
+bool Effect::is_temporally_active(std::uint64_t now_us) const noexcept {
+    if (!started_) {
+        return false;
+    }
+    if (now_us <= start_time_us_) {
+        return start_delay_ == 0;
+    }
+
+    const std::uint64_t elapsed = now_us - start_time_us_;
+    if (elapsed < start_delay_) {
+        return false;
+    }
+    if (runs_forever()) {
+        return true;
+    }
+    return elapsed - start_delay_ < static_cast<std::uint64_t>(duration_) * iterations_;
+}
+
+bool Effect::has_expired(std::uint64_t now_us) const noexcept {
+    if (!started_ || runs_forever() || now_us <= start_time_us_) {
+        return false;
+    }
+
+    const std::uint64_t elapsed = now_us - start_time_us_;
+    if (elapsed < start_delay_) {
+        return false;
+    }
+    return elapsed - start_delay_ >= static_cast<std::uint64_t>(duration_) * iterations_;
+}
+
+float Effect::direction_multiplier() const {
+    if ((direction_flags_ & kDirectionCartesian) != 0) {
+        if (direction_[0] == 0) {
+            return 1.0f;
+        }
+        float cartesian = static_cast<float>(direction_[0]) / static_cast<float>(kNominalMax);
+        if (cartesian > 1.0f) {
+            cartesian = 1.0f;
+        } else if (cartesian < -1.0f) {
+            cartesian = -1.0f;
+        }
+        return cartesian;
+    }
+
+    if ((direction_flags_ & (kDirectionPolar | kDirectionSpherical)) == 0) {
+        return 1.0f;
+    }
+
+    const double angle = (static_cast<double>(direction_[0]) * kTwoPi) / 36000.0;
+    return static_cast<float>(std::cos(angle));
+}
+
+float Effect::envelope_multiplier(std::uint64_t active_elapsed, std::uint64_t total_duration) const {
+    if (!envelope_enabled_) {
+        return 1.0f;
+    }
+
+    const float attack_level = static_cast<float>(clamp_nominal(envelope_.attack_level)) / kNominalMax;
+    const float fade_level = static_cast<float>(clamp_nominal(envelope_.fade_level)) / kNominalMax;
+
+    if (envelope_.attack_time > 0 && active_elapsed < envelope_.attack_time) {
+        const float attack_t = static_cast<float>(active_elapsed) / static_cast<float>(envelope_.attack_time);
+        return attack_level + (1.0f - attack_level) * attack_t;
+    }
+
+    if (duration_ != kInfinite && envelope_.fade_time > 0 && total_duration > 0 && active_elapsed < total_duration) {
+        const std::uint64_t fade_start =
+            (total_duration > envelope_.fade_time) ? (total_duration - envelope_.fade_time) : 0;
+        if (active_elapsed >= fade_start) {
+            const float fade_t = static_cast<float>(active_elapsed - fade_start) / static_cast<float>(envelope_.fade_time);
+            return 1.0f + (fade_level - 1.0f) * fade_t;
+        }
+    }
+
+    return 1.0f;
+}
+
+std::int32_t Effect::compute_force(std::uint64_t now_us, std::uint32_t device_gain) const {
+    if (!is_temporally_active(now_us)) {
+        return 0;
+    }
+
+    const std::uint64_t elapsed = (now_us > start_time_us_) ? (now_us - start_time_us_) : 0;
+    const std::uint64_t active_elapsed = (elapsed > start_delay_) ? (elapsed - start_delay_) : 0;
+    const std::uint64_t total_duration = runs_forever() ? 0 : static_cast<std::uint64_t>(duration_) * iterations_;
+
+    std::int32_t raw_force = 0;
+    if (type_ == EffectType::constant_force) {
+        raw_force = constant_force_.magnitude;
+    } else if (type_ == EffectType::ramp_force) {
+        if (duration_ == 0 || duration_ == kInfinite) {
+            raw_force = ramp_force_.end;
+        } else {
+            const std::uint64_t cycle_elapsed = active_elapsed % duration_;
+            const std::int64_t delta = static_cast<std::int64_t>(ramp_force_.end) - ramp_force_.start;
+            raw_force = ramp_force_.start +
+                        static_cast<std::int32_t>((delta * static_cast<std::int64_t>(cycle_elapsed)) / duration_);
+        }
+    } else if (is_periodic(type_)) {
+        const double phase = static_cast<double>(phase_at(now_us)) / 4294967296.0;
+        const double wave = periodic_wave_sample(type_, phase);
+        raw_force = periodic_.offset + static_cast<std::int32_t>(static_cast<double>(periodic_.magnitude) * wave);
+    } else {
+        return 0;
+    }
+
+    const float shaped =
+        static_cast<float>(raw_force) * envelope_multiplier(active_elapsed, total_duration) * direction_multiplier();
+    const std::int32_t directed_force = clamp_i32(static_cast<std::int64_t>(shaped), -kNominalMax, kNominalMax);
+    return apply_combined_gain(directed_force, effect_gain_, device_gain);
+}
+
+void Effect::apply(g923bridge::WheelStatePayload& payload, std::uint32_t device_gain, std::uint64_t now_us) const {
+    if (!is_temporally_active(now_us)) {
+        return;
+    }
+
+    if (is_condition(type_)) {
+        apply_condition(payload, device_gain);
+        return;
+    }
+
+    const std::int32_t force = compute_force(now_us, device_gain);
+    if (force != 0) {
+        payload.constant_force_enabled = 1;
+        payload.constant_force_magnitude = static_cast<std::int16_t>(
+            clamp_i32(static_cast<std::int64_t>(payload.constant_force_magnitude) + force, -kNominalMax, kNominalMax));
+    }
+}
+
+void Effect::apply_condition(g923bridge::WheelStatePayload& payload, std::uint32_t device_gain) const {
+    const Condition& positive = conditions_[0];
+    const Condition& negative = conditions_[1];
+    const auto coefficient = [this, device_gain](std::int32_t value) {
+        return apply_combined_gain(abs_i32(value), effect_gain_, device_gain);
+    };
+    const auto saturation = [this, device_gain](std::uint32_t value) {
+        return static_cast<std::int32_t>(apply_combined_gain_unsigned(value, effect_gain_, device_gain));
+    };
+
+    if (type_ == EffectType::spring) {
+        const std::int32_t positive_saturation = saturation(positive.positive_saturation);
+        const std::int32_t negative_saturation = saturation(negative.negative_saturation);
+        payload.custom_spring_enabled = 1;
+        payload.spring_k1 = max_u8(payload.spring_k1, scale_nibble(coefficient(positive.positive_coefficient)));
+        payload.spring_k2 = max_u8(payload.spring_k2, scale_nibble(coefficient(negative.negative_coefficient)));
+        payload.spring_sat1 = max_u8(payload.spring_sat1, scale_nibble(positive_saturation));
+        payload.spring_sat2 = max_u8(payload.spring_sat2, scale_nibble(negative_saturation));
+        payload.spring_deadband_left = max_u8(payload.spring_deadband_left, scale_nibble(positive.dead_band));
+        payload.spring_deadband_right = max_u8(payload.spring_deadband_right, scale_nibble(negative.dead_band));
+        payload.spring_clip = max_u8(payload.spring_clip, scale_byte(positive_saturation > negative_saturation
+                                                                         ? positive_saturation
+                                                                         : negative_saturation));
+    } else if (type_ == EffectType::damper || type_ == EffectType::friction || type_ == EffectType::inertia) {
+        payload.damper_enabled = 1;
+        payload.damper_force_positive =
+            max_u8(payload.damper_force_positive, scale_byte(coefficient(positive.positive_coefficient)));
+        payload.damper_force_negative =
+            max_u8(payload.damper_force_negative, scale_byte(coefficient(negative.negative_coefficient)));
+        payload.damper_saturation_positive =
+            max_u8(payload.damper_saturation_positive, scale_byte(saturation(positive.positive_saturation)));
+        payload.damper_saturation_negative =
+            max_u8(payload.damper_saturation_negative, scale_byte(saturation(negative.negative_saturation)));
+    }
+}
+
+void Effect::prepare_batch_factors() {
+    direction_q16_ = std::llround(static_cast<double>(direction_multiplier()) * kUnity);
+
+    attack_level_q16_ = kUnity;
+    attack_slope_q16_ = 0;
+    fade_slope_q16_ = 0;
+    if (envelope_.attack_time > 0) {
+        attack_level_q16_ = nominal_q16(envelope_.attack_level);
+        attack_slope_q16_ = ((kUnity - attack_level_q16_) * kUnity) / envelope_.attack_time;
+    }
+    if (envelope_.fade_time > 0) {
+        fade_slope_q16_ = ((nominal_q16(envelope_.fade_level) - kUnity) * kUnity) / envelope_.fade_time;
+    }
+
+    // Rounding the step up keeps exact fractions such as a square wave's midpoint on the right side
+    std::uint32_t period = 0;
+    phase_offset_ = 0;
+    if (type_ == EffectType::ramp_force && duration_ != 0 && duration_ != kInfinite) {
+        period = duration_;
+    } else if (is_periodic(type_)) {
+        period = periodic_.period == 0 ? kDefaultPeriod : periodic_.period;
+        phase_offset_ = static_cast<std::uint32_t>((static_cast<std::uint64_t>(periodic_.phase % 36000) << 32) / 36000);
+    }
+    phase_step_ = period == 0 ? 0 : ((std::uint64_t{1} << 48) + period - 1) / period;
+}
+
+std::uint32_t Effect::phase_at(std::uint64_t now_us) const noexcept {
+    // The step is 2^48 per period, so the product wraps to exactly the phase within the period
+    const std::uint64_t since = now_us > phase_anchor_us_ ? now_us - phase_anchor_us_ : 0;
+    return anchor_phase_ + static_cast<std::uint32_t>((since * phase_step_) >> 16);
+}
+
+void Effect::restart_phase() noexcept {
+    phase_anchor_us_ = start_time_us_ + start_delay_;
+    anchor_phase_ = phase_offset_;
+}
+
+void EffectBatch::reserve(std::size_t effects) {
+    if (effects > origin_.size()) {
+        resize_forces(effects);
+    }
+    if (effects > condition_from_.size()) {
+        resize_conditions(effects);
+    }
+}
+
+void EffectBatch::clear() noexcept {
+    force_count_ = 0;
+    condition_count_ = 0;
+}
+
+void EffectBatch::resize_forces(std::size_t capacity) {
+    active_from_.resize(capacity);
+    active_until_.resize(capacity);
+    origin_.resize(capacity);
+    waveform_.resize(capacity);
+    time_varying_.resize(capacity);
+    base_.resize(capacity);
+    amplitude_.resize(capacity);
+    phase_anchor_.resize(capacity);
+    anchor_phase_.resize(capacity);
+    phase_step_.resize(capacity);
+    attack_time_.resize(capacity);
+    attack_level_.resize(capacity);
+    attack_slope_.resize(capacity);
+    fade_start_.resize(capacity);
+    fade_slope_.resize(capacity);
+    direction_.resize(capacity);
+    gain_.resize(capacity);
+}
+
+void EffectBatch::resize_conditions(std::size_t capacity) {
+    condition_from_.resize(capacity);
+    condition_until_.resize(capacity);
+    spring_.resize(capacity);
+    damper_.resize(capacity);
+    for (std::vector<std::uint8_t>& level : levels_) {
+        level.resize(capacity);
+    }
+}
+
+void EffectBatch::add(const Effect& effect, std::uint32_t device_gain) {
+    if (!effect.started_ || effect.type_ == EffectType::unknown) {
+        return;
+    }
+
+    const bool forever = effect.runs_forever();
+    const std::uint64_t total_duration = forever ? 0 : static_cast<std::uint64_t>(effect.duration_) * effect.iterations_;
+    const std::uint64_t origin = effect.start_time_us_ + effect.start_delay_;
+    const std::uint64_t active_from = effect.start_delay_ == 0 ? 0 : origin;
+    const std::uint64_t active_until = forever ? std::numeric_limits<std::uint64_t>::max() : origin + total_duration;
+
+    if (is_condition(effect.type_)) {
+        if (condition_count_ == condition_from_.size()) {
+            resize_conditions(condition_count_ < kMinimumCapacity ? kMinimumCapacity : condition_count_ * 2);
+        }
+        const std::size_t i = condition_count_++;
+        g923bridge::WheelStatePayload levels{};
+        effect.apply_condition(levels, device_gain);
+        condition_from_[i] = active_from;
+        condition_until_[i] = active_until;
+        const std::uint8_t values[kLevelCount + 2] = {
+            levels.spring_k1,
+            levels.spring_k2,
+            levels.spring_sat1,
+            levels.spring_sat2,
+            levels.spring_deadband_left,
+            levels.spring_deadband_right,
+            levels.spring_clip,
+            levels.damper_force_positive,
+            levels.damper_force_negative,
+            levels.damper_saturation_positive,
+            levels.damper_saturation_negative,
+            levels.custom_spring_enabled,
+            levels.damper_enabled,
+        };
+        // Column pointers first, since each byte store could otherwise alias them
+        std::uint8_t* columns[kLevelCount + 2];
+        for (std::size_t level = 0; level < kLevelCount; ++level) {
+            columns[level] = levels_[level].data();
+        }
+        columns[kLevelCount] = spring_.data();
+        columns[kLevelCount + 1] = damper_.data();
+        for (std::size_t level = 0; level < kLevelCount + 2; ++level) {
+            columns[level][i] = values[level];
+        }
+        return;
+    }
+
+    if (force_count_ == origin_.size()) {
+        resize_forces(force_count_ < kMinimumCapacity ? kMinimumCapacity : force_count_ * 2);
+    }
+    const std::size_t i = force_count_++;
+    active_from_[i] = active_from;
+    active_until_[i] = active_until;
+    origin_[i] = origin;
+    waveform_[i] = Waveform::ramp;
+    base_[i] = 0;
+    amplitude_[i] = 0;
+
+    // A constant force, or a ramp without a finite duration, is a ramp that never moves
+    if (effect.type_ == EffectType::constant_force) {
+        base_[i] = effect.constant_force_.magnitude;
+    } else if (effect.type_ == EffectType::ramp_force) {
+        if (effect.phase_step_ == 0) {
+            base_[i] = effect.ramp_force_.end;
+        } else {
+            base_[i] = effect.ramp_force_.start;
+            amplitude_[i] = clamp_i32(static_cast<std::int64_t>(effect.ramp_force_.end) - effect.ramp_force_.start,
+                                      std::numeric_limits<std::int32_t>::min(),
+                                      std::numeric_limits<std::int32_t>::max());
+        }
+    } else {
+        base_[i] = effect.periodic_.offset;
+        amplitude_[i] = clamp_i32(effect.periodic_.magnitude, 0, std::numeric_limits<std::int32_t>::max());
+        switch (effect.type_) {
+            case EffectType::square:
+                waveform_[i] = Waveform::square;
+                break;
+            case EffectType::triangle:
+                waveform_[i] = Waveform::triangle;
+                break;
+            case EffectType::sawtooth_up:
+                waveform_[i] = Waveform::sawtooth_up;
+                break;
+            case EffectType::sawtooth_down:
+                waveform_[i] = Waveform::sawtooth_down;
+                break;
+            default:
+                waveform_[i] = Waveform::sine;
+                break;
+        }
+    }
+    phase_anchor_[i] = effect.phase_anchor_us_;
+    anchor_phase_[i] = effect.anchor_phase_;
+    phase_step_[i] = effect.phase_step_;
+
+    attack_time_[i] = effect.envelope_enabled_ ? effect.envelope_.attack_time : 0;
+    attack_level_[i] = effect.attack_level_q16_;
+    attack_slope_[i] = effect.attack_slope_q16_;
+    fade_start_[i] = std::numeric_limits<std::uint64_t>::max();
+    fade_slope_[i] = effect.fade_slope_q16_;
+    const std::uint32_t fade_time = effect.envelope_.fade_time;
+    if (effect.envelope_enabled_ && effect.duration_ != kInfinite && fade_time > 0 && total_duration > 0) {
+        fade_start_[i] = total_duration > fade_time ? total_duration - fade_time : 0;
+    }
+
+    direction_[i] = effect.direction_q16_;
+    gain_[i] = static_cast<std::int64_t>(effect.effect_gain_) * clamp_nominal(device_gain) * kUnity /
+               (static_cast<std::int64_t>(kNominalMax) * kNominalMax);
+    // Last: a byte store may alias any column pointer, so the compiler would reload them after it
+    time_varying_[i] = effect.has_time_varying_force() ? 1 : 0;
+}
+
+bool EffectBatch::has_time_varying_force(std::uint64_t now_us) const noexcept {
+    for (std::size_t i = 0; i < force_count_; ++i) {
+        if (time_varying_[i] && now_us < active_until_[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::int64_t EffectBatch::sample(Waveform waveform, std::uint32_t phase) {
+    const std::int64_t midpoint = std::int64_t{1} << 31;
+    switch (waveform) {
+        case Waveform::ramp:
+            return phase >> 16;
+        case Waveform::square:
+            return phase < midpoint ? kUnity : -kUnity;
+        case Waveform::triangle: {
+            const std::int64_t distance = phase < midpoint ? midpoint - phase : phase - midpoint;
+            return kUnity - (distance >> 14);
+        }
+        case Waveform::sawtooth_up:
+            return static_cast<std::int64_t>(phase >> 15) - kUnity;
+        case Waveform::sawtooth_down:
+            return kUnity - static_cast<std::int64_t>(phase >> 15);
+        case Waveform::sine:
+            break;
+    }
+
+    const std::uint32_t index = phase >> (32 - kSineTableBits);
+    const std::int64_t fraction = (phase >> (16 - kSineTableBits)) & 0xFFFF;
+    const std::int64_t low = kSineTable.values[index];
+    return low + mul_q16(kSineTable.values[index + 1] - low, fraction);
+}
+
+void EffectBatch::evaluate(g923bridge::WheelStatePayload& payload, std::uint64_t now_us) const {
+    std::int64_t constant_force = payload.constant_force_magnitude;
+    for (std::size_t i = 0; i < force_count_; ++i) {
+        if (now_us < active_from_[i] || now_us >= active_until_[i]) {
+            continue;
+        }
+
+        const std::uint64_t elapsed = now_us > origin_[i] ? now_us - origin_[i] : 0;
+        const std::uint64_t since_anchor = now_us > phase_anchor_[i] ? now_us - phase_anchor_[i] : 0;
+        const std::uint32_t phase = anchor_phase_[i] + static_cast<std::uint32_t>((since_anchor * phase_step_[i]) >> 16);
+        const std::int64_t raw = base_[i] + mul_q16(amplitude_[i], sample(waveform_[i], phase));
+
+        std::int64_t envelope = kUnity;
+        if (elapsed < attack_time_[i]) {
+            envelope = attack_level_[i] + mul_q16(static_cast<std::int64_t>(elapsed), attack_slope_[i]);
+        } else if (elapsed >= fade_start_[i]) {
+            envelope = kUnity + mul_q16(static_cast<std::int64_t>(elapsed - fade_start_[i]), fade_slope_[i]);
+        }
+
+        const std::int64_t directed = clamp_nominal_force(mul_q16(mul_q16(raw, envelope), direction_[i]));
+        const std::int64_t force = mul_q16(directed, gain_[i]);
+        if (force != 0) {
+            payload.constant_force_enabled = 1;
+            constant_force = clamp_nominal_force(constant_force + force);
+        }
+    }
+    payload.constant_force_magnitude = static_cast<std::int16_t>(constant_force);
+
+    for (std::size_t i = 0; i < condition_count_; ++i) {
+        const std::uint8_t mask = (now_us >= condition_from_[i] && now_us < condition_until_[i]) ? 0xFF : 0;
+        payload.custom_spring_enabled |= spring_[i] & mask;
+        payload.damper_enabled |= damper_[i] & mask;
+        payload.spring_k1 = max_u8(payload.spring_k1, levels_[spring_k1][i] & mask);
+        payload.spring_k2 = max_u8(payload.spring_k2, levels_[spring_k2][i] & mask);
+        payload.spring_sat1 = max_u8(payload.spring_sat1, levels_[spring_sat1][i] & mask);
+        payload.spring_sat2 = max_u8(payload.spring_sat2, levels_[spring_sat2][i] & mask);
+        payload.spring_deadband_left = max_u8(payload.spring_deadband_left, levels_[spring_deadband_left][i] & mask);
+        payload.spring_deadband_right = max_u8(payload.spring_deadband_right, levels_[spring_deadband_right][i] & mask);
+        payload.spring_clip = max_u8(payload.spring_clip, levels_[spring_clip][i] & mask);
+        payload.damper_force_positive = max_u8(payload.damper_force_positive, levels_[damper_force_positive][i] & mask);
+        payload.damper_force_negative = max_u8(payload.damper_force_negative, levels_[damper_force_negative][i] & mask);
+        payload.damper_saturation_positive =
+            max_u8(payload.damper_saturation_positive, levels_[damper_saturation_positive][i] & mask);
+        payload.damper_saturation_negative =
+            max_u8(payload.damper_saturation_negative, levels_[damper_saturation_negative][i] & mask);
+    }
+}
+
+void apply_autocenter_fallback(g923bridge::WheelStatePayload& payload, std::uint32_t device_gain) {
+    constexpr std::uint32_t kAutocenterFallbackNominal = 3200;
+    if (payload.custom_spring_enabled) {
+        return;
+    }
+
+    payload.autocenter_enabled = 1;
+    payload.autocenter_force = max_u8(
+        payload.autocenter_force,
+        scale_byte(static_cast<std::int32_t>(apply_unsigned_gain(device_gain, kAutocenterFallbackNominal))));
+    payload.autocenter_slope = max_u8(payload.autocenter_slope, 4);
+}
+
+bool has_state(const g923bridge::WheelStatePayload& payload) noexcept {
+    return payload.autocenter_enabled || payload.custom_spring_enabled || payload.damper_enabled ||
+           payload.constant_force_enabled;
+}
+
+OutputFilter::Action OutputFilter::filter(const g923bridge::WheelStatePayload& payload) {
+    if (!has_state(payload)) {
+        have_last_payload_ = false;
+        if (!last_sent_has_state_) {
+            return Action::none;
+        }
+        last_sent_has_state_ = false;
+        last_payload_ = g923bridge::WheelStatePayload{};
+        return Action::send_stop_all;
+    }
+
+    last_sent_has_state_ = true;
+    if (have_last_payload_ && std::memcmp(&payload, &last_payload_, sizeof(payload)) == 0) {
+        return Action::none;
+    }
+
+    last_payload_ = payload;
+    have_last_payload_ = true;
+    return Action::send_state;
+}
+
+void OutputFilter::reset() noexcept {
+    have_last_payload_ = false;
+    last_sent_has_state_ = false;
+    last_payload_ = g923bridge::WheelStatePayload{};
+}
+
+}  // namespace effect_engine
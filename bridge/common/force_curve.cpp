@@ -0,0 +1,76 @@
+#include "force_curve.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace g923bridge {
+
+float map_constant_magnitude_to_curve(std::int16_t signed_magnitude) {
+    constexpr int kNominalForceMax = 10000;
+    constexpr int kInputDeadzone = 2;
+    constexpr float kLowRangeReference = 64.0f;
+    constexpr float kLowRangeExponent = 0.60f;
+    constexpr float kLowRangeMaxOutput = 90.0f;
+    constexpr float kHighRangeGain = 2.0f;
+
+    const int magnitude = std::abs(static_cast<int>(signed_magnitude));
+    if (magnitude <= kInputDeadzone) {
+        return 0.0f;
+    }
+
+    const float low_normalized = std::min(
+        1.0f, static_cast<float>(magnitude - kInputDeadzone) / (kLowRangeReference - static_cast<float>(kInputDeadzone)));
+    const float low_curve = std::pow(low_normalized, kLowRangeExponent) * kLowRangeMaxOutput;
+
+    const float high_normalized = std::min(1.0f, static_cast<float>(magnitude) / static_cast<float>(kNominalForceMax));
+    const float high_curve = std::sqrt(high_normalized) * 127.0f * kHighRangeGain;
+
+    const float curve = std::min(127.0f, std::max(low_curve, high_curve));
+    return signed_magnitude < 0 ? -curve : curve;
+}
+
+int map_constant_magnitude_to_level(std::int16_t signed_magnitude) {
+    const int level = static_cast<int>(std::lround(map_constant_magnitude_to_curve(signed_magnitude)));
+    return std::min(127, std::max(-127, level));
+}
+
+int map_constant_curve_to_hires_level(float curve) {
+    constexpr float kHiresPerLevel = 32767.0f / 127.0f;
+    const int level = static_cast<int>(std::lround(curve * kHiresPerLevel));
+    return std::min(32767, std::max(-32767, level));
+}
+
+int apply_constant_slew_limiter(int target_level, bool have_last_level, int last_level) {
+    if (!have_last_level) {
+        return target_level;
+    }
+
+    constexpr int kMaxStepSameDirection = 24;
+    constexpr int kMaxStepSignFlip = 10;
+    constexpr int kMicroFlipGate = 8;
+
+    if (target_level != 0 && last_level != 0 &&
+        (target_level * last_level) < 0 &&
+        std::abs(target_level) <= kMicroFlipGate &&
+        std::abs(last_level) <= kMicroFlipGate) {
+        return 0;
+    }
+
+    int limited = target_level;
+    const int max_step =
+        ((target_level != 0 && last_level != 0 && (target_level * last_level) < 0) ? kMaxStepSignFlip : kMaxStepSameDirection);
+
+    if (limited > last_level + max_step) {
+        limited = last_level + max_step;
+    } else if (limited < last_level - max_step) {
+        limited = last_level - max_step;
+    }
+
+    if (std::abs(limited) <= 1) {
+        limited = 0;
+    }
+
+    return limited;
+}
+
+}  // namespace g923bridge
@@ -0,0 +1,382 @@
+#include "wheel_output_worker.hpp"
+#include "alloc_tracker.hpp"
+#include "logger.hpp"
+#include "trace_zones.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+
+WheelCommand WheelCommand::custom_spring(std::uint8_t d1, std::uint8_t d2, std::uint8_t k1, std::uint8_t k2,
+                                         std::uint8_t s1, std::uint8_t s2, std::uint8_t clip) {
+    WheelCommand command;
+    command.type = Type::custom_spring;
+    command.args[0] = d1;
+    command.args[1] = d2;
+    command.args[2] = k1;
+    command.args[3] = k2;
+    command.args[4] = s1;
+    command.args[5] = s2;
+    command.args[6] = clip;
+    return command;
+}
+
+WheelCommand WheelCommand::damper(std::uint8_t k1, std::uint8_t k2, std::uint8_t s1, std::uint8_t s2) {
+    WheelCommand command;
+    command.type = Type::damper;
+    command.args[0] = k1;
+    command.args[1] = k2;
+    command.args[2] = s1;
+    command.args[3] = s2;
+    return command;
+}
+
+WheelCommand WheelCommand::enable_autocenter() {
+    WheelCommand command;
+    command.type = Type::enable_autocenter;
+    return command;
+}
+
+WheelCommand WheelCommand::disable_autocenter() {
+    WheelCommand command;
+    command.type = Type::disable_autocenter;
+    return command;
+}
+
+WheelCommand WheelCommand::autocenter_spring(std::uint8_t k1, std::uint8_t k2, std::uint8_t clip) {
+    WheelCommand command;
+    command.type = Type::autocenter_spring;
+    command.args[0] = k1;
+    command.args[1] = k2;
+    command.args[2] = clip;
+    return command;
+}
+
+WheelCommand WheelCommand::constant_force(std::uint8_t raw_level, std::int16_t hires_level) {
+    WheelCommand command;
+    command.type = Type::constant_force;
+    command.args[0] = raw_level;
+    command.level = hires_level;
+    return command;
+}
+
+WheelCommand WheelCommand::led_pattern(std::uint8_t pattern) {
+    WheelCommand command;
+    command.type = Type::led_pattern;
+    command.args[0] = pattern;
+    return command;
+}
+
+WheelCommand WheelCommand::stop_forces() {
+    WheelCommand command;
+    command.type = Type::stop_forces;
+    return command;
+}
+
+void WheelOutputStats::accumulate(const WheelOutputStats& other) {
+    batches += other.batches;
+    commands += other.commands;
+    failures += other.failures;
+    coalesced += other.coalesced;
+    total_latency_us += other.total_latency_us;
+    max_latency_us = std::max(max_latency_us, other.max_latency_us);
+    last_latency_us = std::max(last_latency_us, other.last_latency_us);
+    total_write_us += other.total_write_us;
+    queue_depth += other.queue_depth;
+    healthy = healthy && other.healthy;
+    service_time_us = std::max(service_time_us, other.service_time_us);
+    device_capacity_hz += other.device_capacity_hz;
+    force_cap_hz += other.force_cap_hz;
+    led_cap_hz += other.led_cap_hz;
+    deferrals += other.deferrals;
+}
+
+WheelOutputWorker::WheelOutputWorker(std::unique_ptr<WheelController> wheel, std::size_t index,
+                                     BridgeMetrics* metrics)
+    : wheel_(std::move(wheel)), index_(index), metrics_(metrics), busy_(false), stop_requested_(false), consecutive_failures_(0) {
+    pending_.reserve(kQueueCapacity);
+    executing_.reserve(kQueueCapacity);
+    publish_governor_locked();
+    thread_ = std::thread(&WheelOutputWorker::run, this);
+}
+
+WheelOutputWorker::~WheelOutputWorker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_requested_ = true;
+    }
+    queue_ready_.notify_one();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void WheelOutputWorker::submit(const WheelCommand* commands, std::size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.empty()) {
+            pending_since_ = clock::now();
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            enqueue_locked(commands[i]);
+        }
+        stats_.queue_depth = pending_.size();
+    }
+    queue_ready_.notify_one();
+}
+
+bool WheelOutputWorker::wait_idle(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return queue_drained_.wait_for(lock, timeout, [this] { return pending_.empty() && !busy_; });
+}
+
+bool WheelOutputWorker::is_healthy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_.healthy;
+}
+
+WheelOutputStats WheelOutputWorker::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void WheelOutputWorker::run() {
+    Logger::prepare_thread();
+    char thread_name[32];
+    std::snprintf(thread_name, sizeof(thread_name), "wheel output %zu", index_);
+    trace_zones::prepare_thread(thread_name);
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        queue_ready_.wait(lock, [this] { return stop_requested_ || !pending_.empty(); });
+        if (pending_.empty()) {
+            break;
+        }
+
+        // Rate-limited commands stay queued and keep coalescing until their class has budget
+        if (!stop_requested_) {
+            const clock::duration wait = time_until_ready_locked(clock::now());
+            if (wait > clock::duration::zero()) {
+                governor_.note_deferral();
+                queue_ready_.wait_for(lock, wait,
+                                      [this] { return stop_requested_ || last_stop_locked() != pending_.end(); });
+                continue;
+            }
+        }
+
+        const clock::time_point taken_at = clock::now();
+        const clock::time_point submitted_at = pending_since_;
+        take_ready_commands_locked(taken_at);
+        // Commands of a throttled class stay behind as the next batch, timed from this take
+        if (!pending_.empty()) {
+            pending_since_ = taken_at;
+        }
+        stats_.queue_depth = pending_.size();
+        busy_ = true;
+        lock.unlock();
+
+        std::uint64_t failures = 0;
+        const clock::time_point write_start = clock::now();
+        for (const auto& command : executing_) {
+            NoAllocScope no_alloc("WheelOutputWorker::execute");
+            const clock::time_point command_start = clock::now();
+            const bool success = execute(command);
+            const clock::duration write_time = clock::now() - command_start;
+            governor_.record_write(write_time);
+
+            if (metrics_) {
+                BridgeMetrics::record(metrics_->hid_write, write_time);
+                BridgeMetrics::add(metrics_->commands_sent[static_cast<std::size_t>(command.type)]);
+                if (!success) {
+                    BridgeMetrics::add(metrics_->hid_errors);
+                }
+            }
+
+            // LED updates are cosmetic and never mark the interface as failing
+            if (!success && command.type != WheelCommand::Type::led_pattern) {
+                ++failures;
+            }
+        }
+        const clock::time_point finished_at = clock::now();
+
+        lock.lock();
+        const auto latency_us = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(finished_at - submitted_at).count());
+        const auto write_us = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(finished_at - write_start).count());
+
+        ++stats_.batches;
+        stats_.commands += executing_.size();
+        stats_.failures += failures;
+        stats_.total_latency_us += latency_us;
+        stats_.max_latency_us = std::max(stats_.max_latency_us, latency_us);
+        stats_.last_latency_us = latency_us;
+        stats_.total_write_us += write_us;
+
+        publish_governor_locked();
+
+        consecutive_failures_ = failures == 0 ? 0 : consecutive_failures_ + 1;
+        stats_.healthy = consecutive_failures_ < kUnhealthyAfterFailures;
+
+        executing_.clear();
+        busy_ = false;
+        if (pending_.empty()) {
+            queue_drained_.notify_all();
+        }
+    }
+
+    busy_ = false;
+    queue_drained_.notify_all();
+}
+
+void WheelOutputWorker::enqueue_locked(const WheelCommand& command) {
+    const int command_class = coalesce_class(command.type);
+
+    if (command.type != WheelCommand::Type::stop_forces) {
+        for (auto it = pending_.rbegin(); it != pending_.rend(); ++it) {
+            if (it->type == WheelCommand::Type::stop_forces) {
+                break;
+            }
+            if (coalesce_class(it->type) == command_class) {
+                *it = command;
+                ++stats_.coalesced;
+                return;
+            }
+        }
+    }
+
+    // Back-to-back stops are one stop
+    if (command.type == WheelCommand::Type::stop_forces && !pending_.empty() &&
+        pending_.back().type == WheelCommand::Type::stop_forces) {
+        ++stats_.coalesced;
+        return;
+    }
+
+    // A full queue drops its oldest effect update, never a stop_forces barrier. Only a queue of
+    // nothing but stops has no update to drop, and there the oldest stop repeats the next one.
+    if (pending_.size() >= kQueueCapacity) {
+        const auto evicted = std::find_if(pending_.begin(), pending_.end(), [](const WheelCommand& queued) {
+            return queued.type != WheelCommand::Type::stop_forces;
+        });
+        pending_.erase(evicted == pending_.end() ? pending_.begin() : evicted);
+        ++stats_.coalesced;
+    }
+    pending_.push_back(command);
+}
+
+WheelOutputWorker::clock::duration WheelOutputWorker::time_until_ready_locked(clock::time_point now) {
+    if (last_stop_locked() != pending_.end()) {
+        return clock::duration::zero();
+    }
+
+    bool has_class[static_cast<std::size_t>(OutputGovernor::CommandClass::count)] = {false};
+    for (const auto& command : pending_) {
+        has_class[static_cast<std::size_t>(output_class(command.type))] = true;
+    }
+
+    clock::duration wait = clock::duration::max();
+    for (std::size_t i = 0; i < static_cast<std::size_t>(OutputGovernor::CommandClass::count); ++i) {
+        if (has_class[i]) {
+            wait = std::min(wait, governor_.time_until_available(static_cast<OutputGovernor::CommandClass>(i), now));
+        }
+    }
+
+    return wait;
+}
+
+void WheelOutputWorker::take_ready_commands_locked(clock::time_point now) {
+    constexpr std::size_t kClassCount = static_cast<std::size_t>(OutputGovernor::CommandClass::count);
+    bool ready[kClassCount] = {false};
+    std::size_t taken[kClassCount] = {0};
+
+    for (std::size_t i = 0; i < kClassCount; ++i) {
+        ready[i] = stop_requested_ ||
+                   governor_.time_until_available(static_cast<OutputGovernor::CommandClass>(i), now) ==
+                       clock::duration::zero();
+    }
+
+    // A queued stop_forces is never throttled. It goes out at once together with everything
+    // queued ahead of it, so nothing it was meant to stop can run after it.
+    const auto last_stop = last_stop_locked();
+    const auto flush_end = last_stop == pending_.end() ? pending_.begin() : last_stop + 1;
+
+    // Commands of a class that is still throttled keep their relative order in the queue
+    auto keep = pending_.begin();
+    for (auto it = pending_.begin(); it != pending_.end(); ++it) {
+        const auto command_class = static_cast<std::size_t>(output_class(it->type));
+        if (it < flush_end || ready[command_class]) {
+            executing_.push_back(*it);
+            ++taken[command_class];
+        } else {
+            *keep++ = *it;
+        }
+    }
+    pending_.erase(keep, pending_.end());
+
+    for (std::size_t i = 0; i < kClassCount; ++i) {
+        if (taken[i] > 0) {
+            governor_.consume(static_cast<OutputGovernor::CommandClass>(i), taken[i], now);
+        }
+    }
+}
+
+std::vector<WheelCommand>::iterator WheelOutputWorker::last_stop_locked() {
+    const auto last_stop = std::find_if(pending_.rbegin(), pending_.rend(), [](const WheelCommand& command) {
+        return command.type == WheelCommand::Type::stop_forces;
+    });
+    return last_stop == pending_.rend() ? pending_.end() : std::prev(last_stop.base());
+}
+
+void WheelOutputWorker::publish_governor_locked() {
+    const OutputGovernor::Snapshot& governor = governor_.snapshot();
+    stats_.service_time_us = governor.service_time_us;
+    stats_.device_capacity_hz = governor.device_capacity_hz;
+    stats_.force_cap_hz = governor_.class_cap_hz(OutputGovernor::CommandClass::force);
+    stats_.led_cap_hz = governor_.class_cap_hz(OutputGovernor::CommandClass::led);
+    stats_.deferrals = governor.deferrals;
+}
+
+bool WheelOutputWorker::execute(const WheelCommand& command) {
+    const std::uint8_t* args = command.args;
+
+    switch (command.type) {
+        case WheelCommand::Type::custom_spring:
+            return wheel_->set_custom_spring(args[0], args[1], args[2], args[3], args[4], args[5], args[6]);
+        case WheelCommand::Type::damper:
+            return wheel_->set_damper(args[0], args[1], args[2], args[3]);
+        case WheelCommand::Type::enable_autocenter:
+            return wheel_->enable_autocenter();
+        case WheelCommand::Type::disable_autocenter:
+            return wheel_->disable_autocenter();
+        case WheelCommand::Type::autocenter_spring:
+            return wheel_->set_autocenter_spring(args[0], args[1], args[2]);
+        case WheelCommand::Type::constant_force:
+            return wheel_->has_high_resolution_forces() ? wheel_->set_constant_force_level(command.level)
+                                                        : wheel_->set_constant_force(args[0]);
+        case WheelCommand::Type::led_pattern:
+            return wheel_->set_led_pattern(args[0]);
+        case WheelCommand::Type::stop_forces:
+            return wheel_->stop_forces();
+    }
+
+    return false;
+}
+
+OutputGovernor::CommandClass WheelOutputWorker::output_class(WheelCommand::Type type) noexcept {
+    return type == WheelCommand::Type::led_pattern ? OutputGovernor::CommandClass::led
+                                                   : OutputGovernor::CommandClass::force;
+}
+
+int WheelOutputWorker::coalesce_class(WheelCommand::Type type) noexcept {
+    switch (type) {
+        case WheelCommand::Type::enable_autocenter:
+        case WheelCommand::Type::disable_autocenter:
+            return static_cast<int>(WheelCommand::Type::enable_autocenter);
+        default:
+            return static_cast<int>(type);
+    }
+}
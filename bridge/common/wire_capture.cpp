@@ -0,0 +1,305 @@
+#include "wire_capture.hpp"
+#include "utilities.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+bool write_all(int fd, const std::uint8_t* data, std::size_t size) {
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+}  // namespace
+
+WireCaptureWriter::WireCaptureWriter()
+    : fd_(-1), write_pending_(false), flush_requested_(false), stop_requested_(false), records_written_(0),
+        records_dropped_(0) {
+}
+
+WireCaptureWriter::~WireCaptureWriter() {
+    close();
+}
+
+bool WireCaptureWriter::open(const std::string& path) {
+    close();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        Logger::error("Failed to open wire capture %s: %s", path, std::strerror(errno));
+        return false;
+    }
+
+    buffer_.clear();
+    buffer_.reserve(kBufferSize);
+    writing_.clear();
+    writing_.reserve(kBufferSize);
+    write_pending_ = false;
+    flush_requested_ = false;
+    stop_requested_ = false;
+    records_written_ = 0;
+    records_dropped_ = 0;
+
+    const std::uint64_t now_unix_ns = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+            .count());
+
+    // A new file starts with the header; an existing capture keeps growing, one session at a time
+    struct stat info{};
+    if (fstat(fd_, &info) == 0 && info.st_size == 0) {
+        wire_capture::FileHeader header;
+        header.created_unix_ns = now_unix_ns;
+        const auto* bytes = reinterpret_cast<const std::uint8_t*>(&header);
+        buffer_.insert(buffer_.end(), bytes, bytes + sizeof(header));
+    }
+
+    wire_capture::SessionMarker marker;
+    marker.created_unix_ns = now_unix_ns;
+    append_locked(wire_capture::kSessionMarkerType, &marker, sizeof(marker),
+                  static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                 std::chrono::steady_clock::now().time_since_epoch())
+                                                 .count()));
+
+    writer_ = std::thread(&WireCaptureWriter::run_writer, this);
+    Logger::info("Writing wire capture to %s", path);
+    return true;
+}
+
+void WireCaptureWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fd_ < 0) {
+            return;
+        }
+        stop_requested_ = true;
+    }
+    write_ready_.notify_one();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (records_dropped_ > 0) {
+        Logger::warning("Wire capture dropped %llu records while the disk caught up", records_dropped_);
+    }
+    ::close(fd_);
+    fd_ = -1;
+}
+
+void WireCaptureWriter::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ >= 0 && !hand_off_locked()) {
+        flush_requested_ = true;
+    }
+}
+
+bool WireCaptureWriter::is_open() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fd_ >= 0;
+}
+
+std::uint64_t WireCaptureWriter::records_written() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return records_written_;
+}
+
+std::uint64_t WireCaptureWriter::records_dropped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return records_dropped_;
+}
+
+void WireCaptureWriter::record(std::uint16_t type, const void* payload, std::uint32_t payload_size,
+                               std::chrono::steady_clock::time_point received_at) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0 || stop_requested_) {
+        return;
+    }
+
+    const std::uint32_t size = payload ? payload_size : 0;
+    const std::size_t record_size = wire_capture::padded_size(sizeof(wire_capture::RecordHeader) + size);
+    if (buffer_.size() + record_size > kBufferSize && (!hand_off_locked() || record_size > kBufferSize)) {
+        ++records_dropped_;
+        return;
+    }
+
+    append_locked(type, payload, size,
+                  static_cast<std::uint64_t>(
+                      std::chrono::duration_cast<std::chrono::nanoseconds>(received_at.time_since_epoch()).count()));
+    ++records_written_;
+}
+
+void WireCaptureWriter::append_locked(std::uint16_t type, const void* payload, std::uint32_t payload_size,
+                                      std::uint64_t timestamp_ns) {
+    wire_capture::RecordHeader header;
+    header.timestamp_ns = timestamp_ns;
+    header.type = type;
+    header.payload_size = payload_size;
+
+    const std::size_t offset = buffer_.size();
+    buffer_.resize(offset + wire_capture::padded_size(sizeof(header) + payload_size), 0);
+    std::memcpy(buffer_.data() + offset, &header, sizeof(header));
+    if (payload_size > 0) {
+        std::memcpy(buffer_.data() + offset + sizeof(header), payload, payload_size);
+    }
+}
+
+// Swaps the filled buffer with the writer's empty one; false while the writer is still busy
+bool WireCaptureWriter::hand_off_locked() {
+    if (buffer_.empty()) {
+        return true;
+    }
+    if (write_pending_) {
+        return false;
+    }
+
+    buffer_.swap(writing_);
+    write_pending_ = true;
+    flush_requested_ = false;
+    write_ready_.notify_one();
+    return true;
+}
+
+void WireCaptureWriter::run_writer() {
+    Logger::prepare_thread();
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        write_ready_.wait(lock, [this] { return write_pending_ || stop_requested_; });
+        if (!write_pending_) {
+            // Stopping: whatever is still buffered goes out before the thread ends
+            if (buffer_.empty()) {
+                break;
+            }
+            hand_off_locked();
+        }
+
+        const int fd = fd_;
+        lock.unlock();
+        const bool written = write_all(fd, writing_.data(), writing_.size());
+        if (!written) {
+            Logger::error("Wire capture write failed: %s", std::strerror(errno));
+        }
+        lock.lock();
+
+        writing_.clear();
+        write_pending_ = false;
+        if (flush_requested_) {
+            hand_off_locked();
+        }
+    }
+}
+
+void ReplayTimeline::start_session() noexcept {
+    if (session_open_) {
+        previous_sessions_ns_ += last_timestamp_ns_ - session_base_ns_;
+        session_open_ = false;
+    }
+}
+
+std::uint64_t ReplayTimeline::offset_ns(std::uint64_t timestamp_ns) noexcept {
+    if (session_open_ && timestamp_ns < last_timestamp_ns_) {
+        start_session();
+    }
+    if (!session_open_) {
+        session_open_ = true;
+        session_base_ns_ = timestamp_ns;
+        ++sessions_;
+    }
+
+    last_timestamp_ns_ = timestamp_ns;
+    return previous_sessions_ns_ + (timestamp_ns - session_base_ns_);
+}
+
+std::uint64_t ReplayTimeline::recorded_ns() const noexcept {
+    return previous_sessions_ns_ + (session_open_ ? last_timestamp_ns_ - session_base_ns_ : 0);
+}
+
+WireCaptureReader::WireCaptureReader() : data_(nullptr), size_(0), offset_(0), header_{} {
+}
+
+WireCaptureReader::~WireCaptureReader() {
+    close();
+}
+
+bool WireCaptureReader::open(const std::string& path, const char* magic) {
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        Logger::error("Failed to open wire capture %s: %s", path, std::strerror(errno));
+        return false;
+    }
+
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(wire_capture::FileHeader)) {
+        Logger::error("Wire capture %s is empty or unreadable", path);
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        Logger::error("Failed to map wire capture %s: %s", path, std::strerror(errno));
+        return false;
+    }
+
+    data_ = static_cast<const std::uint8_t*>(mapping);
+    size_ = static_cast<std::size_t>(info.st_size);
+    std::memcpy(&header_, data_, sizeof(header_));
+
+    if (std::memcmp(header_.magic, magic, sizeof(header_.magic)) != 0 ||
+        header_.version != wire_capture::kFileVersion ||
+        header_.record_header_size != sizeof(wire_capture::RecordHeader)) {
+        Logger::error("%s is not a supported wire capture", path);
+        close();
+        return false;
+    }
+
+    rewind();
+    return true;
+}
+
+void WireCaptureReader::close() {
+    if (data_) {
+        munmap(const_cast<std::uint8_t*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    offset_ = 0;
+}
+
+bool WireCaptureReader::next(wire_capture::Record& record) {
+    if (!data_ || offset_ + sizeof(wire_capture::RecordHeader) > size_) {
+        return false;
+    }
+
+    wire_capture::RecordHeader header;
+    std::memcpy(&header, data_ + offset_, sizeof(header));
+    const std::size_t record_size = wire_capture::padded_size(sizeof(header) + header.payload_size);
+    if (offset_ + sizeof(header) + header.payload_size > size_) {
+        return false;
+    }
+
+    record.timestamp_ns = header.timestamp_ns;
+    record.type = header.type;
+    record.payload = data_ + offset_ + sizeof(header);
+    record.payload_size = header.payload_size;
+    offset_ += record_size;
+    return true;
+}
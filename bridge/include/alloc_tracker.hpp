@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+// Heap allocation accounting for the force path. A binary opts in by calling
+// alloc_tracker::note_allocation() from its replacement operator new (bench/alloc_hook.cpp,
+// the proxy's HeapAlloc hook); without one the counters stay at zero.
+namespace alloc_tracker {
+
+inline thread_local std::uint64_t t_thread_allocations = 0;
+inline std::atomic<std::uint64_t> g_total_allocations{0};
+
+inline void note_allocation() noexcept {
+    ++t_thread_allocations;
+    g_total_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Allocations made by the calling thread
+inline std::uint64_t thread_allocations() noexcept {
+    return t_thread_allocations;
+}
+
+inline std::uint64_t total_allocations() noexcept {
+    return g_total_allocations.load(std::memory_order_relaxed);
+}
+
+}  // namespace alloc_tracker
+
+// Marks a block that must not touch the heap. Builds with G923_ALLOC_CHECKS abort when the
+// calling thread allocates before the scope ends; other builds compile it away.
+class NoAllocScope {
+public:
+#ifdef G923_ALLOC_CHECKS
+    explicit NoAllocScope(const char* name) noexcept
+        : name_(name), allocations_before_(alloc_tracker::thread_allocations()) {}
+
+    ~NoAllocScope() {
+        const std::uint64_t allocations = alloc_tracker::thread_allocations() - allocations_before_;
+        if (allocations != 0) {
+            std::fprintf(stderr, "%s: %llu heap allocation(s) inside a no-alloc scope\n", name_,
+                         static_cast<unsigned long long>(allocations));
+            std::abort();
+        }
+    }
+#else
+    explicit NoAllocScope(const char*) noexcept {}
+#endif
+
+    NoAllocScope(const NoAllocScope&) = delete;
+    NoAllocScope& operator=(const NoAllocScope&) = delete;
+
+#ifdef G923_ALLOC_CHECKS
+private:
+    const char* name_;
+    std::uint64_t allocations_before_;
+#endif
+};
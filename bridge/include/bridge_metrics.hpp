@@ -0,0 +1,55 @@
+#pragma once
+
+#include "latency_histogram.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Hot-path counters shared by the bridge server and its output workers. Everything is a
+// relaxed atomic, so recording never takes a lock; readers get a consistent-enough snapshot.
+struct BridgeMetrics {
+    static constexpr std::size_t kCommandTypeCount = 8;
+
+    struct Snapshot {
+        LatencyHistogram::Snapshot receive_to_decode;
+        LatencyHistogram::Snapshot decode_to_apply;
+        LatencyHistogram::Snapshot hid_write;
+        LatencyHistogram::Snapshot lock_wait;
+        std::uint64_t deduplicated_states = 0;
+        std::array<std::uint64_t, kCommandTypeCount> commands_sent{};
+        std::uint64_t hid_errors = 0;
+    };
+
+    LatencyHistogram receive_to_decode;
+    LatencyHistogram decode_to_apply;
+    LatencyHistogram hid_write;
+    LatencyHistogram lock_wait;
+    std::atomic<std::uint64_t> deduplicated_states{0};
+    std::array<std::atomic<std::uint64_t>, kCommandTypeCount> commands_sent{};
+    std::atomic<std::uint64_t> hid_errors{0};
+
+    static void add(std::atomic<std::uint64_t>& counter) noexcept {
+        counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void record(LatencyHistogram& histogram, std::chrono::steady_clock::duration elapsed) noexcept {
+        histogram.record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    Snapshot snapshot() const noexcept {
+        Snapshot snapshot;
+        snapshot.receive_to_decode = receive_to_decode.snapshot();
+        snapshot.decode_to_apply = decode_to_apply.snapshot();
+        snapshot.hid_write = hid_write.snapshot();
+        snapshot.lock_wait = lock_wait.snapshot();
+        snapshot.deduplicated_states = deduplicated_states.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < kCommandTypeCount; ++i) {
+            snapshot.commands_sent[i] = commands_sent[i].load(std::memory_order_relaxed);
+        }
+        snapshot.hid_errors = hid_errors.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+};
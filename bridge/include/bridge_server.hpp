@@ -1,9 +1,13 @@
 #pragma once
 
+#include "bridge_metrics.hpp"
 #include "ffb_bridge_protocol.hpp"
 #include "wheel.hpp"
+#include "wheel_output_worker.hpp"
+#include "wire_capture.hpp"
 #include "device.hpp"
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -21,9 +25,15 @@ public:
         std::string client_name;
         std::string wheel_name;
         std::uint64_t packets_received = 0;
+        WheelOutputStats output_total;
+        std::vector<WheelOutputStats> interface_output;
+        BridgeMetrics::Snapshot metrics;
     };
 
-    explicit BridgeServer(std::uint16_t port = g923bridge::kDefaultPort);
+    explicit BridgeServer(std::uint16_t port = g923bridge::kDefaultPort,
+                          WheelBackend wheel_backend = WheelBackend::classic,
+                          std::uint16_t stats_port = g923bridge::kDefaultStatsPort,
+                          std::unique_ptr<HidBackend> hid_backend = nullptr);
     ~BridgeServer();
 
     bool start();
@@ -32,6 +42,15 @@ public:
     bool reconnect_wheel();
     Status status() const;
 
+    // Applies a state as if it had arrived from the game; for in-process harnesses
+    bool apply_wheel_state(const g923bridge::WheelStatePayload& payload);
+    bool apply_led_pattern(std::uint8_t pattern);
+    void stop_wheel_forces();
+
+    // Appends every received message to a binary capture file until stopped
+    bool start_capture(const std::string& path);
+    void stop_capture();
+
 private:
     enum class WheelConnectResult {
         connected,
@@ -49,24 +68,37 @@ private:
 
     void server_loop();
     void run_client_session(int client_fd);
+    void stats_loop();
+    void run_stats_session(int client_fd);
 
-    bool handle_message(int client_fd, const g923bridge::MessageHeader& header);
+    bool handle_message(int client_fd, const g923bridge::MessageHeader& header,
+                        std::chrono::steady_clock::time_point received_at);
+    std::unique_lock<std::mutex> lock_hot_path();
     bool send_hello_ack(int client_fd);
+    bool send_stats_reply(int client_fd);
     bool apply_wheel_state_locked(const g923bridge::WheelStatePayload& payload);
     bool apply_led_pattern_locked(std::uint8_t pattern);
 
     std::uint16_t port_;
+    std::uint16_t stats_port_;
+    WheelBackend wheel_backend_;
     mutable std::mutex mutex_;
     std::atomic<bool> stop_requested_;
     std::thread server_thread_;
+    std::thread stats_thread_;
 
     int listen_fd_;
+    int stats_listen_fd_;
     DeviceManager device_manager_;
-    std::vector<std::unique_ptr<WheelController>> wheels_;
+    BridgeMetrics metrics_;
+    WireCaptureWriter capture_;
+    std::vector<std::unique_ptr<WheelOutputWorker>> wheel_workers_;
     bool wheel_operation_in_progress_ = false;
     bool last_constant_force_active_ = false;
     bool have_last_constant_level_ = false;
     int last_constant_level_ = 0;
+    bool uses_high_resolution_forces_ = false;
+    int last_constant_hires_level_ = 0;
     bool have_last_wheel_state_ = false;
     g923bridge::WheelStatePayload last_wheel_state_{};
 
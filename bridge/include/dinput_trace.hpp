@@ -0,0 +1,105 @@
+#pragma once
+
+#include "effect_engine.hpp"
+#include "ffb_bridge_protocol.hpp"
+#include "wire_capture_format.hpp"
+#include <cstdint>
+
+// DirectInput call trace written by the proxy and replayed on the host. Records use the wire
+// capture container with their own magic; the record type is an EventType and every payload
+// starts with an EventHeader. Field layouts mirror the DirectInput structures without pulling
+// in Windows headers, so the trace can be read anywhere.
+namespace dinput_trace {
+
+constexpr char kFileMagic[8] = {'G', '9', '2', '3', 'D', 'T', 'R', 'C'};
+constexpr std::uint32_t kMaxTypeSpecificBytes = 48;
+
+enum class EventType : std::uint16_t {
+    // A ValueEvent with the proxy's render thread period in microseconds, 0 when Poll drives
+    // time-varying effects
+    device_created = 1,
+    effect_created = 2,
+    effect_added = 3,
+    effect_released = 4,
+    set_parameters = 5,
+    start = 6,
+    stop = 7,
+    set_gain = 8,
+    set_autocenter = 9,
+    ff_command = 10,
+    unacquire = 11,
+    poll = 12,
+    state_sent = 13,
+    stop_sent = 14,
+    // A ValueEvent with the number of events the proxy could not queue for the writer
+    records_dropped = 15,
+    // The render thread evaluated the effects at clock_us and handed the result to the filter;
+    // a state_sent follows when the filter passed it on
+    render_tick = 16,
+};
+
+using EffectType = effect_engine::EffectType;
+using Condition = effect_engine::Condition;
+
+#pragma pack(push, 1)
+
+// clock_us is the proxy's effect clock at the call, so a replay sees the same effect timing
+struct EventHeader {
+    std::uint64_t clock_us = 0;
+    std::uint32_t device_id = 0;
+    std::uint32_t effect_id = 0;
+};
+
+struct EffectCreatedEvent {
+    EventHeader header;
+    std::uint8_t effect_type = 0;
+    std::uint8_t reserved[7] = {0};
+};
+
+struct SetParametersEvent {
+    EventHeader header;
+    std::uint32_t flags = 0;
+    std::uint32_t effect_flags = 0;
+    std::uint32_t gain = 0;
+    std::uint32_t duration = 0;
+    std::uint32_t start_delay = 0;
+    std::uint32_t axis_count = 0;
+    std::int32_t direction[2] = {0, 0};
+    std::uint8_t has_direction = 0;
+    std::uint8_t has_envelope = 0;
+    std::uint8_t has_type_specific = 0;
+    std::uint8_t reserved = 0;
+    std::uint32_t attack_level = 0;
+    std::uint32_t attack_time = 0;
+    std::uint32_t fade_level = 0;
+    std::uint32_t fade_time = 0;
+    // Original cbTypeSpecificParams; at most kMaxTypeSpecificBytes of it are copied
+    std::uint32_t type_specific_size = 0;
+    std::uint8_t type_specific[kMaxTypeSpecificBytes] = {0};
+};
+
+struct StartEvent {
+    EventHeader header;
+    std::uint32_t iterations = 0;
+    std::uint32_t flags = 0;
+};
+
+// Gain, autocenter mode and force feedback commands
+struct ValueEvent {
+    EventHeader header;
+    std::uint32_t value = 0;
+    std::uint32_t reserved = 0;
+};
+
+struct StateSentEvent {
+    EventHeader header;
+    g923bridge::WheelStatePayload payload;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(EventHeader) == 16, "Unexpected trace EventHeader size");
+static_assert(sizeof(SetParametersEvent) == 120, "Unexpected trace SetParametersEvent size");
+static_assert(2 * sizeof(Condition) == kMaxTypeSpecificBytes, "Trace must hold two conditions");
+
+}  // namespace dinput_trace
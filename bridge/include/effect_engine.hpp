@@ -0,0 +1,283 @@
+#pragma once
+
+#include "ffb_bridge_protocol.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// DirectInput force feedback evaluation without the COM layer. Effects keep their DirectInput
+// parameters in plain structs and fold into a WheelStatePayload; the proxy wraps one Effect per
+// IDirectInputEffect, and host tools and benchmarks use the same code directly. Values follow
+// DirectInput units: forces and gains in 0..10000, times in microseconds, angles in 1/100 deg.
+namespace effect_engine {
+
+constexpr std::int32_t kNominalMax = 10000;
+constexpr std::uint32_t kInfinite = 0xFFFFFFFFu;
+constexpr std::uint32_t kDefaultPeriod = 100000;
+constexpr std::uint64_t kPeriodicUpdateIntervalUs = 4000;
+
+// DIEP_* flags understood by Effect::set_parameters
+constexpr std::uint32_t kParamDuration = 0x00000001;
+constexpr std::uint32_t kParamGain = 0x00000004;
+constexpr std::uint32_t kParamDirection = 0x00000040;
+constexpr std::uint32_t kParamEnvelope = 0x00000080;
+constexpr std::uint32_t kParamTypeSpecific = 0x00000100;
+constexpr std::uint32_t kParamStartDelay = 0x00000200;
+constexpr std::uint32_t kParamAll = 0x000003FF;
+constexpr std::uint32_t kParamStart = 0x20000000;
+constexpr std::uint32_t kParamNoRestart = 0x40000000;
+
+// DIEFF_* coordinate flags
+constexpr std::uint32_t kDirectionCartesian = 0x10;
+constexpr std::uint32_t kDirectionPolar = 0x20;
+constexpr std::uint32_t kDirectionSpherical = 0x40;
+
+enum class EffectType : std::uint8_t {
+    unknown = 0,
+    constant_force,
+    ramp_force,
+    square,
+    sine,
+    triangle,
+    sawtooth_up,
+    sawtooth_down,
+    spring,
+    damper,
+    inertia,
+    friction,
+};
+
+// Type-specific layouts, matching DICONDITION, DICONSTANTFORCE, DIRAMPFORCE and DIPERIODIC
+struct Condition {
+    std::int32_t offset = 0;
+    std::int32_t positive_coefficient = 0;
+    std::int32_t negative_coefficient = 0;
+    std::uint32_t positive_saturation = 0;
+    std::uint32_t negative_saturation = 0;
+    std::int32_t dead_band = 0;
+};
+
+struct ConstantForce {
+    std::int32_t magnitude = 0;
+};
+
+struct RampForce {
+    std::int32_t start = 0;
+    std::int32_t end = 0;
+};
+
+struct Periodic {
+    std::uint32_t magnitude = kNominalMax;
+    std::int32_t offset = 0;
+    std::uint32_t phase = 0;
+    std::uint32_t period = kDefaultPeriod;
+};
+
+struct Envelope {
+    std::uint32_t attack_level = 0;
+    std::uint32_t attack_time = 0;
+    std::uint32_t fade_level = 0;
+    std::uint32_t fade_time = 0;
+};
+
+static_assert(sizeof(Condition) == 24, "Condition must match DICONDITION");
+static_assert(sizeof(Periodic) == 16, "Periodic must match DIPERIODIC");
+
+// The parts of a DIEFFECT that SetParameters reads. type_specific points at the game's
+// parameter block and is only read during set_parameters.
+struct EffectUpdate {
+    std::uint32_t flags = 0;
+    std::uint32_t effect_flags = 0;
+    std::uint32_t gain = 0;
+    std::uint32_t duration = 0;
+    std::uint32_t start_delay = 0;
+    std::uint32_t axis_count = 0;
+    bool has_direction = false;
+    std::int32_t direction[2] = {0, 0};
+    const Envelope* envelope = nullptr;
+    const void* type_specific = nullptr;
+    std::uint32_t type_specific_size = 0;
+};
+
+bool is_condition(EffectType type) noexcept;
+bool is_periodic(EffectType type) noexcept;
+const char* effect_type_name(EffectType type) noexcept;
+
+class Effect {
+public:
+    explicit Effect(EffectType type = EffectType::unknown) noexcept;
+
+    EffectType type() const noexcept { return type_; }
+    bool started() const noexcept { return started_; }
+    const ConstantForce& constant_force() const noexcept { return constant_force_; }
+    const RampForce& ramp_force() const noexcept { return ramp_force_; }
+    const Periodic& periodic() const noexcept { return periodic_; }
+
+    void set_parameters(const EffectUpdate& update, std::uint64_t now_us);
+    void start(std::uint32_t iterations, std::uint64_t now_us) noexcept;
+    void stop() noexcept;
+
+    bool has_time_varying_force() const noexcept;
+    // Stops an effect whose duration and iterations have run out
+    void refresh_runtime(std::uint64_t now_us) noexcept;
+    bool is_temporally_active(std::uint64_t now_us) const noexcept;
+
+    std::int32_t compute_force(std::uint64_t now_us, std::uint32_t device_gain) const;
+    // Conditions raise the spring or damper fields to at least their own level; forces add up
+    void apply(g923bridge::WheelStatePayload& payload, std::uint32_t device_gain, std::uint64_t now_us) const;
+
+private:
+    friend class EffectBatch;
+
+    bool runs_forever() const noexcept;
+    bool has_expired(std::uint64_t now_us) const noexcept;
+    float direction_multiplier() const;
+    float envelope_multiplier(std::uint64_t active_elapsed, std::uint64_t total_duration) const;
+    // Raises the condition fields of payload for a spring, damper, friction or inertia effect
+    void apply_condition(g923bridge::WheelStatePayload& payload, std::uint32_t device_gain) const;
+    // Refreshes the fixed-point factors EffectBatch reads after the parameters change
+    void prepare_batch_factors();
+    // Oscillator phase, as a 0..2^32 fraction of the period, advanced from the last anchor
+    std::uint32_t phase_at(std::uint64_t now_us) const noexcept;
+    // Re-anchors the oscillator at the start of the effect with its DIPERIODIC phase
+    void restart_phase() noexcept;
+
+    EffectType type_;
+    bool started_;
+    bool envelope_enabled_;
+    std::uint32_t iterations_;
+    std::uint32_t effect_gain_;
+    std::uint32_t duration_;
+    std::uint32_t start_delay_;
+    std::uint32_t direction_flags_;
+    std::int32_t direction_[2];
+    std::uint64_t start_time_us_;
+    Envelope envelope_;
+    Condition conditions_[2];
+    ConstantForce constant_force_;
+    RampForce ramp_force_;
+    Periodic periodic_;
+
+    // 16.16 factors and per-microsecond slopes, and the 2^32-per-period phase step
+    std::int64_t direction_q16_;
+    std::int64_t attack_level_q16_;
+    std::int64_t attack_slope_q16_;
+    std::int64_t fade_slope_q16_;
+    std::uint64_t phase_step_;
+    std::uint32_t phase_offset_;
+
+    // Where the oscillator's phase was last pinned down. A period or phase change while the
+    // effect runs moves the anchor to that moment, so the wave carries on from where it was.
+    std::uint64_t phase_anchor_us_;
+    std::uint32_t anchor_phase_;
+};
+
+// Started effects flattened into columns for the rebuild and render paths. add() classifies each
+// effect once and folds its gains, direction and envelope into 16.16 fixed-point factors and
+// slopes, and resolves conditions to the payload levels they raise, so evaluate() is one pass
+// over plain arrays per group. Waveforms run as phase accumulators; sine reads an interpolated
+// table instead of std::sin. Results agree with Effect::apply to within a force unit of
+// fixed-point rounding.
+//
+// Columns grow as needed. Callers on a no-allocation path reserve() ahead for the number of
+// effects they track; clear() keeps the storage, and so does copying into a batch reserved for
+// at least as many effects.
+class EffectBatch {
+public:
+    void reserve(std::size_t effects);
+    void clear() noexcept;
+    // Skips stopped effects
+    void add(const Effect& effect, std::uint32_t device_gain);
+    std::size_t size() const noexcept { return force_count_ + condition_count_; }
+
+    // Ramps and waveforms that have not run out by now_us
+    bool has_time_varying_force(std::uint64_t now_us) const noexcept;
+    void evaluate(g923bridge::WheelStatePayload& payload, std::uint64_t now_us) const;
+
+private:
+    enum class Waveform : std::uint8_t {
+        ramp,
+        square,
+        sine,
+        triangle,
+        sawtooth_up,
+        sawtooth_down,
+    };
+
+    enum Level : std::size_t {
+        spring_k1,
+        spring_k2,
+        spring_sat1,
+        spring_sat2,
+        spring_deadband_left,
+        spring_deadband_right,
+        spring_clip,
+        damper_force_positive,
+        damper_force_negative,
+        damper_saturation_positive,
+        damper_saturation_negative,
+        kLevelCount,
+    };
+
+    static constexpr std::size_t kMinimumCapacity = 16;
+
+    // 16.16 sample of one cycle at phase, a 0..2^32 fraction of the period
+    static std::int64_t sample(Waveform waveform, std::uint32_t phase);
+    void resize_forces(std::size_t capacity);
+    void resize_conditions(std::size_t capacity);
+
+    std::size_t force_count_ = 0;
+    std::size_t condition_count_ = 0;
+
+    // Forces: base + amplitude * wave(phase), shaped by envelope, direction and gain, while
+    // active_from <= now < active_until
+    std::vector<std::uint64_t> active_from_;
+    std::vector<std::uint64_t> active_until_;
+    std::vector<std::uint64_t> origin_;
+    std::vector<Waveform> waveform_;
+    std::vector<std::uint8_t> time_varying_;
+    std::vector<std::int32_t> base_;
+    std::vector<std::int32_t> amplitude_;
+    std::vector<std::uint64_t> phase_anchor_;
+    std::vector<std::uint32_t> anchor_phase_;
+    std::vector<std::uint64_t> phase_step_;
+    std::vector<std::uint64_t> attack_time_;
+    std::vector<std::int64_t> attack_level_;
+    std::vector<std::int64_t> attack_slope_;
+    std::vector<std::uint64_t> fade_start_;
+    std::vector<std::int64_t> fade_slope_;
+    std::vector<std::int64_t> direction_;
+    std::vector<std::int64_t> gain_;
+
+    // Conditions: the levels they raise while active
+    std::vector<std::uint64_t> condition_from_;
+    std::vector<std::uint64_t> condition_until_;
+    std::vector<std::uint8_t> spring_;
+    std::vector<std::uint8_t> damper_;
+    std::vector<std::uint8_t> levels_[kLevelCount];
+};
+
+// Device-wide centring spring used when autocenter is on and no effect drives the spring
+void apply_autocenter_fallback(g923bridge::WheelStatePayload& payload, std::uint32_t device_gain);
+bool has_state(const g923bridge::WheelStatePayload& payload) noexcept;
+
+// Decides which rebuilt payloads reach the bridge: changed states are sent, repeats are
+// dropped, and the first empty payload after a state becomes a stop_all.
+class OutputFilter {
+public:
+    enum class Action {
+        none,
+        send_state,
+        send_stop_all,
+    };
+
+    Action filter(const g923bridge::WheelStatePayload& payload);
+    void reset() noexcept;
+
+private:
+    bool last_sent_has_state_ = false;
+    bool have_last_payload_ = false;
+    g923bridge::WheelStatePayload last_payload_{};
+};
+
+}  // namespace effect_engine
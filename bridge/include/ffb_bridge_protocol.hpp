@@ -8,6 +8,10 @@ namespace g923bridge {
 constexpr std::uint32_t kProtocolMagic = 0x47463233;  // "GF23"
 constexpr std::uint16_t kProtocolVersion = 1;
 constexpr std::uint16_t kDefaultPort = 18423;
+constexpr std::uint16_t kDefaultStatsPort = 18424;
+
+constexpr std::size_t kStatsHistogramBuckets = 144;
+constexpr std::size_t kStatsCommandTypes = 8;
 
 enum class MessageType : std::uint16_t {
     hello = 1,
@@ -16,6 +20,8 @@ enum class MessageType : std::uint16_t {
     stop_all = 11,
     ping = 12,
     set_led_pattern = 13,
+    stats_request = 14,
+    stats_reply = 15,
 };
 
 #pragma pack(push, 1)
@@ -70,11 +76,49 @@ struct LedPatternPayload {
     std::uint8_t pattern = 0;
 };
 
+struct StatsHistogram {
+    std::uint64_t count = 0;
+    std::uint64_t total_ns = 0;
+    std::uint64_t max_ns = 0;
+    std::uint64_t buckets[kStatsHistogramBuckets] = {0};
+};
+
+struct StatsReplyPayload {
+    std::uint64_t server_time_ns = 0;
+    std::uint64_t packets_received = 0;
+    std::uint64_t deduplicated_states = 0;
+    std::uint64_t hid_errors = 0;
+    std::uint64_t commands_sent[kStatsCommandTypes] = {0};
+
+    std::uint64_t output_batches = 0;
+    std::uint64_t output_commands = 0;
+    std::uint64_t output_failures = 0;
+    std::uint64_t output_coalesced = 0;
+    std::uint64_t output_deferrals = 0;
+    std::uint32_t output_queue_depth = 0;
+    std::uint32_t device_capacity_hz = 0;
+    std::uint32_t force_cap_hz = 0;
+    std::uint32_t led_cap_hz = 0;
+
+    std::uint8_t listening = 0;
+    std::uint8_t client_connected = 0;
+    std::uint8_t wheel_connected = 0;
+    std::uint8_t wheel_interfaces = 0;
+    char client_name[64] = {0};
+    char wheel_name[64] = {0};
+
+    StatsHistogram receive_to_decode;
+    StatsHistogram decode_to_apply;
+    StatsHistogram hid_write;
+    StatsHistogram lock_wait;
+};
+
 #pragma pack(pop)
 
 static_assert(sizeof(MessageHeader) == 12, "Unexpected MessageHeader size");
 static_assert(sizeof(HelloPayload) == 68, "Unexpected HelloPayload size");
 static_assert(sizeof(HelloAckPayload) == 68, "Unexpected HelloAckPayload size");
+static_assert(sizeof(StatsHistogram) == 24 + 8 * kStatsHistogramBuckets, "Unexpected StatsHistogram size");
 
 template <typename T>
 constexpr std::size_t payload_size() {
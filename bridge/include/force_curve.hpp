@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+namespace g923bridge {
+
+// Maps a DirectInput constant force magnitude (-10000..10000) onto the wheel's response curve:
+// a power law lifts small forces out of the motor's dead zone, a square-root curve covers the rest.
+float map_constant_magnitude_to_curve(std::int16_t signed_magnitude);
+
+// Classic wheels take a signed 8-bit offset from 128
+int map_constant_magnitude_to_level(std::int16_t signed_magnitude);
+
+// HID++ wheels take a 16-bit level, so the curve is scaled instead of rounded to 8 bits.
+int map_constant_curve_to_hires_level(float curve);
+
+// Limits how far the classic level moves per update and mutes tiny sign flips around zero
+int apply_constant_slew_limiter(int target_level, bool have_last_level, int last_level);
+
+}  // namespace g923bridge
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "slot_ring.hpp"
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// Bounded queue of text lines from any number of threads to one writer, on top of SlotRing: a
+// line is formatted straight into a claimed slot, and when the ring is full the new line is
+// dropped and counted instead of waited for.
+class LineRing {
+public:
+    static constexpr std::size_t kSlots = 512;
+    // Including the terminator; longer lines are cut
+    static constexpr std::size_t kLineCapacity = 256;
+
+    // Producer side, safe from any number of threads
+    bool push(const char* line) noexcept {
+        return ring_.push_with([line](char* text) {
+            std::size_t length = 0;
+            while (line[length] && length + 1 < kLineCapacity) {
+                ++length;
+            }
+            std::memcpy(text, line, length);
+            text[length] = '\0';
+            return length;
+        });
+    }
+
+    bool push_format(const char* format, std::va_list args) noexcept {
+        return ring_.push_with([&](char* text) {
+            const int written = std::vsnprintf(text, kLineCapacity, format, args);
+            std::size_t length = written > 0 ? static_cast<std::size_t>(written) : 0;
+            if (length >= kLineCapacity) {
+                length = kLineCapacity - 1;
+            }
+            text[length] = '\0';
+            return length;
+        });
+    }
+
+    // True once half the slots wait for the writer, so producers can wake it before lines drop
+    bool filling() const noexcept { return ring_.filling(); }
+
+    // Writer side, one thread only. Returns the oldest line, NUL-terminated, or nullptr when the
+    // ring is empty or that line is still being written. The text stays valid until pop().
+    const char* front(std::size_t& length) const noexcept { return ring_.front(length); }
+    void pop() noexcept { ring_.pop(); }
+
+    std::uint64_t take_dropped() noexcept { return ring_.take_dropped(); }
+
+private:
+    SlotRing<kSlots, kLineCapacity> ring_;
+};
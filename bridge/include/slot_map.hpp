@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Values addressed by generational handles. Insertion and removal are O(1): values live densely
+// for iteration, removal moves the last value into the hole, and each slot remembers where its
+// value sits. Erasing bumps the slot's generation, so a handle kept past its value's removal
+// no longer finds anything, even after the slot is reused.
+template <typename T>
+class SlotMap {
+public:
+    struct Handle {
+        std::uint32_t index = kNoSlot;
+        std::uint32_t generation = 0;
+    };
+
+    void reserve(std::size_t count) {
+        slots_.reserve(count);
+        values_.reserve(count);
+        value_slots_.reserve(count);
+    }
+
+    Handle insert(const T& value) {
+        std::uint32_t index = free_head_;
+        if (index == kNoSlot) {
+            index = static_cast<std::uint32_t>(slots_.size());
+            slots_.push_back(Slot{});
+        } else {
+            free_head_ = slots_[index].position;
+        }
+
+        Slot& slot = slots_[index];
+        slot.position = static_cast<std::uint32_t>(values_.size());
+        slot.occupied = true;
+        values_.push_back(value);
+        value_slots_.push_back(index);
+        return Handle{index, slot.generation};
+    }
+
+    // Returns false for a handle whose value is already gone
+    bool erase(Handle handle) {
+        if (!find(handle)) {
+            return false;
+        }
+
+        Slot& slot = slots_[handle.index];
+        const std::uint32_t last = static_cast<std::uint32_t>(values_.size() - 1);
+        if (slot.position != last) {
+            values_[slot.position] = values_[last];
+            value_slots_[slot.position] = value_slots_[last];
+            slots_[value_slots_[slot.position]].position = slot.position;
+        }
+        values_.pop_back();
+        value_slots_.pop_back();
+
+        slot.occupied = false;
+        ++slot.generation;
+        slot.position = free_head_;
+        free_head_ = handle.index;
+        return true;
+    }
+
+    T* find(Handle handle) {
+        if (handle.index >= slots_.size()) {
+            return nullptr;
+        }
+        const Slot& slot = slots_[handle.index];
+        return slot.occupied && slot.generation == handle.generation ? &values_[slot.position] : nullptr;
+    }
+
+    std::size_t size() const noexcept { return values_.size(); }
+    bool empty() const noexcept { return values_.empty(); }
+
+    // Dense iteration in no particular order; removal reorders
+    T* begin() noexcept { return values_.data(); }
+    T* end() noexcept { return values_.data() + values_.size(); }
+    const T* begin() const noexcept { return values_.data(); }
+    const T* end() const noexcept { return values_.data() + values_.size(); }
+
+private:
+    static constexpr std::uint32_t kNoSlot = 0xFFFFFFFFu;
+
+    // position is the value's index while occupied and the next free slot otherwise
+    struct Slot {
+        std::uint32_t position = kNoSlot;
+        std::uint32_t generation = 0;
+        bool occupied = false;
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<T> values_;
+    std::vector<std::uint32_t> value_slots_;
+    std::uint32_t free_head_ = kNoSlot;
+};
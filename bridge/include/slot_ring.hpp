@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded queue of small byte records from any number of threads to one reader. Pushing never
+// blocks, locks or allocates: a record is written straight into a claimed slot, and when every
+// slot still holds a record the reader has not taken, the new record is dropped and counted.
+//
+// Each slot carries a sequence number that says whose turn it is, so producers claim slots with
+// one compare-exchange and the reader can tell a finished record from one still being written.
+template <std::size_t Slots, std::size_t SlotBytes>
+class SlotRing {
+public:
+    static constexpr std::size_t kSlots = Slots;
+    static constexpr std::size_t kSlotBytes = SlotBytes;
+
+    SlotRing() noexcept {
+        for (std::size_t i = 0; i < kSlots; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    SlotRing(const SlotRing&) = delete;
+    SlotRing& operator=(const SlotRing&) = delete;
+
+    // Producer side, safe from any number of threads. fill(char* data) writes at most kSlotBytes
+    // into the slot and returns how many bytes the record holds.
+    template <typename Fill>
+    bool push_with(Fill&& fill) noexcept {
+        std::uint64_t position = next_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[position % kSlots];
+            const std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence == position) {
+                if (next_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    const std::size_t length = fill(slot.data);
+                    slot.length = length < kSlotBytes ? length : kSlotBytes;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (sequence < position) {
+                // The slot still holds the record pushed kSlots positions ago
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                position = next_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // True once half the slots wait for the reader, so producers can wake it before records drop
+    bool filling() const noexcept {
+        return next_.load(std::memory_order_relaxed) - read_.load(std::memory_order_relaxed) >= kSlots / 2;
+    }
+
+    // Reader side, one thread only. Returns the oldest record, or nullptr when the ring is empty
+    // or that record is still being written. The bytes stay valid until pop().
+    const char* front(std::size_t& length) const noexcept {
+        const std::uint64_t read = read_.load(std::memory_order_relaxed);
+        const Slot& slot = slots_[read % kSlots];
+        if (slot.sequence.load(std::memory_order_acquire) != read + 1) {
+            return nullptr;
+        }
+        length = slot.length;
+        return slot.data;
+    }
+
+    void pop() noexcept {
+        const std::uint64_t read = read_.load(std::memory_order_relaxed);
+        slots_[read % kSlots].sequence.store(read + kSlots, std::memory_order_release);
+        read_.store(read + 1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t take_dropped() noexcept { return dropped_.exchange(0, std::memory_order_relaxed); }
+
+private:
+    static_assert((kSlots & (kSlots - 1)) == 0, "slot count must be a power of two");
+
+    // sequence == position: free for the producer claiming that position
+    // sequence == position + 1: holds a finished record for the reader
+    struct Slot {
+        std::atomic<std::uint64_t> sequence{0};
+        std::size_t length = 0;
+        char data[kSlotBytes];
+    };
+
+    Slot slots_[kSlots];
+    std::atomic<std::uint64_t> next_{0};
+    std::atomic<std::uint64_t> read_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+};
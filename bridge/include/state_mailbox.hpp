@@ -0,0 +1,128 @@
+#pragma once
+
+#include "ffb_bridge_protocol.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Latest-value handoff between the threads that compute wheel states and the one thread that
+// transmits them. Publishers never block, lock or allocate; a state they publish replaces any
+// the sender has not taken yet. stop_all is a sticky request that survives until taken and
+// drops every state published before it.
+//
+// Each publish claims a ticket and writes its state into slot ticket % kSlots under a sequence
+// number, so the sender can tell a finished state from one still being written or overwritten.
+class StateMailbox {
+public:
+    static constexpr std::size_t kSlots = 16;
+
+    struct Taken {
+        bool stop_all = false;
+        bool has_state = false;
+        g923bridge::WheelStatePayload state{};
+    };
+
+    StateMailbox() = default;
+    StateMailbox(const StateMailbox&) = delete;
+    StateMailbox& operator=(const StateMailbox&) = delete;
+
+    // Publisher side, safe from any number of threads. Only retries when another publisher is
+    // mid-write in the claimed slot, which takes more concurrent publishers than slots.
+    void publish(const g923bridge::WheelStatePayload& state) noexcept {
+        std::uint64_t words[kWords] = {};
+        std::memcpy(words, &state, sizeof(state));
+        published_.fetch_add(1, std::memory_order_relaxed);
+
+        while (true) {
+            const std::uint64_t ticket = next_ticket_.fetch_add(1);
+            Slot& slot = slots_[ticket % kSlots];
+            if (slot.writing.exchange(true, std::memory_order_acquire)) {
+                continue;
+            }
+
+            slot.sequence.store(ticket * 2 + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (std::size_t i = 0; i < kWords; ++i) {
+                slot.words[i].store(words[i], std::memory_order_relaxed);
+            }
+            slot.sequence.store(ticket * 2 + 2, std::memory_order_release);
+            slot.writing.store(false, std::memory_order_release);
+            return;
+        }
+    }
+
+    // Racing stops can store their tickets in either order, so the mark only ever rises
+    void request_stop_all() noexcept {
+        const std::uint64_t stop_after = next_ticket_.fetch_add(1) + 1;
+        std::uint64_t current = stop_after_.load();
+        while (current < stop_after && !stop_after_.compare_exchange_weak(current, stop_after)) {
+        }
+    }
+
+    // Sender side, one thread only. Returns false when nothing was published since the last take.
+    bool take(Taken& taken) noexcept {
+        taken = Taken{};
+        const std::uint64_t end = next_ticket_.load();
+        const std::uint64_t first = end - taken_until_ > kSlots ? end - kSlots : taken_until_;
+
+        std::uint64_t state_ticket = 0;
+        for (std::uint64_t ticket = end; ticket > first; --ticket) {
+            if (read_slot(ticket - 1, taken.state)) {
+                taken.has_state = true;
+                state_ticket = ticket - 1;
+                break;
+            }
+        }
+
+        // Read after the states: a stop requested before a state we saw is visible here
+        const std::uint64_t stop_after = stop_after_.exchange(0);
+        taken.stop_all = stop_after != 0;
+        if (taken.has_state && stop_after > state_ticket) {
+            taken.has_state = false;
+        }
+
+        const std::uint64_t consumed = taken.has_state ? state_ticket + 1 : stop_after;
+        if (consumed > taken_until_) {
+            taken_until_ = consumed;
+        }
+        return taken.has_state || taken.stop_all;
+    }
+
+    std::uint64_t published() const noexcept { return published_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::size_t kWords = (sizeof(g923bridge::WheelStatePayload) + 7) / 8;
+    static_assert(std::is_trivially_copyable<g923bridge::WheelStatePayload>::value,
+                  "states are copied through atomic words");
+
+    struct Slot {
+        std::atomic<bool> writing{false};
+        std::atomic<std::uint64_t> sequence{0};
+        std::atomic<std::uint64_t> words[kWords];
+    };
+
+    bool read_slot(std::uint64_t ticket, g923bridge::WheelStatePayload& state) const noexcept {
+        const Slot& slot = slots_[ticket % kSlots];
+        if (slot.sequence.load(std::memory_order_acquire) != ticket * 2 + 2) {
+            return false;
+        }
+        std::uint64_t words[kWords];
+        for (std::size_t i = 0; i < kWords; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != ticket * 2 + 2) {
+            return false;
+        }
+        std::memcpy(&state, words, sizeof(state));
+        return true;
+    }
+
+    Slot slots_[kSlots];
+    std::atomic<std::uint64_t> next_ticket_{0};
+    std::atomic<std::uint64_t> stop_after_{0};
+    std::atomic<std::uint64_t> published_{0};
+    std::uint64_t taken_until_ = 0;
+};
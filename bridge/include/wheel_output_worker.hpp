@@ -0,0 +1,123 @@
+#pragma once
+
+#include "bridge_metrics.hpp"
+#include "output_governor.hpp"
+#include "wheel.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct WheelCommand {
+    enum class Type : std::uint8_t {
+        custom_spring,
+        damper,
+        enable_autocenter,
+        disable_autocenter,
+        autocenter_spring,
+        constant_force,
+        led_pattern,
+        stop_forces,
+    };
+
+    static constexpr std::size_t kTypeCount = static_cast<std::size_t>(Type::stop_forces) + 1;
+
+    Type type = Type::stop_forces;
+    std::uint8_t args[7] = {0};
+    std::int16_t level = 0;
+
+    static WheelCommand custom_spring(std::uint8_t d1, std::uint8_t d2, std::uint8_t k1, std::uint8_t k2,
+                                      std::uint8_t s1, std::uint8_t s2, std::uint8_t clip);
+    static WheelCommand damper(std::uint8_t k1, std::uint8_t k2, std::uint8_t s1, std::uint8_t s2);
+    static WheelCommand enable_autocenter();
+    static WheelCommand disable_autocenter();
+    static WheelCommand autocenter_spring(std::uint8_t k1, std::uint8_t k2, std::uint8_t clip);
+    static WheelCommand constant_force(std::uint8_t raw_level, std::int16_t hires_level);
+    static WheelCommand led_pattern(std::uint8_t pattern);
+    static WheelCommand stop_forces();
+};
+
+static_assert(WheelCommand::kTypeCount == BridgeMetrics::kCommandTypeCount,
+              "BridgeMetrics needs one counter per WheelCommand type");
+
+struct WheelOutputStats {
+    std::uint64_t batches = 0;
+    std::uint64_t commands = 0;
+    std::uint64_t failures = 0;
+    std::uint64_t coalesced = 0;
+    std::uint64_t total_latency_us = 0;
+    std::uint64_t max_latency_us = 0;
+    std::uint64_t last_latency_us = 0;
+    std::uint64_t total_write_us = 0;
+    std::size_t queue_depth = 0;
+    bool healthy = true;
+
+    double service_time_us = 0.0;
+    double device_capacity_hz = 0.0;
+    double force_cap_hz = 0.0;
+    double led_cap_hz = 0.0;
+    std::uint64_t deferrals = 0;
+
+    std::uint64_t mean_latency_us() const noexcept { return batches ? total_latency_us / batches : 0; }
+    void accumulate(const WheelOutputStats& other);
+};
+
+// Owns one wheel interface and replays queued commands on a dedicated thread, so a slow or
+// failing interface only delays its own queue. Commands waiting in the queue are coalesced per
+// effect, keeping the newest value; stop_forces acts as a barrier that later commands never
+// overtake and that a full queue never drops. An OutputGovernor paces the writes to what the
+// interface can absorb; a stop_forces is never held back by it.
+class WheelOutputWorker {
+public:
+    WheelOutputWorker(std::unique_ptr<WheelController> wheel, std::size_t index, BridgeMetrics* metrics = nullptr);
+    ~WheelOutputWorker();
+
+    WheelOutputWorker(const WheelOutputWorker&) = delete;
+    WheelOutputWorker& operator=(const WheelOutputWorker&) = delete;
+
+    void submit(const WheelCommand* commands, std::size_t count);
+    bool wait_idle(std::chrono::milliseconds timeout);
+
+    bool is_healthy() const;
+    WheelOutputStats stats() const;
+    std::size_t index() const noexcept { return index_; }
+    const WheelController& wheel() const noexcept { return *wheel_; }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t kQueueCapacity = 32;
+    static constexpr std::uint32_t kUnhealthyAfterFailures = 3;
+
+    std::unique_ptr<WheelController> wheel_;
+    std::size_t index_;
+    BridgeMetrics* metrics_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable queue_ready_;
+    std::condition_variable queue_drained_;
+    std::vector<WheelCommand> pending_;
+    std::vector<WheelCommand> executing_;
+    clock::time_point pending_since_;
+    bool busy_;
+    bool stop_requested_;
+    std::uint32_t consecutive_failures_;
+    OutputGovernor governor_;
+    WheelOutputStats stats_;
+    std::thread thread_;
+
+    void run();
+    void enqueue_locked(const WheelCommand& command);
+    clock::duration time_until_ready_locked(clock::time_point now);
+    void take_ready_commands_locked(clock::time_point now);
+    std::vector<WheelCommand>::iterator last_stop_locked();
+    void publish_governor_locked();
+    bool execute(const WheelCommand& command);
+
+    static int coalesce_class(WheelCommand::Type type) noexcept;
+    static OutputGovernor::CommandClass output_class(WheelCommand::Type type) noexcept;
+};
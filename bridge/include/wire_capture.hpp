@@ -0,0 +1,104 @@
+#pragma once
+
+#include "wire_capture_format.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Buffers records in memory and appends them to the capture file in large writes made by its
+// own thread, so record() never waits on the disk: a full buffer is handed to the writer thread
+// and recording carries on in a second one. If the writer still holds that one, the record is
+// dropped and counted. Every open() starts a new session in the file. Safe to call from the
+// session thread while another thread starts or stops the capture.
+class WireCaptureWriter {
+public:
+    WireCaptureWriter();
+    ~WireCaptureWriter();
+
+    WireCaptureWriter(const WireCaptureWriter&) = delete;
+    WireCaptureWriter& operator=(const WireCaptureWriter&) = delete;
+
+    bool open(const std::string& path);
+    // Writes out everything recorded so far before returning
+    void close();
+    // Hands the buffered records to the writer thread without waiting for them
+    void flush();
+    bool is_open() const;
+
+    void record(std::uint16_t type, const void* payload, std::uint32_t payload_size,
+                std::chrono::steady_clock::time_point received_at);
+
+    std::uint64_t records_written() const;
+    std::uint64_t records_dropped() const;
+
+private:
+    static constexpr std::size_t kBufferSize = 64 * 1024;
+
+    mutable std::mutex mutex_;
+    std::condition_variable write_ready_;
+    int fd_;
+    std::vector<std::uint8_t> buffer_;
+    std::vector<std::uint8_t> writing_;
+    bool write_pending_;
+    bool flush_requested_;
+    bool stop_requested_;
+    std::uint64_t records_written_;
+    std::uint64_t records_dropped_;
+    std::thread writer_;
+
+    void append_locked(std::uint16_t type, const void* payload, std::uint32_t payload_size,
+                       std::uint64_t timestamp_ns);
+    bool hand_off_locked();
+    void run_writer();
+};
+
+// Places recorded timestamps on one replay timeline. Each session continues where the previous
+// one ended, so the gap between appended sessions is skipped, and a timestamp running backwards,
+// as in files written before session markers, also starts a new session.
+class ReplayTimeline {
+public:
+    void start_session() noexcept;
+
+    // Recorded nanoseconds from the start of the replay to this record
+    std::uint64_t offset_ns(std::uint64_t timestamp_ns) noexcept;
+    std::uint64_t recorded_ns() const noexcept;
+    std::uint64_t sessions() const noexcept { return sessions_; }
+
+private:
+    bool session_open_ = false;
+    std::uint64_t session_base_ns_ = 0;
+    std::uint64_t last_timestamp_ns_ = 0;
+    std::uint64_t previous_sessions_ns_ = 0;
+    std::uint64_t sessions_ = 0;
+};
+
+// Maps a capture file read-only and iterates its records without copying payloads.
+class WireCaptureReader {
+public:
+    WireCaptureReader();
+    ~WireCaptureReader();
+
+    WireCaptureReader(const WireCaptureReader&) = delete;
+    WireCaptureReader& operator=(const WireCaptureReader&) = delete;
+
+    // Other record streams share the container under their own magic, e.g. dinput traces
+    bool open(const std::string& path, const char* magic = wire_capture::kFileMagic);
+    void close();
+
+    // Returns false at the end of the file or at a truncated trailing record
+    bool next(wire_capture::Record& record);
+    void rewind() noexcept { offset_ = sizeof(wire_capture::FileHeader); }
+
+    const wire_capture::FileHeader& header() const noexcept { return header_; }
+
+private:
+    const std::uint8_t* data_;
+    std::size_t size_;
+    std::size_t offset_;
+    wire_capture::FileHeader header_;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Capture container shared by the bridge wire capture and the proxy's DirectInput trace. The
+// file is a fixed header followed by append-only records, each an 8-byte-aligned RecordHeader
+// plus its payload, so a reader can map the file and walk it in place. Timestamps are monotonic
+// nanoseconds; the magic tells the record streams apart.
+//
+// Writers append, so one file can hold several sessions. Each session starts with a
+// kSessionMarkerType record, and timestamps only compare within a session: the monotonic clock
+// restarts with the machine and says nothing about the gap between sessions.
+namespace wire_capture {
+
+constexpr char kFileMagic[8] = {'G', '9', '2', '3', 'W', 'C', 'A', 'P'};
+constexpr std::uint32_t kFileVersion = 1;
+constexpr std::size_t kRecordAlignment = 8;
+constexpr std::uint16_t kSessionMarkerType = 0xFFFF;
+
+#pragma pack(push, 1)
+
+struct FileHeader {
+    char magic[8] = {'G', '9', '2', '3', 'W', 'C', 'A', 'P'};
+    std::uint32_t version = kFileVersion;
+    std::uint32_t record_header_size = 16;
+    std::uint64_t created_unix_ns = 0;
+};
+
+struct RecordHeader {
+    std::uint64_t timestamp_ns = 0;
+    std::uint16_t type = 0;
+    std::uint16_t reserved = 0;
+    std::uint32_t payload_size = 0;
+};
+
+struct SessionMarker {
+    std::uint64_t created_unix_ns = 0;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(FileHeader) == 24, "Unexpected capture FileHeader size");
+static_assert(sizeof(RecordHeader) == 16, "Unexpected capture RecordHeader size");
+static_assert(sizeof(SessionMarker) == 8, "Unexpected capture SessionMarker size");
+
+constexpr std::size_t padded_size(std::size_t size) noexcept {
+    return (size + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+}
+
+struct Record {
+    std::uint64_t timestamp_ns = 0;
+    std::uint16_t type = 0;
+    const std::uint8_t* payload = nullptr;
+    std::uint32_t payload_size = 0;
+};
+
+}  // namespace wire_capture
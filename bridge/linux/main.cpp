@@ -0,0 +1,142 @@
+#include "bridge_server.hpp"
+#include "fake_hid_backend.hpp"
+#include "trace_zones.hpp"
+#include "utilities.hpp"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+// Headless bridge for Linux hosts. Wheels are reached through /dev/hidraw; --fake-wheel
+// swaps in an in-memory G923 so the bridge can be exercised without hardware, and
+// --simulate additionally drives a virtual rim whose trace can be written with --trace.
+// --capture records every received message for later replay with g923_replay.
+// --zones writes the TraceZone timeline as Chrome trace JSON (needs -DENABLE_TRACE_ZONES=ON).
+
+namespace {
+
+std::atomic<bool> stop_requested{false};
+
+void handle_signal(int) {
+    stop_requested.store(true);
+}
+
+struct Options {
+    std::uint16_t port = g923bridge::kDefaultPort;
+    std::uint16_t stats_port = g923bridge::kDefaultStatsPort;
+    WheelBackend backend = WheelBackend::classic;
+    bool fake_wheel = false;
+    bool simulate = false;
+    double time_scale = 1.0;
+    const char* trace_path = nullptr;
+    const char* capture_path = nullptr;
+    const char* zones_path = nullptr;
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--port") == 0 && has_value) {
+            options.port = static_cast<std::uint16_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--stats-port") == 0 && has_value) {
+            options.stats_port = static_cast<std::uint16_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--hidpp") == 0) {
+            options.backend = WheelBackend::hidpp;
+        } else if (std::strcmp(argv[i], "--fake-wheel") == 0) {
+            options.fake_wheel = true;
+        } else if (std::strcmp(argv[i], "--simulate") == 0) {
+            options.fake_wheel = true;
+            options.simulate = true;
+        } else if (std::strcmp(argv[i], "--time-scale") == 0 && has_value) {
+            options.time_scale = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--trace") == 0 && has_value) {
+            options.trace_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--capture") == 0 && has_value) {
+            options.capture_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--zones") == 0 && has_value) {
+            options.zones_path = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return options.port != 0 && options.time_scale > 0.0;
+}
+
+void write_trace(const WheelSimulator& simulator, const char* path) {
+    std::FILE* output = std::fopen(path, "w");
+    if (!output || !simulator.write_trace_csv(output)) {
+        Logger::error("Failed to write simulator trace to %s", path);
+    }
+    if (output) {
+        std::fclose(output);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s [--port N] [--stats-port N] [--hidpp] [--fake-wheel]\n"
+                     "       [--simulate] [--time-scale X] [--trace FILE] [--capture FILE]\n"
+                     "       [--zones FILE]\n", argv[0]);
+        return 2;
+    }
+
+    std::unique_ptr<HidBackend> hid_backend;
+    std::shared_ptr<WheelSimulator> simulator;
+    if (options.fake_wheel) {
+        auto fake_backend = std::make_unique<FakeHidBackend>();
+        auto wheel = fake_backend->add_g923(options.backend == WheelBackend::hidpp);
+        if (options.simulate) {
+            if (options.backend == WheelBackend::hidpp) {
+                Logger::warning("The simulator decodes classic commands only; HID++ effects will not move it");
+            }
+            simulator = std::make_shared<WheelSimulator>();
+            wheel->attach_simulator(simulator);
+            simulator->start_realtime(options.time_scale);
+        }
+        hid_backend = std::move(fake_backend);
+    }
+
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+
+    BridgeServer server(options.port, options.backend, options.stats_port, std::move(hid_backend));
+    if (options.capture_path && !server.start_capture(options.capture_path)) {
+        Logger::flush();
+        return 1;
+    }
+    if (!server.start()) {
+        Logger::error("Failed to start bridge server on port %hu", options.port);
+        Logger::flush();
+        return 1;
+    }
+
+    while (!stop_requested.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
+
+    Logger::info("Shutting down bridge server");
+    server.stop();
+
+    if (simulator) {
+        simulator->stop_realtime();
+        const WheelSimulator::Stats stats = simulator->stats();
+        Logger::info("Simulated %.1f s: %llu commands, %llu saturated steps, final angle %.1f deg",
+                     static_cast<double>(simulator->time_us()) * 1e-6, stats.commands, stats.saturated_steps,
+                     simulator->angle_deg());
+        if (options.trace_path) {
+            write_trace(*simulator, options.trace_path);
+        }
+    }
+    if (options.zones_path && !trace_zones::write_chrome_trace(options.zones_path)) {
+        Logger::error("Failed to write trace zones to %s", options.zones_path);
+    }
+    Logger::flush();
+    return 0;
+}
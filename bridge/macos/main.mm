@@ -12,6 +12,8 @@
     NSMenuItem* _serverItem;
     NSMenuItem* _clientItem;
     NSMenuItem* _wheelItem;
+    NSMenuItem* _latencyItem;
+    NSMenuItem* _countersItem;
     NSTimer* _timer;
     std::unique_ptr<BridgeServer> _server;
 }
@@ -21,7 +23,15 @@
 
     [NSApp setActivationPolicy:NSApplicationActivationPolicyAccessory];
 
-    _server = std::make_unique<BridgeServer>();
+    NSString* backendName = [[NSUserDefaults standardUserDefaults] stringForKey:@"ForceFeedbackBackend"];
+    const WheelBackend backend =
+        [backendName isEqualToString:@"hidpp"] ? WheelBackend::hidpp : WheelBackend::classic;
+
+    _server = std::make_unique<BridgeServer>(g923bridge::kDefaultPort, backend);
+    NSString* capturePath = [[NSUserDefaults standardUserDefaults] stringForKey:@"WireCapturePath"];
+    if (capturePath.length > 0) {
+        _server->start_capture(capturePath.stringByExpandingTildeInPath.UTF8String);
+    }
     _server->start();
 
     _statusItem = [[NSStatusBar systemStatusBar] statusItemWithLength:NSVariableStatusItemLength];
@@ -45,6 +55,14 @@
     _wheelItem.enabled = NO;
     [_menu addItem:_wheelItem];
 
+    _latencyItem = [[NSMenuItem alloc] initWithTitle:@"" action:nil keyEquivalent:@""];
+    _latencyItem.enabled = NO;
+    [_menu addItem:_latencyItem];
+
+    _countersItem = [[NSMenuItem alloc] initWithTitle:@"" action:nil keyEquivalent:@""];
+    _countersItem.enabled = NO;
+    [_menu addItem:_countersItem];
+
     [_menu addItem:[NSMenuItem separatorItem]];
 
     NSMenuItem* reconnectItem =
@@ -112,6 +130,25 @@
     }
     _wheelItem.title = wheelText;
 
+    const auto& metrics = status.metrics;
+    _latencyItem.title = [NSString
+        stringWithFormat:@"p50/p99 us: decode %llu/%llu, apply %llu/%llu, HID %llu/%llu, lock %llu/%llu",
+                         metrics.receive_to_decode.percentile_ns(50.0) / 1000,
+                         metrics.receive_to_decode.percentile_ns(99.0) / 1000,
+                         metrics.decode_to_apply.percentile_ns(50.0) / 1000,
+                         metrics.decode_to_apply.percentile_ns(99.0) / 1000,
+                         metrics.hid_write.percentile_ns(50.0) / 1000,
+                         metrics.hid_write.percentile_ns(99.0) / 1000,
+                         metrics.lock_wait.percentile_ns(50.0) / 1000,
+                         metrics.lock_wait.percentile_ns(99.0) / 1000];
+
+    std::uint64_t commands_sent = 0;
+    for (const auto count : metrics.commands_sent) {
+        commands_sent += count;
+    }
+    _countersItem.title = [NSString stringWithFormat:@"Commands: %llu sent, %llu deduplicated, %llu HID errors",
+                                                     commands_sent, metrics.deduplicated_states, metrics.hid_errors];
+
     _statusItem.button.title = @"G923Mac";
 }
 
@@ -1,10 +1,23 @@
 #include "bridge_client.hpp"
+#include "trace_zones.hpp"
 #include <windows.h>
 #include <ws2tcpip.h>
+#include <algorithm>
 #include <cstring>
 
 namespace {
 
+constexpr DWORD kShutdownWaitMs = 500;
+constexpr DWORD kShutdownPollMs = 10;
+constexpr DWORD kConnectPollMs = 5;
+// Bounds the hello_ack wait and every send, so a bridge that accepts and then stalls cannot
+// hold the sender past the shutdown wait
+constexpr DWORD kSocketTimeoutMs = 200;
+constexpr std::chrono::milliseconds kInitialBackoff{50};
+constexpr std::chrono::milliseconds kMaxBackoff{2000};
+// Long enough to take in the SetParameters calls a game makes back-to-back in one frame
+constexpr std::chrono::milliseconds kCoalesceWindow{2};
+
 bool send_exact(SOCKET socket_handle, const void* data, std::size_t size) {
     const auto* bytes = static_cast<const char*>(data);
     std::size_t sent = 0;
@@ -58,13 +71,50 @@ void BridgeClient::initialize() {
         return;
     }
 
-    InitializeCriticalSection(&lock_);
+    InitializeCriticalSection(&name_lock_);
     socket_ = INVALID_SOCKET;
+    connection_ = Connection::disconnected;
     hello_sent_ = false;
+    wants_connection_ = false;
+    next_attempt_ = clock::time_point{};
+    backoff_ = kInitialBackoff;
+    window_open_ = false;
+    window_closes_ = clock::time_point{};
+    desired_state_ = g923bridge::WheelStatePayload{};
+    has_desired_state_ = false;
+    state_dirty_ = false;
+    stop_pending_ = false;
     std::memset(last_client_name_, 0, sizeof(last_client_name_));
     last_process_id_ = 0;
+    stop_requested_.store(false);
+    hello_requested_.store(false);
+    sender_finished_.store(false);
+    states_queued_.store(false);
+    flush_requested_.store(false);
+    states_sent_.store(0);
+    stops_sent_.store(0);
+    send_failures_.store(0);
+    connect_attempts_.store(0);
+    connect_failures_.store(0);
+    connect_wait_us_.store(0);
+    state_replays_.store(0);
+    queued_count_.store(0);
+    coalesce_windows_.store(0);
+    windows_closed_early_.store(0);
     WSADATA wsa_data{};
     WSAStartup(MAKEWORD(2, 2), &wsa_data);
+
+    wake_event_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    sender_thread_ = wake_event_ ? CreateThread(nullptr, 0, &BridgeClient::sender_main, this, 0, nullptr) : nullptr;
+    if (!sender_thread_) {
+        if (wake_event_) {
+            CloseHandle(wake_event_);
+            wake_event_ = nullptr;
+        }
+        DeleteCriticalSection(&name_lock_);
+        WSACleanup();
+        return;
+    }
     initialized_ = true;
 }
 
@@ -73,182 +123,345 @@ void BridgeClient::shutdown() {
         return;
     }
 
-    EnterCriticalSection(&lock_);
-    disconnect_locked();
-    LeaveCriticalSection(&lock_);
-    DeleteCriticalSection(&lock_);
+    stop_requested_.store(true);
+    SetEvent(wake_event_);
+
+    // On process exit the sender has already been terminated; under FreeLibrary it flushes but
+    // cannot finish exiting while the loader lock is held, so wait for its flag, not its handle
+    bool thread_gone = false;
+    for (DWORD waited = 0; waited < kShutdownWaitMs && !sender_finished_.load(); waited += kShutdownPollMs) {
+        if (WaitForSingleObject(sender_thread_, kShutdownPollMs) == WAIT_OBJECT_0) {
+            thread_gone = true;
+            break;
+        }
+    }
+    if (!sender_finished_.load()) {
+        if (!thread_gone) {
+            // Still sending: leave it the handles, the lock and Winsock rather than free them under it
+            initialized_ = false;
+            return;
+        }
+        flush_requested_.store(true);
+        flush_pending();
+        disconnect();
+    }
+
+    CloseHandle(sender_thread_);
+    CloseHandle(wake_event_);
+    sender_thread_ = nullptr;
+    wake_event_ = nullptr;
+    DeleteCriticalSection(&name_lock_);
     WSACleanup();
     initialized_ = false;
 }
 
-bool BridgeClient::send_hello(const char* client_name, std::uint32_t process_id) {
+void BridgeClient::send_hello(const char* client_name, std::uint32_t process_id) {
     if (!initialized_) {
-        return false;
+        return;
     }
 
-    EnterCriticalSection(&lock_);
+    EnterCriticalSection(&name_lock_);
     const char* effective_name = (client_name && client_name[0]) ? client_name : "G923FFBProxy";
     copy_c_string(last_client_name_, sizeof(last_client_name_), effective_name);
     last_process_id_ = process_id;
+    LeaveCriticalSection(&name_lock_);
 
-    if (!ensure_connected_locked()) {
-        LeaveCriticalSection(&lock_);
-        return false;
+    hello_requested_.store(true);
+    SetEvent(wake_event_);
+}
+
+void BridgeClient::send_state(const g923bridge::WheelStatePayload& state) {
+    TraceZone zone("BridgeClient::send_state");
+    if (!initialized_) {
+        return;
     }
 
-    g923bridge::HelloPayload payload{};
-    copy_c_string(payload.client_name, sizeof(payload.client_name), last_client_name_);
-    payload.process_id = process_id;
+    mailbox_.publish(state);
+    flush_requested_.store(true);
+    SetEvent(wake_event_);
+}
 
-    if (!send_message_locked(g923bridge::MessageType::hello, &payload, sizeof(payload))) {
-        disconnect_locked();
-        LeaveCriticalSection(&lock_);
-        return false;
+void BridgeClient::queue_state(const g923bridge::WheelStatePayload& state) {
+    TraceZone zone("BridgeClient::queue_state");
+    if (!initialized_) {
+        return;
     }
 
-    g923bridge::MessageHeader header{};
-    g923bridge::HelloAckPayload ack{};
-    if (!recv_exact(socket_, &header, sizeof(header)) ||
-        header.magic != g923bridge::kProtocolMagic ||
-        header.version != g923bridge::kProtocolVersion ||
-        header.type != static_cast<std::uint16_t>(g923bridge::MessageType::hello_ack) ||
-        header.payload_size != sizeof(ack) ||
-        !recv_exact(socket_, &ack, sizeof(ack)) ||
-        !ack.accepted) {
-        disconnect_locked();
-        LeaveCriticalSection(&lock_);
-        return false;
+    mailbox_.publish(state);
+    queued_count_.fetch_add(1, std::memory_order_relaxed);
+    if (!states_queued_.exchange(true)) {
+        SetEvent(wake_event_);
     }
+}
 
-    hello_sent_ = true;
-    LeaveCriticalSection(&lock_);
-    return true;
+void BridgeClient::flush() {
+    if (!initialized_ || !states_queued_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    if (!flush_requested_.exchange(true)) {
+        SetEvent(wake_event_);
+    }
 }
 
-bool BridgeClient::send_state(const g923bridge::WheelStatePayload& state) {
+void BridgeClient::send_stop_all() {
     if (!initialized_) {
-        return false;
+        return;
     }
 
-    EnterCriticalSection(&lock_);
-    if (!ensure_connected_locked()) {
-        LeaveCriticalSection(&lock_);
-        return false;
-    }
+    mailbox_.request_stop_all();
+    flush_requested_.store(true);
+    SetEvent(wake_event_);
+}
 
-    if (!hello_sent_) {
-        g923bridge::HelloPayload hello{};
-        const char* client_name = last_client_name_[0] ? last_client_name_ : "G923FFBProxy";
-        copy_c_string(hello.client_name, sizeof(hello.client_name), client_name);
-        hello.process_id = last_process_id_;
+BridgeClient::Stats BridgeClient::stats() const {
+    Stats stats;
+    stats.states_published = mailbox_.published();
+    stats.states_sent = states_sent_.load(std::memory_order_relaxed);
+    stats.stops_sent = stops_sent_.load(std::memory_order_relaxed);
+    stats.send_failures = send_failures_.load(std::memory_order_relaxed);
+    stats.connect_attempts = connect_attempts_.load(std::memory_order_relaxed);
+    stats.connect_failures = connect_failures_.load(std::memory_order_relaxed);
+    stats.connect_wait_us = connect_wait_us_.load(std::memory_order_relaxed);
+    stats.state_replays = state_replays_.load(std::memory_order_relaxed);
+    stats.states_queued = queued_count_.load(std::memory_order_relaxed);
+    stats.coalesce_windows = coalesce_windows_.load(std::memory_order_relaxed);
+    stats.windows_closed_early = windows_closed_early_.load(std::memory_order_relaxed);
+    return stats;
+}
 
-        if (!send_message_locked(g923bridge::MessageType::hello, &hello, sizeof(hello))) {
-            disconnect_locked();
-            LeaveCriticalSection(&lock_);
-            return false;
-        }
+DWORD WINAPI BridgeClient::sender_main(LPVOID parameter) {
+    static_cast<BridgeClient*>(parameter)->run_sender();
+    return 0;
+}
 
-        g923bridge::MessageHeader header{};
-        g923bridge::HelloAckPayload ack{};
-        if (!recv_exact(socket_, &header, sizeof(header)) ||
-            header.magic != g923bridge::kProtocolMagic ||
-            header.version != g923bridge::kProtocolVersion ||
-            header.type != static_cast<std::uint16_t>(g923bridge::MessageType::hello_ack) ||
-            header.payload_size != sizeof(ack) ||
-            !recv_exact(socket_, &ack, sizeof(ack)) ||
-            !ack.accepted) {
-            disconnect_locked();
-            LeaveCriticalSection(&lock_);
-            return false;
-        }
+void BridgeClient::run_sender() {
+    trace_zones::prepare_thread("bridge sender");
+    while (!stop_requested_.load()) {
+        WaitForSingleObject(wake_event_, next_wait_ms());
+        flush_pending();
+    }
+    flush_requested_.store(true);
+    flush_pending();
+    disconnect();
+    sender_finished_.store(true);
+}
 
-        hello_sent_ = true;
+// Sleeps until woken unless a connect is in flight, a retry is due or a coalescing window ends
+DWORD BridgeClient::next_wait_ms() const {
+    const clock::time_point now = clock::now();
+    const auto ms_until = [now](clock::time_point at) {
+        return at <= now ? DWORD{0}
+                         : static_cast<DWORD>(std::chrono::duration_cast<std::chrono::milliseconds>(at - now).count() + 1);
+    };
+
+    DWORD wait_ms = INFINITE;
+    if (connection_ == Connection::connecting) {
+        wait_ms = kConnectPollMs;
+    } else if (connection_ == Connection::disconnected && wants_connection_) {
+        wait_ms = ms_until(next_attempt_);
+    }
+    if (window_open_) {
+        wait_ms = std::min(wait_ms, ms_until(window_closes_));
+    }
+    return wait_ms;
+}
+
+bool BridgeClient::window_closed() {
+    if (!window_open_) {
+        if (!states_queued_.load()) {
+            flush_requested_.store(false);
+            return true;
+        }
+        window_open_ = true;
+        window_closes_ = clock::now() + kCoalesceWindow;
+        coalesce_windows_.fetch_add(1, std::memory_order_relaxed);
     }
 
-    if (!send_message_locked(g923bridge::MessageType::apply_wheel_state, &state, sizeof(state))) {
-        disconnect_locked();
-        LeaveCriticalSection(&lock_);
+    const bool flush_requested = flush_requested_.exchange(false);
+    const bool ran_out = clock::now() >= window_closes_;
+    if (!flush_requested && !ran_out) {
         return false;
     }
+    if (!ran_out) {
+        windows_closed_early_.fetch_add(1, std::memory_order_relaxed);
+    }
 
-    LeaveCriticalSection(&lock_);
+    // Acquires the queuing thread's publish; anything queued after this opens the next window
+    window_open_ = false;
+    states_queued_.exchange(false);
     return true;
 }
 
-bool BridgeClient::send_stop_all() {
-    if (!initialized_) {
-        return false;
+void BridgeClient::flush_pending() {
+    TraceZone zone("BridgeClient::flush_pending");
+    if (hello_requested_.exchange(false)) {
+        wants_connection_ = true;
+    }
+    if (!window_closed()) {
+        return;
     }
 
-    EnterCriticalSection(&lock_);
-    if (!ensure_connected_locked()) {
-        LeaveCriticalSection(&lock_);
-        return false;
+    // Fold everything published since the last flush into what the bridge should be doing;
+    // a stop drops the states before it, a later state is sent after the stop
+    StateMailbox::Taken taken;
+    while (mailbox_.take(taken)) {
+        wants_connection_ = true;
+        if (taken.stop_all) {
+            stop_pending_ = true;
+            has_desired_state_ = false;
+            state_dirty_ = false;
+        }
+        if (taken.has_state) {
+            desired_state_ = taken.state;
+            has_desired_state_ = true;
+            state_dirty_ = true;
+        }
     }
 
-    if (!hello_sent_) {
-        g923bridge::HelloPayload hello{};
-        const char* client_name = last_client_name_[0] ? last_client_name_ : "G923FFBProxy";
-        copy_c_string(hello.client_name, sizeof(hello.client_name), client_name);
-        hello.process_id = last_process_id_;
+    if (!wants_connection_ || !ensure_hello()) {
+        return;
+    }
 
-        if (!send_message_locked(g923bridge::MessageType::hello, &hello, sizeof(hello))) {
-            disconnect_locked();
-            LeaveCriticalSection(&lock_);
-            return false;
+    if (stop_pending_) {
+        if (!send_message(g923bridge::MessageType::stop_all, nullptr, 0)) {
+            send_failures_.fetch_add(1, std::memory_order_relaxed);
+            fail_connection();
+            return;
         }
+        stop_pending_ = false;
+        stops_sent_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (state_dirty_) {
+        if (!send_message(g923bridge::MessageType::apply_wheel_state, &desired_state_, sizeof(desired_state_))) {
+            send_failures_.fetch_add(1, std::memory_order_relaxed);
+            fail_connection();
+            return;
+        }
+        state_dirty_ = false;
+        states_sent_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
 
-        g923bridge::MessageHeader header{};
-        g923bridge::HelloAckPayload ack{};
-        if (!recv_exact(socket_, &header, sizeof(header)) ||
-            header.magic != g923bridge::kProtocolMagic ||
-            header.version != g923bridge::kProtocolVersion ||
-            header.type != static_cast<std::uint16_t>(g923bridge::MessageType::hello_ack) ||
-            header.payload_size != sizeof(ack) ||
-            !recv_exact(socket_, &ack, sizeof(ack)) ||
-            !ack.accepted) {
-            disconnect_locked();
-            LeaveCriticalSection(&lock_);
+bool BridgeClient::ensure_connected() {
+    const clock::time_point now = clock::now();
+    if (connection_ == Connection::disconnected) {
+        if (now < next_attempt_) {
             return false;
         }
-
-        hello_sent_ = true;
+        start_connect(now);
     }
 
-    if (!send_message_locked(g923bridge::MessageType::stop_all, nullptr, 0)) {
-        disconnect_locked();
-        LeaveCriticalSection(&lock_);
-        return false;
+    if (connection_ == Connection::connecting) {
+        fd_set writable;
+        fd_set failed;
+        FD_ZERO(&writable);
+        FD_ZERO(&failed);
+        FD_SET(socket_, &writable);
+        FD_SET(socket_, &failed);
+        timeval no_wait{};
+        if (select(0, nullptr, &writable, &failed, &no_wait) == 0) {
+            return false;
+        }
+
+        int error = 0;
+        int error_size = sizeof(error);
+        getsockopt(socket_, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &error_size);
+        finish_connect(FD_ISSET(socket_, &writable) && error == 0, clock::now());
     }
 
-    LeaveCriticalSection(&lock_);
-    return true;
+    return connection_ == Connection::connected;
 }
 
-bool BridgeClient::ensure_connected_locked() {
-    if (socket_ != INVALID_SOCKET) {
-        return true;
-    }
+void BridgeClient::start_connect(clock::time_point now) {
+    connect_attempts_.fetch_add(1, std::memory_order_relaxed);
+    connect_started_ = now;
 
     socket_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (socket_ == INVALID_SOCKET) {
-        return false;
+        finish_connect(false, now);
+        return;
     }
 
+    u_long non_blocking = 1;
+    ioctlsocket(socket_, FIONBIO, &non_blocking);
+
     sockaddr_in address{};
     address.sin_family = AF_INET;
     address.sin_port = htons(g923bridge::kDefaultPort);
     inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
 
-    if (connect(socket_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
-        disconnect_locked();
+    connection_ = Connection::connecting;
+    if (connect(socket_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0) {
+        finish_connect(true, clock::now());
+    } else if (WSAGetLastError() != WSAEWOULDBLOCK) {
+        finish_connect(false, clock::now());
+    }
+}
+
+void BridgeClient::finish_connect(bool accepted, clock::time_point now) {
+    connect_wait_us_.fetch_add(static_cast<std::uint64_t>(
+                                   std::chrono::duration_cast<std::chrono::microseconds>(now - connect_started_).count()),
+                               std::memory_order_relaxed);
+    if (!accepted) {
+        connect_failures_.fetch_add(1, std::memory_order_relaxed);
+        fail_connection();
+        return;
+    }
+
+    // Hello and the messages after it are small; blocking sends with a timeout keep them simple
+    u_long non_blocking = 0;
+    ioctlsocket(socket_, FIONBIO, &non_blocking);
+    const DWORD timeout_ms = kSocketTimeoutMs;
+    setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout_ms), sizeof(timeout_ms));
+    setsockopt(socket_, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout_ms), sizeof(timeout_ms));
+    connection_ = Connection::connected;
+}
+
+bool BridgeClient::ensure_hello() {
+    if (!ensure_connected()) {
+        return false;
+    }
+    if (hello_sent_) {
+        return true;
+    }
+
+    g923bridge::HelloPayload hello{};
+    EnterCriticalSection(&name_lock_);
+    const char* client_name = last_client_name_[0] ? last_client_name_ : "G923FFBProxy";
+    copy_c_string(hello.client_name, sizeof(hello.client_name), client_name);
+    hello.process_id = last_process_id_;
+    LeaveCriticalSection(&name_lock_);
+
+    if (!send_message(g923bridge::MessageType::hello, &hello, sizeof(hello))) {
+        fail_connection();
+        return false;
+    }
+
+    g923bridge::MessageHeader header{};
+    g923bridge::HelloAckPayload ack{};
+    if (!recv_exact(socket_, &header, sizeof(header)) ||
+        header.magic != g923bridge::kProtocolMagic ||
+        header.version != g923bridge::kProtocolVersion ||
+        header.type != static_cast<std::uint16_t>(g923bridge::MessageType::hello_ack) ||
+        header.payload_size != sizeof(ack) ||
+        !recv_exact(socket_, &ack, sizeof(ack)) ||
+        !ack.accepted) {
+        fail_connection();
         return false;
     }
 
+    hello_sent_ = true;
+    backoff_ = kInitialBackoff;
+    // A new session starts from nothing, so bring it up to the latest state straight away
+    if (has_desired_state_ && !state_dirty_) {
+        state_dirty_ = true;
+        state_replays_.fetch_add(1, std::memory_order_relaxed);
+    }
     return true;
 }
 
-bool BridgeClient::send_message_locked(g923bridge::MessageType type, const void* payload, std::uint32_t payload_size) {
+bool BridgeClient::send_message(g923bridge::MessageType type, const void* payload, std::uint32_t payload_size) {
     g923bridge::MessageHeader header{};
     header.type = static_cast<std::uint16_t>(type);
     header.payload_size = payload_size;
@@ -264,10 +477,17 @@ bool BridgeClient::send_message_locked(g923bridge::MessageType type, const void*
     return true;
 }
 
-void BridgeClient::disconnect_locked() {
+void BridgeClient::fail_connection() {
+    disconnect();
+    next_attempt_ = clock::now() + backoff_;
+    backoff_ = std::min<clock::duration>(backoff_ * 2, kMaxBackoff);
+}
+
+void BridgeClient::disconnect() {
     if (socket_ != INVALID_SOCKET) {
         closesocket(socket_);
         socket_ = INVALID_SOCKET;
     }
+    connection_ = Connection::disconnected;
     hello_sent_ = false;
 }
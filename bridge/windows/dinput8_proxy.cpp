@@ -1,13 +1,25 @@
+#include "alloc_tracker.hpp"
 #include "bridge_client.hpp"
+#include "dinput_trace.hpp"
+#include "effect_engine.hpp"
 #include "ffb_bridge_protocol.hpp"
-#include <cmath>
+#include "latency_histogram.hpp"
+#include "proxy_log.hpp"
+#include "slot_map.hpp"
+#include "trace_writer.hpp"
+#include "trace_zones.hpp"
+#include <atomic>
 #include <cstdarg>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <dinput.h>
 #include <windows.h>
 
 void* operator new(std::size_t size) {
+#ifdef G923_ALLOC_CHECKS
+    alloc_tracker::note_allocation();
+#endif
     return HeapAlloc(GetProcessHeap(), 0, static_cast<SIZE_T>(size));
 }
 
@@ -31,10 +43,34 @@ using DllGetClassObjectFn = HRESULT(WINAPI*)(REFCLSID, REFIID, LPVOID*);
 using DllRegisterServerFn = HRESULT(WINAPI*)();
 using DllUnregisterServerFn = HRESULT(WINAPI*)();
 
-constexpr int kMaxEffects = 64;
+// Effects the batches hold room for up front; they double past it outside the force path
+constexpr std::size_t kInitialEffectCapacity = 64;
+constexpr std::uint64_t kDefaultRenderRateHz = 1000000 / effect_engine::kPeriodicUpdateIntervalUs;
+constexpr std::uint64_t kMinRenderRateHz = 50;
+constexpr std::uint64_t kMaxRenderRateHz = 1000;
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
 constexpr DWORD kSyntheticDrivingType = DI8DEVTYPE_DRIVING | (DI8DEVTYPEDRIVING_THREEPEDALS << 8);
-constexpr ULONGLONG kPeriodicUpdateIntervalUs = 4000ULL;
-constexpr double kTwoPi = 6.28318530717958647692;
+
+static_assert(effect_engine::kParamDuration == DIEP_DURATION && effect_engine::kParamGain == DIEP_GAIN &&
+                  effect_engine::kParamDirection == DIEP_DIRECTION && effect_engine::kParamEnvelope == DIEP_ENVELOPE &&
+                  effect_engine::kParamTypeSpecific == DIEP_TYPESPECIFICPARAMS &&
+                  effect_engine::kParamStartDelay == DIEP_STARTDELAY && effect_engine::kParamAll == DIEP_ALLPARAMS &&
+                  effect_engine::kParamStart == DIEP_START && effect_engine::kParamNoRestart == DIEP_NORESTART,
+              "effect_engine parameter flags must match DIEP_*");
+static_assert(effect_engine::kDirectionCartesian == DIEFF_CARTESIAN && effect_engine::kDirectionPolar == DIEFF_POLAR &&
+                  effect_engine::kDirectionSpherical == DIEFF_SPHERICAL,
+              "effect_engine direction flags must match DIEFF_*");
+static_assert(effect_engine::kNominalMax == DI_FFNOMINALMAX && effect_engine::kInfinite == INFINITE,
+              "effect_engine units must match DirectInput");
+static_assert(sizeof(effect_engine::Condition) == sizeof(DICONDITION) &&
+                  sizeof(effect_engine::ConstantForce) == sizeof(DICONSTANTFORCE) &&
+                  sizeof(effect_engine::RampForce) == sizeof(DIRAMPFORCE) &&
+                  sizeof(effect_engine::Periodic) == sizeof(DIPERIODIC) &&
+                  sizeof(effect_engine::Envelope) == sizeof(DIENVELOPE) - sizeof(DWORD),
+              "effect_engine type-specific layouts must match DirectInput");
 
 HMODULE g_real_dinput8 = nullptr;
 HMODULE g_this_module = nullptr;
@@ -44,29 +80,10 @@ DllGetClassObjectFn g_real_get_class_object = nullptr;
 DllRegisterServerFn g_real_register_server = nullptr;
 DllUnregisterServerFn g_real_unregister_server = nullptr;
 BridgeClient g_bridge_client;
+ProxyLog g_proxy_log;
+TraceWriter g_trace;
 volatile LONG g_bridge_announced = 0;
-
-inline LONG abs_long(LONG value) {
-    return (value < 0) ? -value : value;
-}
-
-inline LONG clamp_long(LONG value, LONG minimum, LONG maximum) {
-    if (value < minimum) {
-        return minimum;
-    }
-    if (value > maximum) {
-        return maximum;
-    }
-    return value;
-}
-
-inline DWORD max_dword(DWORD a, DWORD b) {
-    return (a > b) ? a : b;
-}
-
-inline std::uint8_t max_u8(std::uint8_t a, std::uint8_t b) {
-    return (a > b) ? a : b;
-}
+volatile LONG g_next_trace_id = 0;
 
 inline DWORD clamp_dword(DWORD value, DWORD minimum, DWORD maximum) {
     if (value < minimum) {
@@ -96,53 +113,53 @@ bool is_guid_equal(REFGUID a, REFGUID b) {
     return InlineIsEqualGUID(a, b) != FALSE;
 }
 
-const char* effect_guid_name(REFGUID guid) {
+effect_engine::EffectType effect_type_from_guid(REFGUID guid) {
+    using effect_engine::EffectType;
     if (is_guid_equal(guid, GUID_ConstantForce)) {
-        return "ConstantForce";
+        return EffectType::constant_force;
     }
     if (is_guid_equal(guid, GUID_RampForce)) {
-        return "RampForce";
+        return EffectType::ramp_force;
     }
     if (is_guid_equal(guid, GUID_Square)) {
-        return "Square";
+        return EffectType::square;
     }
     if (is_guid_equal(guid, GUID_Sine)) {
-        return "Sine";
+        return EffectType::sine;
     }
     if (is_guid_equal(guid, GUID_Triangle)) {
-        return "Triangle";
+        return EffectType::triangle;
     }
     if (is_guid_equal(guid, GUID_SawtoothUp)) {
-        return "SawtoothUp";
+        return EffectType::sawtooth_up;
     }
     if (is_guid_equal(guid, GUID_SawtoothDown)) {
-        return "SawtoothDown";
+        return EffectType::sawtooth_down;
     }
     if (is_guid_equal(guid, GUID_Spring)) {
-        return "Spring";
+        return EffectType::spring;
     }
     if (is_guid_equal(guid, GUID_Damper)) {
-        return "Damper";
+        return EffectType::damper;
     }
     if (is_guid_equal(guid, GUID_Inertia)) {
-        return "Inertia";
+        return EffectType::inertia;
     }
     if (is_guid_equal(guid, GUID_Friction)) {
-        return "Friction";
+        return EffectType::friction;
     }
-    return "Unknown";
+    return EffectType::unknown;
 }
 
 bool is_property_key(REFGUID prop, ULONG_PTR key) {
     return reinterpret_cast<ULONG_PTR>(&prop) == key;
 }
 
-void append_proxy_log(const char* message) {
-    char module_path[MAX_PATH] = {0};
+// Builds the path of a file that lives next to the proxy DLL
+bool module_sibling_path(const char* file_name, char* module_path) {
+    module_path[0] = '\0';
     if (!g_this_module || GetModuleFileNameA(g_this_module, module_path, MAX_PATH) == 0) {
-        OutputDebugStringA(message);
-        OutputDebugStringA("\n");
-        return;
+        return false;
     }
 
     char* separator = std::strrchr(module_path, '\\');
@@ -155,39 +172,19 @@ void append_proxy_log(const char* message) {
         module_path[0] = '\0';
     }
 
-    std::strncat(module_path, "g923mac_proxy.log", MAX_PATH - std::strlen(module_path) - 1);
-
-    const DWORD attrs = GetFileAttributesA(module_path);
-    if (attrs != INVALID_FILE_ATTRIBUTES && (attrs & FILE_ATTRIBUTE_DIRECTORY) == 0) {
-        HANDLE file = CreateFileA(
-            module_path,
-            FILE_APPEND_DATA,
-            FILE_SHARE_READ | FILE_SHARE_WRITE,
-            nullptr,
-            OPEN_EXISTING,
-            FILE_ATTRIBUTE_NORMAL,
-            nullptr);
-
-        if (file != INVALID_HANDLE_VALUE) {
-            char line[1024] = {0};
-            std::snprintf(line, sizeof(line), "%s\r\n", message);
-            DWORD written = 0;
-            WriteFile(file, line, static_cast<DWORD>(std::strlen(line)), &written, nullptr);
-            CloseHandle(file);
-        }
-    }
+    std::strncat(module_path, file_name, MAX_PATH - std::strlen(module_path) - 1);
+    return true;
+}
 
-    OutputDebugStringA(message);
-    OutputDebugStringA("\n");
+void append_proxy_log(const char* message) {
+    g_proxy_log.write(message);
 }
 
 void append_proxy_logf(const char* format, ...) {
-    char buffer[1024] = {0};
     va_list args;
     va_start(args, format);
-    std::vsnprintf(buffer, sizeof(buffer), format, args);
+    g_proxy_log.write_format(format, args);
     va_end(args);
-    append_proxy_log(buffer);
 }
 
 const char* directinput_iid_name(REFIID riid) {
@@ -208,8 +205,8 @@ void announce_bridge_connection() {
         return;
     }
 
-    const bool connected = g_bridge_client.send_hello("G923FFBProxy", GetCurrentProcessId());
-    append_proxy_logf("bridge hello %s", connected ? "succeeded" : "failed");
+    g_bridge_client.send_hello("G923FFBProxy", GetCurrentProcessId());
+    append_proxy_log("bridge hello queued");
 }
 
 bool ensure_real_dinput_loaded() {
@@ -249,81 +246,206 @@ bool ensure_real_dinput_loaded() {
     return loaded;
 }
 
-std::uint8_t scale_byte(LONG value, LONG source_max = DI_FFNOMINALMAX) {
-    LONG clamped = value;
-    if (clamped < 0) {
-        clamped = 0;
-    }
-    if (clamped > source_max) {
-        clamped = source_max;
-    }
-    return static_cast<std::uint8_t>((clamped * 255) / source_max);
-}
-
-std::uint8_t scale_nibble(LONG value, LONG source_max = DI_FFNOMINALMAX) {
-    LONG clamped = value;
-    if (clamped < 0) {
-        clamped = 0;
-    }
-    if (clamped > source_max) {
-        clamped = source_max;
-    }
-    return static_cast<std::uint8_t>((clamped * 15) / source_max);
+std::uint64_t counter_ns() {
+    static const LONGLONG frequency = [] {
+        LARGE_INTEGER value{};
+        QueryPerformanceFrequency(&value);
+        return value.QuadPart;
+    }();
+    LARGE_INTEGER counter{};
+    QueryPerformanceCounter(&counter);
+    return static_cast<std::uint64_t>(counter.QuadPart / frequency * 1000000000LL +
+                                      counter.QuadPart % frequency * 1000000000LL / frequency);
 }
 
+// Effect time base. GetTickCount64 only moves every 10-16 ms, which would quantise envelopes,
+// the periodic update gate and short-period waves to the system tick
 ULONGLONG now_us() {
-    return static_cast<ULONGLONG>(GetTickCount64()) * 1000ULL;
-}
+    return static_cast<ULONGLONG>(counter_ns() / 1000);
+}
+
+// Render thread period from G923MAC_RENDER_HZ (50-1000, default matches the Poll-driven rate);
+// 0 turns the thread off and leaves time-varying effects to Poll
+std::uint64_t render_interval_us() {
+    static const std::uint64_t interval_us = [] {
+        char value[16] = {0};
+        std::uint64_t rate_hz = kDefaultRenderRateHz;
+        if (GetEnvironmentVariableA("G923MAC_RENDER_HZ", value, sizeof(value)) > 0) {
+            rate_hz = std::strtoull(value, nullptr, 10);
+            if (rate_hz != 0) {
+                rate_hz = rate_hz < kMinRenderRateHz ? kMinRenderRateHz : rate_hz;
+                rate_hz = rate_hz > kMaxRenderRateHz ? kMaxRenderRateHz : rate_hz;
+            }
+        }
+        return rate_hz == 0 ? 0 : 1000000 / rate_hz;
+    }();
+    return interval_us;
+}
+
+// How far each render tick woke past its deadline, and the ticks skipped because one ran late
+LatencyHistogram g_render_lateness;
+std::atomic<std::uint64_t> g_render_overruns{0};
+
+// Entry points through which game threads reach the force path, timed end to end including
+// the real device's own call so the figures are what the game actually waits
+enum class ProxyCall : std::size_t {
+    set_parameters,
+    start,
+    stop,
+    poll,
+    set_property,
+    send_force_feedback_command,
+    count,
+};
 
-DWORD apply_unsigned_gain(DWORD value, DWORD gain) {
-    const DWORD clamped_gain = clamp_dword(gain, 0, DI_FFNOMINALMAX);
-    const ULONGLONG scaled = (static_cast<ULONGLONG>(value) * static_cast<ULONGLONG>(clamped_gain)) /
-                             static_cast<ULONGLONG>(DI_FFNOMINALMAX);
-    return static_cast<DWORD>(scaled);
-}
+constexpr const char* kProxyCallNames[] = {
+    "SetParameters", "Start", "Stop", "Poll", "SetProperty", "SendForceFeedbackCommand",
+};
+static_assert(sizeof(kProxyCallNames) / sizeof(kProxyCallNames[0]) == static_cast<std::size_t>(ProxyCall::count),
+              "every ProxyCall needs a name");
 
-LONG apply_signed_gain(LONG value, DWORD gain) {
-    const DWORD clamped_gain = clamp_dword(gain, 0, DI_FFNOMINALMAX);
-    const LONGLONG scaled = (static_cast<LONGLONG>(value) * static_cast<LONGLONG>(clamped_gain)) /
-                            static_cast<LONGLONG>(DI_FFNOMINALMAX);
-    return clamp_long(static_cast<LONG>(scaled), -DI_FFNOMINALMAX, DI_FFNOMINALMAX);
-}
+LatencyHistogram g_call_time[static_cast<std::size_t>(ProxyCall::count)];
 
-LONG apply_combined_gain(LONG value, DWORD effect_gain, DWORD device_gain) {
-    const LONG after_effect = apply_signed_gain(value, effect_gain);
-    return apply_signed_gain(after_effect, device_gain);
-}
+class CallTimer {
+public:
+    explicit CallTimer(ProxyCall call) : call_(call), start_ns_(counter_ns()) {}
+    ~CallTimer() { g_call_time[static_cast<std::size_t>(call_)].record(counter_ns() - start_ns_); }
 
-DWORD apply_combined_gain_unsigned(DWORD value, DWORD effect_gain, DWORD device_gain) {
-    return apply_unsigned_gain(apply_unsigned_gain(value, effect_gain), device_gain);
-}
+    CallTimer(const CallTimer&) = delete;
+    CallTimer& operator=(const CallTimer&) = delete;
 
-double normalize_phase01(double phase) {
-    double result = std::fmod(phase, 1.0);
-    if (result < 0.0) {
-        result += 1.0;
+private:
+    ProxyCall call_;
+    std::uint64_t start_ns_;
+};
+
+void log_proxy_stats() {
+    for (std::size_t i = 0; i < static_cast<std::size_t>(ProxyCall::count); ++i) {
+        const LatencyHistogram::Snapshot snapshot = g_call_time[i].snapshot();
+        if (snapshot.count == 0) {
+            continue;
+        }
+        append_proxy_logf("game thread time in %s: %llu calls, mean %.1f us, p99 %.1f us, max %.1f us",
+                          kProxyCallNames[i], static_cast<unsigned long long>(snapshot.count),
+                          static_cast<double>(snapshot.mean_ns()) / 1000.0,
+                          static_cast<double>(snapshot.percentile_ns(99.0)) / 1000.0,
+                          static_cast<double>(snapshot.max_ns) / 1000.0);
+    }
+
+    const LatencyHistogram::Snapshot lateness = g_render_lateness.snapshot();
+    if (lateness.count > 0) {
+        append_proxy_logf("render thread every %llu us: %llu ticks, late by p50 %.1f us, p99 %.1f us, max %.1f us, "
+                          "%llu overruns",
+                          static_cast<unsigned long long>(render_interval_us()),
+                          static_cast<unsigned long long>(lateness.count),
+                          static_cast<double>(lateness.percentile_ns(50.0)) / 1000.0,
+                          static_cast<double>(lateness.percentile_ns(99.0)) / 1000.0,
+                          static_cast<double>(lateness.max_ns) / 1000.0,
+                          static_cast<unsigned long long>(g_render_overruns.load(std::memory_order_relaxed)));
+    }
+
+    const BridgeClient::Stats stats = g_bridge_client.stats();
+    append_proxy_logf("bridge sender: %llu states published, %llu sent, %llu stops sent, %llu send failures",
+                      static_cast<unsigned long long>(stats.states_published),
+                      static_cast<unsigned long long>(stats.states_sent),
+                      static_cast<unsigned long long>(stats.stops_sent),
+                      static_cast<unsigned long long>(stats.send_failures));
+    append_proxy_logf("bridge connects: %llu attempts, %llu failed, %.1f ms waiting, %llu state replays",
+                      static_cast<unsigned long long>(stats.connect_attempts),
+                      static_cast<unsigned long long>(stats.connect_failures),
+                      static_cast<double>(stats.connect_wait_us) / 1000.0,
+                      static_cast<unsigned long long>(stats.state_replays));
+    append_proxy_logf("bridge coalescing: %llu game thread updates queued in %llu windows (%llu closed early), "
+                      "%llu states sent",
+                      static_cast<unsigned long long>(stats.states_queued),
+                      static_cast<unsigned long long>(stats.coalesce_windows),
+                      static_cast<unsigned long long>(stats.windows_closed_early),
+                      static_cast<unsigned long long>(stats.states_sent));
+}
+
+dinput_trace::EventHeader trace_header(std::uint32_t device_id, std::uint32_t effect_id) {
+    dinput_trace::EventHeader header;
+    header.clock_us = now_us();
+    header.device_id = device_id;
+    header.effect_id = effect_id;
+    return header;
+}
+
+void trace_event(dinput_trace::EventType type, std::uint32_t device_id, std::uint32_t effect_id = 0) {
+    if (!g_trace.enabled()) {
+        return;
     }
-    return result;
+    const dinput_trace::EventHeader header = trace_header(device_id, effect_id);
+    g_trace.record(type, &header, sizeof(header));
 }
 
-double periodic_wave_sample(REFGUID guid, double phase01) {
-    const double normalized = normalize_phase01(phase01);
-    if (is_guid_equal(guid, GUID_Sine)) {
-        return std::sin(normalized * kTwoPi);
-    }
-    if (is_guid_equal(guid, GUID_Square)) {
-        return (normalized < 0.5) ? 1.0 : -1.0;
-    }
-    if (is_guid_equal(guid, GUID_Triangle)) {
-        return 1.0 - 4.0 * std::abs(normalized - 0.5);
-    }
-    if (is_guid_equal(guid, GUID_SawtoothUp)) {
-        return (2.0 * normalized) - 1.0;
+void trace_value(dinput_trace::EventType type, std::uint32_t device_id, std::uint32_t effect_id, DWORD value) {
+    if (!g_trace.enabled()) {
+        return;
     }
-    if (is_guid_equal(guid, GUID_SawtoothDown)) {
-        return 1.0 - (2.0 * normalized);
+    dinput_trace::ValueEvent event;
+    event.header = trace_header(device_id, effect_id);
+    event.value = value;
+    g_trace.record(type, &event, sizeof(event));
+}
+
+void trace_set_parameters(std::uint32_t device_id, std::uint32_t effect_id, LPCDIEFFECT effect, DWORD flags) {
+    if (!g_trace.enabled()) {
+        return;
     }
-    return std::sin(normalized * kTwoPi);
+
+    dinput_trace::SetParametersEvent event;
+    event.header = trace_header(device_id, effect_id);
+    event.flags = flags;
+    event.effect_flags = effect->dwFlags;
+    event.gain = effect->dwGain;
+    event.duration = effect->dwDuration;
+    event.start_delay = effect->dwStartDelay;
+    event.axis_count = effect->cAxes;
+    if (effect->cAxes > 0 && effect->rglDirection) {
+        event.has_direction = 1;
+        event.direction[0] = effect->rglDirection[0];
+        event.direction[1] = (effect->cAxes > 1) ? effect->rglDirection[1] : effect->rglDirection[0];
+    }
+    if (effect->lpEnvelope) {
+        event.has_envelope = 1;
+        event.attack_level = effect->lpEnvelope->dwAttackLevel;
+        event.attack_time = effect->lpEnvelope->dwAttackTime;
+        event.fade_level = effect->lpEnvelope->dwFadeLevel;
+        event.fade_time = effect->lpEnvelope->dwFadeTime;
+    }
+    if (effect->lpvTypeSpecificParams) {
+        event.has_type_specific = 1;
+        event.type_specific_size = effect->cbTypeSpecificParams;
+        std::memcpy(event.type_specific, effect->lpvTypeSpecificParams,
+                    min_dword(effect->cbTypeSpecificParams, dinput_trace::kMaxTypeSpecificBytes));
+    }
+    g_trace.record(dinput_trace::EventType::set_parameters, &event, sizeof(event));
+}
+
+effect_engine::EffectUpdate effect_update_from(LPCDIEFFECT effect, DWORD flags, effect_engine::Envelope& envelope) {
+    effect_engine::EffectUpdate update;
+    update.flags = flags;
+    update.effect_flags = effect->dwFlags;
+    update.gain = effect->dwGain;
+    update.duration = effect->dwDuration;
+    update.start_delay = effect->dwStartDelay;
+    update.axis_count = effect->cAxes;
+    if (effect->cAxes > 0 && effect->rglDirection) {
+        update.has_direction = true;
+        update.direction[0] = effect->rglDirection[0];
+        update.direction[1] = (effect->cAxes > 1) ? effect->rglDirection[1] : effect->rglDirection[0];
+    }
+    if (effect->lpEnvelope) {
+        envelope.attack_level = effect->lpEnvelope->dwAttackLevel;
+        envelope.attack_time = effect->lpEnvelope->dwAttackTime;
+        envelope.fade_level = effect->lpEnvelope->dwFadeLevel;
+        envelope.fade_time = effect->lpEnvelope->dwFadeTime;
+        update.envelope = &envelope;
+    }
+    update.type_specific = effect->lpvTypeSpecificParams;
+    update.type_specific_size = effect->cbTypeSpecificParams;
+    return update;
 }
 
 struct EnumObjectContext {
@@ -459,6 +581,9 @@ HRESULT populate_effect_info(LPDIEFFECTINFOW info, const SupportedEffectDefiniti
 }
 
 class DeviceProxy;
+class EffectProxy;
+
+using EffectTable = SlotMap<EffectProxy*>;
 
 class EffectProxy final : public IDirectInputEffect {
 public:
@@ -480,45 +605,31 @@ public:
     HRESULT STDMETHODCALLTYPE Unload() override;
     HRESULT STDMETHODCALLTYPE Escape(LPDIEFFESCAPE escape) override;
 
-    bool started() const noexcept { return started_; }
-    bool has_time_varying_force() const;
-    void refresh_runtime(ULONGLONG now);
-    void force_stop_runtime();
-    void apply(g923bridge::WheelStatePayload& payload, DWORD device_gain, ULONGLONG now) const;
+    bool started() const noexcept { return effect_.started(); }
+    std::uint32_t trace_id() const noexcept { return trace_id_; }
+    bool has_time_varying_force() const { return effect_.has_time_varying_force(); }
+    const effect_engine::Effect& effect() const noexcept { return effect_; }
+    EffectTable::Handle table_handle() const noexcept { return table_handle_; }
+    void set_table_handle(EffectTable::Handle handle) noexcept { table_handle_ = handle; }
+    void refresh_runtime(ULONGLONG now) { effect_.refresh_runtime(now); }
+    void force_stop_runtime() { effect_.stop(); }
 
 private:
-    void update_from_effect(LPCDIEFFECT effect, DWORD flags);
-    bool is_temporally_active(ULONGLONG now) const;
-    bool has_expired(ULONGLONG now) const;
-    LONG compute_force(ULONGLONG now, DWORD device_gain) const;
-    float direction_multiplier() const;
-    float envelope_multiplier(ULONGLONG active_elapsed, ULONGLONG total_duration) const;
+    void log_type_specific() const;
 
     volatile LONG ref_count_;
     IDirectInputEffect* inner_;
     DeviceProxy* owner_;
+    std::uint32_t trace_id_;
     GUID guid_;
-    bool started_;
-    DWORD iterations_;
-    DWORD effect_gain_;
-    DWORD duration_;
-    DWORD start_delay_;
-    DWORD direction_flags_;
-    LONG direction_[2];
-    bool envelope_enabled_;
-    DIENVELOPE envelope_;
-    ULONGLONG start_time_us_;
-    DWORD condition_count_;
-    DICONDITION conditions_[2];
-    DICONSTANTFORCE constant_force_;
-    DIPERIODIC periodic_force_;
-    DIRAMPFORCE ramp_force_;
+    effect_engine::Effect effect_;
+    EffectTable::Handle table_handle_;
 };
 
 class DeviceProxy final : public IDirectInputDevice8W {
 public:
     explicit DeviceProxy(IDirectInputDevice8W* inner);
-    ~DeviceProxy() = default;
+    ~DeviceProxy();
 
     ULONG STDMETHODCALLTYPE AddRef() override;
     ULONG STDMETHODCALLTYPE Release() override;
@@ -557,20 +668,63 @@ public:
     void remove_effect(EffectProxy* effect);
     void rebuild_and_send();
     bool has_active_time_varying_effect() const;
+    std::uint32_t trace_id() const noexcept { return trace_id_; }
 
 private:
+    // What the render thread evaluates: the effects flattened into a batch and the device state
+    // that shapes their output, republished by game threads after every change
+    struct EffectSnapshot {
+        effect_engine::EffectBatch effects;
+        DWORD ff_gain = 0;
+        DWORD autocenter_mode = 0;
+        DWORD ff_state = 0;
+        bool time_varying = false;
+        std::uint64_t version = 0;
+    };
+
+    static DWORD WINAPI render_main(LPVOID parameter);
+    void run_render();
+    bool render_tick(ULONGLONG now);
+    // Grows the batches ahead of the effect table so rebuilds never allocate
+    void reserve_batches();
+    // Flattens the tracked effects into batch_ with the current device gain
+    void build_batch();
+    // Publishes batch_ as last built; suspending drops the snapshot's time-varying flag so the
+    // render thread winds down
+    void publish_snapshot(bool suspend_render = false);
+    bool render_active();
+    void send_stop_all();
+    // Explicit stop from the game: sends stop_all and forgets what was last sent
+    void stop_output();
+    // Filters and sends one payload; a render payload built from a superseded snapshot is dropped.
+    // render_now is the clock a render payload was evaluated at.
+    void submit(const g923bridge::WheelStatePayload& payload, std::uint64_t render_version,
+                ULONGLONG render_now = 0);
+
     volatile LONG ref_count_;
     IDirectInputDevice8W* inner_;
-    EffectProxy* effects_[kMaxEffects];
-    int effect_count_;
+    std::uint32_t trace_id_;
+    EffectTable effects_;
+    std::size_t batch_capacity_;
     DWORD ff_gain_;
     DWORD autocenter_mode_;
     DWORD ff_state_;
     bool advertises_force_feedback_;
-    bool last_sent_has_state_;
-    bool have_last_payload_;
     ULONGLONG last_periodic_rebuild_us_;
-    g923bridge::WheelStatePayload last_payload_;
+    effect_engine::EffectBatch batch_;
+
+    SRWLOCK snapshot_lock_;
+    EffectSnapshot snapshot_;
+    bool render_running_;
+    std::atomic<std::uint64_t> snapshot_version_;
+    EffectSnapshot render_copy_;
+    HANDLE render_thread_;
+    HANDLE render_stop_event_;
+    std::atomic<bool> render_stop_requested_;
+
+    // Game threads and the render thread share the filter and the order of what reaches the bridge
+    CRITICAL_SECTION output_lock_;
+    effect_engine::OutputFilter output_filter_;
 };
 
 class DirectInputProxy final : public IDirectInput8W {
@@ -662,12 +816,15 @@ private:
 };
 
 EffectProxy::EffectProxy(IDirectInputEffect* inner, REFGUID guid, DeviceProxy* owner)
-    : ref_count_(1), inner_(inner), owner_(owner), guid_(guid), started_(false), iterations_(1),
-      effect_gain_(DI_FFNOMINALMAX), duration_(INFINITE), start_delay_(0), direction_flags_(DIEFF_POLAR),
-      direction_{0, 0}, envelope_enabled_(false), envelope_{}, start_time_us_(0), condition_count_(0),
-      conditions_{}, constant_force_{}, periodic_force_{}, ramp_force_{} {
-    periodic_force_.dwMagnitude = DI_FFNOMINALMAX;
-    periodic_force_.dwPeriod = 100000;
+    : ref_count_(1), inner_(inner), owner_(owner),
+      trace_id_(static_cast<std::uint32_t>(InterlockedIncrement(&g_next_trace_id))), guid_(guid),
+      effect_(effect_type_from_guid(guid)) {
+    if (g_trace.enabled()) {
+        dinput_trace::EffectCreatedEvent event;
+        event.header = trace_header(owner_->trace_id(), trace_id_);
+        event.effect_type = static_cast<std::uint8_t>(effect_.type());
+        g_trace.record(dinput_trace::EventType::effect_created, &event, sizeof(event));
+    }
 }
 
 ULONG STDMETHODCALLTYPE EffectProxy::AddRef() {
@@ -683,6 +840,7 @@ ULONG STDMETHODCALLTYPE EffectProxy::Release() {
         inner_->Release();
     }
     if (remaining == 0) {
+        trace_event(dinput_trace::EventType::effect_released, owner_->trace_id(), trace_id_);
         owner_->remove_effect(this);
         delete this;
     }
@@ -725,56 +883,52 @@ HRESULT STDMETHODCALLTYPE EffectProxy::GetParameters(LPDIEFFECT effect, DWORD fl
 }
 
 HRESULT STDMETHODCALLTYPE EffectProxy::SetParameters(LPCDIEFFECT effect, DWORD flags) {
+    CallTimer timer(ProxyCall::set_parameters);
     const HRESULT result = inner_ ? inner_->SetParameters(effect, flags) : DI_OK;
     if (SUCCEEDED(result) && effect) {
         append_proxy_logf(
             "EffectProxy::SetParameters effect=%s flags=0x%08lx axes=%lu type_bytes=%lu",
-            effect_guid_name(guid_),
+            effect_engine::effect_type_name(effect_.type()),
             static_cast<unsigned long>(flags),
             static_cast<unsigned long>(effect->cAxes),
             static_cast<unsigned long>(effect->cbTypeSpecificParams));
-        update_from_effect(effect, flags);
-        if ((flags & DIEP_START) != 0) {
-            started_ = true;
-            if ((flags & DIEP_NORESTART) == 0) {
-                start_time_us_ = now_us();
-            }
-            if (iterations_ == 0) {
-                iterations_ = 1;
-            }
-        }
-        if (is_guid_equal(guid_, GUID_ConstantForce) && constant_force_.lMagnitude != 0) {
-            started_ = true;
-            if (start_time_us_ == 0) {
-                start_time_us_ = now_us();
-            }
-        }
+        trace_set_parameters(owner_->trace_id(), trace_id_, effect, flags);
+        effect_engine::Envelope envelope;
+        effect_.set_parameters(effect_update_from(effect, flags, envelope), now_us());
+        log_type_specific();
         owner_->rebuild_and_send();
     }
     return result;
 }
 
 HRESULT STDMETHODCALLTYPE EffectProxy::Start(DWORD iterations, DWORD flags) {
+    CallTimer timer(ProxyCall::start);
     const HRESULT result = inner_ ? inner_->Start(iterations, flags) : DI_OK;
     if (SUCCEEDED(result)) {
         append_proxy_logf("EffectProxy::Start effect=%s iterations=%lu flags=0x%08lx",
-                          effect_guid_name(guid_),
+                          effect_engine::effect_type_name(effect_.type()),
                           static_cast<unsigned long>(iterations),
                           static_cast<unsigned long>(flags));
-        iterations_ = (iterations == 0) ? 1 : iterations;
-        started_ = true;
-        start_time_us_ = now_us();
+        if (g_trace.enabled()) {
+            dinput_trace::StartEvent event;
+            event.header = trace_header(owner_->trace_id(), trace_id_);
+            event.iterations = iterations;
+            event.flags = flags;
+            g_trace.record(dinput_trace::EventType::start, &event, sizeof(event));
+        }
+        effect_.start(iterations, now_us());
         owner_->rebuild_and_send();
     }
     return result;
 }
 
 HRESULT STDMETHODCALLTYPE EffectProxy::Stop() {
+    CallTimer timer(ProxyCall::stop);
     const HRESULT result = inner_ ? inner_->Stop() : DI_OK;
     if (SUCCEEDED(result)) {
-        append_proxy_logf("EffectProxy::Stop effect=%s", effect_guid_name(guid_));
-        started_ = false;
-        iterations_ = 1;
+        append_proxy_logf("EffectProxy::Stop effect=%s", effect_engine::effect_type_name(effect_.type()));
+        trace_event(dinput_trace::EventType::stop, owner_->trace_id(), trace_id_);
+        effect_.stop();
         owner_->rebuild_and_send();
     }
     return result;
@@ -787,7 +941,7 @@ HRESULT STDMETHODCALLTYPE EffectProxy::GetEffectStatus(LPDWORD flags) {
     if (inner_) {
         return inner_->GetEffectStatus(flags);
     }
-    *flags = is_temporally_active(now_us()) ? DIEGES_PLAYING : 0;
+    *flags = effect_.is_temporally_active(now_us()) ? DIEGES_PLAYING : 0;
     return DI_OK;
 }
 
@@ -795,296 +949,49 @@ HRESULT STDMETHODCALLTYPE EffectProxy::Download() { return inner_ ? inner_->Down
 HRESULT STDMETHODCALLTYPE EffectProxy::Unload() { return inner_ ? inner_->Unload() : DI_OK; }
 HRESULT STDMETHODCALLTYPE EffectProxy::Escape(LPDIEFFESCAPE escape) { return inner_ ? inner_->Escape(escape) : DI_OK; }
 
-bool EffectProxy::has_time_varying_force() const {
-    if (!started_) {
-        return false;
-    }
-
-    return is_guid_equal(guid_, GUID_RampForce) ||
-           is_guid_equal(guid_, GUID_Sine) ||
-           is_guid_equal(guid_, GUID_Square) ||
-           is_guid_equal(guid_, GUID_Triangle) ||
-           is_guid_equal(guid_, GUID_SawtoothUp) ||
-           is_guid_equal(guid_, GUID_SawtoothDown);
-}
-
-void EffectProxy::refresh_runtime(ULONGLONG now) {
-    if (started_ && has_expired(now)) {
-        started_ = false;
-        iterations_ = 1;
-    }
-}
-
-void EffectProxy::force_stop_runtime() {
-    started_ = false;
-    iterations_ = 1;
-}
-
-void EffectProxy::update_from_effect(LPCDIEFFECT effect, DWORD flags) {
-    if (!effect) {
-        return;
-    }
-
-    const bool all_params = (flags & DIEP_ALLPARAMS) == DIEP_ALLPARAMS;
-    if (all_params || (flags & DIEP_GAIN) != 0) {
-        effect_gain_ = clamp_dword(effect->dwGain, 0, DI_FFNOMINALMAX);
-    }
-    if (all_params || (flags & DIEP_DURATION) != 0) {
-        duration_ = effect->dwDuration;
-    }
-    if (all_params || (flags & DIEP_STARTDELAY) != 0) {
-        start_delay_ = effect->dwStartDelay;
-    }
-    if ((all_params || (flags & DIEP_DIRECTION) != 0) && effect->cAxes > 0 && effect->rglDirection) {
-        direction_flags_ = effect->dwFlags;
-        if ((direction_flags_ & (DIEFF_CARTESIAN | DIEFF_POLAR | DIEFF_SPHERICAL)) == 0) {
-            direction_flags_ |= DIEFF_POLAR;
-        }
-        direction_[0] = effect->rglDirection[0];
-        direction_[1] = (effect->cAxes > 1) ? effect->rglDirection[1] : effect->rglDirection[0];
-    }
-    if (all_params || (flags & DIEP_ENVELOPE) != 0) {
-        envelope_enabled_ = effect->lpEnvelope != nullptr;
-        if (effect->lpEnvelope) {
-            envelope_ = *effect->lpEnvelope;
-        }
-    }
-
-    if ((all_params || (flags & DIEP_TYPESPECIFICPARAMS) != 0) &&
-        effect->lpvTypeSpecificParams && effect->cbTypeSpecificParams > 0) {
-        if (is_guid_equal(guid_, GUID_Spring) || is_guid_equal(guid_, GUID_Damper) ||
-            is_guid_equal(guid_, GUID_Friction) || is_guid_equal(guid_, GUID_Inertia)) {
-            const auto* conditions = static_cast<const DICONDITION*>(effect->lpvTypeSpecificParams);
-            condition_count_ = min_dword(2, effect->cbTypeSpecificParams / sizeof(DICONDITION));
-            if (condition_count_ == 0) {
-                condition_count_ = 1;
-            }
-            for (DWORD i = 0; i < condition_count_; ++i) {
-                conditions_[i] = conditions[i];
-            }
-            if (condition_count_ == 1) {
-                conditions_[1] = conditions_[0];
-            }
-        } else if (is_guid_equal(guid_, GUID_ConstantForce)) {
-            constant_force_ = *static_cast<const DICONSTANTFORCE*>(effect->lpvTypeSpecificParams);
-        } else if (is_guid_equal(guid_, GUID_RampForce)) {
-            ramp_force_ = *static_cast<const DIRAMPFORCE*>(effect->lpvTypeSpecificParams);
-        } else {
-            periodic_force_ = *static_cast<const DIPERIODIC*>(effect->lpvTypeSpecificParams);
-            if (periodic_force_.dwPeriod == 0) {
-                periodic_force_.dwPeriod = 100000;
-            }
-        }
-    }
-
-    if (is_guid_equal(guid_, GUID_ConstantForce)) {
+void EffectProxy::log_type_specific() const {
+    using effect_engine::EffectType;
+    if (effect_.type() == EffectType::constant_force) {
         append_proxy_logf("EffectProxy::ConstantForce magnitude=%ld",
-                          static_cast<long>(constant_force_.lMagnitude));
-    } else if (is_guid_equal(guid_, GUID_RampForce)) {
+                          static_cast<long>(effect_.constant_force().magnitude));
+    } else if (effect_.type() == EffectType::ramp_force) {
         append_proxy_logf("EffectProxy::RampForce start=%ld end=%ld",
-                          static_cast<long>(ramp_force_.lStart),
-                          static_cast<long>(ramp_force_.lEnd));
-    } else if (is_guid_equal(guid_, GUID_Sine) || is_guid_equal(guid_, GUID_Square) ||
-               is_guid_equal(guid_, GUID_Triangle) || is_guid_equal(guid_, GUID_SawtoothUp) ||
-               is_guid_equal(guid_, GUID_SawtoothDown)) {
+                          static_cast<long>(effect_.ramp_force().start),
+                          static_cast<long>(effect_.ramp_force().end));
+    } else if (effect_engine::is_periodic(effect_.type())) {
         append_proxy_logf("EffectProxy::Periodic magnitude=%lu offset=%ld period=%lu",
-                          static_cast<unsigned long>(periodic_force_.dwMagnitude),
-                          static_cast<long>(periodic_force_.lOffset),
-                          static_cast<unsigned long>(periodic_force_.dwPeriod));
-    }
-}
-
-float EffectProxy::direction_multiplier() const {
-    if ((direction_flags_ & DIEFF_CARTESIAN) != 0) {
-        if (direction_[0] == 0) {
-            return 1.0f;
-        }
-        float cartesian = static_cast<float>(direction_[0]) / static_cast<float>(DI_FFNOMINALMAX);
-        if (cartesian > 1.0f) {
-            cartesian = 1.0f;
-        } else if (cartesian < -1.0f) {
-            cartesian = -1.0f;
-        }
-        return cartesian;
-    }
-
-    if ((direction_flags_ & (DIEFF_POLAR | DIEFF_SPHERICAL)) == 0) {
-        return 1.0f;
-    }
-
-    const double angle = (static_cast<double>(direction_[0]) * kTwoPi) / 36000.0;
-    return static_cast<float>(std::cos(angle));
-}
-
-float EffectProxy::envelope_multiplier(ULONGLONG active_elapsed, ULONGLONG total_duration) const {
-    if (!envelope_enabled_) {
-        return 1.0f;
-    }
-
-    const float attack_level = static_cast<float>(clamp_dword(envelope_.dwAttackLevel, 0, DI_FFNOMINALMAX)) /
-                               static_cast<float>(DI_FFNOMINALMAX);
-    const float fade_level = static_cast<float>(clamp_dword(envelope_.dwFadeLevel, 0, DI_FFNOMINALMAX)) /
-                             static_cast<float>(DI_FFNOMINALMAX);
-
-    if (envelope_.dwAttackTime > 0 && active_elapsed < envelope_.dwAttackTime) {
-        const float attack_t = static_cast<float>(active_elapsed) / static_cast<float>(envelope_.dwAttackTime);
-        return attack_level + (1.0f - attack_level) * attack_t;
-    }
-
-    if (duration_ != INFINITE && envelope_.dwFadeTime > 0 && total_duration > 0 && active_elapsed < total_duration) {
-        const ULONGLONG fade_start = (total_duration > envelope_.dwFadeTime) ? (total_duration - envelope_.dwFadeTime) : 0ULL;
-        if (active_elapsed >= fade_start) {
-            const ULONGLONG fade_elapsed = active_elapsed - fade_start;
-            const float fade_t = static_cast<float>(fade_elapsed) / static_cast<float>(envelope_.dwFadeTime);
-            return 1.0f + (fade_level - 1.0f) * fade_t;
-        }
-    }
-
-    return 1.0f;
-}
-
-bool EffectProxy::is_temporally_active(ULONGLONG now) const {
-    if (!started_) {
-        return false;
+                          static_cast<unsigned long>(effect_.periodic().magnitude),
+                          static_cast<long>(effect_.periodic().offset),
+                          static_cast<unsigned long>(effect_.periodic().period));
     }
-
-    if (now <= start_time_us_) {
-        return start_delay_ == 0;
-    }
-
-    const ULONGLONG elapsed = now - start_time_us_;
-    if (elapsed < start_delay_) {
-        return false;
-    }
-
-    if (duration_ == INFINITE || iterations_ == INFINITE || duration_ == 0) {
-        return true;
-    }
-
-    const ULONGLONG total_duration = static_cast<ULONGLONG>(duration_) * static_cast<ULONGLONG>(iterations_);
-    const ULONGLONG active_elapsed = elapsed - start_delay_;
-    return active_elapsed < total_duration;
 }
 
-bool EffectProxy::has_expired(ULONGLONG now) const {
-    if (!started_ || duration_ == INFINITE || iterations_ == INFINITE || duration_ == 0) {
-        return false;
-    }
-    if (now <= start_time_us_) {
-        return false;
-    }
-
-    const ULONGLONG elapsed = now - start_time_us_;
-    if (elapsed < start_delay_) {
-        return false;
-    }
-
-    const ULONGLONG total_duration = static_cast<ULONGLONG>(duration_) * static_cast<ULONGLONG>(iterations_);
-    return (elapsed - start_delay_) >= total_duration;
+DeviceProxy::DeviceProxy(IDirectInputDevice8W* inner)
+    : ref_count_(1), inner_(inner), trace_id_(static_cast<std::uint32_t>(InterlockedIncrement(&g_next_trace_id))),
+      effects_(), batch_capacity_(0), ff_gain_(DI_FFNOMINALMAX),
+      autocenter_mode_(DIPROPAUTOCENTER_ON), ff_state_(DIGFFS_EMPTY | DIGFFS_STOPPED | DIGFFS_ACTUATORSON | DIGFFS_POWERON),
+      advertises_force_feedback_(true), last_periodic_rebuild_us_(0), render_running_(false), snapshot_version_(0),
+      render_thread_(nullptr), render_stop_event_(CreateEventW(nullptr, TRUE, FALSE, nullptr)),
+      render_stop_requested_(false), output_filter_() {
+    InitializeSRWLock(&snapshot_lock_);
+    InitializeCriticalSection(&output_lock_);
+    reserve_batches();
+    trace_value(dinput_trace::EventType::device_created, trace_id_, 0, static_cast<DWORD>(render_interval_us()));
 }
 
-LONG EffectProxy::compute_force(ULONGLONG now, DWORD device_gain) const {
-    if (!is_temporally_active(now)) {
-        return 0;
+DeviceProxy::~DeviceProxy() {
+    render_stop_requested_.store(true);
+    if (render_stop_event_) {
+        SetEvent(render_stop_event_);
     }
-
-    const ULONGLONG elapsed = (now > start_time_us_) ? (now - start_time_us_) : 0ULL;
-    const ULONGLONG active_elapsed = (elapsed > start_delay_) ? (elapsed - start_delay_) : 0ULL;
-    const ULONGLONG total_duration =
-        (duration_ == INFINITE || iterations_ == INFINITE || duration_ == 0)
-            ? 0ULL
-            : static_cast<ULONGLONG>(duration_) * static_cast<ULONGLONG>(iterations_);
-
-    LONG raw_force = 0;
-
-    if (is_guid_equal(guid_, GUID_ConstantForce)) {
-        raw_force = constant_force_.lMagnitude;
-    } else if (is_guid_equal(guid_, GUID_RampForce)) {
-        if (duration_ == 0 || duration_ == INFINITE) {
-            raw_force = ramp_force_.lEnd;
-        } else {
-            const DWORD cycle_duration = (duration_ == 0) ? 1 : duration_;
-            const DWORD cycle_elapsed = static_cast<DWORD>(active_elapsed % cycle_duration);
-            const LONG delta = ramp_force_.lEnd - ramp_force_.lStart;
-            raw_force = ramp_force_.lStart +
-                        static_cast<LONG>((static_cast<LONGLONG>(delta) * static_cast<LONGLONG>(cycle_elapsed)) /
-                                          static_cast<LONGLONG>(cycle_duration));
-        }
-    } else if (is_guid_equal(guid_, GUID_Sine) || is_guid_equal(guid_, GUID_Square) ||
-               is_guid_equal(guid_, GUID_Triangle) || is_guid_equal(guid_, GUID_SawtoothUp) ||
-               is_guid_equal(guid_, GUID_SawtoothDown)) {
-        const DWORD period = (periodic_force_.dwPeriod == 0) ? 100000 : periodic_force_.dwPeriod;
-        const double phase_offset = static_cast<double>(periodic_force_.dwPhase) / 36000.0;
-        const double phase = static_cast<double>(active_elapsed % period) / static_cast<double>(period) + phase_offset;
-        const double wave = periodic_wave_sample(guid_, phase);
-        raw_force = static_cast<LONG>(periodic_force_.lOffset +
-                                      static_cast<LONG>(static_cast<double>(periodic_force_.dwMagnitude) * wave));
-    } else {
-        return 0;
+    if (render_thread_) {
+        WaitForSingleObject(render_thread_, INFINITE);
+        CloseHandle(render_thread_);
     }
-
-    const float shaped = static_cast<float>(raw_force) *
-                         envelope_multiplier(active_elapsed, total_duration) *
-                         direction_multiplier();
-    const LONG directed_force = clamp_long(static_cast<LONG>(shaped), -DI_FFNOMINALMAX, DI_FFNOMINALMAX);
-    return apply_combined_gain(directed_force, effect_gain_, device_gain);
-}
-
-void EffectProxy::apply(g923bridge::WheelStatePayload& payload, DWORD device_gain, ULONGLONG now) const {
-    if (!is_temporally_active(now)) {
-        return;
-    }
-
-    if (is_guid_equal(guid_, GUID_Spring)) {
-        payload.custom_spring_enabled = 1;
-        const DWORD combined_positive_sat = apply_combined_gain_unsigned(
-            conditions_[0].dwPositiveSaturation, effect_gain_, device_gain);
-        const DWORD combined_negative_sat = apply_combined_gain_unsigned(
-            conditions_[1].dwNegativeSaturation, effect_gain_, device_gain);
-        const LONG combined_positive_coeff = apply_combined_gain(
-            abs_long(conditions_[0].lPositiveCoefficient), effect_gain_, device_gain);
-        const LONG combined_negative_coeff = apply_combined_gain(
-            abs_long(conditions_[1].lNegativeCoefficient), effect_gain_, device_gain);
-
-        payload.spring_k1 = max_u8(payload.spring_k1, scale_nibble(combined_positive_coeff));
-        payload.spring_k2 = max_u8(payload.spring_k2, scale_nibble(combined_negative_coeff));
-        payload.spring_sat1 = max_u8(payload.spring_sat1, scale_nibble(static_cast<LONG>(combined_positive_sat)));
-        payload.spring_sat2 = max_u8(payload.spring_sat2, scale_nibble(static_cast<LONG>(combined_negative_sat)));
-        payload.spring_deadband_left = max_u8(payload.spring_deadband_left, scale_nibble(conditions_[0].lDeadBand));
-        payload.spring_deadband_right = max_u8(payload.spring_deadband_right, scale_nibble(conditions_[1].lDeadBand));
-        payload.spring_clip = max_u8(
-            payload.spring_clip,
-            scale_byte(static_cast<LONG>(max_dword(combined_positive_sat, combined_negative_sat))));
-    } else if (is_guid_equal(guid_, GUID_Damper) || is_guid_equal(guid_, GUID_Friction) || is_guid_equal(guid_, GUID_Inertia)) {
-        payload.damper_enabled = 1;
-        payload.damper_force_positive = max_u8(
-            payload.damper_force_positive,
-            scale_byte(apply_combined_gain(abs_long(conditions_[0].lPositiveCoefficient), effect_gain_, device_gain)));
-        payload.damper_force_negative = max_u8(
-            payload.damper_force_negative,
-            scale_byte(apply_combined_gain(abs_long(conditions_[1].lNegativeCoefficient), effect_gain_, device_gain)));
-        payload.damper_saturation_positive =
-            max_u8(payload.damper_saturation_positive, scale_byte(static_cast<LONG>(apply_combined_gain_unsigned(
-                conditions_[0].dwPositiveSaturation, effect_gain_, device_gain))));
-        payload.damper_saturation_negative =
-            max_u8(payload.damper_saturation_negative, scale_byte(static_cast<LONG>(apply_combined_gain_unsigned(
-                conditions_[1].dwNegativeSaturation, effect_gain_, device_gain))));
-    } else {
-        const LONG force = compute_force(now, device_gain);
-        if (force != 0) {
-            payload.constant_force_enabled = 1;
-            payload.constant_force_magnitude = static_cast<std::int16_t>(
-                clamp_long(static_cast<LONG>(payload.constant_force_magnitude) + force,
-                           -DI_FFNOMINALMAX, DI_FFNOMINALMAX));
-        }
+    if (render_stop_event_) {
+        CloseHandle(render_stop_event_);
     }
-}
-
-DeviceProxy::DeviceProxy(IDirectInputDevice8W* inner)
-    : ref_count_(1), inner_(inner), effects_{}, effect_count_(0), ff_gain_(DI_FFNOMINALMAX),
-      autocenter_mode_(DIPROPAUTOCENTER_ON), ff_state_(DIGFFS_EMPTY | DIGFFS_STOPPED | DIGFFS_ACTUATORSON | DIGFFS_POWERON),
-      advertises_force_feedback_(true), last_sent_has_state_(false), have_last_payload_(false),
-      last_periodic_rebuild_us_(0), last_payload_{} {
+    DeleteCriticalSection(&output_lock_);
 }
 
 ULONG STDMETHODCALLTYPE DeviceProxy::AddRef() {
@@ -1203,6 +1110,7 @@ HRESULT STDMETHODCALLTYPE DeviceProxy::GetProperty(REFGUID prop, LPDIPROPHEADER
 }
 
 HRESULT STDMETHODCALLTYPE DeviceProxy::SetProperty(REFGUID prop, LPCDIPROPHEADER header) {
+    CallTimer timer(ProxyCall::set_property);
     if (!header) {
         return E_POINTER;
     }
@@ -1212,6 +1120,7 @@ HRESULT STDMETHODCALLTYPE DeviceProxy::SetProperty(REFGUID prop, LPCDIPROPHEADER
             return DIERR_INVALIDPARAM;
         }
         ff_gain_ = clamp_dword(reinterpret_cast<const DIPROPDWORD*>(header)->dwData, 0, DI_FFNOMINALMAX);
+        trace_value(dinput_trace::EventType::set_gain, trace_id_, 0, ff_gain_);
         rebuild_and_send();
         return DI_OK;
     }
@@ -1221,6 +1130,7 @@ HRESULT STDMETHODCALLTYPE DeviceProxy::SetProperty(REFGUID prop, LPCDIPROPHEADER
             return DIERR_INVALIDPARAM;
         }
         autocenter_mode_ = reinterpret_cast<const DIPROPDWORD*>(header)->dwData;
+        trace_value(dinput_trace::EventType::set_autocenter, trace_id_, 0, autocenter_mode_);
         rebuild_and_send();
         return DI_OK;
     }
@@ -1229,15 +1139,20 @@ HRESULT STDMETHODCALLTYPE DeviceProxy::SetProperty(REFGUID prop, LPCDIPROPHEADER
 }
 HRESULT STDMETHODCALLTYPE DeviceProxy::Acquire() { return inner_->Acquire(); }
 HRESULT STDMETHODCALLTYPE DeviceProxy::Unacquire() {
-    g_bridge_client.send_stop_all();
+    trace_event(dinput_trace::EventType::unacquire, trace_id_);
     ff_state_ |= DIGFFS_STOPPED | DIGFFS_EMPTY;
-    have_last_payload_ = false;
-    last_sent_has_state_ = false;
-    last_payload_ = g923bridge::WheelStatePayload{};
+    publish_snapshot(true);
+    stop_output();
+    g_trace.flush();
     return inner_->Unacquire();
 }
-HRESULT STDMETHODCALLTYPE DeviceProxy::GetDeviceState(DWORD size, LPVOID data) { return inner_->GetDeviceState(size, data); }
+// Reading input starts the game's next frame, so the updates of the last one are complete
+HRESULT STDMETHODCALLTYPE DeviceProxy::GetDeviceState(DWORD size, LPVOID data) {
+    g_bridge_client.flush();
+    return inner_->GetDeviceState(size, data);
+}
 HRESULT STDMETHODCALLTYPE DeviceProxy::GetDeviceData(DWORD size, LPDIDEVICEOBJECTDATA data, LPDWORD inout, DWORD flags) {
+    g_bridge_client.flush();
     return inner_->GetDeviceData(size, data, inout, flags);
 }
 HRESULT STDMETHODCALLTYPE DeviceProxy::SetDataFormat(LPCDIDATAFORMAT format) { return inner_->SetDataFormat(format); }
@@ -1320,13 +1235,23 @@ HRESULT STDMETHODCALLTYPE DeviceProxy::EnumCreatedEffectObjects(LPDIENUMCREATEDE
 }
 HRESULT STDMETHODCALLTYPE DeviceProxy::Escape(LPDIEFFESCAPE escape) { return inner_->Escape(escape); }
 HRESULT STDMETHODCALLTYPE DeviceProxy::Poll() {
+    CallTimer timer(ProxyCall::poll);
+    TraceZone zone("DeviceProxy::Poll");
     const HRESULT result = inner_->Poll();
+    trace_event(dinput_trace::EventType::poll, trace_id_);
     const ULONGLONG now = now_us();
-    if (has_active_time_varying_effect() &&
-        (last_periodic_rebuild_us_ == 0 || (now - last_periodic_rebuild_us_) >= kPeriodicUpdateIntervalUs)) {
+    const bool time_varying = has_active_time_varying_effect();
+    if (render_interval_us() != 0) {
+        // The render thread keeps these effects moving; Poll only restarts it, e.g. after Unacquire
+        if (time_varying && !render_active()) {
+            rebuild_and_send();
+        }
+    } else if (time_varying && (last_periodic_rebuild_us_ == 0 ||
+                                (now - last_periodic_rebuild_us_) >= effect_engine::kPeriodicUpdateIntervalUs)) {
         rebuild_and_send();
         last_periodic_rebuild_us_ = now;
     }
+    g_bridge_client.flush();
     return result;
 }
 HRESULT STDMETHODCALLTYPE DeviceProxy::SendDeviceData(DWORD size, LPCDIDEVICEOBJECTDATA data, LPDWORD inout, DWORD flags) {
@@ -1354,7 +1279,7 @@ HRESULT STDMETHODCALLTYPE DeviceProxy::CreateEffect(
     }
 
     IDirectInputEffect* inner_effect = nullptr;
-    append_proxy_logf("CreateEffect called effect=%s", effect_guid_name(guid));
+    append_proxy_logf("CreateEffect called effect=%s", effect_engine::effect_type_name(effect_type_from_guid(guid)));
     HRESULT result = inner_->CreateEffect(guid, effect, &inner_effect, outer);
     if (FAILED(result) || !inner_effect) {
         inner_effect = nullptr;
@@ -1362,44 +1287,43 @@ HRESULT STDMETHODCALLTYPE DeviceProxy::CreateEffect(
         append_proxy_log("CreateEffect using software fallback");
     }
 
+    // Tracked before its first SetParameters so that rebuild already includes it
     auto* proxy = new EffectProxy(inner_effect, guid, this);
+    proxy->set_table_handle(effects_.insert(proxy));
+    reserve_batches();
+    trace_event(dinput_trace::EventType::effect_added, trace_id_, proxy->trace_id());
     if (effect) {
         proxy->SetParameters(effect, DIEP_ALLPARAMS);
     }
-    if (effect_count_ < kMaxEffects) {
-        effects_[effect_count_++] = proxy;
-    } else {
-        append_proxy_log("effect table full, not tracking additional effect");
-    }
     *out = proxy;
     return result;
 }
 
 HRESULT STDMETHODCALLTYPE DeviceProxy::SendForceFeedbackCommand(DWORD command) {
+    CallTimer timer(ProxyCall::send_force_feedback_command);
     append_proxy_logf("SendForceFeedbackCommand command=0x%08lx",
                       static_cast<unsigned long>(command));
     HRESULT result = inner_->SendForceFeedbackCommand(command);
     if (FAILED(result)) {
         result = DI_OK;
     }
+    trace_value(dinput_trace::EventType::ff_command, trace_id_, 0, command);
 
     switch (command) {
         case DISFFC_RESET:
         case DISFFC_STOPALL:
-            for (int i = 0; i < effect_count_; ++i) {
-                if (effects_[i]) {
-                    effects_[i]->force_stop_runtime();
-                }
+            for (EffectProxy* tracked : effects_) {
+                tracked->force_stop_runtime();
             }
             ff_state_ |= DIGFFS_STOPPED | DIGFFS_EMPTY;
             ff_state_ &= ~DIGFFS_PAUSED;
-            g_bridge_client.send_stop_all();
-            have_last_payload_ = false;
-            last_sent_has_state_ = false;
-            last_payload_ = g923bridge::WheelStatePayload{};
+            build_batch();
+            publish_snapshot();
+            stop_output();
             break;
         case DISFFC_PAUSE:
             ff_state_ |= DIGFFS_PAUSED;
+            publish_snapshot();
             break;
         case DISFFC_CONTINUE:
             ff_state_ &= ~DIGFFS_PAUSED;
@@ -1411,17 +1335,14 @@ HRESULT STDMETHODCALLTYPE DeviceProxy::SendForceFeedbackCommand(DWORD command) {
             rebuild_and_send();
             break;
         case DISFFC_SETACTUATORSOFF:
-            for (int i = 0; i < effect_count_; ++i) {
-                if (effects_[i]) {
-                    effects_[i]->force_stop_runtime();
-                }
+            for (EffectProxy* tracked : effects_) {
+                tracked->force_stop_runtime();
             }
             ff_state_ |= DIGFFS_ACTUATORSOFF;
             ff_state_ &= ~DIGFFS_ACTUATORSON;
-            g_bridge_client.send_stop_all();
-            have_last_payload_ = false;
-            last_sent_has_state_ = false;
-            last_payload_ = g923bridge::WheelStatePayload{};
+            build_batch();
+            publish_snapshot();
+            stop_output();
             break;
         default:
             break;
@@ -1431,83 +1352,248 @@ HRESULT STDMETHODCALLTYPE DeviceProxy::SendForceFeedbackCommand(DWORD command) {
 }
 
 void DeviceProxy::remove_effect(EffectProxy* effect) {
-    for (int i = 0; i < effect_count_; ++i) {
-        if (effects_[i] == effect) {
-            for (int j = i; j < effect_count_ - 1; ++j) {
-                effects_[j] = effects_[j + 1];
-            }
-            effects_[effect_count_ - 1] = nullptr;
-            --effect_count_;
-            break;
-        }
-    }
+    effects_.erase(effect->table_handle());
     rebuild_and_send();
 }
 
+void DeviceProxy::send_stop_all() {
+    g_bridge_client.send_stop_all();
+    trace_event(dinput_trace::EventType::stop_sent, trace_id_);
+}
+
 bool DeviceProxy::has_active_time_varying_effect() const {
-    for (int i = 0; i < effect_count_; ++i) {
-        if (effects_[i] && effects_[i]->has_time_varying_force()) {
+    for (const EffectProxy* tracked : effects_) {
+        if (tracked->has_time_varying_force()) {
             return true;
         }
     }
     return false;
 }
 
+// Device-level gain, autocenter and pause handling applied after the effects
+void finish_payload(g923bridge::WheelStatePayload& payload, DWORD ff_gain, DWORD autocenter_mode, DWORD ff_state) {
+    if (autocenter_mode == DIPROPAUTOCENTER_ON) {
+        effect_engine::apply_autocenter_fallback(payload, ff_gain);
+    }
+
+    if ((ff_state & DIGFFS_PAUSED) != 0 || (ff_state & DIGFFS_ACTUATORSOFF) != 0) {
+        payload = g923bridge::WheelStatePayload{};
+    }
+}
+
 void DeviceProxy::rebuild_and_send() {
+    TraceZone zone("DeviceProxy::rebuild_and_send");
+    NoAllocScope no_alloc("DeviceProxy::rebuild_and_send");
     const ULONGLONG now = now_us();
+    for (EffectProxy* tracked : effects_) {
+        tracked->refresh_runtime(now);
+    }
+    build_batch();
+
     g923bridge::WheelStatePayload payload{};
+    batch_.evaluate(payload, now);
+    finish_payload(payload, ff_gain_, autocenter_mode_, ff_state_);
+
+    if (effect_engine::has_state(payload)) {
+        ff_state_ &= ~DIGFFS_EMPTY;
+        ff_state_ &= ~DIGFFS_STOPPED;
+    } else {
+        ff_state_ |= DIGFFS_EMPTY | DIGFFS_STOPPED;
+    }
 
-    for (int i = 0; i < effect_count_; ++i) {
-        if (effects_[i]) {
-            effects_[i]->refresh_runtime(now);
-            effects_[i]->apply(payload, ff_gain_, now);
+    publish_snapshot();
+    submit(payload, 0);
+}
+
+void DeviceProxy::reserve_batches() {
+    if (batch_capacity_ != 0 && effects_.size() <= batch_capacity_) {
+        return;
+    }
+    batch_capacity_ = batch_capacity_ == 0 ? kInitialEffectCapacity : batch_capacity_ * 2;
+    effects_.reserve(batch_capacity_);
+    batch_.reserve(batch_capacity_);
+    AcquireSRWLockExclusive(&snapshot_lock_);
+    snapshot_.effects.reserve(batch_capacity_);
+    ReleaseSRWLockExclusive(&snapshot_lock_);
+}
+
+void DeviceProxy::build_batch() {
+    batch_.clear();
+    for (const EffectProxy* tracked : effects_) {
+        batch_.add(tracked->effect(), ff_gain_);
+    }
+}
+
+void DeviceProxy::publish_snapshot(bool suspend_render) {
+    const bool time_varying = !suspend_render && batch_.has_time_varying_force(now_us());
+    AcquireSRWLockExclusive(&snapshot_lock_);
+    snapshot_.effects = batch_;
+    snapshot_.ff_gain = ff_gain_;
+    snapshot_.autocenter_mode = autocenter_mode_;
+    snapshot_.ff_state = ff_state_;
+    snapshot_.time_varying = time_varying;
+    snapshot_.version = snapshot_version_.fetch_add(1) + 1;
+
+    const bool start_render = snapshot_.time_varying && !render_running_ && render_interval_us() != 0;
+    if (start_render) {
+        render_running_ = true;
+    }
+    ReleaseSRWLockExclusive(&snapshot_lock_);
+
+    if (start_render) {
+        // A previous render thread has already given up the snapshot and is only exiting
+        if (render_thread_) {
+            WaitForSingleObject(render_thread_, INFINITE);
+            CloseHandle(render_thread_);
+        }
+        render_thread_ = CreateThread(nullptr, 0, &DeviceProxy::render_main, this, 0, nullptr);
+        if (!render_thread_) {
+            AcquireSRWLockExclusive(&snapshot_lock_);
+            render_running_ = false;
+            ReleaseSRWLockExclusive(&snapshot_lock_);
+            append_proxy_log("render thread failed to start");
         }
     }
+}
 
-    if (autocenter_mode_ == DIPROPAUTOCENTER_ON && !payload.custom_spring_enabled) {
-        constexpr DWORD kAutocenterFallbackNominal = 3200;
-        payload.autocenter_enabled = 1;
-        payload.autocenter_force = max_u8(
-            payload.autocenter_force,
-            scale_byte(static_cast<LONG>(apply_unsigned_gain(ff_gain_, kAutocenterFallbackNominal))));
-        payload.autocenter_slope = max_u8(payload.autocenter_slope, 4);
+bool DeviceProxy::render_active() {
+    AcquireSRWLockShared(&snapshot_lock_);
+    const bool active = render_running_;
+    ReleaseSRWLockShared(&snapshot_lock_);
+    return active;
+}
+
+void DeviceProxy::stop_output() {
+    EnterCriticalSection(&output_lock_);
+    send_stop_all();
+    output_filter_.reset();
+    LeaveCriticalSection(&output_lock_);
+}
+
+void DeviceProxy::submit(const g923bridge::WheelStatePayload& payload, std::uint64_t render_version,
+                         ULONGLONG render_now) {
+    EnterCriticalSection(&output_lock_);
+    if (render_version != 0 && render_version != snapshot_version_.load()) {
+        LeaveCriticalSection(&output_lock_);
+        return;
+    }
+    if (render_version != 0 && g_trace.enabled()) {
+        // Recorded under the output lock, so it lands in order with the game thread's sends
+        dinput_trace::EventHeader header = trace_header(trace_id_, 0);
+        header.clock_us = render_now;
+        g_trace.record(dinput_trace::EventType::render_tick, &header, sizeof(header));
+    }
+
+    switch (output_filter_.filter(payload)) {
+        case effect_engine::OutputFilter::Action::send_state:
+            // The render thread sends at its own cadence, so only game-thread states are logged and
+            // held back for the rest of their frame's updates
+            if (render_version == 0) {
+                append_proxy_logf(
+                    "rebuild_and_send spring=%u damper=%u constant=%u constant_mag=%d",
+                    static_cast<unsigned>(payload.custom_spring_enabled),
+                    static_cast<unsigned>(payload.damper_enabled),
+                    static_cast<unsigned>(payload.constant_force_enabled),
+                    static_cast<int>(payload.constant_force_magnitude));
+                g_bridge_client.queue_state(payload);
+            } else {
+                g_bridge_client.send_state(payload);
+            }
+            if (g_trace.enabled()) {
+                dinput_trace::StateSentEvent event;
+                event.header = trace_header(trace_id_, 0);
+                event.payload = payload;
+                g_trace.record(dinput_trace::EventType::state_sent, &event, sizeof(event));
+            }
+            break;
+        case effect_engine::OutputFilter::Action::send_stop_all:
+            append_proxy_log(render_version == 0 ? "rebuild_and_send stop_all" : "render stop_all");
+            send_stop_all();
+            break;
+        case effect_engine::OutputFilter::Action::none:
+            break;
     }
+    LeaveCriticalSection(&output_lock_);
+}
 
-    if ((ff_state_ & DIGFFS_PAUSED) != 0 || (ff_state_ & DIGFFS_ACTUATORSOFF) != 0) {
-        payload = g923bridge::WheelStatePayload{};
+DWORD WINAPI DeviceProxy::render_main(LPVOID parameter) {
+    static_cast<DeviceProxy*>(parameter)->run_render();
+    return 0;
+}
+
+// Ticks on absolute deadlines so the cadence does not drift with evaluation time; a tick that
+// wakes more than a period late skips ahead instead of bursting to catch up
+void DeviceProxy::run_render() {
+    trace_zones::prepare_thread("proxy render");
+    const std::uint64_t interval_us = render_interval_us();
+    HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!timer) {
+        timer = CreateWaitableTimerW(nullptr, FALSE, nullptr);
     }
 
-    const bool has_state =
-        payload.autocenter_enabled || payload.custom_spring_enabled ||
-        payload.damper_enabled || payload.constant_force_enabled;
+    ULONGLONG deadline = now_us();
+    while (!render_stop_requested_.load()) {
+        deadline += interval_us;
+        ULONGLONG now = now_us();
+        if (deadline > now) {
+            LARGE_INTEGER due{};
+            due.QuadPart = -static_cast<LONGLONG>((deadline - now) * 10);
+            if (timer && SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE)) {
+                HANDLE handles[2] = {timer, render_stop_event_};
+                WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+            } else {
+                WaitForSingleObject(render_stop_event_, static_cast<DWORD>((deadline - now + 999) / 1000));
+            }
+            if (render_stop_requested_.load()) {
+                break;
+            }
+            now = now_us();
+        }
 
-    if (has_state) {
-        ff_state_ &= ~DIGFFS_EMPTY;
-        ff_state_ &= ~DIGFFS_STOPPED;
-        const bool payload_changed =
-            !have_last_payload_ || std::memcmp(&payload, &last_payload_, sizeof(payload)) != 0;
-        if (payload_changed) {
-            append_proxy_logf(
-                "rebuild_and_send spring=%u damper=%u constant=%u constant_mag=%d",
-                static_cast<unsigned>(payload.custom_spring_enabled),
-                static_cast<unsigned>(payload.damper_enabled),
-                static_cast<unsigned>(payload.constant_force_enabled),
-                static_cast<int>(payload.constant_force_magnitude));
-            g_bridge_client.send_state(payload);
-            last_payload_ = payload;
-            have_last_payload_ = true;
+        const ULONGLONG late_us = now > deadline ? now - deadline : 0;
+        g_render_lateness.record(late_us * 1000);
+        if (late_us >= interval_us) {
+            g_render_overruns.fetch_add(1, std::memory_order_relaxed);
+            deadline = now;
         }
-        last_sent_has_state_ = true;
-    } else {
-        ff_state_ |= DIGFFS_EMPTY | DIGFFS_STOPPED;
-        have_last_payload_ = false;
-        if (last_sent_has_state_) {
-            append_proxy_log("rebuild_and_send stop_all");
-            g_bridge_client.send_stop_all();
-            last_sent_has_state_ = false;
-            last_payload_ = g923bridge::WheelStatePayload{};
+
+        if (!render_tick(now)) {
+            break;
         }
     }
+
+    if (timer) {
+        CloseHandle(timer);
+    }
+}
+
+// Returns false once no time-varying effect is left in the latest snapshot
+bool DeviceProxy::render_tick(ULONGLONG now) {
+    TraceZone zone("DeviceProxy::render_tick");
+    AcquireSRWLockShared(&snapshot_lock_);
+    render_copy_ = snapshot_;
+    ReleaseSRWLockShared(&snapshot_lock_);
+
+    g923bridge::WheelStatePayload payload{};
+    bool time_varying = false;
+    if (render_copy_.time_varying) {
+        render_copy_.effects.evaluate(payload, now);
+        time_varying = render_copy_.effects.has_time_varying_force(now);
+        finish_payload(payload, render_copy_.ff_gain, render_copy_.autocenter_mode, render_copy_.ff_state);
+        submit(payload, render_copy_.version, now);
+    }
+    if (time_varying) {
+        return true;
+    }
+
+    // Nothing left to animate: give up the thread unless a game thread published since the copy
+    AcquireSRWLockExclusive(&snapshot_lock_);
+    const bool superseded = snapshot_.version != render_copy_.version;
+    if (!superseded) {
+        render_running_ = false;
+    }
+    ReleaseSRWLockExclusive(&snapshot_lock_);
+    return superseded;
 }
 
 }  // namespace
@@ -1516,7 +1602,13 @@ extern "C" BOOL WINAPI DllMain(HINSTANCE instance, DWORD reason, LPVOID reserved
     (void)reserved;
     if (reason == DLL_PROCESS_ATTACH) {
         g_this_module = instance;
+        char log_path[MAX_PATH] = {0};
+        g_proxy_log.initialize(module_sibling_path("g923mac_proxy.log", log_path) ? log_path : nullptr);
         g_bridge_client.initialize();
+        char trace_path[MAX_PATH] = {0};
+        if (module_sibling_path("g923mac_proxy.trace", trace_path)) {
+            g_trace.initialize(trace_path);
+        }
         DisableThreadLibraryCalls(instance);
         append_proxy_log("proxy attached");
         ensure_real_dinput_loaded();
@@ -1524,6 +1616,15 @@ extern "C" BOOL WINAPI DllMain(HINSTANCE instance, DWORD reason, LPVOID reserved
         append_proxy_log("proxy detaching");
         g_bridge_client.send_stop_all();
         g_bridge_client.shutdown();
+        log_proxy_stats();
+        g_trace.shutdown();
+        g_proxy_log.shutdown();
+#ifdef G923_TRACE_ZONES
+        char zones_path[MAX_PATH] = {0};
+        if (module_sibling_path("g923mac_proxy_zones.json", zones_path)) {
+            trace_zones::write_chrome_trace(zones_path);
+        }
+#endif
         InterlockedExchange(&g_bridge_announced, 0);
         g_this_module = nullptr;
     }
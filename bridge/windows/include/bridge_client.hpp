@@ -1,27 +1,117 @@
 #pragma once
 
 #include "ffb_bridge_protocol.hpp"
+#include "state_mailbox.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <winsock2.h>
 #include <windows.h>
 
+// Game threads hand states to a mailbox and return; a sender thread owns the socket, says
+// hello, and transmits the newest state or a pending stop_all whenever it is woken. While the
+// bridge is unreachable the sender retries a non-blocking connect with exponential backoff and
+// replays the latest state as soon as a connection is accepted.
+//
+// Queued states are held for a short coalescing window opened by the first of them, so a burst
+// of effect updates in one frame reaches the bridge as its last state. A flush, an immediate
+// send or a stop_all closes the window early.
 class BridgeClient {
 public:
+    struct Stats {
+        std::uint64_t states_published = 0;
+        std::uint64_t states_sent = 0;
+        std::uint64_t stops_sent = 0;
+        std::uint64_t send_failures = 0;
+        std::uint64_t connect_attempts = 0;
+        std::uint64_t connect_failures = 0;
+        // From starting a connect to it being accepted or refused, summed over attempts
+        std::uint64_t connect_wait_us = 0;
+        std::uint64_t state_replays = 0;
+        std::uint64_t states_queued = 0;
+        std::uint64_t coalesce_windows = 0;
+        // Windows closed by a flush, an immediate send or a stop_all before they ran out
+        std::uint64_t windows_closed_early = 0;
+    };
+
     void initialize();
+    // Stops the sender after it has flushed anything still pending
     void shutdown();
 
-    bool send_hello(const char* client_name, std::uint32_t process_id);
-    bool send_state(const g923bridge::WheelStatePayload& state);
-    bool send_stop_all();
+    void send_hello(const char* client_name, std::uint32_t process_id);
+    void send_state(const g923bridge::WheelStatePayload& state);
+    // Like send_state, but waits out the coalescing window; only wakes the sender to open one
+    void queue_state(const g923bridge::WheelStatePayload& state);
+    // Sends queued states now instead of at the end of their window; free when none are queued
+    void flush();
+    void send_stop_all();
+
+    Stats stats() const;
 
 private:
-    bool ensure_connected_locked();
-    bool send_message_locked(g923bridge::MessageType type, const void* payload, std::uint32_t payload_size);
-    void disconnect_locked();
+    using clock = std::chrono::steady_clock;
 
-    CRITICAL_SECTION lock_;
-    SOCKET socket_;
-    bool hello_sent_;
+    enum class Connection {
+        disconnected,
+        connecting,
+        connected,
+    };
+
+    static DWORD WINAPI sender_main(LPVOID parameter);
+    void run_sender();
+    DWORD next_wait_ms() const;
+    void flush_pending();
+    // False while a coalescing window is open and nothing asked to close it
+    bool window_closed();
+
+    bool ensure_connected();
+    void start_connect(clock::time_point now);
+    void finish_connect(bool accepted, clock::time_point now);
+    bool ensure_hello();
+    bool send_message(g923bridge::MessageType type, const void* payload, std::uint32_t payload_size);
+    void fail_connection();
+    void disconnect();
+
+    StateMailbox mailbox_;
+    HANDLE wake_event_;
+    HANDLE sender_thread_;
+    std::atomic<bool> stop_requested_;
+    std::atomic<bool> hello_requested_;
+    std::atomic<bool> sender_finished_;
+    std::atomic<bool> states_queued_;
+    std::atomic<bool> flush_requested_;
+
+    // Guards only the client name, which game threads set and the sender reads
+    CRITICAL_SECTION name_lock_;
     char last_client_name_[64];
     std::uint32_t last_process_id_;
+
+    // Owned by the sender thread
+    SOCKET socket_;
+    Connection connection_;
+    bool hello_sent_;
+    bool wants_connection_;
+    clock::time_point connect_started_;
+    clock::time_point next_attempt_;
+    clock::duration backoff_;
+    bool window_open_;
+    clock::time_point window_closes_;
+
+    // What the bridge should be doing, kept so a new connection can be brought up to date
+    g923bridge::WheelStatePayload desired_state_;
+    bool has_desired_state_;
+    bool state_dirty_;
+    bool stop_pending_;
+
+    std::atomic<std::uint64_t> states_sent_;
+    std::atomic<std::uint64_t> stops_sent_;
+    std::atomic<std::uint64_t> send_failures_;
+    std::atomic<std::uint64_t> connect_attempts_;
+    std::atomic<std::uint64_t> connect_failures_;
+    std::atomic<std::uint64_t> connect_wait_us_;
+    std::atomic<std::uint64_t> state_replays_;
+    std::atomic<std::uint64_t> queued_count_;
+    std::atomic<std::uint64_t> coalesce_windows_;
+    std::atomic<std::uint64_t> windows_closed_early_;
     bool initialized_;
 };
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "line_ring.hpp"
+#include <atomic>
+#include <cstdarg>
+#include <cstddef>
+#include <windows.h>
+
+// The proxy's text log. Callers format a line into a LineRing and return; a writer thread takes
+// the lines every kFlushIntervalMs, or sooner once the ring is filling, passes each to
+// OutputDebugStringA and appends the batch with one WriteFile on a handle opened at startup.
+// The file is only written when it already exists, and lines that find the ring full are
+// counted and reported in the log rather than waited for.
+class ProxyLog {
+public:
+    // A null path or a missing file leaves only the debugger output
+    void initialize(const char* path);
+    // Stops the writer after it has written everything still queued
+    void shutdown();
+
+    void write(const char* line);
+    void write_format(const char* format, std::va_list args);
+
+private:
+    static constexpr DWORD kFlushIntervalMs = 50;
+    static constexpr std::size_t kBatchSize = 16 * 1024;
+
+    static DWORD WINAPI writer_main(LPVOID parameter);
+    void run_writer();
+    void drain();
+    void append_line(const char* line, std::size_t length);
+    void flush_batch();
+
+    LineRing ring_;
+    HANDLE wake_event_ = nullptr;
+    HANDLE writer_thread_ = nullptr;
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<bool> writer_finished_{false};
+    bool initialized_ = false;
+
+    // Owned by the writer thread
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    std::size_t batch_used_ = 0;
+    char batch_[kBatchSize];
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "dinput_trace.hpp"
+#include "slot_ring.hpp"
+#include <atomic>
+#include <cstddef>
+#include <windows.h>
+
+// Appends dinput_trace events to a file next to the proxy DLL. Recording only starts when the
+// file already exists, like the proxy log, and costs a single flag check when it does not.
+// Callers copy each event into a SlotRing and return; a writer thread takes the events every
+// kFlushIntervalMs, or sooner once the ring is filling, and appends them with one WriteFile.
+// Events that find the ring full are counted and written as a records_dropped event, and every
+// initialize() starts a new session in the file.
+class TraceWriter {
+public:
+    void initialize(const char* path);
+    // Stops the writer after it has written everything still queued
+    void shutdown();
+
+    bool enabled() const noexcept { return enabled_; }
+
+    void record(dinput_trace::EventType type, const void* payload, std::uint32_t payload_size);
+    // Wakes the writer instead of waiting for its next interval
+    void flush();
+
+private:
+    static constexpr std::size_t kRingSlots = 1024;
+    static constexpr std::size_t kRecordBytes = 256;
+    static constexpr std::size_t kBatchSize = 64 * 1024;
+    static constexpr DWORD kFlushIntervalMs = 100;
+
+    static DWORD WINAPI writer_main(LPVOID parameter);
+    void run_writer();
+    void drain();
+    void append_record(std::uint16_t type, const void* payload, std::uint32_t payload_size);
+    void append(const void* data, std::size_t size);
+    void flush_batch();
+    std::uint64_t timestamp_ns() const;
+
+    SlotRing<kRingSlots, kRecordBytes> ring_;
+    LARGE_INTEGER frequency_{};
+    HANDLE wake_event_ = nullptr;
+    HANDLE writer_thread_ = nullptr;
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<bool> writer_finished_{false};
+    bool enabled_ = false;
+
+    // Owned by the writer thread
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    std::size_t batch_used_ = 0;
+    std::uint8_t batch_[kBatchSize];
+};
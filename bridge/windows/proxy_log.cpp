@@ -0,0 +1,162 @@
+#include "proxy_log.hpp"
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+constexpr DWORD kShutdownWaitMs = 500;
+constexpr DWORD kShutdownPollMs = 10;
+
+}  // namespace
+
+void ProxyLog::initialize(const char* path) {
+    if (initialized_) {
+        return;
+    }
+
+    file_ = INVALID_HANDLE_VALUE;
+    batch_used_ = 0;
+    if (path) {
+        const DWORD attrs = GetFileAttributesA(path);
+        if (attrs != INVALID_FILE_ATTRIBUTES && (attrs & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+            file_ = CreateFileA(path, FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        }
+    }
+
+    stop_requested_.store(false);
+    writer_finished_.store(false);
+    wake_event_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    writer_thread_ = wake_event_ ? CreateThread(nullptr, 0, &ProxyLog::writer_main, this, 0, nullptr) : nullptr;
+    if (!writer_thread_) {
+        if (wake_event_) {
+            CloseHandle(wake_event_);
+            wake_event_ = nullptr;
+        }
+        if (file_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(file_);
+            file_ = INVALID_HANDLE_VALUE;
+        }
+        return;
+    }
+    initialized_ = true;
+}
+
+void ProxyLog::shutdown() {
+    if (!initialized_) {
+        return;
+    }
+
+    initialized_ = false;
+    stop_requested_.store(true);
+    SetEvent(wake_event_);
+
+    // Same as the bridge sender: on process exit the writer is already gone, under FreeLibrary
+    // it drains but cannot finish exiting while the loader lock is held
+    bool thread_gone = false;
+    for (DWORD waited = 0; waited < kShutdownWaitMs && !writer_finished_.load(); waited += kShutdownPollMs) {
+        if (WaitForSingleObject(writer_thread_, kShutdownPollMs) == WAIT_OBJECT_0) {
+            thread_gone = true;
+            break;
+        }
+    }
+    if (!writer_finished_.load()) {
+        if (!thread_gone) {
+            // Still writing: leave it the handles rather than close them under it
+            return;
+        }
+        drain();
+    }
+
+    CloseHandle(writer_thread_);
+    CloseHandle(wake_event_);
+    writer_thread_ = nullptr;
+    wake_event_ = nullptr;
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+}
+
+void ProxyLog::write(const char* line) {
+    if (!initialized_) {
+        OutputDebugStringA(line);
+        OutputDebugStringA("\n");
+        return;
+    }
+
+    ring_.push(line);
+    if (ring_.filling()) {
+        SetEvent(wake_event_);
+    }
+}
+
+void ProxyLog::write_format(const char* format, std::va_list args) {
+    if (!initialized_) {
+        char line[LineRing::kLineCapacity];
+        std::vsnprintf(line, sizeof(line), format, args);
+        OutputDebugStringA(line);
+        OutputDebugStringA("\n");
+        return;
+    }
+
+    ring_.push_format(format, args);
+    if (ring_.filling()) {
+        SetEvent(wake_event_);
+    }
+}
+
+DWORD WINAPI ProxyLog::writer_main(LPVOID parameter) {
+    static_cast<ProxyLog*>(parameter)->run_writer();
+    return 0;
+}
+
+void ProxyLog::run_writer() {
+    while (!stop_requested_.load()) {
+        WaitForSingleObject(wake_event_, kFlushIntervalMs);
+        drain();
+    }
+    drain();
+    writer_finished_.store(true);
+}
+
+void ProxyLog::drain() {
+    std::size_t length = 0;
+    while (const char* line = ring_.front(length)) {
+        OutputDebugStringA(line);
+        OutputDebugStringA("\n");
+        append_line(line, length);
+        ring_.pop();
+    }
+
+    const std::uint64_t dropped = ring_.take_dropped();
+    if (dropped > 0) {
+        char notice[64];
+        const int written = std::snprintf(notice, sizeof(notice), "proxy log dropped %llu lines",
+                                          static_cast<unsigned long long>(dropped));
+        OutputDebugStringA(notice);
+        OutputDebugStringA("\n");
+        append_line(notice, written > 0 ? static_cast<std::size_t>(written) : 0);
+    }
+    flush_batch();
+}
+
+void ProxyLog::append_line(const char* line, std::size_t length) {
+    if (file_ == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    if (batch_used_ + length + 2 > kBatchSize) {
+        flush_batch();
+    }
+    std::memcpy(batch_ + batch_used_, line, length);
+    std::memcpy(batch_ + batch_used_ + length, "\r\n", 2);
+    batch_used_ += length + 2;
+}
+
+void ProxyLog::flush_batch() {
+    if (batch_used_ > 0) {
+        DWORD written = 0;
+        WriteFile(file_, batch_, static_cast<DWORD>(batch_used_), &written, nullptr);
+        batch_used_ = 0;
+    }
+}
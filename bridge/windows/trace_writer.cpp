@@ -0,0 +1,197 @@
+#include "trace_writer.hpp"
+#include <cstring>
+
+namespace {
+
+constexpr DWORD kShutdownWaitMs = 500;
+constexpr DWORD kShutdownPollMs = 10;
+
+std::uint64_t unix_time_ns() {
+    FILETIME now{};
+    GetSystemTimeAsFileTime(&now);
+    // FILETIME counts 100 ns ticks since 1601
+    const ULONGLONG ticks = (static_cast<ULONGLONG>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+    return (ticks - 116444736000000000ULL) * 100ULL;
+}
+
+}  // namespace
+
+void TraceWriter::initialize(const char* path) {
+    if (enabled_ || !path) {
+        return;
+    }
+
+    const DWORD attrs = GetFileAttributesA(path);
+    if (attrs == INVALID_FILE_ATTRIBUTES || (attrs & FILE_ATTRIBUTE_DIRECTORY) != 0) {
+        return;
+    }
+
+    HANDLE file = CreateFileA(path, FILE_APPEND_DATA, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    QueryPerformanceFrequency(&frequency_);
+    file_ = file;
+    batch_used_ = 0;
+
+    // A new file starts with the header; an existing trace keeps growing, one session at a time
+    LARGE_INTEGER size{};
+    if (GetFileSizeEx(file, &size) && size.QuadPart == 0) {
+        wire_capture::FileHeader header;
+        std::memcpy(header.magic, dinput_trace::kFileMagic, sizeof(header.magic));
+        header.created_unix_ns = unix_time_ns();
+        append(&header, sizeof(header));
+    }
+    wire_capture::SessionMarker marker;
+    marker.created_unix_ns = unix_time_ns();
+    append_record(wire_capture::kSessionMarkerType, &marker, sizeof(marker));
+
+    stop_requested_.store(false);
+    writer_finished_.store(false);
+    wake_event_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    writer_thread_ = wake_event_ ? CreateThread(nullptr, 0, &TraceWriter::writer_main, this, 0, nullptr) : nullptr;
+    if (!writer_thread_) {
+        if (wake_event_) {
+            CloseHandle(wake_event_);
+            wake_event_ = nullptr;
+        }
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+        return;
+    }
+    enabled_ = true;
+}
+
+void TraceWriter::shutdown() {
+    if (!enabled_) {
+        return;
+    }
+
+    enabled_ = false;
+    stop_requested_.store(true);
+    SetEvent(wake_event_);
+
+    // Same as the proxy log: on process exit the writer is already gone, under FreeLibrary it
+    // drains but cannot finish exiting while the loader lock is held
+    bool thread_gone = false;
+    for (DWORD waited = 0; waited < kShutdownWaitMs && !writer_finished_.load(); waited += kShutdownPollMs) {
+        if (WaitForSingleObject(writer_thread_, kShutdownPollMs) == WAIT_OBJECT_0) {
+            thread_gone = true;
+            break;
+        }
+    }
+    if (!writer_finished_.load()) {
+        if (!thread_gone) {
+            // Still writing: leave it the handles rather than close them under it
+            return;
+        }
+        drain();
+    }
+
+    CloseHandle(writer_thread_);
+    CloseHandle(wake_event_);
+    writer_thread_ = nullptr;
+    wake_event_ = nullptr;
+    CloseHandle(file_);
+    file_ = INVALID_HANDLE_VALUE;
+}
+
+std::uint64_t TraceWriter::timestamp_ns() const {
+    LARGE_INTEGER counter{};
+    QueryPerformanceCounter(&counter);
+    const std::uint64_t ticks = static_cast<std::uint64_t>(counter.QuadPart);
+    const std::uint64_t frequency = static_cast<std::uint64_t>(frequency_.QuadPart);
+    return (ticks / frequency) * 1000000000ULL + ((ticks % frequency) * 1000000000ULL) / frequency;
+}
+
+void TraceWriter::record(dinput_trace::EventType type, const void* payload, std::uint32_t payload_size) {
+    if (!enabled_) {
+        return;
+    }
+
+    wire_capture::RecordHeader header;
+    header.timestamp_ns = timestamp_ns();
+    header.type = static_cast<std::uint16_t>(type);
+    header.payload_size = payload_size;
+    const std::size_t record_size = wire_capture::padded_size(sizeof(header) + payload_size);
+    if (record_size > kRecordBytes) {
+        return;
+    }
+
+    ring_.push_with([&](char* data) {
+        std::memset(data, 0, record_size);
+        std::memcpy(data, &header, sizeof(header));
+        std::memcpy(data + sizeof(header), payload, payload_size);
+        return record_size;
+    });
+    if (ring_.filling()) {
+        SetEvent(wake_event_);
+    }
+}
+
+void TraceWriter::flush() {
+    if (enabled_) {
+        SetEvent(wake_event_);
+    }
+}
+
+DWORD WINAPI TraceWriter::writer_main(LPVOID parameter) {
+    static_cast<TraceWriter*>(parameter)->run_writer();
+    return 0;
+}
+
+void TraceWriter::run_writer() {
+    while (!stop_requested_.load()) {
+        WaitForSingleObject(wake_event_, kFlushIntervalMs);
+        drain();
+    }
+    drain();
+    writer_finished_.store(true);
+}
+
+void TraceWriter::drain() {
+    std::size_t length = 0;
+    while (const char* record = ring_.front(length)) {
+        append(record, length);
+        ring_.pop();
+    }
+
+    const std::uint64_t dropped = ring_.take_dropped();
+    if (dropped > 0) {
+        dinput_trace::ValueEvent event;
+        event.value = dropped > 0xFFFFFFFFULL ? 0xFFFFFFFFU : static_cast<std::uint32_t>(dropped);
+        append_record(static_cast<std::uint16_t>(dinput_trace::EventType::records_dropped), &event, sizeof(event));
+    }
+    flush_batch();
+}
+
+void TraceWriter::append_record(std::uint16_t type, const void* payload, std::uint32_t payload_size) {
+    wire_capture::RecordHeader header;
+    header.timestamp_ns = timestamp_ns();
+    header.type = type;
+    header.payload_size = payload_size;
+
+    std::uint8_t record[kRecordBytes] = {0};
+    const std::size_t record_size = wire_capture::padded_size(sizeof(header) + payload_size);
+    std::memcpy(record, &header, sizeof(header));
+    std::memcpy(record + sizeof(header), payload, payload_size);
+    append(record, record_size);
+}
+
+void TraceWriter::append(const void* data, std::size_t size) {
+    if (batch_used_ + size > kBatchSize) {
+        flush_batch();
+    }
+    std::memcpy(batch_ + batch_used_, data, size);
+    batch_used_ += size;
+}
+
+void TraceWriter::flush_batch() {
+    if (batch_used_ > 0) {
+        DWORD written = 0;
+        WriteFile(file_, batch_, static_cast<DWORD>(batch_used_), &written, nullptr);
+        batch_used_ = 0;
+    }
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "constants.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+namespace g923_commands {
+    static constexpr std::uint8_t DISABLE_AUTOCENTER = 0xF5;
+    static constexpr std::uint8_t ENABLE_AUTOCENTER = 0xF4;
+    static constexpr std::uint8_t SET_AUTOCENTER_SPRING = 0xFE;
+    static constexpr std::uint8_t SET_FORCE_EFFECT = 0xF1;
+    static constexpr std::uint8_t STOP_FORCES = 0xF3;
+    static constexpr std::uint8_t SET_LED_PATTERN = 0xF8;
+
+    static constexpr std::uint8_t EFFECT_CONSTANT = 0x00;
+    static constexpr std::uint8_t EFFECT_SPRING = 0x01;
+    static constexpr std::uint8_t EFFECT_DAMPER = 0x02;
+    static constexpr std::uint8_t EFFECT_TRAPEZOID = 0x06;
+
+    static constexpr std::uint8_t LED_COMMAND_TYPE = 0x12;
+}
+
+struct Command {
+    std::uint8_t data[COMMAND_MAX_LENGTH] = {0};
+
+    constexpr Command() = default;
+    constexpr explicit Command(std::initializer_list<std::uint8_t> init) {
+        std::size_t i = 0;
+        for (auto value : init) {
+            if (i < COMMAND_MAX_LENGTH) {
+                data[i++] = value;
+            }
+        }
+    }
+
+    constexpr std::uint8_t& operator[](std::size_t index) noexcept { return data[index]; }
+    constexpr const std::uint8_t& operator[](std::size_t index) const noexcept { return data[index]; }
+
+    constexpr const std::uint8_t* raw() const noexcept { return data; }
+    constexpr std::size_t size() const noexcept { return COMMAND_MAX_LENGTH; }
+
+    constexpr bool operator==(const Command& other) const noexcept {
+        for (std::size_t i = 0; i < COMMAND_MAX_LENGTH; ++i) {
+            if (data[i] != other.data[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+    constexpr bool operator!=(const Command& other) const noexcept { return !(*this == other); }
+};
+
+// Typed effect parameters. Each layout lists the bytes written after the two-byte
+// SET_FORCE_EFFECT header, and kParamBytes is checked against the 8-byte command at compile time.
+namespace g923_effects {
+    static constexpr std::size_t FORCE_EFFECT_HEADER = 2;
+
+    constexpr std::uint8_t pack_nibbles(std::uint8_t high, std::uint8_t low) noexcept {
+        return static_cast<std::uint8_t>(((high & 0x0F) << 4) | (low & 0x0F));
+    }
+
+    struct ConstantForce {
+        static constexpr std::uint8_t kType = g923_commands::EFFECT_CONSTANT;
+        static constexpr std::size_t kParamBytes = 5;  // level x4, reserved
+        std::uint8_t level = 0x80;
+    };
+
+    struct Spring {
+        static constexpr std::uint8_t kType = g923_commands::EFFECT_SPRING;
+        static constexpr std::size_t kParamBytes = 5;  // d1, d2, k2|k1, s2|s1, clip
+        std::uint8_t deadband_left = 0;
+        std::uint8_t deadband_right = 0;
+        std::uint8_t k1 = 0;
+        std::uint8_t k2 = 0;
+        std::uint8_t saturation1 = 0;
+        std::uint8_t saturation2 = 0;
+        std::uint8_t clip = 0;
+    };
+
+    struct Damper {
+        static constexpr std::uint8_t kType = g923_commands::EFFECT_DAMPER;
+        static constexpr std::size_t kParamBytes = 5;  // k1, s1, k2, s2, reserved
+        std::uint8_t k1 = 0;
+        std::uint8_t k2 = 0;
+        std::uint8_t saturation1 = 0;
+        std::uint8_t saturation2 = 0;
+    };
+
+    struct Trapezoid {
+        static constexpr std::uint8_t kType = g923_commands::EFFECT_TRAPEZOID;
+        static constexpr std::size_t kParamBytes = 5;  // l1, l2, t1, t2, t3|s
+        std::uint8_t level1 = 0;
+        std::uint8_t level2 = 0;
+        std::uint8_t time1 = 0;
+        std::uint8_t time2 = 0;
+        std::uint8_t time3 = 0;
+        std::uint8_t step = 0;
+    };
+
+    template <typename Effect>
+    constexpr Command begin(const Effect&) noexcept {
+        static_assert(FORCE_EFFECT_HEADER + Effect::kParamBytes <= COMMAND_MAX_LENGTH,
+                      "Effect parameters do not fit in a command");
+        Command command;
+        command[0] = g923_commands::SET_FORCE_EFFECT;
+        command[1] = Effect::kType;
+        return command;
+    }
+
+    constexpr Command encode(const ConstantForce& effect) noexcept {
+        Command command = begin(effect);
+        command[2] = effect.level;
+        command[3] = effect.level;
+        command[4] = effect.level;
+        command[5] = effect.level;
+        return command;
+    }
+
+    constexpr Command encode(const Spring& effect) noexcept {
+        Command command = begin(effect);
+        command[2] = effect.deadband_left;
+        command[3] = effect.deadband_right;
+        command[4] = pack_nibbles(effect.k2, effect.k1);
+        command[5] = pack_nibbles(effect.saturation2, effect.saturation1);
+        command[6] = effect.clip;
+        return command;
+    }
+
+    constexpr Command encode(const Damper& effect) noexcept {
+        Command command = begin(effect);
+        command[2] = effect.k1;
+        command[3] = effect.saturation1;
+        command[4] = effect.k2;
+        command[5] = effect.saturation2;
+        return command;
+    }
+
+    constexpr Command encode(const Trapezoid& effect) noexcept {
+        Command command = begin(effect);
+        command[2] = effect.level1;
+        command[3] = effect.level2;
+        command[4] = effect.time1;
+        command[5] = effect.time2;
+        command[6] = pack_nibbles(effect.time3, effect.step);
+        return command;
+    }
+}
+
+class CommandBuilder {
+public:
+    static constexpr Command create_disable_autocenter() {
+        return Command{g923_commands::DISABLE_AUTOCENTER};
+    }
+
+    static constexpr Command create_enable_autocenter() {
+        return Command{g923_commands::ENABLE_AUTOCENTER};
+    }
+
+    static constexpr Command create_autocenter_spring(std::uint8_t k1, std::uint8_t k2, std::uint8_t clip) {
+        return Command{g923_commands::SET_AUTOCENTER_SPRING, 0x00, k1, k2, clip, 0x00};
+    }
+
+    static constexpr Command create_constant_force(std::uint8_t force_level) {
+        return g923_effects::encode(g923_effects::ConstantForce{force_level});
+    }
+
+    static constexpr Command create_custom_spring(std::uint8_t d1, std::uint8_t d2, std::uint8_t k1, std::uint8_t k2,
+                                                  std::uint8_t s1, std::uint8_t s2, std::uint8_t clip) {
+        return g923_effects::encode(g923_effects::Spring{d1, d2, k1, k2, s1, s2, clip});
+    }
+
+    static constexpr Command create_damper(std::uint8_t k1, std::uint8_t k2, std::uint8_t s1, std::uint8_t s2) {
+        return g923_effects::encode(g923_effects::Damper{k1, k2, s1, s2});
+    }
+
+    static constexpr Command create_trapezoid(std::uint8_t l1, std::uint8_t l2, std::uint8_t t1, std::uint8_t t2,
+                                              std::uint8_t t3, std::uint8_t s) {
+        return g923_effects::encode(g923_effects::Trapezoid{l1, l2, t1, t2, t3, s});
+    }
+
+    static constexpr Command create_stop_forces() {
+        return Command{g923_commands::STOP_FORCES, 0x00};
+    }
+
+    static constexpr Command create_led_pattern(std::uint8_t pattern) {
+        return Command{g923_commands::SET_LED_PATTERN, g923_commands::LED_COMMAND_TYPE, pattern};
+    }
+};
@@ -9,8 +9,9 @@ static constexpr std::uint32_t G923_DEVICE_ID = 0xC266046D;
 static constexpr std::size_t COMMAND_MAX_LENGTH = 8;
 static constexpr std::size_t COMMAND_MAX_COUNT = 4;
 
-static constexpr int FORCE_UPDATE_RATE = 8;  // Force feedback update every 8 frames
-static constexpr int LED_UPDATE_RATE = 32;   // LED update every 32 frames
+// Relative output budget: forces are weighted as one update every 8 frames, LEDs every 32
+static constexpr int FORCE_UPDATE_RATE = 8;
+static constexpr int LED_UPDATE_RATE = 32;
 
 static constexpr std::uint8_t LED_PATTERN_OFF = 0x00;
 static constexpr std::uint8_t LED_PATTERN_1 = 0x01;
@@ -1,16 +1,16 @@
 #pragma once
 
+#include "hid_transport.hpp"
 #include "types.hpp"
 #include "utilities.hpp"
 #include <vector>
 #include <memory>
-#include <CoreFoundation/CoreFoundation.h>
-#include <IOKit/hid/IOHIDManager.h>
 
 class DeviceManager {
 public:
-    DeviceManager();
-    ~DeviceManager();
+    // Uses the platform backend when none is given
+    explicit DeviceManager(std::unique_ptr<HidBackend> backend = nullptr);
+    ~DeviceManager() = default;
     
     DeviceManager(const DeviceManager&) = delete;
     DeviceManager& operator=(const DeviceManager&) = delete;
@@ -19,23 +19,17 @@ public:
     
     std::vector<HidDevice> list_all_devices();
     std::vector<HidDevice> find_known_wheels();
+    std::unique_ptr<HidTransport> create_transport(const HidDevice& device);
     
-    bool is_initialized() const noexcept { return hid_manager_ != nullptr; }
+    bool is_initialized() const noexcept { return backend_ && backend_->is_initialized(); }
     
 private:
-    hid_manager_t* hid_manager_;
-    
-    bool initialize_hid_manager();
-    void cleanup_hid_manager();
-    
-    static device_id_t get_device_property_number(hid_device_t* device, CFStringRef property);
-    static CFStringRef get_device_property_string(hid_device_t* device, CFStringRef property);
-    static void copy_devices_to_array(const void* value, void* context);
+    std::unique_ptr<HidBackend> backend_;
 };
 
 class HidDeviceInterface {
 public:
-    explicit HidDeviceInterface(const HidDevice& device);
+    HidDeviceInterface(const HidDevice& device, std::unique_ptr<HidTransport> transport);
     ~HidDeviceInterface();
     
     HidDeviceInterface(const HidDeviceInterface&) = delete;
@@ -46,13 +40,15 @@ public:
     bool open();
     bool close();
     bool send_command(const Command& command);
+    bool send_report(const std::uint8_t* data, std::size_t length);
+    bool get_input_report(std::uint8_t report_id, std::uint8_t* data, std::size_t& length);
     
-    bool is_open() const noexcept { return is_open_; }
+    bool is_open() const noexcept { return transport_ && transport_->is_open(); }
     const HidDevice& device() const noexcept { return device_; }
     
 private:
     HidDevice device_;
-    bool is_open_;
+    std::unique_ptr<HidTransport> transport_;
     
     bool validate_device() const;
 };
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "hid_transport.hpp"
+#include "hidpp_mock.hpp"
+#include "wheel_simulator.hpp"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// In-memory HID interface for tests, benchmarks and the headless server. Writes take an
+// optional service time and are counted; with a HID++ mock attached, numbered reports are
+// answered by it so the HID++ backend can initialise against the fake. An attached
+// simulator receives every classic command.
+class FakeHidDevice {
+public:
+    struct Stats {
+        std::uint64_t writes = 0;
+        std::uint64_t numbered_writes = 0;
+        std::uint64_t failed_writes = 0;
+        std::uint64_t reads = 0;
+        std::uint64_t opens = 0;
+    };
+
+    // Runs on the writing thread after each successful write
+    using WriteObserver = std::function<void(const std::uint8_t* data, std::size_t length, bool numbered)>;
+
+    explicit FakeHidDevice(const HidDevice& device);
+
+    const HidDevice& device() const noexcept { return device_; }
+
+    void set_service_time(std::chrono::microseconds service_time);
+    void set_write_failure(bool fail);
+    void attach_hidpp(std::unique_ptr<HidppMockDevice> hidpp);
+    void attach_simulator(std::shared_ptr<WheelSimulator> simulator);
+    void set_write_observer(WriteObserver observer);
+
+    Stats stats() const;
+    Command last_command() const;
+
+    bool open();
+    bool write(const std::uint8_t* data, std::size_t length, bool numbered);
+    bool read(std::uint8_t report_id, std::uint8_t* data, std::size_t& length);
+
+private:
+    HidDevice device_;
+    mutable std::mutex mutex_;
+    std::chrono::microseconds service_time_;
+    bool fail_writes_;
+    std::unique_ptr<HidppMockDevice> hidpp_;
+    std::shared_ptr<WheelSimulator> simulator_;
+    WriteObserver observer_;
+    Stats stats_;
+    Command last_command_;
+};
+
+class FakeHidBackend final : public HidBackend {
+public:
+    std::shared_ptr<FakeHidDevice> add_device(device_id_t vendor_id, device_id_t product_id, const std::string& name);
+    std::shared_ptr<FakeHidDevice> add_g923(bool with_hidpp = false);
+
+    bool is_initialized() const override { return true; }
+    std::vector<HidDevice> list_all_devices() override;
+    std::unique_ptr<HidTransport> create_transport(const HidDevice& device) override;
+
+private:
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<FakeHidDevice>> devices_;
+
+    std::shared_ptr<FakeHidDevice> add_device_locked(device_id_t vendor_id, device_id_t product_id,
+                                                     const std::string& name);
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// History buffer that keeps the newest items. Its storage is allocated once by the constructor,
+// so push() never touches the heap; once the ring is full each push overwrites the oldest item
+// and counts it as dropped. Not synchronised, callers hold their own lock.
+template <typename T>
+class FixedRing {
+public:
+    explicit FixedRing(std::size_t capacity) : items_(std::max<std::size_t>(capacity, 1)) {}
+
+    void push(const T& item) noexcept {
+        if (size_ == items_.size()) {
+            items_[head_] = item;
+            head_ = (head_ + 1) % items_.size();
+            ++dropped_;
+            return;
+        }
+        items_[(head_ + size_) % items_.size()] = item;
+        ++size_;
+    }
+
+    void pop_front() noexcept {
+        if (size_ > 0) {
+            head_ = (head_ + 1) % items_.size();
+            --size_;
+        }
+    }
+
+    // Index 0 is the oldest item still held
+    const T& operator[](std::size_t index) const noexcept { return items_[(head_ + index) % items_.size()]; }
+    const T& front() const noexcept { return (*this)[0]; }
+    const T& back() const noexcept { return (*this)[size_ - 1]; }
+
+    bool empty() const noexcept { return size_ == 0; }
+    std::size_t size() const noexcept { return size_; }
+    std::size_t capacity() const noexcept { return items_.size(); }
+    std::uint64_t dropped() const noexcept { return dropped_; }
+
+    void clear() noexcept {
+        head_ = 0;
+        size_ = 0;
+        dropped_ = 0;
+    }
+
+    std::vector<T> to_vector() const {
+        std::vector<T> items;
+        items.reserve(size_);
+        for (std::size_t i = 0; i < size_; ++i) {
+            items.push_back((*this)[i]);
+        }
+        return items;
+    }
+
+private:
+    std::vector<T> items_;
+    std::size_t head_ = 0;
+    std::size_t size_ = 0;
+    std::uint64_t dropped_ = 0;
+};
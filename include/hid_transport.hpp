@@ -0,0 +1,34 @@
+#pragma once
+
+#include "types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One open HID interface. Classic wheel commands are unnumbered output reports; HID++ reports
+// are numbered and carry their report ID in data[0].
+class HidTransport {
+public:
+    virtual ~HidTransport() = default;
+
+    virtual bool open() = 0;
+    virtual bool close() = 0;
+    virtual bool is_open() const = 0;
+
+    virtual bool write_output_report(const std::uint8_t* data, std::size_t length, bool numbered) = 0;
+    virtual bool read_input_report(std::uint8_t report_id, std::uint8_t* data, std::size_t& length) = 0;
+};
+
+// Enumerates HID interfaces on one platform and creates transports for them.
+class HidBackend {
+public:
+    virtual ~HidBackend() = default;
+
+    virtual bool is_initialized() const = 0;
+    virtual std::vector<HidDevice> list_all_devices() = 0;
+    virtual std::unique_ptr<HidTransport> create_transport(const HidDevice& device) = 0;
+};
+
+// IOKit on macOS, hidraw on Linux
+std::unique_ptr<HidBackend> create_platform_hid_backend();
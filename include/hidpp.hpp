@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace hidpp {
+    static constexpr std::uint8_t REPORT_ID_SHORT = 0x10;
+    static constexpr std::uint8_t REPORT_ID_LONG = 0x11;
+    static constexpr std::uint8_t REPORT_ID_VERY_LONG = 0x12;
+
+    static constexpr std::size_t REPORT_LENGTH_SHORT = 7;
+    static constexpr std::size_t REPORT_LENGTH_LONG = 20;
+    static constexpr std::size_t REPORT_LENGTH_VERY_LONG = 64;
+    static constexpr std::size_t REPORT_HEADER_LENGTH = 4;
+
+    static constexpr std::uint8_t DEVICE_INDEX = 0xFF;
+    static constexpr std::uint8_t SOFTWARE_ID = 0x01;
+    static constexpr std::uint8_t ERROR_FEATURE_INDEX = 0xFF;
+
+    static constexpr std::uint8_t ROOT_FEATURE_INDEX = 0x00;
+    static constexpr std::uint8_t ROOT_GET_FEATURE = 0x00;
+    static constexpr std::uint16_t FEATURE_FORCE_FEEDBACK = 0x8123;
+
+    static constexpr std::uint8_t FF_GET_INFO = 0x00;
+    static constexpr std::uint8_t FF_RESET_ALL = 0x01;
+    static constexpr std::uint8_t FF_DOWNLOAD_EFFECT = 0x02;
+    static constexpr std::uint8_t FF_SET_EFFECT_STATE = 0x03;
+    static constexpr std::uint8_t FF_DESTROY_EFFECT = 0x04;
+    static constexpr std::uint8_t FF_GET_APERTURE = 0x05;
+    static constexpr std::uint8_t FF_SET_APERTURE = 0x06;
+    static constexpr std::uint8_t FF_GET_GLOBAL_GAINS = 0x07;
+    static constexpr std::uint8_t FF_SET_GLOBAL_GAINS = 0x08;
+    static constexpr std::size_t FF_FUNCTION_COUNT = 9;
+
+    static constexpr std::uint8_t EFFECT_CONSTANT = 0x00;
+    static constexpr std::uint8_t EFFECT_SPRING = 0x06;
+    static constexpr std::uint8_t EFFECT_DAMPER = 0x07;
+    static constexpr std::uint8_t EFFECT_TYPE_MASK = 0x7F;
+    static constexpr std::uint8_t EFFECT_AUTOSTART = 0x80;
+
+    static constexpr std::uint8_t EFFECT_STATE_STOP = 0x01;
+    static constexpr std::uint8_t EFFECT_STATE_PLAY = 0x02;
+    static constexpr std::uint8_t EFFECT_STATE_PAUSE = 0x03;
+
+    // Slot 0 in a download request asks the device to allocate a new slot.
+    static constexpr std::uint8_t SLOT_NEW = 0x00;
+
+    static constexpr std::uint8_t ERROR_INVALID_ARGUMENT = 0x02;
+    static constexpr std::uint8_t ERROR_OUT_OF_RANGE = 0x03;
+    static constexpr std::uint8_t ERROR_INVALID_FEATURE_INDEX = 0x06;
+    static constexpr std::uint8_t ERROR_INVALID_FUNCTION = 0x07;
+    static constexpr std::uint8_t ERROR_BUSY = 0x08;
+
+    static constexpr std::uint16_t CONDITION_SATURATION_MAX = 0xFFFF;
+}
+
+struct HidppReport {
+    std::uint8_t data[hidpp::REPORT_LENGTH_VERY_LONG] = {0};
+    std::size_t length = 0;
+
+    std::uint8_t report_id() const noexcept { return data[0]; }
+    std::uint8_t device_index() const noexcept { return data[1]; }
+    std::uint8_t feature_index() const noexcept { return data[2]; }
+    std::uint8_t function() const noexcept { return static_cast<std::uint8_t>(data[3] >> 4); }
+    std::uint8_t software_id() const noexcept { return static_cast<std::uint8_t>(data[3] & 0x0F); }
+    bool is_error() const noexcept { return data[2] == hidpp::ERROR_FEATURE_INDEX; }
+
+    std::uint8_t* params() noexcept { return data + hidpp::REPORT_HEADER_LENGTH; }
+    const std::uint8_t* params() const noexcept { return data + hidpp::REPORT_HEADER_LENGTH; }
+    std::size_t param_capacity() const noexcept {
+        return length > hidpp::REPORT_HEADER_LENGTH ? length - hidpp::REPORT_HEADER_LENGTH : 0;
+    }
+
+    const std::uint8_t* raw() const noexcept { return data; }
+    std::size_t size() const noexcept { return length; }
+};
+
+struct HidppCondition {
+    std::int16_t left_coefficient = 0;
+    std::int16_t right_coefficient = 0;
+    std::uint16_t left_saturation = 0;
+    std::uint16_t right_saturation = 0;
+    std::uint16_t deadband = 0;
+    std::int16_t center = 0;
+};
+
+class HidppCommandBuilder {
+public:
+    static HidppReport create_request(std::uint8_t feature_index, std::uint8_t function,
+                                      const std::uint8_t* params, std::size_t param_count);
+    static HidppReport create_get_feature(std::uint16_t feature_id);
+    static HidppReport create_get_info(std::uint8_t feature_index);
+    static HidppReport create_reset_all(std::uint8_t feature_index);
+    static HidppReport create_constant_force(std::uint8_t feature_index, std::uint8_t slot,
+                                             std::int16_t level, bool autostart);
+    static HidppReport create_condition(std::uint8_t feature_index, std::uint8_t slot, std::uint8_t effect_type,
+                                        const HidppCondition& condition, bool autostart);
+    static HidppReport create_set_effect_state(std::uint8_t feature_index, std::uint8_t slot, std::uint8_t state);
+    static HidppReport create_destroy_effect(std::uint8_t feature_index, std::uint8_t slot);
+    static HidppReport create_set_global_gain(std::uint8_t feature_index, std::uint16_t gain, std::uint16_t boost);
+
+    static std::int16_t read_int16(const std::uint8_t* bytes) noexcept;
+    static std::uint16_t read_uint16(const std::uint8_t* bytes) noexcept;
+    static void write_uint16(std::uint8_t* bytes, std::uint16_t value) noexcept;
+};
+
+class HidppTransport {
+public:
+    virtual ~HidppTransport() = default;
+
+    virtual bool write_report(const HidppReport& report) = 0;
+    virtual bool read_report(std::uint8_t report_id, HidppReport& report) = 0;
+};
+
+class HidppForceFeedback {
+public:
+    enum class EffectRole : std::size_t {
+        constant,
+        spring,
+        damper,
+        autocenter,
+        count,
+    };
+
+    struct Stats {
+        std::uint64_t requests_sent = 0;
+        std::uint64_t write_failures = 0;
+        std::uint64_t read_failures = 0;
+        std::uint64_t error_responses = 0;
+        std::array<std::uint64_t, hidpp::FF_FUNCTION_COUNT> function_counts{};
+    };
+
+    explicit HidppForceFeedback(HidppTransport& transport);
+
+    HidppForceFeedback(const HidppForceFeedback&) = delete;
+    HidppForceFeedback& operator=(const HidppForceFeedback&) = delete;
+
+    bool initialize();
+
+    bool set_constant_force(std::int16_t level);
+    bool set_spring(const HidppCondition& condition);
+    bool set_damper(const HidppCondition& condition);
+    bool set_autocenter(const HidppCondition& condition);
+    bool set_autocenter_enabled(bool enabled);
+    bool set_global_gain(std::uint16_t gain);
+    bool stop_forces();
+    bool reset();
+
+    bool is_initialized() const noexcept { return is_initialized_; }
+    std::uint8_t feature_index() const noexcept { return feature_index_; }
+    std::uint8_t slot_capacity() const noexcept { return slot_capacity_; }
+    std::uint8_t slot(EffectRole role) const noexcept { return roles_[static_cast<std::size_t>(role)].slot; }
+    bool is_playing(EffectRole role) const noexcept { return roles_[static_cast<std::size_t>(role)].playing; }
+    const Stats& stats() const noexcept { return stats_; }
+
+private:
+    struct RoleState {
+        std::uint8_t slot = hidpp::SLOT_NEW;
+        bool playing = false;
+    };
+
+    HidppTransport& transport_;
+    std::uint8_t feature_index_;
+    std::uint8_t slot_capacity_;
+    bool is_initialized_;
+    bool autocenter_enabled_;
+    HidppCondition autocenter_condition_;
+    std::array<RoleState, static_cast<std::size_t>(EffectRole::count)> roles_;
+    Stats stats_;
+
+    bool transact(const HidppReport& request, HidppReport& response);
+    bool upload_effect(EffectRole role, const HidppReport& request);
+    bool stop_effect(EffectRole role);
+    bool upload_condition(EffectRole role, std::uint8_t effect_type, const HidppCondition& condition);
+    void forget_slots();
+
+    static bool is_condition_active(const HidppCondition& condition) noexcept;
+};
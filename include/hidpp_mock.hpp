@@ -0,0 +1,75 @@
+#pragma once
+
+#include "fixed_ring.hpp"
+#include "hidpp.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Protocol-level stand-in for the G923 HID++ force feedback interface. It decodes the
+// requests produced by HidppCommandBuilder, keeps an on-device slot table and answers
+// like the wheel would, so encoding, slot handling and report rates can be checked
+// without hardware. Pending responses and report times live in rings sized up front, so
+// a write never allocates.
+class HidppMockDevice final : public HidppTransport {
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct EffectSlot {
+        bool allocated = false;
+        bool playing = false;
+        std::uint8_t effect_type = 0;
+        std::uint16_t duration_ms = 0;
+        std::uint16_t delay_ms = 0;
+        std::int16_t level = 0;
+        HidppCondition condition{};
+        std::uint64_t download_count = 0;
+    };
+
+    explicit HidppMockDevice(std::uint8_t slot_count = 16, std::uint8_t feature_index = 0x0B);
+
+    bool write_report(const HidppReport& report) override;
+    bool read_report(std::uint8_t report_id, HidppReport& report) override;
+
+    void set_write_failure(bool fail) noexcept { fail_writes_ = fail; }
+    void set_feature_supported(bool supported) noexcept { feature_supported_ = supported; }
+
+    const EffectSlot& slot(std::uint8_t slot) const;
+    std::size_t allocated_slot_count() const noexcept;
+    std::size_t playing_slot_count() const noexcept;
+    std::uint8_t slot_count() const noexcept { return static_cast<std::uint8_t>(slots_.size()); }
+    std::uint16_t global_gain() const noexcept { return global_gain_; }
+
+    std::uint64_t report_count() const noexcept { return report_count_; }
+    std::uint64_t function_count(std::uint8_t function) const noexcept;
+    std::uint64_t error_count() const noexcept { return error_count_; }
+    const HidppReport& last_request() const noexcept { return last_request_; }
+
+    double reports_per_second() const;
+    std::size_t peak_reports_in_window(clock::duration window) const;
+    void reset_statistics();
+
+private:
+    static constexpr std::size_t kReportHistory = 4096;
+    static constexpr std::size_t kMaxPendingResponses = 32;
+
+    std::vector<EffectSlot> slots_;
+    std::uint8_t feature_index_;
+    bool feature_supported_;
+    bool fail_writes_;
+    std::uint16_t global_gain_;
+    std::uint64_t report_count_;
+    std::uint64_t error_count_;
+    std::array<std::uint64_t, hidpp::FF_FUNCTION_COUNT> function_counts_;
+    HidppReport last_request_;
+    FixedRing<HidppReport> responses_;
+    FixedRing<clock::time_point> report_times_;
+
+    void handle_root_request(const HidppReport& request, HidppReport& response);
+    void handle_force_feedback_request(const HidppReport& request, HidppReport& response);
+    void handle_download(const HidppReport& request, HidppReport& response);
+    bool decode_slot(std::uint8_t slot, std::size_t& index) const noexcept;
+    void make_error(const HidppReport& request, std::uint8_t error_code, HidppReport& response);
+    void queue_response(const HidppReport& response);
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-bucket log-linear histogram of nanosecond durations. Each power of two is split into
+// four sub-buckets, so any recorded value is reported within 25% of its true magnitude.
+// Recording is a handful of relaxed atomic adds and never allocates.
+class LatencyHistogram {
+public:
+    static constexpr std::size_t kSubBuckets = 4;
+    static constexpr std::size_t kOctaves = 36;
+    static constexpr std::size_t kBucketCount = kSubBuckets * kOctaves;
+
+    struct Snapshot {
+        std::array<std::uint64_t, kBucketCount> buckets{};
+        std::uint64_t count = 0;
+        std::uint64_t total_ns = 0;
+        std::uint64_t max_ns = 0;
+
+        std::uint64_t percentile_ns(double percentile) const noexcept;
+        std::uint64_t mean_ns() const noexcept { return count ? total_ns / count : 0; }
+        void merge(const Snapshot& other) noexcept;
+    };
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(std::uint64_t value_ns) noexcept;
+    Snapshot snapshot() const noexcept;
+    void reset() noexcept;
+
+    static std::size_t bucket_index(std::uint64_t value_ns) noexcept;
+    static std::uint64_t bucket_lower_bound(std::size_t index) noexcept;
+    static std::uint64_t bucket_upper_bound(std::size_t index) noexcept;
+
+private:
+    std::array<std::atomic<std::uint64_t>, kBucketCount> buckets_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> total_ns_{0};
+    std::atomic<std::uint64_t> max_ns_{0};
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+
+enum class LogLevel : std::uint8_t {
+    Debug,
+    Info,
+    Warning,
+    Error
+};
+
+// Levels below G923_LOG_MIN_LEVEL (0 = Debug ... 3 = Error) are removed at compile time,
+// including the evaluation of their arguments' formatting.
+#ifndef G923_LOG_MIN_LEVEL
+#ifdef UTI_RELEASE
+#define G923_LOG_MIN_LEVEL 1
+#else
+#define G923_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+// A log call is captured as a fixed-size binary record: the format string pointer, up to
+// kMaxArguments scalar arguments and inline copies of string arguments.
+struct LogRecord {
+    static constexpr std::size_t kMaxArguments = 6;
+    static constexpr std::size_t kTextCapacity = 64;
+
+    enum class ArgumentType : std::uint8_t {
+        signed_integer,
+        unsigned_integer,
+        floating,
+        text,
+    };
+
+    union Argument {
+        std::int64_t signed_value;
+        std::uint64_t unsigned_value;
+        double floating_value;
+        std::uint32_t text_offset;
+    };
+
+    std::uint64_t timestamp_ns = 0;
+    const char* format = nullptr;
+    LogLevel level = LogLevel::Debug;
+    std::uint8_t argument_count = 0;
+    std::uint8_t text_used = 0;
+    ArgumentType types[kMaxArguments] = {};
+    Argument arguments[kMaxArguments] = {};
+    char text[kTextCapacity] = {0};
+
+    void add(const char* value) noexcept;
+    void add(char* value) noexcept { add(static_cast<const char*>(value)); }
+    void add(const std::string& value) noexcept { add(value.c_str()); }
+
+    template <typename T>
+    void add(T value) noexcept {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Unsupported log argument type");
+        if constexpr (std::is_enum<T>::value) {
+            add(static_cast<std::underlying_type_t<T>>(value));
+        } else if constexpr (std::is_floating_point<T>::value) {
+            types[argument_count] = ArgumentType::floating;
+            arguments[argument_count++].floating_value = static_cast<double>(value);
+        } else if constexpr (std::is_signed<T>::value) {
+            types[argument_count] = ArgumentType::signed_integer;
+            arguments[argument_count++].signed_value = static_cast<std::int64_t>(value);
+        } else {
+            types[argument_count] = ArgumentType::unsigned_integer;
+            arguments[argument_count++].unsigned_value = static_cast<std::uint64_t>(value);
+        }
+    }
+};
+
+// Printf-style logger. Enabled calls only copy a LogRecord into a lock-free ring owned by the
+// calling thread; a background thread formats the records and writes them out.
+class Logger {
+public:
+    static constexpr LogLevel kMinLevel = static_cast<LogLevel>(G923_LOG_MIN_LEVEL);
+
+    static constexpr bool is_compiled_in(LogLevel level) noexcept {
+        return static_cast<int>(level) >= static_cast<int>(kMinLevel);
+    }
+
+    template <typename... Args>
+    static void debug(const char* format, const Args&... args) {
+        log<LogLevel::Debug>(format, args...);
+    }
+
+    template <typename... Args>
+    static void info(const char* format, const Args&... args) {
+        log<LogLevel::Info>(format, args...);
+    }
+
+    template <typename... Args>
+    static void warning(const char* format, const Args&... args) {
+        log<LogLevel::Warning>(format, args...);
+    }
+
+    template <typename... Args>
+    static void error(const char* format, const Args&... args) {
+        log<LogLevel::Error>(format, args...);
+    }
+
+    template <LogLevel level, typename... Args>
+    static void log(const char* format, const Args&... args) {
+        static_assert(sizeof...(Args) <= LogRecord::kMaxArguments, "Too many log arguments");
+        if constexpr (is_compiled_in(level)) {
+            // Debug and info can also be silenced at runtime; warnings and errors always pass
+            if (level < LogLevel::Warning && !enabled_.load(std::memory_order_relaxed)) {
+                return;
+            }
+
+            LogRecord record;
+            record.level = level;
+            record.format = format;
+            (record.add(args), ...);
+            submit(record);
+        }
+    }
+
+    static void set_enabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    // Registers the calling thread's ring, which otherwise happens on its first log call; threads
+    // that log from a no-alloc path call this when they start
+    static void prepare_thread();
+    static void set_output(std::FILE* output);
+    static void flush();
+    static std::uint64_t dropped_records();
+
+    static std::size_t format_record(const LogRecord& record, char* buffer, std::size_t size);
+
+private:
+    static std::atomic<bool> enabled_;
+    static void submit(LogRecord& record);
+};
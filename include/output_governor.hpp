@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Paces HID output for one wheel interface. Write completion times feed an estimate of how
+// many reports per second the device absorbs; that capacity is split between command classes
+// and enforced with a token bucket per class. Callers keep coalescing while they wait, so
+// whatever goes out once a class has budget again is the newest value.
+class OutputGovernor {
+public:
+    using clock = std::chrono::steady_clock;
+
+    enum class CommandClass : std::size_t {
+        force,
+        led,
+        count,
+    };
+
+    struct Snapshot {
+        double service_time_us = 0.0;
+        double device_capacity_hz = 0.0;
+        std::array<double, static_cast<std::size_t>(CommandClass::count)> class_caps_hz{};
+        std::uint64_t samples = 0;
+        std::uint64_t deferrals = 0;
+    };
+
+    explicit OutputGovernor(double initial_capacity_hz = 1000.0);
+
+    void record_write(clock::duration service_time);
+    clock::duration time_until_available(CommandClass command_class, clock::time_point now);
+    void consume(CommandClass command_class, std::size_t reports, clock::time_point now);
+    void note_deferral() noexcept { ++snapshot_.deferrals; }
+
+    double class_cap_hz(CommandClass command_class) const noexcept {
+        return snapshot_.class_caps_hz[static_cast<std::size_t>(command_class)];
+    }
+    const Snapshot& snapshot() const noexcept { return snapshot_; }
+
+private:
+    struct Bucket {
+        double tokens = 0.0;
+        clock::time_point last_refill{};
+    };
+
+    Snapshot snapshot_;
+    std::array<Bucket, static_cast<std::size_t>(CommandClass::count)> buckets_;
+
+    void update_caps();
+    void refill(CommandClass command_class, clock::time_point now);
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+// Scoped timeline zones for the force path. Builds with G923_TRACE_ZONES record each zone's
+// start and duration into a ring owned by the calling thread; write_chrome_trace() dumps every
+// thread's ring as Chrome trace-event JSON for chrome://tracing or Perfetto. Other builds
+// compile the zones away and dump an empty trace.
+namespace trace_zones {
+
+std::uint64_t now_ns() noexcept;
+// Sets up the calling thread's ring before returning the start time, so the first zone on a
+// thread allocates when it opens rather than inside whatever it encloses
+std::uint64_t begin() noexcept;
+void record(const char* name, std::uint64_t start_ns, std::uint64_t end_ns) noexcept;
+
+// Sets up the calling thread's ring ahead of its first zone and names it in the trace
+void prepare_thread(const char* thread_name);
+
+bool write_chrome_trace(std::FILE* output);
+bool write_chrome_trace(const char* path);
+
+}  // namespace trace_zones
+
+class TraceZone {
+public:
+#ifdef G923_TRACE_ZONES
+    explicit TraceZone(const char* name) noexcept : name_(name), start_ns_(trace_zones::begin()) {}
+    ~TraceZone() { trace_zones::record(name_, start_ns_, trace_zones::now_ns()); }
+#else
+    explicit TraceZone(const char*) noexcept {}
+#endif
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+#ifdef G923_TRACE_ZONES
+private:
+    const char* name_;
+    std::uint64_t start_ns_;
+#endif
+};
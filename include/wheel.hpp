@@ -2,12 +2,19 @@
 
 #include "types.hpp"
 #include "device.hpp"
+#include "hidpp.hpp"
 #include "utilities.hpp"
 #include <memory>
 
+enum class WheelBackend {
+    classic,
+    hidpp
+};
+
 class WheelController {
 public:
-    explicit WheelController(const HidDevice& device);
+    WheelController(const HidDevice& device, std::unique_ptr<HidTransport> transport,
+                    WheelBackend backend = WheelBackend::classic);
     ~WheelController();
     
     WheelController(const WheelController&) = delete;
@@ -24,6 +31,7 @@ public:
     bool set_custom_spring(std::uint8_t d1, std::uint8_t d2, std::uint8_t k1, std::uint8_t k2,
                             std::uint8_t s1, std::uint8_t s2, std::uint8_t clip);
     bool set_constant_force(std::uint8_t force_level);
+    bool set_constant_force_level(std::int16_t level);
     bool set_damper(std::uint8_t k1, std::uint8_t k2, std::uint8_t s1, std::uint8_t s2);
     bool set_trapezoid(std::uint8_t l1, std::uint8_t l2, std::uint8_t t1, std::uint8_t t2,
                         std::uint8_t t3, std::uint8_t s);
@@ -34,17 +42,22 @@ public:
     bool is_initialized() const noexcept { return is_initialized_; }
     bool is_calibrated() const noexcept { return is_calibrated_; }
     const HidDevice& device() const noexcept { return device_; }
+    WheelBackend backend() const noexcept { return backend_; }
+    bool has_high_resolution_forces() const noexcept { return backend_ == WheelBackend::hidpp; }
     
 private:
     HidDevice device_;
     std::unique_ptr<HidDeviceInterface> device_interface_;
+    WheelBackend backend_;
+    std::unique_ptr<HidppTransport> hidpp_transport_;
+    std::unique_ptr<HidppForceFeedback> hidpp_;
     bool is_initialized_;
     bool is_calibrated_;
     
     bool send_command(const Command& command);
-    Command create_command_for_device(std::uint8_t cmd_id, 
-                                        const std::vector<std::uint8_t>& params = {});
     
     bool validate_device() const;
     bool perform_calibration_sequence();
+    bool initialize_hidpp();
+    bool check_hidpp_result(bool success);
 };
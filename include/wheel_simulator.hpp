@@ -0,0 +1,151 @@
+#pragma once
+
+#include "command_encoder.hpp"
+#include "fixed_ring.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Virtual G923 rim. It decodes the classic 8-byte output reports produced by CommandBuilder
+// into motor effects and integrates a single-axis rim model (inertia, Coulomb and viscous
+// friction, a torque-limited motor with finite bandwidth, end stops). Time advances either
+// explicitly through advance() or from a background thread following a scaled wall clock,
+// and every step can be recorded as an angle/torque trace. The trace and the command log are
+// fixed rings allocated up front, so apply() never allocates on a writer's no-alloc path and a
+// long run keeps its newest history, counting what it overwrote.
+class WheelSimulator {
+public:
+    struct Config {
+        double inertia_kg_m2 = 0.035;
+        double coulomb_friction_nm = 0.04;
+        double viscous_friction_nm_s = 0.006;
+        double max_motor_torque_nm = 2.2;
+        double motor_time_constant_s = 0.002;
+        double rotation_range_deg = 900.0;
+        double end_stop_stiffness_nm_per_rad = 40.0;
+        double spring_full_scale_deg = 90.0;
+        double damper_full_scale_dps = 360.0;
+        std::chrono::microseconds step{500};
+        std::size_t trace_decimation = 2;
+        std::size_t trace_capacity = 1 << 18;
+        std::size_t command_capacity = 1 << 16;
+    };
+
+    struct TraceSample {
+        std::uint64_t time_us = 0;
+        float angle_deg = 0.0f;
+        float velocity_dps = 0.0f;
+        float commanded_torque_nm = 0.0f;
+        float motor_torque_nm = 0.0f;
+        std::uint8_t led_pattern = 0;
+    };
+
+    struct CommandEvent {
+        std::uint64_t time_us = 0;
+        Command command;
+    };
+
+    struct Stats {
+        std::uint64_t commands = 0;
+        std::uint64_t unknown_commands = 0;
+        std::uint64_t steps = 0;
+        std::uint64_t dropped_samples = 0;
+        std::uint64_t dropped_commands = 0;
+        std::uint64_t saturated_steps = 0;
+    };
+
+    WheelSimulator();
+    explicit WheelSimulator(const Config& config);
+    ~WheelSimulator();
+
+    WheelSimulator(const WheelSimulator&) = delete;
+    WheelSimulator& operator=(const WheelSimulator&) = delete;
+
+    // Decodes one output report at the current simulated time
+    void apply(const Command& command);
+
+    // Offline mode: steps the model by the given amount of simulated time
+    void advance(std::chrono::microseconds duration);
+
+    // Real-time mode: simulated time follows the wall clock multiplied by time_scale
+    void start_realtime(double time_scale = 1.0);
+    void stop_realtime();
+
+    void set_hand_torque(double torque_nm);
+    void set_angle(double angle_deg);
+
+    std::uint64_t time_us() const;
+    double angle_deg() const;
+    double motor_torque_nm() const;
+    std::uint8_t led_pattern() const;
+    Stats stats() const;
+
+    std::vector<TraceSample> trace() const;
+    std::vector<CommandEvent> command_log() const;
+    void clear_trace();
+    bool write_trace_csv(std::FILE* output) const;
+
+private:
+    struct ConditionEffect {
+        bool active = false;
+        double deadband_left = 0.0;
+        double deadband_right = 0.0;
+        double coefficient_positive = 0.0;
+        double coefficient_negative = 0.0;
+        double saturation_positive = 0.0;
+        double saturation_negative = 0.0;
+    };
+
+    struct TrapezoidEffect {
+        bool active = false;
+        double level1 = 0.0;
+        double level2 = 0.0;
+        std::uint32_t hold1_us = 0;
+        std::uint32_t hold2_us = 0;
+        std::uint32_t step_interval_us = 0;
+        double step = 0.0;
+        double level = 0.0;
+        bool ramping = false;
+        bool toward_level2 = true;
+        std::uint64_t phase_start_us = 0;
+        std::uint64_t last_step_us = 0;
+    };
+
+    Config config_;
+    mutable std::mutex mutex_;
+
+    std::uint64_t time_us_;
+    double angle_rad_;
+    double velocity_rad_s_;
+    double motor_torque_nm_;
+    double commanded_torque_nm_;
+    double hand_torque_nm_;
+    std::uint8_t led_pattern_;
+
+    bool autocenter_enabled_;
+    ConditionEffect autocenter_;
+    ConditionEffect spring_;
+    ConditionEffect damper_;
+    TrapezoidEffect trapezoid_;
+    double constant_level_;
+
+    Stats stats_;
+    std::size_t steps_since_sample_;
+    FixedRing<TraceSample> trace_;
+    FixedRing<CommandEvent> commands_;
+
+    std::thread realtime_thread_;
+    std::atomic<bool> realtime_running_;
+
+    void apply_locked(const Command& command);
+    void step_locked(double dt);
+    double effect_torque_fraction_locked();
+    double trapezoid_level_locked();
+    void record_sample_locked();
+    void realtime_loop(double time_scale);
+};
@@ -0,0 +1,37 @@
+#include "command_encoder.hpp"
+
+// Golden bytes for every encoder, checked by the compiler. Any layout change that alters what
+// goes over the wire fails the build here.
+namespace {
+
+constexpr Command golden(std::uint8_t b0, std::uint8_t b1, std::uint8_t b2, std::uint8_t b3, std::uint8_t b4,
+                         std::uint8_t b5, std::uint8_t b6, std::uint8_t b7) {
+    return Command{b0, b1, b2, b3, b4, b5, b6, b7};
+}
+
+static_assert(g923_effects::pack_nibbles(0x0A, 0x05) == 0xA5, "High nibble first");
+static_assert(g923_effects::pack_nibbles(0xFA, 0x35) == 0xA5, "Nibble inputs are masked to four bits");
+static_assert(g923_effects::pack_nibbles(0x0F, 0x0F) == 0xFF, "Full-scale nibbles");
+
+static_assert(sizeof(Command) == COMMAND_MAX_LENGTH, "Command must stay a plain 8-byte report");
+
+static_assert(CommandBuilder::create_disable_autocenter() == golden(0xF5, 0, 0, 0, 0, 0, 0, 0), "disable autocenter");
+static_assert(CommandBuilder::create_enable_autocenter() == golden(0xF4, 0, 0, 0, 0, 0, 0, 0), "enable autocenter");
+static_assert(CommandBuilder::create_autocenter_spring(0x01, 0x02, 0x03) ==
+                  golden(0xFE, 0x00, 0x01, 0x02, 0x03, 0x00, 0x00, 0x00),
+              "autocenter spring");
+static_assert(CommandBuilder::create_constant_force(0x90) == golden(0xF1, 0x00, 0x90, 0x90, 0x90, 0x90, 0x00, 0x00),
+              "constant force");
+static_assert(CommandBuilder::create_custom_spring(0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07) ==
+                  golden(0xF1, 0x01, 0x01, 0x02, 0x43, 0x65, 0x07, 0x00),
+              "custom spring");
+static_assert(CommandBuilder::create_damper(0x01, 0x02, 0x03, 0x04) ==
+                  golden(0xF1, 0x02, 0x01, 0x03, 0x02, 0x04, 0x00, 0x00),
+              "damper");
+static_assert(CommandBuilder::create_trapezoid(0x01, 0x02, 0x03, 0x04, 0x05, 0x06) ==
+                  golden(0xF1, 0x06, 0x01, 0x02, 0x03, 0x04, 0x56, 0x00),
+              "trapezoid");
+static_assert(CommandBuilder::create_stop_forces() == golden(0xF3, 0, 0, 0, 0, 0, 0, 0), "stop forces");
+static_assert(CommandBuilder::create_led_pattern(0x1F) == golden(0xF8, 0x12, 0x1F, 0, 0, 0, 0, 0), "LED pattern");
+
+}  // namespace
@@ -0,0 +1,180 @@
+#include "fake_hid_backend.hpp"
+#include "constants.hpp"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+class FakeHidTransport final : public HidTransport {
+public:
+    explicit FakeHidTransport(std::shared_ptr<FakeHidDevice> device) : device_(std::move(device)), is_open_(false) {}
+
+    bool open() override {
+        is_open_ = is_open_ || device_->open();
+        return is_open_;
+    }
+
+    bool close() override {
+        is_open_ = false;
+        return true;
+    }
+
+    bool is_open() const override { return is_open_; }
+
+    bool write_output_report(const std::uint8_t* data, std::size_t length, bool numbered) override {
+        return device_->write(data, length, numbered);
+    }
+
+    bool read_input_report(std::uint8_t report_id, std::uint8_t* data, std::size_t& length) override {
+        return device_->read(report_id, data, length);
+    }
+
+private:
+    std::shared_ptr<FakeHidDevice> device_;
+    bool is_open_;
+};
+
+}  // namespace
+
+FakeHidDevice::FakeHidDevice(const HidDevice& device)
+    : device_(device), service_time_(0), fail_writes_(false), stats_{}, last_command_{} {
+}
+
+void FakeHidDevice::set_service_time(std::chrono::microseconds service_time) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    service_time_ = service_time;
+}
+
+void FakeHidDevice::set_write_failure(bool fail) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fail_writes_ = fail;
+}
+
+void FakeHidDevice::attach_hidpp(std::unique_ptr<HidppMockDevice> hidpp) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hidpp_ = std::move(hidpp);
+}
+
+void FakeHidDevice::attach_simulator(std::shared_ptr<WheelSimulator> simulator) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    simulator_ = std::move(simulator);
+}
+
+void FakeHidDevice::set_write_observer(WriteObserver observer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    observer_ = std::move(observer);
+}
+
+FakeHidDevice::Stats FakeHidDevice::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+Command FakeHidDevice::last_command() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_command_;
+}
+
+bool FakeHidDevice::open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.opens;
+    return true;
+}
+
+bool FakeHidDevice::write(const std::uint8_t* data, std::size_t length, bool numbered) {
+    std::chrono::microseconds service_time(0);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        service_time = service_time_;
+    }
+    if (service_time.count() > 0) {
+        std::this_thread::sleep_for(service_time);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fail_writes_) {
+        ++stats_.failed_writes;
+        return false;
+    }
+
+    ++stats_.writes;
+    if (observer_) {
+        observer_(data, length, numbered);
+    }
+    if (!numbered) {
+        last_command_ = Command{};
+        std::memcpy(last_command_.data, data, std::min(length, COMMAND_MAX_LENGTH));
+        if (simulator_) {
+            simulator_->apply(last_command_);
+        }
+        return true;
+    }
+
+    ++stats_.numbered_writes;
+    if (!hidpp_) {
+        return true;
+    }
+
+    HidppReport report;
+    report.length = std::min(length, sizeof(report.data));
+    std::memcpy(report.data, data, report.length);
+    return hidpp_->write_report(report);
+}
+
+bool FakeHidDevice::read(std::uint8_t report_id, std::uint8_t* data, std::size_t& length) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.reads;
+
+    HidppReport report;
+    if (!hidpp_ || !hidpp_->read_report(report_id, report)) {
+        return false;
+    }
+
+    length = std::min(length, report.length);
+    std::memcpy(data, report.data, length);
+    return true;
+}
+
+std::shared_ptr<FakeHidDevice> FakeHidBackend::add_device(device_id_t vendor_id, device_id_t product_id,
+                                                          const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return add_device_locked(vendor_id, product_id, name);
+}
+
+std::shared_ptr<FakeHidDevice> FakeHidBackend::add_g923(bool with_hidpp) {
+    std::shared_ptr<FakeHidDevice> device;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        device = add_device_locked(G923_VENDOR_ID, G923_PRODUCT_ID, "g923-" + std::to_string(devices_.size()));
+    }
+    if (with_hidpp) {
+        device->attach_hidpp(std::make_unique<HidppMockDevice>());
+    }
+    return device;
+}
+
+std::shared_ptr<FakeHidDevice> FakeHidBackend::add_device_locked(device_id_t vendor_id, device_id_t product_id,
+                                                                 const std::string& name) {
+    const HidDevice device(vendor_id, product_id, (product_id << 16) | vendor_id, "fake:" + name);
+    devices_.push_back(std::make_shared<FakeHidDevice>(device));
+    return devices_.back();
+}
+
+std::vector<HidDevice> FakeHidBackend::list_all_devices() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<HidDevice> devices;
+    devices.reserve(devices_.size());
+    for (const auto& device : devices_) {
+        devices.push_back(device->device());
+    }
+    return devices;
+}
+
+std::unique_ptr<HidTransport> FakeHidBackend::create_transport(const HidDevice& device) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = std::find_if(devices_.begin(), devices_.end(), [&device](const std::shared_ptr<FakeHidDevice>& fake) {
+        return fake->device().path == device.path;
+    });
+    return it == devices_.end() ? nullptr : std::make_unique<FakeHidTransport>(*it);
+}
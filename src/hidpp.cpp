@@ -0,0 +1,273 @@
+#include "hidpp.hpp"
+#include <algorithm>
+
+HidppReport HidppCommandBuilder::create_request(std::uint8_t feature_index, std::uint8_t function,
+                                                const std::uint8_t* params, std::size_t param_count) {
+    HidppReport report;
+    const bool very_long = param_count > (hidpp::REPORT_LENGTH_LONG - hidpp::REPORT_HEADER_LENGTH);
+    report.length = very_long ? hidpp::REPORT_LENGTH_VERY_LONG : hidpp::REPORT_LENGTH_LONG;
+    report.data[0] = very_long ? hidpp::REPORT_ID_VERY_LONG : hidpp::REPORT_ID_LONG;
+    report.data[1] = hidpp::DEVICE_INDEX;
+    report.data[2] = feature_index;
+    report.data[3] = static_cast<std::uint8_t>((function << 4) | hidpp::SOFTWARE_ID);
+
+    const std::size_t count = std::min(param_count, report.param_capacity());
+    for (std::size_t i = 0; i < count; ++i) {
+        report.params()[i] = params[i];
+    }
+
+    return report;
+}
+
+HidppReport HidppCommandBuilder::create_get_feature(std::uint16_t feature_id) {
+    std::uint8_t params[2] = {0};
+    write_uint16(params, feature_id);
+    return create_request(hidpp::ROOT_FEATURE_INDEX, hidpp::ROOT_GET_FEATURE, params, sizeof(params));
+}
+
+HidppReport HidppCommandBuilder::create_get_info(std::uint8_t feature_index) {
+    return create_request(feature_index, hidpp::FF_GET_INFO, nullptr, 0);
+}
+
+HidppReport HidppCommandBuilder::create_reset_all(std::uint8_t feature_index) {
+    return create_request(feature_index, hidpp::FF_RESET_ALL, nullptr, 0);
+}
+
+HidppReport HidppCommandBuilder::create_constant_force(std::uint8_t feature_index, std::uint8_t slot,
+                                                       std::int16_t level, bool autostart) {
+    // slot, type, duration (0 = infinite), start delay, level, attack and fade envelope
+    std::uint8_t params[14] = {0};
+    params[0] = slot;
+    params[1] = static_cast<std::uint8_t>(hidpp::EFFECT_CONSTANT | (autostart ? hidpp::EFFECT_AUTOSTART : 0));
+    write_uint16(params + 6, static_cast<std::uint16_t>(level));
+    return create_request(feature_index, hidpp::FF_DOWNLOAD_EFFECT, params, sizeof(params));
+}
+
+HidppReport HidppCommandBuilder::create_condition(std::uint8_t feature_index, std::uint8_t slot,
+                                                  std::uint8_t effect_type, const HidppCondition& condition,
+                                                  bool autostart) {
+    std::uint8_t params[18] = {0};
+    params[0] = slot;
+    params[1] = static_cast<std::uint8_t>((effect_type & hidpp::EFFECT_TYPE_MASK) |
+                                          (autostart ? hidpp::EFFECT_AUTOSTART : 0));
+    write_uint16(params + 6, condition.left_saturation);
+    write_uint16(params + 8, static_cast<std::uint16_t>(condition.left_coefficient));
+    write_uint16(params + 10, condition.deadband);
+    write_uint16(params + 12, static_cast<std::uint16_t>(condition.center));
+    write_uint16(params + 14, static_cast<std::uint16_t>(condition.right_coefficient));
+    write_uint16(params + 16, condition.right_saturation);
+    return create_request(feature_index, hidpp::FF_DOWNLOAD_EFFECT, params, sizeof(params));
+}
+
+HidppReport HidppCommandBuilder::create_set_effect_state(std::uint8_t feature_index, std::uint8_t slot,
+                                                         std::uint8_t state) {
+    const std::uint8_t params[2] = {slot, state};
+    return create_request(feature_index, hidpp::FF_SET_EFFECT_STATE, params, sizeof(params));
+}
+
+HidppReport HidppCommandBuilder::create_destroy_effect(std::uint8_t feature_index, std::uint8_t slot) {
+    const std::uint8_t params[1] = {slot};
+    return create_request(feature_index, hidpp::FF_DESTROY_EFFECT, params, sizeof(params));
+}
+
+HidppReport HidppCommandBuilder::create_set_global_gain(std::uint8_t feature_index, std::uint16_t gain,
+                                                        std::uint16_t boost) {
+    std::uint8_t params[4] = {0};
+    write_uint16(params, gain);
+    write_uint16(params + 2, boost);
+    return create_request(feature_index, hidpp::FF_SET_GLOBAL_GAINS, params, sizeof(params));
+}
+
+std::int16_t HidppCommandBuilder::read_int16(const std::uint8_t* bytes) noexcept {
+    return static_cast<std::int16_t>(read_uint16(bytes));
+}
+
+std::uint16_t HidppCommandBuilder::read_uint16(const std::uint8_t* bytes) noexcept {
+    return static_cast<std::uint16_t>((bytes[0] << 8) | bytes[1]);
+}
+
+void HidppCommandBuilder::write_uint16(std::uint8_t* bytes, std::uint16_t value) noexcept {
+    bytes[0] = static_cast<std::uint8_t>(value >> 8);
+    bytes[1] = static_cast<std::uint8_t>(value & 0xFF);
+}
+
+HidppForceFeedback::HidppForceFeedback(HidppTransport& transport)
+    : transport_(transport), feature_index_(0), slot_capacity_(0), is_initialized_(false),
+        autocenter_enabled_(false), autocenter_condition_{}, roles_{}, stats_{} {
+}
+
+bool HidppForceFeedback::initialize() {
+    if (is_initialized_) {
+        return true;
+    }
+
+    HidppReport response;
+    if (!transact(HidppCommandBuilder::create_get_feature(hidpp::FEATURE_FORCE_FEEDBACK), response)) {
+        return false;
+    }
+
+    feature_index_ = response.params()[0];
+    if (feature_index_ == hidpp::ROOT_FEATURE_INDEX) {
+        return false;
+    }
+
+    if (!transact(HidppCommandBuilder::create_get_info(feature_index_), response)) {
+        return false;
+    }
+
+    slot_capacity_ = response.params()[0];
+    if (slot_capacity_ < static_cast<std::size_t>(EffectRole::count)) {
+        return false;
+    }
+
+    if (!reset()) {
+        return false;
+    }
+
+    if (!set_global_gain(0xFFFF)) {
+        return false;
+    }
+
+    is_initialized_ = true;
+    return true;
+}
+
+bool HidppForceFeedback::set_constant_force(std::int16_t level) {
+    const RoleState& state = roles_[static_cast<std::size_t>(EffectRole::constant)];
+    if (level == 0 && !state.playing) {
+        return true;
+    }
+
+    return upload_effect(EffectRole::constant,
+                         HidppCommandBuilder::create_constant_force(feature_index_, state.slot, level, true));
+}
+
+bool HidppForceFeedback::set_spring(const HidppCondition& condition) {
+    return upload_condition(EffectRole::spring, hidpp::EFFECT_SPRING, condition);
+}
+
+bool HidppForceFeedback::set_damper(const HidppCondition& condition) {
+    return upload_condition(EffectRole::damper, hidpp::EFFECT_DAMPER, condition);
+}
+
+bool HidppForceFeedback::set_autocenter(const HidppCondition& condition) {
+    autocenter_condition_ = condition;
+    if (!autocenter_enabled_) {
+        return true;
+    }
+    return upload_condition(EffectRole::autocenter, hidpp::EFFECT_SPRING, autocenter_condition_);
+}
+
+bool HidppForceFeedback::set_autocenter_enabled(bool enabled) {
+    autocenter_enabled_ = enabled;
+    if (!enabled) {
+        return stop_effect(EffectRole::autocenter);
+    }
+    return upload_condition(EffectRole::autocenter, hidpp::EFFECT_SPRING, autocenter_condition_);
+}
+
+bool HidppForceFeedback::set_global_gain(std::uint16_t gain) {
+    HidppReport response;
+    return transact(HidppCommandBuilder::create_set_global_gain(feature_index_, gain, 0), response);
+}
+
+bool HidppForceFeedback::stop_forces() {
+    const bool constant_ok = stop_effect(EffectRole::constant);
+    const bool spring_ok = stop_effect(EffectRole::spring);
+    const bool damper_ok = stop_effect(EffectRole::damper);
+    return constant_ok && spring_ok && damper_ok;
+}
+
+bool HidppForceFeedback::reset() {
+    HidppReport response;
+    if (!transact(HidppCommandBuilder::create_reset_all(feature_index_), response)) {
+        return false;
+    }
+    forget_slots();
+    return true;
+}
+
+bool HidppForceFeedback::transact(const HidppReport& request, HidppReport& response) {
+    ++stats_.requests_sent;
+    if (feature_index_ != hidpp::ROOT_FEATURE_INDEX && request.feature_index() == feature_index_ &&
+        request.function() < hidpp::FF_FUNCTION_COUNT) {
+        ++stats_.function_counts[request.function()];
+    }
+
+    if (!transport_.write_report(request)) {
+        ++stats_.write_failures;
+        return false;
+    }
+
+    if (!transport_.read_report(request.report_id(), response)) {
+        ++stats_.read_failures;
+        return false;
+    }
+
+    if (response.is_error()) {
+        ++stats_.error_responses;
+        return false;
+    }
+
+    if (response.feature_index() != request.feature_index() || response.function() != request.function()) {
+        ++stats_.read_failures;
+        return false;
+    }
+
+    return true;
+}
+
+bool HidppForceFeedback::upload_effect(EffectRole role, const HidppReport& request) {
+    RoleState& state = roles_[static_cast<std::size_t>(role)];
+
+    HidppReport response;
+    if (!transact(request, response)) {
+        return false;
+    }
+
+    const std::uint8_t assigned_slot = response.params()[0];
+    if (assigned_slot == hidpp::SLOT_NEW || assigned_slot > slot_capacity_) {
+        return false;
+    }
+
+    state.slot = assigned_slot;
+    state.playing = true;
+    return true;
+}
+
+bool HidppForceFeedback::stop_effect(EffectRole role) {
+    RoleState& state = roles_[static_cast<std::size_t>(role)];
+    if (state.slot == hidpp::SLOT_NEW || !state.playing) {
+        return true;
+    }
+
+    HidppReport response;
+    if (!transact(HidppCommandBuilder::create_set_effect_state(feature_index_, state.slot, hidpp::EFFECT_STATE_STOP),
+                  response)) {
+        return false;
+    }
+
+    state.playing = false;
+    return true;
+}
+
+bool HidppForceFeedback::upload_condition(EffectRole role, std::uint8_t effect_type, const HidppCondition& condition) {
+    if (!is_condition_active(condition)) {
+        return stop_effect(role);
+    }
+
+    const RoleState& state = roles_[static_cast<std::size_t>(role)];
+    return upload_effect(role,
+                         HidppCommandBuilder::create_condition(feature_index_, state.slot, effect_type, condition, true));
+}
+
+void HidppForceFeedback::forget_slots() {
+    for (auto& role : roles_) {
+        role = RoleState{};
+    }
+}
+
+bool HidppForceFeedback::is_condition_active(const HidppCondition& condition) noexcept {
+    return (condition.left_coefficient != 0 || condition.right_coefficient != 0) &&
+           (condition.left_saturation != 0 || condition.right_saturation != 0);
+}
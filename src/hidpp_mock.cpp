@@ -0,0 +1,229 @@
+#include "hidpp_mock.hpp"
+#include <algorithm>
+
+HidppMockDevice::HidppMockDevice(std::uint8_t slot_count, std::uint8_t feature_index)
+    : slots_(slot_count), feature_index_(feature_index), feature_supported_(true), fail_writes_(false),
+        global_gain_(0), report_count_(0), error_count_(0), function_counts_{}, last_request_{},
+        responses_(kMaxPendingResponses), report_times_(kReportHistory) {
+}
+
+bool HidppMockDevice::write_report(const HidppReport& report) {
+    if (fail_writes_) {
+        return false;
+    }
+
+    ++report_count_;
+    report_times_.push(clock::now());
+    last_request_ = report;
+
+    HidppReport response;
+    response.length = report.length;
+    response.data[0] = report.report_id();
+    response.data[1] = report.device_index();
+    response.data[2] = report.feature_index();
+    response.data[3] = report.data[3];
+
+    if (report.device_index() != hidpp::DEVICE_INDEX) {
+        make_error(report, hidpp::ERROR_INVALID_ARGUMENT, response);
+    } else if (report.feature_index() == hidpp::ROOT_FEATURE_INDEX) {
+        handle_root_request(report, response);
+    } else if (feature_supported_ && report.feature_index() == feature_index_) {
+        handle_force_feedback_request(report, response);
+    } else {
+        make_error(report, hidpp::ERROR_INVALID_FEATURE_INDEX, response);
+    }
+
+    queue_response(response);
+    return true;
+}
+
+bool HidppMockDevice::read_report(std::uint8_t report_id, HidppReport& report) {
+    if (responses_.empty() || responses_.front().report_id() != report_id) {
+        return false;
+    }
+
+    report = responses_.front();
+    responses_.pop_front();
+    return true;
+}
+
+const HidppMockDevice::EffectSlot& HidppMockDevice::slot(std::uint8_t slot) const {
+    static const EffectSlot kEmpty{};
+    std::size_t index = 0;
+    return decode_slot(slot, index) ? slots_[index] : kEmpty;
+}
+
+std::size_t HidppMockDevice::allocated_slot_count() const noexcept {
+    return static_cast<std::size_t>(std::count_if(slots_.begin(), slots_.end(),
+                                                  [](const EffectSlot& slot) { return slot.allocated; }));
+}
+
+std::size_t HidppMockDevice::playing_slot_count() const noexcept {
+    return static_cast<std::size_t>(std::count_if(slots_.begin(), slots_.end(),
+                                                  [](const EffectSlot& slot) { return slot.playing; }));
+}
+
+std::uint64_t HidppMockDevice::function_count(std::uint8_t function) const noexcept {
+    return function < function_counts_.size() ? function_counts_[function] : 0;
+}
+
+double HidppMockDevice::reports_per_second() const {
+    if (report_times_.size() < 2) {
+        return 0.0;
+    }
+
+    const auto span = std::chrono::duration<double>(report_times_.back() - report_times_.front()).count();
+    return span > 0.0 ? static_cast<double>(report_times_.size() - 1) / span : 0.0;
+}
+
+std::size_t HidppMockDevice::peak_reports_in_window(clock::duration window) const {
+    std::size_t peak = 0;
+    std::size_t begin = 0;
+
+    for (std::size_t end = 0; end < report_times_.size(); ++end) {
+        while (report_times_[end] - report_times_[begin] >= window) {
+            ++begin;
+        }
+        peak = std::max(peak, end - begin + 1);
+    }
+
+    return peak;
+}
+
+void HidppMockDevice::reset_statistics() {
+    report_count_ = 0;
+    error_count_ = 0;
+    function_counts_.fill(0);
+    report_times_.clear();
+}
+
+void HidppMockDevice::handle_root_request(const HidppReport& request, HidppReport& response) {
+    if (request.function() != hidpp::ROOT_GET_FEATURE) {
+        make_error(request, hidpp::ERROR_INVALID_FUNCTION, response);
+        return;
+    }
+
+    const std::uint16_t feature_id = HidppCommandBuilder::read_uint16(request.params());
+    const bool known = feature_supported_ && feature_id == hidpp::FEATURE_FORCE_FEEDBACK;
+    response.params()[0] = known ? feature_index_ : hidpp::ROOT_FEATURE_INDEX;
+}
+
+void HidppMockDevice::handle_force_feedback_request(const HidppReport& request, HidppReport& response) {
+    const std::uint8_t function = request.function();
+    if (function >= hidpp::FF_FUNCTION_COUNT) {
+        make_error(request, hidpp::ERROR_INVALID_FUNCTION, response);
+        return;
+    }
+    ++function_counts_[function];
+
+    const std::uint8_t* params = request.params();
+    std::size_t index = 0;
+
+    switch (function) {
+        case hidpp::FF_GET_INFO:
+            response.params()[0] = slot_count();
+            break;
+        case hidpp::FF_RESET_ALL:
+            std::fill(slots_.begin(), slots_.end(), EffectSlot{});
+            break;
+        case hidpp::FF_DOWNLOAD_EFFECT:
+            handle_download(request, response);
+            break;
+        case hidpp::FF_SET_EFFECT_STATE:
+            if (!decode_slot(params[0], index) || !slots_[index].allocated) {
+                make_error(request, hidpp::ERROR_INVALID_ARGUMENT, response);
+                break;
+            }
+            slots_[index].playing = params[1] == hidpp::EFFECT_STATE_PLAY;
+            response.params()[0] = params[0];
+            break;
+        case hidpp::FF_DESTROY_EFFECT:
+            if (!decode_slot(params[0], index) || !slots_[index].allocated) {
+                make_error(request, hidpp::ERROR_INVALID_ARGUMENT, response);
+                break;
+            }
+            slots_[index] = EffectSlot{};
+            break;
+        case hidpp::FF_SET_GLOBAL_GAINS:
+            global_gain_ = HidppCommandBuilder::read_uint16(params);
+            break;
+        case hidpp::FF_GET_GLOBAL_GAINS:
+            HidppCommandBuilder::write_uint16(response.params(), global_gain_);
+            break;
+        default:
+            break;
+    }
+}
+
+void HidppMockDevice::handle_download(const HidppReport& request, HidppReport& response) {
+    const std::uint8_t* params = request.params();
+    std::size_t index = 0;
+
+    if (params[0] == hidpp::SLOT_NEW) {
+        const auto free_slot = std::find_if(slots_.begin(), slots_.end(),
+                                            [](const EffectSlot& slot) { return !slot.allocated; });
+        if (free_slot == slots_.end()) {
+            make_error(request, hidpp::ERROR_BUSY, response);
+            return;
+        }
+        index = static_cast<std::size_t>(free_slot - slots_.begin());
+    } else if (!decode_slot(params[0], index) || !slots_[index].allocated) {
+        make_error(request, hidpp::ERROR_INVALID_ARGUMENT, response);
+        return;
+    }
+
+    const std::uint8_t effect_type = params[1] & hidpp::EFFECT_TYPE_MASK;
+    const bool is_condition = effect_type == hidpp::EFFECT_SPRING || effect_type == hidpp::EFFECT_DAMPER;
+    if (effect_type != hidpp::EFFECT_CONSTANT && !is_condition) {
+        make_error(request, hidpp::ERROR_OUT_OF_RANGE, response);
+        return;
+    }
+
+    // Condition effects need 18 parameter bytes and therefore a very long report
+    if (is_condition && request.report_id() != hidpp::REPORT_ID_VERY_LONG) {
+        make_error(request, hidpp::ERROR_INVALID_ARGUMENT, response);
+        return;
+    }
+
+    EffectSlot& slot = slots_[index];
+    slot.allocated = true;
+    slot.effect_type = effect_type;
+    slot.duration_ms = HidppCommandBuilder::read_uint16(params + 2);
+    slot.delay_ms = HidppCommandBuilder::read_uint16(params + 4);
+    if (is_condition) {
+        slot.condition.left_saturation = HidppCommandBuilder::read_uint16(params + 6);
+        slot.condition.left_coefficient = HidppCommandBuilder::read_int16(params + 8);
+        slot.condition.deadband = HidppCommandBuilder::read_uint16(params + 10);
+        slot.condition.center = HidppCommandBuilder::read_int16(params + 12);
+        slot.condition.right_coefficient = HidppCommandBuilder::read_int16(params + 14);
+        slot.condition.right_saturation = HidppCommandBuilder::read_uint16(params + 16);
+    } else {
+        slot.level = HidppCommandBuilder::read_int16(params + 6);
+    }
+    if ((params[1] & hidpp::EFFECT_AUTOSTART) != 0) {
+        slot.playing = true;
+    }
+    ++slot.download_count;
+
+    response.params()[0] = static_cast<std::uint8_t>(index + 1);
+}
+
+bool HidppMockDevice::decode_slot(std::uint8_t slot, std::size_t& index) const noexcept {
+    if (slot == hidpp::SLOT_NEW || slot > slots_.size()) {
+        return false;
+    }
+    index = static_cast<std::size_t>(slot - 1);
+    return true;
+}
+
+void HidppMockDevice::make_error(const HidppReport& request, std::uint8_t error_code, HidppReport& response) {
+    ++error_count_;
+    response.data[2] = hidpp::ERROR_FEATURE_INDEX;
+    response.data[3] = request.feature_index();
+    response.data[4] = request.data[3];
+    response.data[5] = error_code;
+}
+
+void HidppMockDevice::queue_response(const HidppReport& response) {
+    responses_.push(response);
+}
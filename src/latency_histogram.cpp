@@ -0,0 +1,103 @@
+#include "latency_histogram.hpp"
+#include <algorithm>
+
+namespace {
+
+int highest_bit(std::uint64_t value) noexcept {
+    int bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+}
+
+}  // namespace
+
+std::uint64_t LatencyHistogram::Snapshot::percentile_ns(double percentile) const noexcept {
+    if (count == 0) {
+        return 0;
+    }
+
+    const double clamped = std::max(0.0, std::min(100.0, percentile));
+    const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(clamped / 100.0 * count + 0.5));
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(bucket_upper_bound(i), max_ns);
+        }
+    }
+
+    return max_ns;
+}
+
+void LatencyHistogram::Snapshot::merge(const Snapshot& other) noexcept {
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    count += other.count;
+    total_ns += other.total_ns;
+    max_ns = std::max(max_ns, other.max_ns);
+}
+
+void LatencyHistogram::record(std::uint64_t value_ns) noexcept {
+    buckets_[bucket_index(value_ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_ns_.fetch_add(value_ns, std::memory_order_relaxed);
+
+    std::uint64_t current_max = max_ns_.load(std::memory_order_relaxed);
+    while (value_ns > current_max &&
+           !max_ns_.compare_exchange_weak(current_max, value_ns, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const noexcept {
+    Snapshot snapshot;
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    snapshot.count = count_.load(std::memory_order_relaxed);
+    snapshot.total_ns = total_ns_.load(std::memory_order_relaxed);
+    snapshot.max_ns = max_ns_.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void LatencyHistogram::reset() noexcept {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    total_ns_.store(0, std::memory_order_relaxed);
+    max_ns_.store(0, std::memory_order_relaxed);
+}
+
+// Values below kSubBuckets get one bucket each; above that every octave [2^n, 2^(n+1)) is cut
+// into kSubBuckets equal slices. Anything past the last octave lands in the final bucket.
+std::size_t LatencyHistogram::bucket_index(std::uint64_t value_ns) noexcept {
+    if (value_ns < kSubBuckets) {
+        return static_cast<std::size_t>(value_ns);
+    }
+
+    const int octave = highest_bit(value_ns) - 1;
+    const auto sub_bucket = static_cast<std::size_t>((value_ns >> (octave - 1)) & (kSubBuckets - 1));
+    const std::size_t index = static_cast<std::size_t>(octave) * kSubBuckets + sub_bucket;
+    return std::min(index, kBucketCount - 1);
+}
+
+std::uint64_t LatencyHistogram::bucket_lower_bound(std::size_t index) noexcept {
+    if (index < kSubBuckets) {
+        return index;
+    }
+
+    const std::size_t octave = index / kSubBuckets;
+    const std::size_t sub_bucket = index % kSubBuckets;
+    return (static_cast<std::uint64_t>(kSubBuckets + sub_bucket)) << (octave - 1);
+}
+
+std::uint64_t LatencyHistogram::bucket_upper_bound(std::size_t index) noexcept {
+    if (index + 1 >= kBucketCount) {
+        return UINT64_MAX;
+    }
+    return bucket_lower_bound(index + 1) - 1;
+}
@@ -0,0 +1,193 @@
+#include "hid_transport.hpp"
+#include "utilities.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+constexpr const char* kHidrawClassPath = "/sys/class/hidraw";
+constexpr std::size_t kMaxReportLength = 64;
+constexpr int kReadTimeoutMs = 100;
+
+// Output reports go out with one write() each. hidraw expects the report ID in the first byte,
+// with 0 for devices that do not number their reports.
+class HidrawTransport final : public HidTransport {
+public:
+    explicit HidrawTransport(std::string path) : path_(std::move(path)), fd_(-1) {}
+
+    ~HidrawTransport() override {
+        close();
+    }
+
+    bool open() override {
+        if (fd_ >= 0) {
+            return true;
+        }
+
+        fd_ = ::open(path_.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd_ < 0) {
+            Logger::error("Failed to open %s: %s", path_, std::strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    bool close() override {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        return true;
+    }
+
+    bool is_open() const override { return fd_ >= 0; }
+
+    bool write_output_report(const std::uint8_t* data, std::size_t length, bool numbered) override {
+        std::uint8_t buffer[kMaxReportLength + 1];
+        const std::uint8_t* report = data;
+        std::size_t report_length = length;
+
+        if (!numbered) {
+            if (length > kMaxReportLength) {
+                return false;
+            }
+            buffer[0] = 0;
+            std::memcpy(buffer + 1, data, length);
+            report = buffer;
+            report_length = length + 1;
+        }
+
+        while (true) {
+            const ssize_t written = ::write(fd_, report, report_length);
+            if (written == static_cast<ssize_t>(report_length)) {
+                return true;
+            }
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            Logger::error("hidraw write to %s failed: %s", path_, written < 0 ? std::strerror(errno) : "short write");
+            return false;
+        }
+    }
+
+    // Input reports arrive on the same descriptor; skip unrelated ones until the deadline
+    bool read_input_report(std::uint8_t report_id, std::uint8_t* data, std::size_t& length) override {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kReadTimeoutMs);
+
+        while (true) {
+            const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            if (remaining.count() <= 0) {
+                return false;
+            }
+
+            pollfd descriptor{};
+            descriptor.fd = fd_;
+            descriptor.events = POLLIN;
+            const int ready = ::poll(&descriptor, 1, static_cast<int>(remaining.count()));
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ready <= 0) {
+                return false;
+            }
+
+            const ssize_t received = ::read(fd_, data, length);
+            if (received < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            if (received > 0 && data[0] == report_id) {
+                length = static_cast<std::size_t>(received);
+                return true;
+            }
+        }
+    }
+
+private:
+    std::string path_;
+    int fd_;
+};
+
+// Parses HID_ID=<bus>:<vendor>:<product> from a hidraw node's uevent file
+bool read_hid_id(const std::string& node, device_id_t& vendor_id, device_id_t& product_id) {
+    const std::string uevent_path = std::string(kHidrawClassPath) + "/" + node + "/device/uevent";
+    std::FILE* uevent = std::fopen(uevent_path.c_str(), "r");
+    if (!uevent) {
+        return false;
+    }
+
+    bool found = false;
+    char line[256];
+    while (std::fgets(line, sizeof(line), uevent)) {
+        unsigned bus = 0;
+        unsigned vendor = 0;
+        unsigned product = 0;
+        if (std::sscanf(line, "HID_ID=%x:%x:%x", &bus, &vendor, &product) == 3) {
+            vendor_id = vendor;
+            product_id = product;
+            found = true;
+            break;
+        }
+    }
+
+    std::fclose(uevent);
+    return found;
+}
+
+class HidrawBackend final : public HidBackend {
+public:
+    bool is_initialized() const override { return true; }
+
+    std::vector<HidDevice> list_all_devices() override {
+        std::vector<HidDevice> devices;
+
+        DIR* directory = opendir(kHidrawClassPath);
+        if (!directory) {
+            return devices;
+        }
+
+        while (const dirent* entry = readdir(directory)) {
+            if (std::strncmp(entry->d_name, "hidraw", 6) != 0) {
+                continue;
+            }
+
+            device_id_t vendor_id = 0;
+            device_id_t product_id = 0;
+            if (!read_hid_id(entry->d_name, vendor_id, product_id)) {
+                continue;
+            }
+
+            const device_id_t device_id = (product_id << 16) | vendor_id;
+            devices.emplace_back(vendor_id, product_id, device_id, std::string("/dev/") + entry->d_name);
+        }
+
+        closedir(directory);
+        std::sort(devices.begin(), devices.end(),
+                  [](const HidDevice& left, const HidDevice& right) { return left.path < right.path; });
+        return devices;
+    }
+
+    std::unique_ptr<HidTransport> create_transport(const HidDevice& device) override {
+        if (device.path.empty()) {
+            return nullptr;
+        }
+        return std::make_unique<HidrawTransport>(device.path);
+    }
+};
+
+}  // namespace
+
+std::unique_ptr<HidBackend> create_platform_hid_backend() {
+    return std::make_unique<HidrawBackend>();
+}
@@ -0,0 +1,315 @@
+#include "logger.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+std::atomic<bool> Logger::enabled_{true};
+
+namespace {
+
+constexpr std::size_t kRingCapacity = 1024;
+constexpr std::chrono::milliseconds kFlushInterval(10);
+
+// Single-producer ring: only the owning thread pushes, only the backend pops.
+class LogRing {
+public:
+    bool push(const LogRecord& record) noexcept {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= kRingCapacity) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        records_[tail % kRingCapacity] = record;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    const LogRecord* front() const noexcept {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        return head == tail_.load(std::memory_order_acquire) ? nullptr : &records_[head % kRingCapacity];
+    }
+
+    void pop() noexcept { head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    std::uint64_t take_dropped() noexcept { return dropped_.exchange(0, std::memory_order_relaxed); }
+
+    std::atomic<bool> retired{false};
+
+private:
+    std::array<LogRecord, kRingCapacity> records_;
+    std::atomic<std::size_t> head_{0};
+    std::atomic<std::size_t> tail_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+};
+
+class LogBackend {
+public:
+    LogBackend() : output_(stdout), dropped_total_(0), stop_requested_(false) {
+        thread_ = std::thread(&LogBackend::run, this);
+    }
+
+    ~LogBackend() {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            stop_requested_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+        drain();
+    }
+
+    LogRing* register_thread() {
+        std::lock_guard<std::mutex> lock(drain_mutex_);
+        rings_.push_back(std::make_unique<LogRing>());
+        return rings_.back().get();
+    }
+
+    void set_output(std::FILE* output) {
+        std::lock_guard<std::mutex> lock(drain_mutex_);
+        output_ = output ? output : stdout;
+    }
+
+    std::uint64_t dropped_total() const { return dropped_total_.load(std::memory_order_relaxed); }
+
+    // Writes out every queued record, oldest first across all threads
+    void drain() {
+        std::lock_guard<std::mutex> lock(drain_mutex_);
+        char line[512];
+
+        for (auto& ring : rings_) {
+            const std::uint64_t dropped = ring->take_dropped();
+            if (dropped > 0) {
+                dropped_total_.fetch_add(dropped, std::memory_order_relaxed);
+                std::fprintf(output_, "\033[1;33m=== g923mac::warning \033[0m: dropped %llu log records\n",
+                             static_cast<unsigned long long>(dropped));
+            }
+        }
+
+        while (true) {
+            LogRing* oldest = nullptr;
+            for (auto& ring : rings_) {
+                const LogRecord* record = ring->front();
+                if (record && (!oldest || record->timestamp_ns < oldest->front()->timestamp_ns)) {
+                    oldest = ring.get();
+                }
+            }
+            if (!oldest) {
+                break;
+            }
+
+            Logger::format_record(*oldest->front(), line, sizeof(line));
+            std::fputs(line, output_);
+            oldest->pop();
+        }
+
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                    [](const std::unique_ptr<LogRing>& ring) {
+                                        return ring->retired.load(std::memory_order_acquire) && !ring->front();
+                                    }),
+                     rings_.end());
+        std::fflush(output_);
+    }
+
+private:
+    std::FILE* output_;
+    std::vector<std::unique_ptr<LogRing>> rings_;
+    std::atomic<std::uint64_t> dropped_total_;
+    std::mutex drain_mutex_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool stop_requested_;
+    std::thread thread_;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        while (!stop_requested_) {
+            wake_.wait_for(lock, kFlushInterval, [this] { return stop_requested_; });
+            lock.unlock();
+            drain();
+            lock.lock();
+        }
+    }
+};
+
+LogBackend& backend() {
+    static LogBackend instance;
+    return instance;
+}
+
+// Registers the calling thread's ring on first use and retires it when the thread exits
+struct ThreadRing {
+    LogRing* ring = backend().register_thread();
+    ~ThreadRing() { ring->retired.store(true, std::memory_order_release); }
+};
+
+ThreadRing& thread_ring() {
+    thread_local ThreadRing instance;
+    return instance;
+}
+
+std::uint64_t now_ns() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch())
+                                          .count());
+}
+
+const char* level_prefix(LogLevel level, int& color_code) {
+    switch (level) {
+        case LogLevel::Debug:
+            color_code = 37;  // White
+            return "g923mac::debug";
+        case LogLevel::Info:
+            color_code = 32;  // Green
+            return "g923mac::info";
+        case LogLevel::Warning:
+            color_code = 33;  // Yellow
+            return "g923mac::warning";
+        case LogLevel::Error:
+            color_code = 31;  // Red
+            return "g923mac::error";
+    }
+    color_code = 0;
+    return "g923mac";
+}
+
+// Formats one argument using the flags, width and precision of the original conversion, with
+// the length modifier replaced to match the stored type.
+int format_argument(const LogRecord& record, std::size_t index, const char* spec, std::size_t spec_length,
+                    char conversion, char* out, std::size_t size) {
+    char format[32];
+    spec_length = std::min(spec_length, sizeof(format) - 5);
+    std::memcpy(format, spec, spec_length);
+
+    const LogRecord::Argument& argument = record.arguments[index];
+    switch (record.types[index]) {
+        case LogRecord::ArgumentType::text: {
+            const char* text = argument.text_offset < LogRecord::kTextCapacity ? record.text + argument.text_offset : "";
+            std::memcpy(format + spec_length, "s", 2);
+            return std::snprintf(out, size, format, text);
+        }
+        case LogRecord::ArgumentType::floating:
+            format[spec_length] = std::strchr("eEfFgGaA", conversion) ? conversion : 'g';
+            format[spec_length + 1] = '\0';
+            return std::snprintf(out, size, format, argument.floating_value);
+        case LogRecord::ArgumentType::signed_integer:
+        case LogRecord::ArgumentType::unsigned_integer:
+            break;
+    }
+
+    const bool is_signed = record.types[index] == LogRecord::ArgumentType::signed_integer;
+    const long long signed_value =
+        is_signed ? static_cast<long long>(argument.signed_value) : static_cast<long long>(argument.unsigned_value);
+    const unsigned long long unsigned_value = is_signed ? static_cast<unsigned long long>(argument.signed_value)
+                                                        : static_cast<unsigned long long>(argument.unsigned_value);
+    if (conversion == 'c') {
+        std::memcpy(format + spec_length, "c", 2);
+        return std::snprintf(out, size, format, static_cast<int>(signed_value));
+    }
+
+    const char integer_conversion = std::strchr("diuxXo", conversion) ? conversion : (is_signed ? 'd' : 'u');
+    format[spec_length] = 'l';
+    format[spec_length + 1] = 'l';
+    format[spec_length + 2] = integer_conversion;
+    format[spec_length + 3] = '\0';
+    if (integer_conversion == 'd' || integer_conversion == 'i') {
+        return std::snprintf(out, size, format, signed_value);
+    }
+    return std::snprintf(out, size, format, unsigned_value);
+}
+
+}  // namespace
+
+void LogRecord::add(const char* value) noexcept {
+    types[argument_count] = ArgumentType::text;
+    arguments[argument_count].text_offset = static_cast<std::uint32_t>(kTextCapacity);
+    if (value && text_used < kTextCapacity) {
+        const std::size_t available = kTextCapacity - text_used;
+        const std::size_t length = std::min(std::strlen(value), available - 1);
+        std::memcpy(text + text_used, value, length);
+        text[text_used + length] = '\0';
+        arguments[argument_count].text_offset = text_used;
+        text_used = static_cast<std::uint8_t>(text_used + length + 1);
+    }
+    ++argument_count;
+}
+
+void Logger::prepare_thread() {
+    thread_ring();
+}
+
+void Logger::submit(LogRecord& record) {
+    record.timestamp_ns = now_ns();
+    thread_ring().ring->push(record);
+}
+
+void Logger::set_output(std::FILE* output) {
+    backend().set_output(output);
+}
+
+void Logger::flush() {
+    backend().drain();
+}
+
+std::uint64_t Logger::dropped_records() {
+    return backend().dropped_total();
+}
+
+std::size_t Logger::format_record(const LogRecord& record, char* buffer, std::size_t size) {
+    if (size < 2) {
+        if (size == 1) {
+            buffer[0] = '\0';
+        }
+        return 0;
+    }
+
+    int color_code = 0;
+    const char* prefix = level_prefix(record.level, color_code);
+    int written = std::snprintf(buffer, size, "\033[1;%dm=== %s \033[0m: ", color_code, prefix);
+    std::size_t used = std::min(static_cast<std::size_t>(std::max(written, 0)), size - 1);
+
+    std::size_t next_argument = 0;
+    const char* cursor = record.format ? record.format : "";
+    while (*cursor && used + 1 < size) {
+        if (*cursor != '%') {
+            buffer[used++] = *cursor++;
+            continue;
+        }
+
+        if (cursor[1] == '%') {
+            buffer[used++] = '%';
+            cursor += 2;
+            continue;
+        }
+
+        // Collect flags, width and precision; drop length modifiers
+        const char* spec_start = cursor++;
+        while (*cursor && std::strchr("-+ #0123456789.", *cursor)) {
+            ++cursor;
+        }
+        const std::size_t spec_length = static_cast<std::size_t>(cursor - spec_start);
+        while (*cursor && std::strchr("hlLqjzt", *cursor)) {
+            ++cursor;
+        }
+        const char conversion = *cursor ? *cursor++ : 's';
+
+        if (next_argument >= record.argument_count) {
+            continue;
+        }
+        written = format_argument(record, next_argument++, spec_start, spec_length, conversion, buffer + used,
+                                  size - used);
+        used = std::min(used + static_cast<std::size_t>(std::max(written, 0)), size - 1);
+    }
+
+    if (used + 1 >= size) {
+        used = size - 2;
+    }
+    buffer[used++] = '\n';
+    buffer[used] = '\0';
+    return used;
+}
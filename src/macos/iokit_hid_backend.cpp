@@ -0,0 +1,303 @@
+#include "hid_transport.hpp"
+#include "constants.hpp"
+#include "utilities.hpp"
+#include <CoreFoundation/CoreFoundation.h>
+#include <IOKit/IOReturn.h>
+#include <IOKit/hid/IOHIDDevice.h>
+#include <IOKit/hid/IOHIDKeys.h>
+#include <IOKit/hid/IOHIDManager.h>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <mach/mach_error.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr CFIndex kMaxReportLength = 64;
+constexpr std::size_t kQueuedReports = 8;
+constexpr CFTimeInterval kReadTimeoutSeconds = 0.1;
+
+// Input reports are only delivered while a run loop runs in this mode, which happens inside
+// read_input_report, so callbacks never fire on some other run loop the caller is running
+CFStringRef input_run_loop_mode() {
+    return CFSTR("com.g923mac.input-reports");
+}
+
+bool check_io_result(const char* operation, IOReturn result) {
+    if (result != kIOReturnSuccess) {
+        Logger::error("%s failed with error code 0x%x (%s)", operation, result, mach_error_string(result));
+        return false;
+    }
+    return true;
+}
+
+class IOKitHidTransport final : public HidTransport {
+public:
+    explicit IOKitHidTransport(IOHIDDeviceRef device) : device_(device), is_open_(false) {}
+
+    ~IOKitHidTransport() override {
+        if (is_open_) {
+            close();
+        }
+    }
+
+    bool open() override {
+        if (is_open_) {
+            return true;
+        }
+        is_open_ = check_io_result("IOHIDDeviceOpen", IOHIDDeviceOpen(device_, kIOHIDOptionsTypeNone));
+        if (is_open_) {
+            // HID++ responses arrive on the interrupt IN pipe, which GetReport does not read
+            queued_count_ = 0;
+            IOHIDDeviceRegisterInputReportCallback(device_, input_buffer_, sizeof(input_buffer_),
+                                                   &IOKitHidTransport::on_input_report, this);
+            schedule_on(CFRunLoopGetCurrent());
+        }
+        return is_open_;
+    }
+
+    bool close() override {
+        if (!is_open_) {
+            return true;
+        }
+
+        // Ensure all pending operations are completed
+        CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0.1, false);
+
+        IOHIDDeviceRegisterInputReportCallback(device_, input_buffer_, sizeof(input_buffer_), nullptr, nullptr);
+        schedule_on(nullptr);
+        if (!check_io_result("IOHIDDeviceClose", IOHIDDeviceClose(device_, 0))) {
+            return false;
+        }
+        is_open_ = false;
+        queued_count_ = 0;
+        return true;
+    }
+
+    bool is_open() const override { return is_open_; }
+
+    bool write_output_report(const std::uint8_t* data, std::size_t length, bool numbered) override {
+        // Numbered reports carry their report ID in the first byte
+        const CFIndex report_id = numbered ? data[0] : static_cast<CFIndex>(time(nullptr));
+        const IOReturn result = IOHIDDeviceSetReport(device_, kIOHIDReportTypeOutput, report_id, data,
+                                                     static_cast<CFIndex>(length));
+        return check_io_result("IOHIDDeviceSetReport", result);
+    }
+
+    // Waits up to kReadTimeoutSeconds for an input report with the given ID, discarding others
+    bool read_input_report(std::uint8_t report_id, std::uint8_t* data, std::size_t& length) override {
+        if (!is_open_) {
+            return false;
+        }
+
+        schedule_on(CFRunLoopGetCurrent());
+        const CFAbsoluteTime deadline = CFAbsoluteTimeGetCurrent() + kReadTimeoutSeconds;
+        while (true) {
+            while (queued_count_ > 0) {
+                const QueuedReport& report = queued_[queued_head_];
+                queued_head_ = (queued_head_ + 1) % kQueuedReports;
+                --queued_count_;
+                if (report.length > 0 && report.data[0] == report_id && report.length <= length) {
+                    std::memcpy(data, report.data, report.length);
+                    length = report.length;
+                    return true;
+                }
+            }
+
+            const CFTimeInterval remaining = deadline - CFAbsoluteTimeGetCurrent();
+            if (remaining <= 0) {
+                return false;
+            }
+            CFRunLoopRunInMode(input_run_loop_mode(), remaining, true);
+        }
+    }
+
+private:
+    struct QueuedReport {
+        std::uint8_t data[kMaxReportLength];
+        std::size_t length;
+    };
+
+    // Runs on whichever thread pumps the run loop the device is scheduled on, which is the
+    // thread inside read_input_report
+    static void on_input_report(void* context, IOReturn result, void*, IOHIDReportType, uint32_t,
+                                uint8_t* report, CFIndex report_length) {
+        auto* self = static_cast<IOKitHidTransport*>(context);
+        if (result != kIOReturnSuccess || report_length <= 0) {
+            return;
+        }
+
+        // A full queue drops its oldest report; readers only want the latest responses
+        if (self->queued_count_ == kQueuedReports) {
+            self->queued_head_ = (self->queued_head_ + 1) % kQueuedReports;
+            --self->queued_count_;
+        }
+        QueuedReport& slot = self->queued_[(self->queued_head_ + self->queued_count_) % kQueuedReports];
+        slot.length = static_cast<std::size_t>(std::min(report_length, kMaxReportLength));
+        std::memcpy(slot.data, report, slot.length);
+        ++self->queued_count_;
+    }
+
+    void schedule_on(CFRunLoopRef run_loop) {
+        if (run_loop == scheduled_run_loop_) {
+            return;
+        }
+        if (scheduled_run_loop_) {
+            IOHIDDeviceUnscheduleFromRunLoop(device_, scheduled_run_loop_, input_run_loop_mode());
+        }
+        scheduled_run_loop_ = run_loop;
+        if (scheduled_run_loop_) {
+            IOHIDDeviceScheduleWithRunLoop(device_, scheduled_run_loop_, input_run_loop_mode());
+        }
+    }
+
+    IOHIDDeviceRef device_;
+    bool is_open_;
+    CFRunLoopRef scheduled_run_loop_ = nullptr;
+    std::uint8_t input_buffer_[kMaxReportLength];
+    QueuedReport queued_[kQueuedReports];
+    std::size_t queued_head_ = 0;
+    std::size_t queued_count_ = 0;
+};
+
+class IOKitHidBackend final : public HidBackend {
+public:
+    IOKitHidBackend() : hid_manager_(nullptr) {
+        if (!initialize_hid_manager()) {
+            Logger::error("Failed to initialize HID manager");
+        }
+    }
+
+    ~IOKitHidBackend() override {
+        cleanup_hid_manager();
+    }
+
+    bool is_initialized() const override { return hid_manager_ != nullptr; }
+
+    std::vector<HidDevice> list_all_devices() override {
+        std::vector<HidDevice> devices;
+
+        CFSetRef device_set = IOHIDManagerCopyDevices(hid_manager_);
+        if (!device_set) {
+            return devices;
+        }
+
+        CFIndex count = CFSetGetCount(device_set);
+        CFMutableArrayRef device_array = CFArrayCreateMutable(kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks);
+
+        CFSetApplyFunction(device_set, copy_devices_to_array, device_array);
+
+        for (CFIndex i = 0; i < count; ++i) {
+            IOHIDDeviceRef device = static_cast<IOHIDDeviceRef>(
+                const_cast<void*>(CFArrayGetValueAtIndex(device_array, i))
+            );
+
+            device_id_t vendor_id = get_device_property_number(device, CFSTR(kIOHIDVendorIDKey));
+            device_id_t product_id = get_device_property_number(device, CFSTR(kIOHIDProductIDKey));
+            device_id_t device_id = (product_id << 16) | vendor_id;
+
+            devices.emplace_back(vendor_id, product_id, device_id, static_cast<void*>(device));
+        }
+
+        CFRelease(device_array);
+        CFRelease(device_set);
+        return devices;
+    }
+
+    std::unique_ptr<HidTransport> create_transport(const HidDevice& device) override {
+        if (!device.native_handle) {
+            return nullptr;
+        }
+        return std::make_unique<IOKitHidTransport>(static_cast<IOHIDDeviceRef>(device.native_handle));
+    }
+
+private:
+    IOHIDManagerRef hid_manager_;
+
+    bool initialize_hid_manager() {
+        hid_manager_ = IOHIDManagerCreate(kCFAllocatorDefault, kIOHIDManagerOptionNone);
+        if (!hid_manager_) {
+            Logger::error("IOHIDManagerCreate failed");
+            return false;
+        }
+
+        CFMutableDictionaryRef matching_dict = CFDictionaryCreateMutable(
+            kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+
+        if (matching_dict) {
+            int vendor_id = static_cast<int>(G923_VENDOR_ID);
+            CFNumberRef vendor_id_ref = CFNumberCreate(kCFAllocatorDefault, kCFNumberIntType, &vendor_id);
+            CFDictionarySetValue(matching_dict, CFSTR(kIOHIDVendorIDKey), vendor_id_ref);
+            CFRelease(vendor_id_ref);
+
+            int product_id = static_cast<int>(G923_PRODUCT_ID);
+            CFNumberRef product_id_ref = CFNumberCreate(kCFAllocatorDefault, kCFNumberIntType, &product_id);
+            CFDictionarySetValue(matching_dict, CFSTR(kIOHIDProductIDKey), product_id_ref);
+            CFRelease(product_id_ref);
+
+            IOHIDManagerSetDeviceMatching(hid_manager_, matching_dict);
+            CFRelease(matching_dict);
+        } else {
+            IOHIDManagerSetDeviceMatching(hid_manager_, nullptr);
+        }
+
+        IOReturn result = IOHIDManagerOpen(hid_manager_, kIOHIDOptionsTypeNone);
+
+        if (!check_io_result("IOHIDManagerOpen", result)) {
+            cleanup_hid_manager();
+            return false;
+        }
+
+        return true;
+    }
+
+    void cleanup_hid_manager() {
+        if (hid_manager_) {
+            Logger::debug("Cleaning up HID manager");
+
+            // Schedule with run loop to ensure proper cleanup
+            IOHIDManagerScheduleWithRunLoop(hid_manager_, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
+
+            // Close the manager
+            IOReturn result = IOHIDManagerClose(hid_manager_, kIOHIDManagerOptionNone);
+            if (result != kIOReturnSuccess) {
+                Logger::warning("Failed to close HID manager: %d", result);
+            }
+
+            // Unschedule from run loop
+            IOHIDManagerUnscheduleFromRunLoop(hid_manager_, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
+
+            // Release the manager
+            CFRelease(hid_manager_);
+            hid_manager_ = nullptr;
+
+            // Give system time to fully release resources
+            usleep(100 * 1000);  // 100ms
+
+            Logger::debug("HID manager cleanup complete");
+        }
+    }
+
+    static device_id_t get_device_property_number(IOHIDDeviceRef device, CFStringRef property) {
+        CFTypeRef data = IOHIDDeviceGetProperty(device, property);
+
+        if (data && CFGetTypeID(data) == CFNumberGetTypeID()) {
+            device_id_t number;
+            CFNumberGetValue(static_cast<CFNumberRef>(data), kCFNumberSInt32Type, &number);
+            return number;
+        }
+
+        return 0;
+    }
+
+    static void copy_devices_to_array(const void* value, void* context) {
+        CFArrayAppendValue(static_cast<CFMutableArrayRef>(context), value);
+    }
+};
+
+}  // namespace
+
+std::unique_ptr<HidBackend> create_platform_hid_backend() {
+    return std::make_unique<IOKitHidBackend>();
+}
@@ -0,0 +1,79 @@
+#include "output_governor.hpp"
+#include "constants.hpp"
+#include <algorithm>
+
+namespace {
+
+constexpr double kServiceTimeSmoothing = 0.1;
+constexpr double kCapacityHeadroom = 0.8;
+constexpr double kMinCapacityHz = 50.0;
+constexpr double kMaxCapacityHz = 2000.0;
+constexpr double kBucketBurst = 8.0;
+
+// FORCE_UPDATE_RATE and LED_UPDATE_RATE are frame intervals, so their inverses weigh the classes
+constexpr double kForceWeight = 1.0 / FORCE_UPDATE_RATE;
+constexpr double kLedWeight = 1.0 / LED_UPDATE_RATE;
+constexpr double kForceShare = kForceWeight / (kForceWeight + kLedWeight);
+
+}  // namespace
+
+OutputGovernor::OutputGovernor(double initial_capacity_hz) {
+    const double capacity = std::max(kMinCapacityHz, std::min(kMaxCapacityHz, initial_capacity_hz));
+    snapshot_.service_time_us = 1000000.0 / capacity;
+    update_caps();
+
+    const clock::time_point now = clock::now();
+    for (auto& bucket : buckets_) {
+        bucket.tokens = kBucketBurst;
+        bucket.last_refill = now;
+    }
+}
+
+void OutputGovernor::record_write(clock::duration service_time) {
+    const double sample_us = std::chrono::duration<double, std::micro>(service_time).count();
+    if (snapshot_.samples == 0) {
+        snapshot_.service_time_us = sample_us;
+    } else {
+        snapshot_.service_time_us += kServiceTimeSmoothing * (sample_us - snapshot_.service_time_us);
+    }
+    ++snapshot_.samples;
+    update_caps();
+}
+
+OutputGovernor::clock::duration OutputGovernor::time_until_available(CommandClass command_class,
+                                                                       clock::time_point now) {
+    refill(command_class, now);
+
+    const Bucket& bucket = buckets_[static_cast<std::size_t>(command_class)];
+    if (bucket.tokens >= 1.0) {
+        return clock::duration::zero();
+    }
+
+    const double wait_seconds = (1.0 - bucket.tokens) / class_cap_hz(command_class);
+    return std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(wait_seconds));
+}
+
+void OutputGovernor::consume(CommandClass command_class, std::size_t reports, clock::time_point now) {
+    refill(command_class, now);
+    buckets_[static_cast<std::size_t>(command_class)].tokens -= static_cast<double>(reports);
+}
+
+void OutputGovernor::update_caps() {
+    const double measured = snapshot_.service_time_us > 0.0 ? 1000000.0 / snapshot_.service_time_us : kMaxCapacityHz;
+    snapshot_.device_capacity_hz = std::max(kMinCapacityHz, std::min(kMaxCapacityHz, measured));
+
+    const double budget = snapshot_.device_capacity_hz * kCapacityHeadroom;
+    snapshot_.class_caps_hz[static_cast<std::size_t>(CommandClass::force)] = budget * kForceShare;
+    snapshot_.class_caps_hz[static_cast<std::size_t>(CommandClass::led)] = budget * (1.0 - kForceShare);
+}
+
+void OutputGovernor::refill(CommandClass command_class, clock::time_point now) {
+    Bucket& bucket = buckets_[static_cast<std::size_t>(command_class)];
+    if (now <= bucket.last_refill) {
+        return;
+    }
+
+    const double elapsed = std::chrono::duration<double>(now - bucket.last_refill).count();
+    bucket.tokens = std::min(kBucketBurst, bucket.tokens + elapsed * class_cap_hz(command_class));
+    bucket.last_refill = now;
+}
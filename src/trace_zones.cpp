@@ -0,0 +1,188 @@
+#include "trace_zones.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace trace_zones {
+
+namespace {
+
+constexpr std::size_t kRingCapacity = 16384;
+constexpr std::size_t kThreadNameCapacity = 32;
+
+struct Zone {
+    const char* name = nullptr;
+    std::uint64_t start_ns = 0;
+    std::uint64_t duration_ns = 0;
+};
+
+// Written only by its owning thread, which overwrites the oldest zones once the ring is full.
+// The dump copies slots while the owner keeps recording and drops any it may have overwritten.
+struct ThreadRing {
+    std::uint32_t thread_id = 0;
+    char thread_name[kThreadNameCapacity] = {0};
+    std::atomic<std::uint64_t> written{0};
+    std::atomic<bool> retired{false};
+    Zone zones[kRingCapacity];
+};
+
+// Rings outlive their threads so a dump still shows them; a new thread reuses a retired ring
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    std::uint32_t next_thread_id = 1;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+ThreadRing* acquire_ring() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+
+    ThreadRing* ring = nullptr;
+    for (auto& candidate : shared.rings) {
+        if (candidate->retired.load(std::memory_order_acquire)) {
+            ring = candidate.get();
+            break;
+        }
+    }
+    if (!ring) {
+        shared.rings.push_back(std::make_unique<ThreadRing>());
+        ring = shared.rings.back().get();
+    }
+
+    ring->thread_id = shared.next_thread_id++;
+    std::snprintf(ring->thread_name, sizeof(ring->thread_name), "thread %u", static_cast<unsigned>(ring->thread_id));
+    ring->written.store(0, std::memory_order_relaxed);
+    ring->retired.store(false, std::memory_order_release);
+    return ring;
+}
+
+struct ThreadRingOwner {
+    ThreadRing* ring = acquire_ring();
+    ~ThreadRingOwner() { ring->retired.store(true, std::memory_order_release); }
+};
+
+ThreadRing& thread_ring() {
+    thread_local ThreadRingOwner owner;
+    return *owner.ring;
+}
+
+struct DumpedZone {
+    Zone zone;
+    std::uint32_t thread_id;
+};
+
+void write_escaped(std::FILE* output, const char* text) {
+    for (const char* cursor = text ? text : ""; *cursor; ++cursor) {
+        const char c = *cursor;
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', output);
+            std::fputc(c, output);
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            std::fputc(c, output);
+        }
+    }
+}
+
+}  // namespace
+
+std::uint64_t now_ns() noexcept {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+std::uint64_t begin() noexcept {
+    thread_ring();
+    return now_ns();
+}
+
+void record(const char* name, std::uint64_t start_ns, std::uint64_t end_ns) noexcept {
+    ThreadRing& ring = thread_ring();
+    const std::uint64_t index = ring.written.load(std::memory_order_relaxed);
+    Zone& zone = ring.zones[index % kRingCapacity];
+    zone.name = name;
+    zone.start_ns = start_ns;
+    zone.duration_ns = end_ns > start_ns ? end_ns - start_ns : 0;
+    ring.written.store(index + 1, std::memory_order_release);
+}
+
+void prepare_thread(const char* thread_name) {
+    ThreadRing& ring = thread_ring();
+    std::snprintf(ring.thread_name, sizeof(ring.thread_name), "%s", thread_name ? thread_name : "");
+}
+
+bool write_chrome_trace(std::FILE* output) {
+    if (!output) {
+        return false;
+    }
+
+    std::vector<DumpedZone> zones;
+    std::vector<std::pair<std::uint32_t, std::string>> threads;
+    {
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        for (const auto& ring : shared.rings) {
+            const std::uint64_t written = ring->written.load(std::memory_order_acquire);
+            const std::uint64_t first = written > kRingCapacity ? written - kRingCapacity : 0;
+            const std::size_t copied_from = zones.size();
+            for (std::uint64_t i = first; i < written; ++i) {
+                zones.push_back(DumpedZone{ring->zones[i % kRingCapacity], ring->thread_id});
+            }
+
+            // Slots the owner reached again while we copied hold newer zones than we meant to read
+            const std::uint64_t written_after = ring->written.load(std::memory_order_acquire);
+            const std::uint64_t overwritten =
+                written_after > kRingCapacity + first ? written_after - kRingCapacity - first : 0;
+            if (overwritten > 0) {
+                const std::size_t drop = static_cast<std::size_t>(
+                    std::min<std::uint64_t>(overwritten, zones.size() - copied_from));
+                zones.erase(zones.begin() + static_cast<std::ptrdiff_t>(copied_from),
+                            zones.begin() + static_cast<std::ptrdiff_t>(copied_from + drop));
+            }
+            if (written > 0) {
+                threads.emplace_back(ring->thread_id, ring->thread_name);
+            }
+        }
+    }
+
+    std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", output);
+    bool first_event = true;
+    for (const auto& thread : threads) {
+        std::fprintf(output, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"",
+                     first_event ? "" : ",", static_cast<unsigned>(thread.first));
+        write_escaped(output, thread.second.c_str());
+        std::fputs("\"}}", output);
+        first_event = false;
+    }
+    for (const DumpedZone& dumped : zones) {
+        std::fprintf(output, "%s\n{\"name\":\"", first_event ? "" : ",");
+        write_escaped(output, dumped.zone.name);
+        std::fprintf(output, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                     static_cast<unsigned>(dumped.thread_id), static_cast<double>(dumped.zone.start_ns) / 1000.0,
+                     static_cast<double>(dumped.zone.duration_ns) / 1000.0);
+        first_event = false;
+    }
+    std::fputs("\n]}\n", output);
+    return std::ferror(output) == 0;
+}
+
+bool write_chrome_trace(const char* path) {
+    std::FILE* output = std::fopen(path, "w");
+    if (!output) {
+        return false;
+    }
+    const bool written = write_chrome_trace(output);
+    return std::fclose(output) == 0 && written;
+}
+
+}  // namespace trace_zones
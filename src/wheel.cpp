@@ -1,11 +1,56 @@
 #include "wheel.hpp"
 #include "command.hpp"
 #include "constants.hpp"
+#include "trace_zones.hpp"
 #include "utilities.hpp"
+#include <algorithm>
 #include <unistd.h>
 
-WheelController::WheelController(const HidDevice& device)
-    : device_(device), device_interface_(std::make_unique<HidDeviceInterface>(device)),
+namespace {
+
+constexpr int kHidppLevelMax = 32767;
+constexpr int kClassicLevelCenter = 128;
+constexpr int kClassicLevelRange = 127;
+constexpr int kNibbleMax = 15;
+constexpr int kByteMax = 255;
+
+std::int16_t scale_to_hidpp_level(int value, int source_max) {
+    const int scaled = (value * kHidppLevelMax) / source_max;
+    return static_cast<std::int16_t>(std::max(-kHidppLevelMax, std::min(kHidppLevelMax, scaled)));
+}
+
+std::uint16_t scale_to_hidpp_saturation(int value, int source_max) {
+    const int clamped = std::max(0, std::min(source_max, value));
+    return static_cast<std::uint16_t>((clamped * hidpp::CONDITION_SATURATION_MAX) / source_max);
+}
+
+class HidppInterfaceTransport final : public HidppTransport {
+public:
+    explicit HidppInterfaceTransport(HidDeviceInterface& device_interface)
+        : device_interface_(device_interface) {}
+
+    bool write_report(const HidppReport& report) override {
+        return device_interface_.send_report(report.raw(), report.size());
+    }
+
+    bool read_report(std::uint8_t report_id, HidppReport& report) override {
+        std::size_t length = sizeof(report.data);
+        if (!device_interface_.get_input_report(report_id, report.data, length)) {
+            return false;
+        }
+        report.length = length;
+        return true;
+    }
+
+private:
+    HidDeviceInterface& device_interface_;
+};
+
+}  // namespace
+
+WheelController::WheelController(const HidDevice& device, std::unique_ptr<HidTransport> transport, WheelBackend backend)
+    : device_(device), device_interface_(std::make_unique<HidDeviceInterface>(device, std::move(transport))),
+        backend_(backend),
         is_initialized_(false), is_calibrated_(false) {
     
     if (!validate_device()) {
@@ -13,12 +58,12 @@ WheelController::WheelController(const HidDevice& device)
         return;
     }
     
-    Logger::info("Created WheelController for device " + utils::format_device_id(device_.device_id));
+    Logger::info("Created WheelController for device 0x%X", device_.device_id);
 }
 
 WheelController::~WheelController() {
     if (is_initialized_) {
-        Logger::info("Cleaning up WheelController for device " + utils::format_device_id(device_.device_id));
+        Logger::info("Cleaning up WheelController for device 0x%X", device_.device_id);
         
         // Reset wheel state before closing
         if (device_interface_ && device_interface_->is_open()) {
@@ -33,7 +78,7 @@ WheelController::~WheelController() {
             device_interface_->close();
         }
         
-        Logger::info("WheelController destroyed for device " + utils::format_device_id(device_.device_id));
+        Logger::info("WheelController destroyed for device 0x%X", device_.device_id);
     }
 }
 
@@ -46,7 +91,7 @@ bool WheelController::initialize() {
         return false;
     }
     
-    Logger::info("Initializing wheel controller for device " + utils::format_device_id(device_.device_id));
+    Logger::info("Initializing wheel controller for device 0x%X", device_.device_id);
     
     // Open the device and keep it open for the lifetime of the controller
     if (!device_interface_->open()) {
@@ -54,6 +99,11 @@ bool WheelController::initialize() {
         return false;
     }
     
+    if (backend_ == WheelBackend::hidpp && !initialize_hidpp()) {
+        Logger::warning("HID++ force feedback unavailable, falling back to classic commands");
+        backend_ = WheelBackend::classic;
+    }
+    
     if (!set_led_pattern(LED_PATTERN_OFF)) {
         Logger::warning("Failed to reset LED pattern during initialization");
     }
@@ -64,6 +114,7 @@ bool WheelController::initialize() {
 }
 
 bool WheelController::calibrate() {
+    TraceZone zone("WheelController::calibrate");
     if (!is_initialized_) {
         Logger::error("Cannot calibrate: wheel not initialized");
         return false;
@@ -122,32 +173,83 @@ bool WheelController::perform_calibration_sequence() {
 }
 
 bool WheelController::enable_autocenter() {
+    if (hidpp_) {
+        return check_hidpp_result(hidpp_->set_autocenter_enabled(true));
+    }
+    
     Command command = CommandBuilder::create_enable_autocenter();
     return send_command(command);
 }
 
 bool WheelController::disable_autocenter() {
+    if (hidpp_) {
+        return check_hidpp_result(hidpp_->set_autocenter_enabled(false));
+    }
+    
     Command command = CommandBuilder::create_disable_autocenter();
     return send_command(command);
 }
 
 bool WheelController::set_autocenter_spring(std::uint8_t k1, std::uint8_t k2, std::uint8_t clip) {
+    if (hidpp_) {
+        HidppCondition condition;
+        condition.right_coefficient = scale_to_hidpp_level(k1, kNibbleMax);
+        condition.left_coefficient = scale_to_hidpp_level(k2, kNibbleMax);
+        condition.right_saturation = scale_to_hidpp_saturation(clip, kByteMax);
+        condition.left_saturation = condition.right_saturation;
+        return check_hidpp_result(hidpp_->set_autocenter(condition));
+    }
+    
     Command command = CommandBuilder::create_autocenter_spring(k1, k2, clip);
     return send_command(command);
 }
 
 bool WheelController::set_custom_spring(std::uint8_t d1, std::uint8_t d2, std::uint8_t k1, std::uint8_t k2,
                                         std::uint8_t s1, std::uint8_t s2, std::uint8_t clip) {
+    if (hidpp_) {
+        const std::uint16_t clip_saturation = scale_to_hidpp_saturation(clip, kByteMax);
+        HidppCondition condition;
+        condition.right_coefficient = scale_to_hidpp_level(k1, kNibbleMax);
+        condition.left_coefficient = scale_to_hidpp_level(k2, kNibbleMax);
+        condition.right_saturation = std::min(scale_to_hidpp_saturation(s1, kNibbleMax), clip_saturation);
+        condition.left_saturation = std::min(scale_to_hidpp_saturation(s2, kNibbleMax), clip_saturation);
+        condition.deadband = scale_to_hidpp_saturation((d1 + d2) / 2, kNibbleMax);
+        return check_hidpp_result(hidpp_->set_spring(condition));
+    }
+    
     Command command = CommandBuilder::create_custom_spring(d1, d2, k1, k2, s1, s2, clip);
     return send_command(command);
 }
 
 bool WheelController::set_constant_force(std::uint8_t force_level) {
+    if (hidpp_) {
+        return set_constant_force_level(
+            scale_to_hidpp_level(static_cast<int>(force_level) - kClassicLevelCenter, kClassicLevelRange));
+    }
+    
     Command command = CommandBuilder::create_constant_force(force_level);
     return send_command(command);
 }
 
+bool WheelController::set_constant_force_level(std::int16_t level) {
+    if (hidpp_) {
+        return check_hidpp_result(hidpp_->set_constant_force(level));
+    }
+    
+    const int classic_level = kClassicLevelCenter + (static_cast<int>(level) * kClassicLevelRange) / kHidppLevelMax;
+    return set_constant_force(static_cast<std::uint8_t>(std::max(0, std::min(kByteMax, classic_level))));
+}
+
 bool WheelController::set_damper(std::uint8_t k1, std::uint8_t k2, std::uint8_t s1, std::uint8_t s2) {
+    if (hidpp_) {
+        HidppCondition condition;
+        condition.right_coefficient = scale_to_hidpp_level(k1, kByteMax);
+        condition.left_coefficient = scale_to_hidpp_level(k2, kByteMax);
+        condition.right_saturation = scale_to_hidpp_saturation(s1, kByteMax);
+        condition.left_saturation = scale_to_hidpp_saturation(s2, kByteMax);
+        return check_hidpp_result(hidpp_->set_damper(condition));
+    }
+    
     Command command = CommandBuilder::create_damper(k1, k2, s1, s2);
     return send_command(command);
 }
@@ -159,6 +261,10 @@ bool WheelController::set_trapezoid(std::uint8_t l1, std::uint8_t l2, std::uint8
 }
 
 bool WheelController::stop_forces() {
+    if (hidpp_) {
+        return check_hidpp_result(hidpp_->stop_forces());
+    }
+    
     Command command = CommandBuilder::create_stop_forces();
     return send_command(command);
 }
@@ -169,6 +275,7 @@ bool WheelController::set_led_pattern(std::uint8_t pattern) {
 }
 
 bool WheelController::send_command(const Command& command) {
+    TraceZone zone("WheelController::send_command");
     if (!device_interface_->is_open()) {
         Logger::error("Device not open for command");
         return false;
@@ -185,6 +292,29 @@ bool WheelController::send_command(const Command& command) {
     return success;
 }
 
+bool WheelController::initialize_hidpp() {
+    hidpp_transport_ = std::make_unique<HidppInterfaceTransport>(*device_interface_);
+    hidpp_ = std::make_unique<HidppForceFeedback>(*hidpp_transport_);
+    
+    if (!hidpp_->initialize()) {
+        hidpp_.reset();
+        hidpp_transport_.reset();
+        return false;
+    }
+    
+    Logger::info("Using HID++ force feedback with %zu effect slots at feature index %u", hidpp_->slot_capacity(),
+                 hidpp_->feature_index());
+    return true;
+}
+
+bool WheelController::check_hidpp_result(bool success) {
+    if (!success) {
+        Logger::error("Failed to send HID++ force feedback request");
+    }
+    
+    return success;
+}
+
 bool WheelController::validate_device() const {
     if (!device_.is_valid()) {
         Logger::error("Invalid HID device");
@@ -192,7 +322,7 @@ bool WheelController::validate_device() const {
     }
     
     if (!device_.is_g923()) {
-        Logger::error("Device is not a G923 wheel: " + utils::format_device_id(device_.device_id));
+        Logger::error("Device is not a G923 wheel: 0x%X", device_.device_id);
         return false;
     }
     
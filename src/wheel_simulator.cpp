@@ -0,0 +1,376 @@
+#include "wheel_simulator.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kRadToDeg = 180.0 / kPi;
+constexpr double kNibbleMax = 15.0;
+constexpr double kByteMax = 255.0;
+constexpr double kLevelCenter = 128.0;
+constexpr double kLevelRange = 127.0;
+constexpr double kStickVelocityRadS = 1e-3;
+constexpr double kEndStopDamping = 0.5;
+constexpr std::chrono::milliseconds kRealtimeTick(1);
+
+double decode_level(std::uint8_t level) {
+    return std::max(-1.0, std::min(1.0, (static_cast<double>(level) - kLevelCenter) / kLevelRange));
+}
+
+std::uint8_t low_nibble(std::uint8_t value) {
+    return static_cast<std::uint8_t>(value & 0x0F);
+}
+
+std::uint8_t high_nibble(std::uint8_t value) {
+    return static_cast<std::uint8_t>(value >> 4);
+}
+
+double sign(double value) {
+    return value > 0.0 ? 1.0 : (value < 0.0 ? -1.0 : 0.0);
+}
+
+// Torque fraction of a one-dimensional condition: zero inside the deadband, proportional to the
+// offset outside it on each side, clipped to that side's saturation and opposing the offset.
+double condition_fraction(double offset, double deadband_left, double deadband_right, double coefficient_positive,
+                          double coefficient_negative, double saturation_positive, double saturation_negative) {
+    if (offset > deadband_right) {
+        return -std::min(coefficient_positive * (offset - deadband_right), saturation_positive);
+    }
+    if (offset < -deadband_left) {
+        return std::min(coefficient_negative * (-deadband_left - offset), saturation_negative);
+    }
+    return 0.0;
+}
+
+}  // namespace
+
+WheelSimulator::WheelSimulator() : WheelSimulator(Config{}) {
+}
+
+WheelSimulator::WheelSimulator(const Config& config)
+    : config_(config), time_us_(0), angle_rad_(0.0), velocity_rad_s_(0.0), motor_torque_nm_(0.0),
+        commanded_torque_nm_(0.0), hand_torque_nm_(0.0), led_pattern_(0), autocenter_enabled_(false),
+        constant_level_(0.0), stats_{}, steps_since_sample_(0), trace_(config.trace_capacity),
+        commands_(config.command_capacity), realtime_running_(false) {
+    config_.step = std::max(config_.step, std::chrono::microseconds(10));
+    config_.trace_decimation = std::max<std::size_t>(config_.trace_decimation, 1);
+}
+
+WheelSimulator::~WheelSimulator() {
+    stop_realtime();
+}
+
+void WheelSimulator::apply(const Command& command) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    apply_locked(command);
+}
+
+void WheelSimulator::advance(std::chrono::microseconds duration) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::uint64_t end_us = time_us_ + static_cast<std::uint64_t>(std::max<std::int64_t>(duration.count(), 0));
+    const double dt = static_cast<double>(config_.step.count()) * 1e-6;
+    while (time_us_ < end_us) {
+        step_locked(dt);
+    }
+}
+
+void WheelSimulator::start_realtime(double time_scale) {
+    if (realtime_running_.exchange(true)) {
+        return;
+    }
+    realtime_thread_ = std::thread(&WheelSimulator::realtime_loop, this, std::max(time_scale, 0.01));
+}
+
+void WheelSimulator::stop_realtime() {
+    realtime_running_.store(false);
+    if (realtime_thread_.joinable()) {
+        realtime_thread_.join();
+    }
+}
+
+void WheelSimulator::set_hand_torque(double torque_nm) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hand_torque_nm_ = torque_nm;
+}
+
+void WheelSimulator::set_angle(double angle_deg) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    angle_rad_ = angle_deg / kRadToDeg;
+    velocity_rad_s_ = 0.0;
+}
+
+std::uint64_t WheelSimulator::time_us() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return time_us_;
+}
+
+double WheelSimulator::angle_deg() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return angle_rad_ * kRadToDeg;
+}
+
+double WheelSimulator::motor_torque_nm() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return motor_torque_nm_;
+}
+
+std::uint8_t WheelSimulator::led_pattern() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return led_pattern_;
+}
+
+WheelSimulator::Stats WheelSimulator::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.dropped_samples = trace_.dropped();
+    stats.dropped_commands = commands_.dropped();
+    return stats;
+}
+
+std::vector<WheelSimulator::TraceSample> WheelSimulator::trace() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return trace_.to_vector();
+}
+
+std::vector<WheelSimulator::CommandEvent> WheelSimulator::command_log() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return commands_.to_vector();
+}
+
+void WheelSimulator::clear_trace() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    trace_.clear();
+    commands_.clear();
+}
+
+bool WheelSimulator::write_trace_csv(std::FILE* output) const {
+    if (!output) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::fprintf(output, "time_us,angle_deg,velocity_dps,commanded_torque_nm,motor_torque_nm,led_pattern\n");
+    for (std::size_t i = 0; i < trace_.size(); ++i) {
+        const TraceSample& sample = trace_[i];
+        std::fprintf(output, "%llu,%.3f,%.3f,%.4f,%.4f,%u\n", static_cast<unsigned long long>(sample.time_us),
+                     sample.angle_deg, sample.velocity_dps, sample.commanded_torque_nm, sample.motor_torque_nm,
+                     static_cast<unsigned>(sample.led_pattern));
+    }
+    return std::ferror(output) == 0;
+}
+
+void WheelSimulator::apply_locked(const Command& command) {
+    ++stats_.commands;
+    commands_.push(CommandEvent{time_us_, command});
+
+    switch (command[0]) {
+        case g923_commands::ENABLE_AUTOCENTER:
+            autocenter_enabled_ = true;
+            return;
+        case g923_commands::DISABLE_AUTOCENTER:
+            autocenter_enabled_ = false;
+            return;
+        case g923_commands::SET_AUTOCENTER_SPRING:
+            autocenter_.active = true;
+            autocenter_.deadband_left = 0.0;
+            autocenter_.deadband_right = 0.0;
+            autocenter_.coefficient_positive = command[2] / kNibbleMax;
+            autocenter_.coefficient_negative = command[3] / kNibbleMax;
+            autocenter_.saturation_positive = command[4] / kByteMax;
+            autocenter_.saturation_negative = autocenter_.saturation_positive;
+            return;
+        case g923_commands::STOP_FORCES:
+            constant_level_ = 0.0;
+            spring_.active = false;
+            damper_.active = false;
+            trapezoid_.active = false;
+            return;
+        case g923_commands::SET_LED_PATTERN:
+            if (command[1] == g923_commands::LED_COMMAND_TYPE) {
+                led_pattern_ = command[2];
+                return;
+            }
+            break;
+        case g923_commands::SET_FORCE_EFFECT:
+            switch (command[1]) {
+                case g923_commands::EFFECT_CONSTANT:
+                    constant_level_ = decode_level(command[2]);
+                    return;
+                case g923_commands::EFFECT_SPRING: {
+                    const double clip = command[6] / kByteMax;
+                    spring_.active = command[4] != 0;
+                    spring_.deadband_left = command[2] / kByteMax;
+                    spring_.deadband_right = command[3] / kByteMax;
+                    spring_.coefficient_positive = low_nibble(command[4]) / kNibbleMax;
+                    spring_.coefficient_negative = high_nibble(command[4]) / kNibbleMax;
+                    spring_.saturation_positive = std::min(low_nibble(command[5]) / kNibbleMax, clip);
+                    spring_.saturation_negative = std::min(high_nibble(command[5]) / kNibbleMax, clip);
+                    return;
+                }
+                case g923_commands::EFFECT_DAMPER:
+                    damper_.active = command[2] != 0 || command[4] != 0;
+                    damper_.coefficient_positive = command[2] / kByteMax;
+                    damper_.saturation_positive = command[3] / kByteMax;
+                    damper_.coefficient_negative = command[4] / kByteMax;
+                    damper_.saturation_negative = command[5] / kByteMax;
+                    return;
+                case g923_commands::EFFECT_TRAPEZOID:
+                    trapezoid_ = TrapezoidEffect{};
+                    trapezoid_.active = true;
+                    trapezoid_.level1 = decode_level(command[2]);
+                    trapezoid_.level2 = decode_level(command[3]);
+                    trapezoid_.hold1_us = command[4] * 1000u;
+                    trapezoid_.hold2_us = command[5] * 1000u;
+                    trapezoid_.step_interval_us = high_nibble(command[6]) * 1000u;
+                    trapezoid_.step = low_nibble(command[6]) / kLevelRange;
+                    trapezoid_.level = trapezoid_.level1;
+                    trapezoid_.phase_start_us = time_us_;
+                    return;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
+
+    ++stats_.unknown_commands;
+}
+
+double WheelSimulator::trapezoid_level_locked() {
+    TrapezoidEffect& effect = trapezoid_;
+    if (!effect.active) {
+        return 0.0;
+    }
+
+    if (!effect.ramping) {
+        const std::uint32_t hold_us = effect.toward_level2 ? effect.hold1_us : effect.hold2_us;
+        if (time_us_ - effect.phase_start_us >= hold_us) {
+            effect.ramping = true;
+            effect.last_step_us = time_us_;
+        }
+    }
+
+    if (effect.ramping) {
+        const double target = effect.toward_level2 ? effect.level2 : effect.level1;
+        if (effect.step <= 0.0 || effect.step_interval_us == 0) {
+            effect.level = target;
+        } else {
+            while (time_us_ - effect.last_step_us >= effect.step_interval_us && effect.level != target) {
+                effect.level = target > effect.level ? std::min(target, effect.level + effect.step)
+                                                     : std::max(target, effect.level - effect.step);
+                effect.last_step_us += effect.step_interval_us;
+            }
+        }
+
+        if (effect.level == target) {
+            effect.ramping = false;
+            effect.toward_level2 = !effect.toward_level2;
+            effect.phase_start_us = time_us_;
+        }
+    }
+
+    return effect.level;
+}
+
+double WheelSimulator::effect_torque_fraction_locked() {
+    const double position = angle_rad_ * kRadToDeg / config_.spring_full_scale_deg;
+    const double half_range = 0.5 * config_.rotation_range_deg / config_.spring_full_scale_deg;
+    const double velocity = velocity_rad_s_ * kRadToDeg / config_.damper_full_scale_dps;
+
+    double fraction = constant_level_ + trapezoid_level_locked();
+
+    if (autocenter_enabled_ && autocenter_.active) {
+        fraction += condition_fraction(position, 0.0, 0.0, autocenter_.coefficient_positive,
+                                       autocenter_.coefficient_negative, autocenter_.saturation_positive,
+                                       autocenter_.saturation_negative);
+    }
+
+    if (spring_.active) {
+        fraction += condition_fraction(position, spring_.deadband_left * half_range,
+                                       spring_.deadband_right * half_range, spring_.coefficient_positive,
+                                       spring_.coefficient_negative, spring_.saturation_positive,
+                                       spring_.saturation_negative);
+    }
+
+    if (damper_.active) {
+        fraction += condition_fraction(velocity, 0.0, 0.0, damper_.coefficient_positive,
+                                       damper_.coefficient_negative,
+                                       damper_.saturation_positive > 0.0 ? damper_.saturation_positive : 1.0,
+                                       damper_.saturation_negative > 0.0 ? damper_.saturation_negative : 1.0);
+    }
+
+    return fraction;
+}
+
+void WheelSimulator::step_locked(double dt) {
+    const double fraction = effect_torque_fraction_locked();
+    if (std::fabs(fraction) > 1.0) {
+        ++stats_.saturated_steps;
+    }
+    commanded_torque_nm_ = std::max(-1.0, std::min(1.0, fraction)) * config_.max_motor_torque_nm;
+
+    // The motor follows the command through a first-order lag
+    motor_torque_nm_ += (commanded_torque_nm_ - motor_torque_nm_) * (dt / (config_.motor_time_constant_s + dt));
+
+    double torque = motor_torque_nm_ + hand_torque_nm_ - config_.viscous_friction_nm_s * velocity_rad_s_;
+
+    const double limit_rad = 0.5 * config_.rotation_range_deg / kRadToDeg;
+    if (std::fabs(angle_rad_) > limit_rad) {
+        const double overshoot = angle_rad_ - sign(angle_rad_) * limit_rad;
+        torque -= config_.end_stop_stiffness_nm_per_rad * overshoot + kEndStopDamping * velocity_rad_s_;
+    }
+
+    // Coulomb friction holds the rim until the applied torque breaks it free
+    if (std::fabs(velocity_rad_s_) < kStickVelocityRadS && std::fabs(torque) <= config_.coulomb_friction_nm) {
+        velocity_rad_s_ = 0.0;
+    } else {
+        const double direction = std::fabs(velocity_rad_s_) >= kStickVelocityRadS ? sign(velocity_rad_s_) : sign(torque);
+        const double previous_velocity = velocity_rad_s_;
+        velocity_rad_s_ += (torque - direction * config_.coulomb_friction_nm) / config_.inertia_kg_m2 * dt;
+        if (previous_velocity != 0.0 && sign(previous_velocity) != sign(velocity_rad_s_)) {
+            velocity_rad_s_ = 0.0;
+        }
+    }
+
+    angle_rad_ += velocity_rad_s_ * dt;
+    time_us_ += static_cast<std::uint64_t>(config_.step.count());
+    ++stats_.steps;
+
+    if (++steps_since_sample_ >= config_.trace_decimation) {
+        steps_since_sample_ = 0;
+        record_sample_locked();
+    }
+}
+
+void WheelSimulator::record_sample_locked() {
+    TraceSample sample;
+    sample.time_us = time_us_;
+    sample.angle_deg = static_cast<float>(angle_rad_ * kRadToDeg);
+    sample.velocity_dps = static_cast<float>(velocity_rad_s_ * kRadToDeg);
+    sample.commanded_torque_nm = static_cast<float>(commanded_torque_nm_);
+    sample.motor_torque_nm = static_cast<float>(motor_torque_nm_);
+    sample.led_pattern = led_pattern_;
+    trace_.push(sample);
+}
+
+void WheelSimulator::realtime_loop(double time_scale) {
+    using clock = std::chrono::steady_clock;
+    const clock::time_point wall_start = clock::now();
+    const std::uint64_t sim_start_us = time_us();
+    const double dt = static_cast<double>(config_.step.count()) * 1e-6;
+
+    while (realtime_running_.load()) {
+        const double elapsed_us =
+            std::chrono::duration<double, std::micro>(clock::now() - wall_start).count() * time_scale;
+        const std::uint64_t target_us = sim_start_us + static_cast<std::uint64_t>(elapsed_us);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            while (time_us_ + static_cast<std::uint64_t>(config_.step.count()) <= target_us) {
+                step_locked(dt);
+            }
+        }
+        std::this_thread::sleep_for(kRealtimeTick);
+    }
+}
@@ -0,0 +1,101 @@
+#include "alloc_tracker.hpp"
+#include "check.hpp"
+#include "fake_hid_backend.hpp"
+#include "hidpp_mock.hpp"
+#include "logger.hpp"
+#include "wheel_output_worker.hpp"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#ifndef G923_ALLOC_CHECKS
+#error "alloc_check_test needs the output path built with G923_ALLOC_CHECKS"
+#endif
+
+// Drives WheelOutputWorker against each kind of fake wheel. The worker and the wheel code are
+// compiled with G923_ALLOC_CHECKS and bench/alloc_hook.cpp counts every allocation, so one heap
+// allocation inside WheelOutputWorker::execute aborts the test. Enough batches go through to wrap
+// the HID++ mock's report history and the simulator's command log.
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr int kBatches = 2500;
+constexpr std::size_t kBatchSize = 7;
+
+void run_force_path(bool with_hidpp, bool with_simulator) {
+    FakeHidBackend backend;
+    auto device = backend.add_g923(with_hidpp);
+
+    std::shared_ptr<WheelSimulator> simulator;
+    if (with_simulator) {
+        WheelSimulator::Config config;
+        config.command_capacity = 256;
+        config.trace_capacity = 256;
+        simulator = std::make_shared<WheelSimulator>(config);
+        device->attach_simulator(simulator);
+    }
+
+    auto wheel = std::make_unique<WheelController>(device->device(), backend.create_transport(device->device()),
+                                                   with_hidpp ? WheelBackend::hidpp : WheelBackend::classic);
+    CHECK(wheel->initialize());
+    CHECK(wheel->has_high_resolution_forces() == with_hidpp);
+    WheelOutputWorker worker(std::move(wheel), 0);
+    // Setting up the worker allocates, which shows the counting hook is in place
+    CHECK(alloc_tracker::total_allocations() > 0);
+
+    // The trailing stop flushes the whole batch past the governor, so every command is written
+    // without coalescing
+    for (int i = 0; i < kBatches; ++i) {
+        const auto level = static_cast<std::uint8_t>(i);
+        const WheelCommand batch[] = {
+            WheelCommand::constant_force(level, static_cast<std::int16_t>((i % 512) * 64 - 16384)),
+            WheelCommand::custom_spring(0, 0, 4, 4, level, level, 255),
+            WheelCommand::damper(2, 2, level, level),
+            WheelCommand::autocenter_spring(1, 1, 128),
+            WheelCommand::disable_autocenter(),
+            WheelCommand::led_pattern(static_cast<std::uint8_t>(i % 32)),
+            WheelCommand::stop_forces(),
+        };
+        static_assert(sizeof(batch) / sizeof(batch[0]) == kBatchSize, "one command per effect");
+        worker.submit(batch, kBatchSize);
+        CHECK(worker.wait_idle(5s));
+    }
+
+    CHECK(worker.stats().failures == 0);
+    CHECK(worker.stats().commands == static_cast<std::uint64_t>(kBatches) * kBatchSize);
+    if (with_hidpp) {
+        CHECK(device->stats().numbered_writes > 4096);
+    }
+    if (simulator) {
+        CHECK(simulator->stats().dropped_commands > 0);
+    }
+}
+
+void test_classic() {
+    run_force_path(false, false);
+}
+
+void test_classic_with_simulator() {
+    run_force_path(false, true);
+}
+
+void test_hidpp() {
+    run_force_path(true, false);
+}
+
+void test_hidpp_with_simulator() {
+    run_force_path(true, true);
+}
+
+}  // namespace
+
+int main() {
+    Logger::set_enabled(false);
+    run_test("classic", test_classic);
+    run_test("classic_with_simulator", test_classic_with_simulator);
+    run_test("hidpp", test_hidpp);
+    run_test("hidpp_with_simulator", test_hidpp_with_simulator);
+    return check_result();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdio>
+
+// Assertions for the ctest executables. A failed CHECK prints where it failed and the test keeps
+// going, so one run reports every broken expectation; check_result() is the process exit code.
+namespace check_detail {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void fail(const char* file, int line, const char* expression) {
+    ++failures();
+    std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", file, line, expression);
+}
+
+}  // namespace check_detail
+
+#define CHECK(expression) \
+    ((expression) ? static_cast<void>(0) : check_detail::fail(__FILE__, __LINE__, #expression))
+
+inline void run_test(const char* name, void (*test)()) {
+    const int before = check_detail::failures();
+    test();
+    std::printf("%s %s\n", check_detail::failures() == before ? "[ ok ]" : "[FAIL]", name);
+}
+
+inline int check_result() {
+    const int count = check_detail::failures();
+    if (count > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", count);
+    }
+    return count == 0 ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+#include "check.hpp"
+#include "effect_engine.hpp"
+#include "effect_test_support.hpp"
+#include "slot_map.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+using namespace effect_test;
+
+// --- Batch against the reference path --------------------------------------------------
+
+constexpr EffectType kEffectTypes[] = {
+    EffectType::constant_force, EffectType::ramp_force, EffectType::sine,        EffectType::square,
+    EffectType::triangle,       EffectType::sawtooth_up, EffectType::spring,     EffectType::damper,
+};
+constexpr std::size_t kEffectTypeCount = sizeof(kEffectTypes) / sizeof(kEffectTypes[0]);
+
+std::vector<effect_engine::Effect> make_mixed_effects(std::size_t count) {
+    effect_engine::Envelope envelope;
+    envelope.attack_level = 2000;
+    envelope.attack_time = 200000;
+
+    std::vector<effect_engine::Effect> effects;
+    for (std::size_t i = 0; i < count; ++i) {
+        EffectSpec spec;
+        spec.type = kEffectTypes[i % kEffectTypeCount];
+        spec.magnitude = static_cast<std::int32_t>(1000 + (i * 523) % 8000);
+        spec.period_us = static_cast<std::uint32_t>(20000 + i * 1000);
+        spec.duration_us = i % 3 == 0 ? effect_engine::kInfinite : 5000000;
+        spec.direction = static_cast<std::int32_t>((i * 4500) % 36000);
+        spec.envelope = i % 2 == 0 ? &envelope : nullptr;
+        effects.push_back(make_effect(spec));
+    }
+    return effects;
+}
+
+// Every type alone through the batch lands within a force unit of Effect::apply, 64 of them
+// summed within a unit each, and the condition fields match exactly
+void test_batch_matches_apply() {
+    constexpr std::uint32_t kDeviceGain = 7300;
+    const std::vector<effect_engine::Effect> effects = make_mixed_effects(64);
+
+    for (std::size_t i = 0; i < kEffectTypeCount; ++i) {
+        effect_engine::EffectBatch single;
+        single.add(effects[i], kDeviceGain);
+        int max_difference = 0;
+        for (std::uint64_t now = 0; now < 6000000; now += 1000) {
+            g923bridge::WheelStatePayload reference{};
+            effects[i].apply(reference, kDeviceGain, now);
+            g923bridge::WheelStatePayload batched{};
+            single.evaluate(batched, now);
+            max_difference =
+                std::max(max_difference, std::abs(reference.constant_force_magnitude - batched.constant_force_magnitude));
+        }
+        CHECK(max_difference <= 1);
+    }
+
+    effect_engine::EffectBatch batch;
+    for (const effect_engine::Effect& effect : effects) {
+        batch.add(effect, kDeviceGain);
+    }
+    int max_difference = 0;
+    std::size_t condition_mismatches = 0;
+    for (std::uint64_t now = 0; now < 6000000; now += kStepUs) {
+        g923bridge::WheelStatePayload reference{};
+        for (const effect_engine::Effect& effect : effects) {
+            effect.apply(reference, kDeviceGain, now);
+        }
+        g923bridge::WheelStatePayload batched{};
+        batch.evaluate(batched, now);
+        max_difference =
+            std::max(max_difference, std::abs(reference.constant_force_magnitude - batched.constant_force_magnitude));
+        batched.constant_force_magnitude = reference.constant_force_magnitude;
+        condition_mismatches += std::memcmp(&reference, &batched, sizeof(reference)) != 0 ? 1 : 0;
+    }
+    CHECK(max_difference <= static_cast<int>(effects.size()));
+    CHECK(condition_mismatches == 0);
+}
+
+// --- Effect table ----------------------------------------------------------------------
+
+// A million random creates and releases: live handles always find their value, released ones
+// are refused even after their slot is reused, and the size tracks the live set
+void test_slot_map_stress() {
+    struct Live {
+        SlotMap<std::uint32_t>::Handle handle;
+        std::uint32_t value;
+    };
+    SlotMap<std::uint32_t> table;
+    std::vector<Live> live;
+    std::vector<SlotMap<std::uint32_t>::Handle> released;
+    std::uint32_t random = 0x9E3779B9u;
+    const auto next_random = [&random] {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        return random;
+    };
+
+    constexpr std::size_t kOperations = 1000000;
+    std::size_t peak = 0;
+    std::size_t stale_checks = 0;
+    std::size_t mismatches = 0;
+    for (std::size_t op = 0; op < kOperations; ++op) {
+        // Drifts between empty and a few hundred effects so slots are reused at every depth
+        const std::size_t target = (op / 50000) % 2 == 0 ? 400 : 8;
+        if (live.empty() || (live.size() < target && next_random() % 4 != 0)) {
+            const std::uint32_t value = static_cast<std::uint32_t>(op);
+            live.push_back(Live{table.insert(value), value});
+        } else {
+            const std::size_t victim = next_random() % live.size();
+            mismatches += table.erase(live[victim].handle) ? 0 : 1;
+            released.push_back(live[victim].handle);
+            live[victim] = live.back();
+            live.pop_back();
+        }
+        peak = std::max(peak, live.size());
+
+        if (!live.empty()) {
+            const Live& probe = live[next_random() % live.size()];
+            const std::uint32_t* found = table.find(probe.handle);
+            mismatches += found && *found == probe.value ? 0 : 1;
+        }
+        if (!released.empty()) {
+            const SlotMap<std::uint32_t>::Handle stale = released[next_random() % released.size()];
+            ++stale_checks;
+            mismatches += !table.find(stale) && !table.erase(stale) ? 0 : 1;
+        }
+        mismatches += table.size() == live.size() ? 0 : 1;
+    }
+    CHECK(mismatches == 0);
+    CHECK(peak == 400);
+    CHECK(stale_checks > kOperations / 2);
+}
+
+}  // namespace
+
+int main() {
+    run_test("batch_matches_apply", test_batch_matches_apply);
+    run_test("slot_map_stress", test_slot_map_stress);
+    return check_result();
+}
@@ -0,0 +1,139 @@
+#include "check.hpp"
+#include "effect_engine.hpp"
+#include "effect_test_support.hpp"
+
+namespace {
+
+using namespace effect_test;
+
+void test_constant_force_runs_for_its_duration() {
+    EffectSpec spec;
+    spec.magnitude = 6000;
+    spec.duration_us = 50000;
+    spec.start_delay_us = 10000;
+    effect_engine::Effect effect = make_effect(spec);
+
+    CHECK(effect.started());
+    CHECK(!apply_one(effect, 5000).constant_force_enabled);
+    const g923bridge::WheelStatePayload running = apply_one(effect, 20000);
+    CHECK(running.constant_force_enabled);
+    CHECK(running.constant_force_magnitude == 6000);
+    CHECK(!apply_one(effect, 60000).constant_force_enabled);
+
+    effect.refresh_runtime(30000);
+    CHECK(effect.started());
+    effect.refresh_runtime(60001);
+    CHECK(!effect.started());
+}
+
+void test_direction_and_stop() {
+    EffectSpec spec;
+    spec.magnitude = 4000;
+    spec.direction = 18000;
+    effect_engine::Effect effect = make_effect(spec);
+    CHECK(apply_one(effect, 1000).constant_force_magnitude == -4000);
+
+    effect.stop();
+    CHECK(!effect.started());
+    CHECK(!apply_one(effect, 1000).constant_force_enabled);
+    effect_engine::EffectBatch batch;
+    batch.add(effect, kNominalMax);
+    CHECK(batch.size() == 0);
+}
+
+void test_forces_add_and_clamp() {
+    EffectSpec spec;
+    spec.magnitude = 7000;
+    const effect_engine::Effect first = make_effect(spec);
+    const effect_engine::Effect second = make_effect(spec);
+    g923bridge::WheelStatePayload payload{};
+    first.apply(payload, kNominalMax, 0);
+    second.apply(payload, kNominalMax, 0);
+    CHECK(payload.constant_force_magnitude == kNominalMax);
+
+    // Device gain scales the force
+    g923bridge::WheelStatePayload halved{};
+    first.apply(halved, kNominalMax / 2, 0);
+    CHECK(halved.constant_force_magnitude == 3500);
+}
+
+void test_conditions_set_spring_and_damper() {
+    EffectSpec spec;
+    spec.type = EffectType::spring;
+    const g923bridge::WheelStatePayload spring = apply_one(make_effect(spec), 0);
+    CHECK(spring.custom_spring_enabled);
+    CHECK(spring.spring_k1 > 0 && spring.spring_k2 > 0);
+    CHECK(spring.spring_k1 >= spring.spring_k2);
+    CHECK(!spring.constant_force_enabled);
+
+    spec.type = EffectType::damper;
+    const g923bridge::WheelStatePayload damper = apply_one(make_effect(spec), 0);
+    CHECK(damper.damper_enabled);
+    CHECK(!damper.custom_spring_enabled);
+}
+
+void test_parameters_can_start_an_effect() {
+    effect_engine::ConstantForce constant;
+    constant.magnitude = 2500;
+    effect_engine::EffectUpdate update;
+    update.flags = effect_engine::kParamAll | effect_engine::kParamStart;
+    update.gain = kNominalMax;
+    update.duration = effect_engine::kInfinite;
+    update.type_specific = &constant;
+    update.type_specific_size = sizeof(constant);
+
+    effect_engine::Effect effect(EffectType::constant_force);
+    CHECK(!effect.started());
+    effect.set_parameters(update, 1000);
+    CHECK(effect.started());
+    CHECK(apply_one(effect, 2000).constant_force_magnitude == 2500);
+}
+
+void test_autocenter_fallback() {
+    g923bridge::WheelStatePayload empty{};
+    effect_engine::apply_autocenter_fallback(empty, kNominalMax);
+    CHECK(empty.autocenter_enabled);
+    CHECK(empty.autocenter_force > 0);
+    CHECK(effect_engine::has_state(empty));
+
+    // An effect spring takes over from the fallback
+    EffectSpec spec;
+    spec.type = EffectType::spring;
+    g923bridge::WheelStatePayload spring = apply_one(make_effect(spec), 0);
+    effect_engine::apply_autocenter_fallback(spring, kNominalMax);
+    CHECK(!spring.autocenter_enabled);
+}
+
+void test_output_filter() {
+    using Action = effect_engine::OutputFilter::Action;
+    effect_engine::OutputFilter filter;
+    g923bridge::WheelStatePayload empty{};
+    g923bridge::WheelStatePayload state{};
+    state.constant_force_enabled = 1;
+    state.constant_force_magnitude = 100;
+
+    CHECK(filter.filter(empty) == Action::none);
+    CHECK(filter.filter(state) == Action::send_state);
+    CHECK(filter.filter(state) == Action::none);
+    state.constant_force_magnitude = 101;
+    CHECK(filter.filter(state) == Action::send_state);
+    CHECK(filter.filter(empty) == Action::send_stop_all);
+    CHECK(filter.filter(empty) == Action::none);
+    CHECK(filter.filter(state) == Action::send_state);
+
+    filter.reset();
+    CHECK(filter.filter(state) == Action::send_state);
+}
+
+}  // namespace
+
+int main() {
+    run_test("constant_force_runs_for_its_duration", test_constant_force_runs_for_its_duration);
+    run_test("direction_and_stop", test_direction_and_stop);
+    run_test("forces_add_and_clamp", test_forces_add_and_clamp);
+    run_test("conditions_set_spring_and_damper", test_conditions_set_spring_and_damper);
+    run_test("parameters_can_start_an_effect", test_parameters_can_start_an_effect);
+    run_test("autocenter_fallback", test_autocenter_fallback);
+    run_test("output_filter", test_output_filter);
+    return check_result();
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "effect_engine.hpp"
+#include <cstdint>
+
+// Builds started effects for the effect engine tests, with the fields a test cares about set
+// through EffectSpec and the rest at typical game values
+namespace effect_test {
+
+using effect_engine::EffectType;
+using effect_engine::kNominalMax;
+
+constexpr double kTwoPi = 6.28318530717958647692;
+constexpr std::uint64_t kStepUs = 250;
+
+struct EffectSpec {
+    EffectType type = EffectType::constant_force;
+    std::int32_t magnitude = kNominalMax;
+    std::uint32_t period_us = effect_engine::kDefaultPeriod;
+    std::uint32_t duration_us = effect_engine::kInfinite;
+    std::uint32_t start_delay_us = 0;
+    std::int32_t direction = 0;
+    const effect_engine::Envelope* envelope = nullptr;
+};
+
+inline effect_engine::Effect make_effect(const EffectSpec& spec) {
+    effect_engine::ConstantForce constant;
+    constant.magnitude = spec.magnitude;
+    effect_engine::RampForce ramp;
+    ramp.start = spec.magnitude;
+    ramp.end = -spec.magnitude;
+    effect_engine::Periodic periodic;
+    periodic.magnitude = static_cast<std::uint32_t>(spec.magnitude);
+    periodic.period = spec.period_us;
+    effect_engine::Condition conditions[2];
+    for (effect_engine::Condition& condition : conditions) {
+        condition.positive_coefficient = 6000;
+        condition.negative_coefficient = 5000;
+        condition.positive_saturation = 8000;
+        condition.negative_saturation = 8000;
+        condition.dead_band = 500;
+    }
+
+    effect_engine::EffectUpdate update;
+    update.flags = effect_engine::kParamAll;
+    update.effect_flags = effect_engine::kDirectionPolar;
+    update.gain = kNominalMax;
+    update.duration = spec.duration_us;
+    update.start_delay = spec.start_delay_us;
+    update.axis_count = 1;
+    update.has_direction = true;
+    update.direction[0] = spec.direction;
+    update.envelope = spec.envelope;
+    if (effect_engine::is_condition(spec.type)) {
+        update.type_specific = conditions;
+        update.type_specific_size = sizeof(conditions);
+    } else if (effect_engine::is_periodic(spec.type)) {
+        update.type_specific = &periodic;
+        update.type_specific_size = sizeof(periodic);
+    } else if (spec.type == EffectType::ramp_force) {
+        update.type_specific = &ramp;
+        update.type_specific_size = sizeof(ramp);
+    } else {
+        update.type_specific = &constant;
+        update.type_specific_size = sizeof(constant);
+    }
+
+    effect_engine::Effect effect(spec.type);
+    effect.set_parameters(update, 0);
+    effect.start(1, 0);
+    return effect;
+}
+
+inline std::int16_t evaluate_one(const effect_engine::Effect& effect, std::uint64_t now_us) {
+    effect_engine::EffectBatch batch;
+    batch.add(effect, kNominalMax);
+    g923bridge::WheelStatePayload payload{};
+    batch.evaluate(payload, now_us);
+    return payload.constant_force_magnitude;
+}
+
+inline g923bridge::WheelStatePayload apply_one(const effect_engine::Effect& effect, std::uint64_t now_us) {
+    g923bridge::WheelStatePayload payload{};
+    effect.apply(payload, kNominalMax, now_us);
+    return payload;
+}
+
+}  // namespace effect_test
@@ -0,0 +1,69 @@
+#include "check.hpp"
+#include "effect_engine.hpp"
+#include "effect_test_support.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+using namespace effect_test;
+
+struct AccuracyCase {
+    EffectType type;
+    std::uint32_t period_us;
+    std::uint32_t attack_us;
+    std::uint32_t fade_us;
+    std::uint32_t duration_us;
+};
+
+// Waveforms and envelopes evaluated every 250 us stay within two force units of the ideal curve
+void test_envelope_and_waveform_accuracy() {
+    const AccuracyCase cases[] = {
+        {EffectType::sine, 2000, 0, 0, 40000},
+        {EffectType::sine, 8000, 0, 0, 40000},
+        {EffectType::triangle, 5000, 0, 0, 40000},
+        {EffectType::constant_force, 0, 5000, 0, 40000},
+        {EffectType::constant_force, 0, 0, 3000, 20000},
+    };
+
+    for (const AccuracyCase& test : cases) {
+        effect_engine::Envelope envelope;
+        envelope.attack_time = test.attack_us;
+        envelope.fade_time = test.fade_us;
+        EffectSpec spec;
+        spec.type = test.type;
+        spec.period_us = test.period_us ? test.period_us : effect_engine::kDefaultPeriod;
+        spec.duration_us = test.duration_us;
+        spec.envelope = test.attack_us || test.fade_us ? &envelope : nullptr;
+        const effect_engine::Effect effect = make_effect(spec);
+
+        const auto ideal = [&test](std::uint64_t t) {
+            double level = 1.0;
+            if (t < test.attack_us) {
+                level = static_cast<double>(t) / test.attack_us;
+            } else if (test.fade_us && t >= test.duration_us - test.fade_us) {
+                level = 1.0 - static_cast<double>(t - (test.duration_us - test.fade_us)) / test.fade_us;
+            }
+            if (!effect_engine::is_periodic(test.type)) {
+                return level * kNominalMax;
+            }
+            const double phase = static_cast<double>(t % test.period_us) / test.period_us;
+            const double wave = test.type == EffectType::sine ? std::sin(phase * kTwoPi) : 1.0 - 4.0 * std::fabs(phase - 0.5);
+            return level * kNominalMax * wave;
+        };
+
+        double max_error = 0.0;
+        for (std::uint64_t t = 0; t < test.duration_us; t += kStepUs) {
+            max_error = std::max(max_error, std::fabs(effect.compute_force(t, kNominalMax) - ideal(t)));
+        }
+        CHECK(max_error <= 2.0);
+    }
+}
+
+}  // namespace
+
+int main() {
+    run_test("envelope_and_waveform_accuracy", test_envelope_and_waveform_accuracy);
+    return check_result();
+}
@@ -0,0 +1,201 @@
+#include "check.hpp"
+#include "constants.hpp"
+#include "fake_hid_backend.hpp"
+#include "hidpp.hpp"
+#include "hidpp_mock.hpp"
+#include "wheel.hpp"
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+constexpr std::uint8_t kFeatureIndex = 0x0B;
+
+HidppReport transact(HidppMockDevice& mock, const HidppReport& request) {
+    HidppReport response;
+    CHECK(mock.write_report(request));
+    CHECK(mock.read_report(request.report_id(), response));
+    return response;
+}
+
+std::uint8_t error_code(const HidppReport& response) {
+    return response.is_error() ? response.data[5] : 0;
+}
+
+void test_feature_lookup() {
+    HidppMockDevice mock(16, kFeatureIndex);
+    HidppReport response = transact(mock, HidppCommandBuilder::create_get_feature(hidpp::FEATURE_FORCE_FEEDBACK));
+    CHECK(!response.is_error());
+    CHECK(response.params()[0] == kFeatureIndex);
+
+    response = transact(mock, HidppCommandBuilder::create_get_feature(0x1234));
+    CHECK(response.params()[0] == hidpp::ROOT_FEATURE_INDEX);
+
+    mock.set_feature_supported(false);
+    response = transact(mock, HidppCommandBuilder::create_get_feature(hidpp::FEATURE_FORCE_FEEDBACK));
+    CHECK(response.params()[0] == hidpp::ROOT_FEATURE_INDEX);
+    response = transact(mock, HidppCommandBuilder::create_get_info(kFeatureIndex));
+    CHECK(error_code(response) == hidpp::ERROR_INVALID_FEATURE_INDEX);
+}
+
+void test_download_and_play() {
+    HidppMockDevice mock(16, kFeatureIndex);
+    HidppReport response = transact(mock, HidppCommandBuilder::create_get_info(kFeatureIndex));
+    CHECK(response.params()[0] == 16);
+
+    response = transact(mock, HidppCommandBuilder::create_constant_force(kFeatureIndex, hidpp::SLOT_NEW, -1234, true));
+    CHECK(!response.is_error());
+    const std::uint8_t slot = response.params()[0];
+    CHECK(slot == 1);
+    CHECK(mock.slot(slot).allocated);
+    CHECK(mock.slot(slot).playing);
+    CHECK(mock.slot(slot).effect_type == hidpp::EFFECT_CONSTANT);
+    CHECK(mock.slot(slot).level == -1234);
+
+    response = transact(mock, HidppCommandBuilder::create_constant_force(kFeatureIndex, slot, 500, false));
+    CHECK(response.params()[0] == slot);
+    CHECK(mock.slot(slot).level == 500);
+    CHECK(mock.slot(slot).download_count == 2);
+    CHECK(mock.allocated_slot_count() == 1);
+
+    transact(mock, HidppCommandBuilder::create_set_effect_state(kFeatureIndex, slot, hidpp::EFFECT_STATE_STOP));
+    CHECK(!mock.slot(slot).playing);
+    CHECK(mock.playing_slot_count() == 0);
+
+    transact(mock, HidppCommandBuilder::create_destroy_effect(kFeatureIndex, slot));
+    CHECK(!mock.slot(slot).allocated);
+    response = transact(mock, HidppCommandBuilder::create_set_effect_state(kFeatureIndex, slot, hidpp::EFFECT_STATE_PLAY));
+    CHECK(error_code(response) == hidpp::ERROR_INVALID_ARGUMENT);
+
+    CHECK(mock.function_count(hidpp::FF_DOWNLOAD_EFFECT) == 2);
+    CHECK(mock.function_count(hidpp::FF_DESTROY_EFFECT) == 1);
+}
+
+void test_condition_layout() {
+    HidppMockDevice mock(16, kFeatureIndex);
+    HidppCondition condition;
+    condition.left_coefficient = -300;
+    condition.right_coefficient = 700;
+    condition.left_saturation = 0x1111;
+    condition.right_saturation = 0x2222;
+    condition.deadband = 0x3333;
+    condition.center = -44;
+
+    const HidppReport request =
+        HidppCommandBuilder::create_condition(kFeatureIndex, hidpp::SLOT_NEW, hidpp::EFFECT_SPRING, condition, true);
+    CHECK(request.report_id() == hidpp::REPORT_ID_VERY_LONG);
+    const HidppReport response = transact(mock, request);
+    CHECK(!response.is_error());
+
+    const HidppMockDevice::EffectSlot& slot = mock.slot(response.params()[0]);
+    CHECK(slot.effect_type == hidpp::EFFECT_SPRING);
+    CHECK(slot.condition.left_coefficient == -300);
+    CHECK(slot.condition.right_coefficient == 700);
+    CHECK(slot.condition.left_saturation == 0x1111);
+    CHECK(slot.condition.right_saturation == 0x2222);
+    CHECK(slot.condition.deadband == 0x3333);
+    CHECK(slot.condition.center == -44);
+}
+
+void test_condition_needs_very_long_report() {
+    HidppMockDevice mock(16, kFeatureIndex);
+    HidppReport request =
+        HidppCommandBuilder::create_condition(kFeatureIndex, hidpp::SLOT_NEW, hidpp::EFFECT_DAMPER, HidppCondition{}, true);
+    request.data[0] = hidpp::REPORT_ID_LONG;
+    request.length = hidpp::REPORT_LENGTH_LONG;
+
+    const HidppReport response = transact(mock, request);
+    CHECK(error_code(response) == hidpp::ERROR_INVALID_ARGUMENT);
+    CHECK(mock.allocated_slot_count() == 0);
+    CHECK(mock.error_count() == 1);
+}
+
+void test_slots_run_out() {
+    HidppMockDevice mock(2, kFeatureIndex);
+    CHECK(!transact(mock, HidppCommandBuilder::create_constant_force(kFeatureIndex, hidpp::SLOT_NEW, 1, true)).is_error());
+    CHECK(!transact(mock, HidppCommandBuilder::create_constant_force(kFeatureIndex, hidpp::SLOT_NEW, 2, true)).is_error());
+    const HidppReport response =
+        transact(mock, HidppCommandBuilder::create_constant_force(kFeatureIndex, hidpp::SLOT_NEW, 3, true));
+    CHECK(error_code(response) == hidpp::ERROR_BUSY);
+    CHECK(mock.allocated_slot_count() == 2);
+
+    transact(mock, HidppCommandBuilder::create_reset_all(kFeatureIndex));
+    CHECK(mock.allocated_slot_count() == 0);
+}
+
+void test_write_failure() {
+    HidppMockDevice mock(16, kFeatureIndex);
+    mock.set_write_failure(true);
+    HidppReport response;
+    CHECK(!mock.write_report(HidppCommandBuilder::create_get_info(kFeatureIndex)));
+    CHECK(!mock.read_report(hidpp::REPORT_ID_LONG, response));
+    CHECK(mock.report_count() == 0);
+
+    mock.set_write_failure(false);
+    CHECK(mock.write_report(HidppCommandBuilder::create_get_info(kFeatureIndex)));
+    CHECK(!mock.read_report(hidpp::REPORT_ID_VERY_LONG, response));
+    CHECK(mock.read_report(hidpp::REPORT_ID_LONG, response));
+}
+
+void test_force_feedback_initialize() {
+    HidppMockDevice mock(16, kFeatureIndex);
+    HidppForceFeedback force_feedback(mock);
+    CHECK(force_feedback.initialize());
+    CHECK(mock.global_gain() == 0xFFFF);
+
+    CHECK(force_feedback.set_constant_force(8000));
+    CHECK(mock.allocated_slot_count() == 1);
+    CHECK(force_feedback.stop_forces());
+    CHECK(mock.playing_slot_count() == 0);
+
+    HidppMockDevice unsupported(16, kFeatureIndex);
+    unsupported.set_feature_supported(false);
+    HidppForceFeedback fallback(unsupported);
+    CHECK(!fallback.initialize());
+}
+
+// The classic spring deadbands are nibbles; a full deadband must reach the full HID++ range
+void test_spring_deadband_scaling() {
+    FakeHidBackend backend;
+    auto device = backend.add_g923(true);
+
+    std::uint16_t deadband = 0;
+    bool saw_spring = false;
+    device->set_write_observer([&](const std::uint8_t* data, std::size_t length, bool numbered) {
+        if (!numbered || length < hidpp::REPORT_HEADER_LENGTH + 12 || data[0] != hidpp::REPORT_ID_VERY_LONG ||
+            (data[3] >> 4) != hidpp::FF_DOWNLOAD_EFFECT) {
+            return;
+        }
+        const std::uint8_t* params = data + hidpp::REPORT_HEADER_LENGTH;
+        if ((params[1] & hidpp::EFFECT_TYPE_MASK) == hidpp::EFFECT_SPRING) {
+            deadband = HidppCommandBuilder::read_uint16(params + 10);
+            saw_spring = true;
+        }
+    });
+
+    WheelController wheel(device->device(), backend.create_transport(device->device()), WheelBackend::hidpp);
+    CHECK(wheel.initialize());
+    CHECK(wheel.backend() == WheelBackend::hidpp);
+
+    CHECK(wheel.set_custom_spring(15, 15, 8, 8, 15, 15, 255));
+    CHECK(saw_spring);
+    CHECK(deadband == hidpp::CONDITION_SATURATION_MAX);
+
+    CHECK(wheel.set_custom_spring(5, 5, 8, 8, 15, 15, 255));
+    CHECK(deadband == hidpp::CONDITION_SATURATION_MAX / 3);
+    device->set_write_observer(nullptr);
+}
+
+}  // namespace
+
+int main() {
+    run_test("feature_lookup", test_feature_lookup);
+    run_test("download_and_play", test_download_and_play);
+    run_test("condition_layout", test_condition_layout);
+    run_test("condition_needs_very_long_report", test_condition_needs_very_long_report);
+    run_test("slots_run_out", test_slots_run_out);
+    run_test("write_failure", test_write_failure);
+    run_test("force_feedback_initialize", test_force_feedback_initialize);
+    run_test("spring_deadband_scaling", test_spring_deadband_scaling);
+    return check_result();
+}
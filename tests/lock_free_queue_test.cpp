@@ -0,0 +1,337 @@
+#include "check.hpp"
+#include "line_ring.hpp"
+#include "slot_ring.hpp"
+#include "state_mailbox.hpp"
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Tags a state with who published it and when, in several fields, so a state torn between two
+// publishes shows up as fields that disagree
+g923bridge::WheelStatePayload make_state(std::uint8_t publisher, std::uint16_t sequence) {
+    g923bridge::WheelStatePayload state{};
+    state.constant_force_enabled = 1;
+    state.constant_force_magnitude = static_cast<std::int16_t>(sequence);
+    state.spring_k1 = static_cast<std::uint8_t>(sequence);
+    state.damper_force_positive = publisher;
+    state.led_pattern = publisher;
+    return state;
+}
+
+bool is_whole(const g923bridge::WheelStatePayload& state) {
+    return state.constant_force_enabled == 1 &&
+           state.spring_k1 == static_cast<std::uint8_t>(state.constant_force_magnitude) &&
+           state.damper_force_positive == state.led_pattern;
+}
+
+// --- StateMailbox ----------------------------------------------------------------------
+
+void test_stop_after_state_drops_it() {
+    StateMailbox mailbox;
+    StateMailbox::Taken taken;
+    CHECK(!mailbox.take(taken));
+
+    mailbox.publish(make_state(0, 1));
+    mailbox.request_stop_all();
+    CHECK(mailbox.take(taken));
+    CHECK(taken.stop_all);
+    CHECK(!taken.has_state);
+    CHECK(!mailbox.take(taken));
+}
+
+void test_state_after_stop_follows_it() {
+    StateMailbox mailbox;
+    StateMailbox::Taken taken;
+    mailbox.publish(make_state(0, 1));
+    mailbox.request_stop_all();
+    mailbox.publish(make_state(0, 2));
+    CHECK(mailbox.take(taken));
+    CHECK(taken.stop_all);
+    CHECK(taken.has_state);
+    CHECK(taken.state.constant_force_magnitude == 2);
+
+    // Back-to-back stops are taken as one
+    mailbox.request_stop_all();
+    mailbox.request_stop_all();
+    CHECK(mailbox.take(taken));
+    CHECK(taken.stop_all && !taken.has_state);
+    CHECK(!mailbox.take(taken));
+}
+
+// Tickets run many times round the slots, taken one by one and in bursts longer than the ring
+void test_mailbox_wraps() {
+    StateMailbox mailbox;
+    StateMailbox::Taken taken;
+    std::size_t mismatches = 0;
+    for (std::uint16_t i = 1; i <= StateMailbox::kSlots * 4 + 3; ++i) {
+        mailbox.publish(make_state(0, i));
+        mismatches += mailbox.take(taken) && taken.has_state && !taken.stop_all &&
+                              taken.state.constant_force_magnitude == i
+                          ? 0
+                          : 1;
+    }
+    CHECK(mismatches == 0);
+
+    for (std::uint16_t i = 1; i <= StateMailbox::kSlots * 2 + 5; ++i) {
+        mailbox.publish(make_state(0, static_cast<std::uint16_t>(1000 + i)));
+    }
+    CHECK(mailbox.take(taken));
+    CHECK(taken.has_state);
+    CHECK(taken.state.constant_force_magnitude == 1000 + StateMailbox::kSlots * 2 + 5);
+    CHECK(!mailbox.take(taken));
+    CHECK(mailbox.published() == StateMailbox::kSlots * 6 + 8);
+}
+
+// Publishers race each other, with stops mixed in, against a sender taking as fast as it can.
+// Every state taken is whole and newer than the last one taken from its publisher, and since
+// every publisher finishes with a stop, the last thing the sender takes is a stop with no state.
+void test_concurrent_publishers() {
+    constexpr std::uint8_t kPublishers = 4;
+    constexpr std::uint16_t kStatesEach = 20000;
+    constexpr std::uint16_t kStopEvery = 500;
+
+    StateMailbox mailbox;
+    std::atomic<bool> publishing{true};
+    std::size_t torn = 0;
+    std::size_t out_of_order = 0;
+    std::size_t takes = 0;
+    StateMailbox::Taken last;
+
+    std::thread sender([&] {
+        std::uint16_t newest[kPublishers] = {};
+        StateMailbox::Taken taken;
+        while (true) {
+            const bool finished = !publishing.load();
+            while (mailbox.take(taken)) {
+                ++takes;
+                last = taken;
+                if (!taken.has_state) {
+                    continue;
+                }
+                if (!is_whole(taken.state) || taken.state.led_pattern >= kPublishers) {
+                    ++torn;
+                    continue;
+                }
+                const auto sequence = static_cast<std::uint16_t>(taken.state.constant_force_magnitude);
+                out_of_order += sequence > newest[taken.state.led_pattern] ? 0 : 1;
+                newest[taken.state.led_pattern] = sequence;
+            }
+            if (finished) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    std::vector<std::thread> publishers;
+    for (std::uint8_t p = 0; p < kPublishers; ++p) {
+        publishers.emplace_back([&mailbox, p] {
+            for (std::uint16_t i = 1; i <= kStatesEach; ++i) {
+                mailbox.publish(make_state(p, i));
+                if (i % kStopEvery == 0) {
+                    mailbox.request_stop_all();
+                }
+            }
+        });
+    }
+    for (std::thread& publisher : publishers) {
+        publisher.join();
+    }
+    publishing.store(false);
+    sender.join();
+
+    CHECK(torn == 0);
+    CHECK(out_of_order == 0);
+    CHECK(takes > 0);
+    CHECK(last.stop_all);
+    CHECK(!last.has_state);
+    CHECK(mailbox.published() == static_cast<std::uint64_t>(kPublishers) * kStatesEach);
+}
+
+// --- SlotRing and LineRing -------------------------------------------------------------
+
+using SmallRing = SlotRing<8, 16>;
+
+bool push_number(SmallRing& ring, std::uint32_t value) {
+    return ring.push_with([value](char* data) {
+        std::memcpy(data, &value, sizeof(value));
+        return sizeof(value);
+    });
+}
+
+bool pop_number(SmallRing& ring, std::uint32_t& value) {
+    std::size_t length = 0;
+    const char* data = ring.front(length);
+    if (!data || length != sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, data, sizeof(value));
+    ring.pop();
+    return true;
+}
+
+void test_slot_ring_drops_when_full() {
+    SmallRing ring;
+    std::uint32_t value = 0;
+    CHECK(!pop_number(ring, value));
+
+    for (std::uint32_t i = 0; i < SmallRing::kSlots; ++i) {
+        CHECK(push_number(ring, i));
+        CHECK(ring.filling() == (i + 1 >= SmallRing::kSlots / 2));
+    }
+    CHECK(!push_number(ring, 100));
+    CHECK(!push_number(ring, 101));
+    CHECK(ring.take_dropped() == 2);
+    CHECK(ring.take_dropped() == 0);
+
+    // Taking the oldest record frees exactly one slot
+    CHECK(pop_number(ring, value) && value == 0);
+    CHECK(push_number(ring, 200));
+    CHECK(!push_number(ring, 201));
+    CHECK(ring.take_dropped() == 1);
+
+    for (std::uint32_t i = 1; i < SmallRing::kSlots; ++i) {
+        CHECK(pop_number(ring, value) && value == i);
+    }
+    CHECK(pop_number(ring, value) && value == 200);
+    CHECK(!pop_number(ring, value));
+    CHECK(!ring.filling());
+}
+
+void test_slot_ring_wraps() {
+    SmallRing ring;
+    std::size_t mismatches = 0;
+    std::uint32_t expected = 0;
+    for (std::uint32_t i = 0; i < SmallRing::kSlots * 50; ++i) {
+        mismatches += push_number(ring, i) ? 0 : 1;
+        // Keep a few records waiting so the reader trails the producer across the wrap
+        if (i + 1 - expected > 3) {
+            std::uint32_t value = 0;
+            mismatches += pop_number(ring, value) && value == expected++ ? 0 : 1;
+        }
+    }
+    std::uint32_t value = 0;
+    while (pop_number(ring, value)) {
+        mismatches += value == expected++ ? 0 : 1;
+    }
+    CHECK(mismatches == 0);
+    CHECK(expected == SmallRing::kSlots * 50);
+    CHECK(ring.take_dropped() == 0);
+}
+
+// Producers race into a ring too small for them: every record is either read, in the order its
+// producer pushed it, or counted as dropped
+void test_slot_ring_concurrent_producers() {
+    constexpr std::uint32_t kProducers = 4;
+    constexpr std::uint32_t kRecordsEach = 50000;
+
+    SlotRing<64, 16> ring;
+    std::atomic<bool> producing{true};
+    std::uint64_t received = 0;
+    std::uint64_t dropped = 0;
+    std::size_t out_of_order = 0;
+
+    std::thread reader([&] {
+        std::uint32_t next[kProducers] = {};
+        while (true) {
+            const bool finished = !producing.load();
+            std::size_t length = 0;
+            while (const char* data = ring.front(length)) {
+                std::uint32_t record[2];
+                std::memcpy(record, data, sizeof(record));
+                ring.pop();
+                ++received;
+                out_of_order += length == sizeof(record) && record[0] < kProducers && record[1] >= next[record[0]] ? 0 : 1;
+                next[record[0] % kProducers] = record[1] + 1;
+            }
+            dropped += ring.take_dropped();
+            if (finished) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    std::vector<std::thread> producers;
+    for (std::uint32_t p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&ring, p] {
+            for (std::uint32_t i = 0; i < kRecordsEach; ++i) {
+                ring.push_with([p, i](char* data) {
+                    const std::uint32_t record[2] = {p, i};
+                    std::memcpy(data, record, sizeof(record));
+                    return sizeof(record);
+                });
+            }
+        });
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    producing.store(false);
+    reader.join();
+
+    CHECK(out_of_order == 0);
+    CHECK(received > 0);
+    CHECK(received + dropped == static_cast<std::uint64_t>(kProducers) * kRecordsEach);
+}
+
+bool push_formatted(LineRing& ring, const char* format, ...) {
+    std::va_list args;
+    va_start(args, format);
+    const bool pushed = ring.push_format(format, args);
+    va_end(args);
+    return pushed;
+}
+
+void test_line_ring() {
+    LineRing ring;
+    const std::string long_line(LineRing::kLineCapacity * 2, 'x');
+    CHECK(ring.push("first"));
+    CHECK(push_formatted(ring, "effect %d gain %u", 3, 7300u));
+    CHECK(ring.push(long_line.c_str()));
+    CHECK(push_formatted(ring, "%s", long_line.c_str()));
+
+    std::size_t length = 0;
+    const char* line = ring.front(length);
+    CHECK(line && length == 5 && std::strcmp(line, "first") == 0);
+    ring.pop();
+    line = ring.front(length);
+    CHECK(line && std::strcmp(line, "effect 3 gain 7300") == 0);
+    ring.pop();
+
+    // Long lines are cut to fit their terminator, whether copied or formatted
+    for (int i = 0; i < 2; ++i) {
+        line = ring.front(length);
+        CHECK(line && length == LineRing::kLineCapacity - 1);
+        CHECK(line && std::strlen(line) == LineRing::kLineCapacity - 1);
+        ring.pop();
+    }
+    CHECK(!ring.front(length));
+
+    for (std::size_t i = 0; i < LineRing::kSlots; ++i) {
+        CHECK(ring.push("line"));
+    }
+    CHECK(ring.filling());
+    CHECK(!ring.push("one too many"));
+    CHECK(ring.take_dropped() == 1);
+}
+
+}  // namespace
+
+int main() {
+    run_test("stop_after_state_drops_it", test_stop_after_state_drops_it);
+    run_test("state_after_stop_follows_it", test_state_after_stop_follows_it);
+    run_test("mailbox_wraps", test_mailbox_wraps);
+    run_test("concurrent_publishers", test_concurrent_publishers);
+    run_test("slot_ring_drops_when_full", test_slot_ring_drops_when_full);
+    run_test("slot_ring_wraps", test_slot_ring_wraps);
+    run_test("slot_ring_concurrent_producers", test_slot_ring_concurrent_producers);
+    run_test("line_ring", test_line_ring);
+    return check_result();
+}
@@ -0,0 +1,77 @@
+#include "check.hpp"
+#include "effect_engine.hpp"
+#include "effect_test_support.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+using namespace effect_test;
+
+effect_engine::Effect make_sine(std::uint32_t period_us) {
+    EffectSpec spec;
+    spec.type = EffectType::sine;
+    spec.period_us = period_us;
+    return make_effect(spec);
+}
+
+void retune_sine(effect_engine::Effect& effect, std::uint32_t period_us, std::uint64_t now_us) {
+    effect_engine::Periodic periodic;
+    periodic.period = period_us;
+    effect_engine::EffectUpdate update;
+    update.flags = effect_engine::kParamTypeSpecific;
+    update.type_specific = &periodic;
+    update.type_specific_size = sizeof(periodic);
+    effect.set_parameters(update, now_us);
+}
+
+// The table-driven sine stays within two force units of std::sin over ten seconds
+void test_sine_table_accuracy() {
+    constexpr std::uint64_t kRunUs = 10000000;
+    for (const std::uint32_t period : {1000u, 4000u, 20000u, 100000u}) {
+        const effect_engine::Effect effect = make_sine(period);
+        double max_error = 0.0;
+        for (std::uint64_t t = 0; t < kRunUs; t += kStepUs) {
+            const double ideal = kNominalMax * std::sin(kTwoPi * static_cast<double>(t % period) / period);
+            max_error = std::max(max_error, std::fabs(evaluate_one(effect, t) - ideal));
+        }
+        CHECK(max_error <= 2.0);
+    }
+}
+
+// Retuning a running sine carries its phase on: the wave follows the continuous curve and never
+// steps further between samples than the new period's steepest slope allows
+void test_retune_keeps_phase() {
+    constexpr std::uint64_t kRetuneUs = 103300;
+    constexpr std::uint64_t kRunUs = 1000000;
+    const effect_engine::Effect before = make_sine(20000);
+    effect_engine::Effect after = before;
+    retune_sine(after, 13000, kRetuneUs);
+
+    const auto continuous = [](std::uint64_t t) {
+        const double cycles = t < kRetuneUs ? t / 20000.0 : kRetuneUs / 20000.0 + (t - kRetuneUs) / 13000.0;
+        return kNominalMax * std::sin(kTwoPi * cycles);
+    };
+    const double steepest_step = kNominalMax * kTwoPi * kStepUs / 13000.0;
+
+    double max_error = 0.0;
+    double max_jump = 0.0;
+    double previous = evaluate_one(before, 0);
+    for (std::uint64_t t = 0; t < kRunUs; t += kStepUs) {
+        const double value = evaluate_one(t < kRetuneUs ? before : after, t);
+        max_error = std::max(max_error, std::fabs(value - continuous(t)));
+        max_jump = std::max(max_jump, std::fabs(value - previous));
+        previous = value;
+    }
+    CHECK(max_error <= 2.0);
+    CHECK(max_jump <= steepest_step + 2.0);
+}
+
+}  // namespace
+
+int main() {
+    run_test("sine_table_accuracy", test_sine_table_accuracy);
+    run_test("retune_keeps_phase", test_retune_keeps_phase);
+    return check_result();
+}
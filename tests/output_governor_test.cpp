@@ -0,0 +1,162 @@
+#include "check.hpp"
+#include "command_encoder.hpp"
+#include "fake_hid_backend.hpp"
+#include "logger.hpp"
+#include "output_governor.hpp"
+#include "wheel_output_worker.hpp"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+namespace {
+
+using namespace std::chrono_literals;
+using clock_type = std::chrono::steady_clock;
+
+constexpr double kForceShare = 0.8 * 0.8;
+constexpr double kLedShare = 0.8 * 0.2;
+
+bool near(double value, double expected, double tolerance) {
+    return std::fabs(value - expected) <= tolerance;
+}
+
+void test_capacity_follows_service_time() {
+    OutputGovernor governor;
+    governor.record_write(4ms);
+    CHECK(near(governor.snapshot().service_time_us, 4000.0, 0.01));
+    CHECK(near(governor.snapshot().device_capacity_hz, 250.0, 0.01));
+    CHECK(near(governor.class_cap_hz(OutputGovernor::CommandClass::force), 250.0 * kForceShare, 0.01));
+    CHECK(near(governor.class_cap_hz(OutputGovernor::CommandClass::led), 250.0 * kLedShare, 0.01));
+
+    // Later samples are smoothed rather than taken as they are
+    governor.record_write(8ms);
+    CHECK(near(governor.snapshot().service_time_us, 4400.0, 0.01));
+    for (int i = 0; i < 200; ++i) {
+        governor.record_write(8ms);
+    }
+    CHECK(near(governor.snapshot().service_time_us, 8000.0, 1.0));
+
+    OutputGovernor stalled;
+    stalled.record_write(100ms);
+    CHECK(near(stalled.snapshot().device_capacity_hz, 50.0, 0.01));
+    OutputGovernor instant;
+    instant.record_write(1us);
+    CHECK(near(instant.snapshot().device_capacity_hz, 2000.0, 0.01));
+}
+
+void test_token_bucket() {
+    constexpr auto kForce = OutputGovernor::CommandClass::force;
+    OutputGovernor governor;
+    governor.record_write(1ms);
+    const double cap = governor.class_cap_hz(kForce);
+
+    const clock_type::time_point start = clock_type::now() + 1s;
+    CHECK(governor.time_until_available(kForce, start) == clock_type::duration::zero());
+
+    // The burst refills to eight reports, not more
+    governor.consume(kForce, 8, start);
+    const clock_type::duration wait = governor.time_until_available(kForce, start);
+    CHECK(near(std::chrono::duration<double>(wait).count(), 1.0 / cap, 1e-6));
+    CHECK(governor.time_until_available(kForce, start + wait + 1us) == clock_type::duration::zero());
+
+    const clock_type::time_point later = start + 10s;
+    governor.consume(kForce, 7, later);
+    CHECK(governor.time_until_available(kForce, later) == clock_type::duration::zero());
+    governor.consume(kForce, 1, later);
+    CHECK(governor.time_until_available(kForce, later) > clock_type::duration::zero());
+
+    // Classes draw from separate buckets
+    CHECK(governor.time_until_available(OutputGovernor::CommandClass::led, later) == clock_type::duration::zero());
+}
+
+struct FakeWheel {
+    FakeHidBackend backend;
+    std::shared_ptr<FakeHidDevice> device = backend.add_g923();
+    std::unique_ptr<WheelOutputWorker> worker;
+
+    explicit FakeWheel(std::chrono::microseconds service_time) {
+        auto wheel = std::make_unique<WheelController>(device->device(), backend.create_transport(device->device()));
+        CHECK(wheel->initialize());
+        device->set_service_time(service_time);
+        worker = std::make_unique<WheelOutputWorker>(std::move(wheel), 0);
+    }
+};
+
+// Flooding a 4 ms fake wheel: the governor learns its capacity, holds forces to their share of
+// it and still delivers the newest value
+void test_control_loop_against_slow_device() {
+    FakeWheel wheel(4ms);
+    const std::uint64_t writes_before = wheel.device->stats().writes;
+
+    const clock_type::time_point start = clock_type::now();
+    std::uint8_t level = 0;
+    while (clock_type::now() - start < 1s) {
+        const WheelCommand command = WheelCommand::constant_force(level++, 0);
+        wheel.worker->submit(&command, 1);
+        std::this_thread::sleep_for(500us);
+    }
+    const std::uint8_t newest = static_cast<std::uint8_t>(level - 1);
+    CHECK(wheel.worker->wait_idle(2s));
+    const double elapsed_s = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    const WheelOutputStats stats = wheel.worker->stats();
+    const std::uint64_t writes = wheel.device->stats().writes - writes_before;
+    CHECK(stats.service_time_us >= 3500.0 && stats.service_time_us <= 12000.0);
+    CHECK(near(stats.device_capacity_hz, 1000000.0 / stats.service_time_us, 0.5));
+    CHECK(near(stats.force_cap_hz, stats.device_capacity_hz * kForceShare, 0.5));
+    CHECK(near(stats.led_cap_hz, stats.device_capacity_hz * kLedShare, 0.5));
+
+    // The initial burst plus what the force share allows over the run
+    const double allowed = 8.0 + stats.force_cap_hz * elapsed_s * 1.1;
+    CHECK(static_cast<double>(writes) <= allowed);
+    CHECK(static_cast<double>(writes) >= allowed * 0.3);
+    CHECK(stats.deferrals > 0);
+    CHECK(stats.coalesced > 0);
+
+    const Command expected = CommandBuilder::create_constant_force(newest);
+    CHECK(std::memcmp(wheel.device->last_command().data, expected.data, COMMAND_MAX_LENGTH) == 0);
+}
+
+// Once the force budget is spent, a force waits for it but a stop goes out at once
+void test_stop_bypasses_throttle() {
+    FakeWheel wheel(10ms);
+
+    // A stop releases the commands queued ahead of it too, so this run leaves the bucket in debt
+    WheelCommand burst[32];
+    for (int i = 0; i < 16; ++i) {
+        burst[2 * i] = WheelCommand::constant_force(static_cast<std::uint8_t>(i), 0);
+        burst[2 * i + 1] = WheelCommand::stop_forces();
+    }
+    wheel.worker->submit(burst, 32);
+    CHECK(wheel.worker->wait_idle(5s));
+
+    const WheelCommand force = WheelCommand::constant_force(200, 0);
+    wheel.worker->submit(&force, 1);
+    std::this_thread::sleep_for(5ms);
+    CHECK(!wheel.worker->wait_idle(0ms));
+    CHECK(wheel.device->last_command().data[0] == g923_commands::STOP_FORCES);
+
+    const clock_type::time_point stop_at = clock_type::now();
+    const WheelCommand stop = WheelCommand::stop_forces();
+    wheel.worker->submit(&stop, 1);
+    CHECK(wheel.worker->wait_idle(1s));
+    const auto stop_latency = clock_type::now() - stop_at;
+
+    // Two 10 ms writes, well inside the ~70 ms the force would still have waited
+    CHECK(stop_latency < 45ms);
+    CHECK(wheel.device->last_command().data[0] == g923_commands::STOP_FORCES);
+}
+
+}  // namespace
+
+int main() {
+    Logger::set_enabled(false);
+    run_test("capacity_follows_service_time", test_capacity_follows_service_time);
+    run_test("token_bucket", test_token_bucket);
+    run_test("control_loop_against_slow_device", test_control_loop_against_slow_device);
+    run_test("stop_bypasses_throttle", test_stop_bypasses_throttle);
+    return check_result();
+}
@@ -0,0 +1,146 @@
+#include "check.hpp"
+#include "command_encoder.hpp"
+#include "fake_hid_backend.hpp"
+#include "logger.hpp"
+#include "wheel_output_worker.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+std::unique_ptr<WheelOutputWorker> make_worker(FakeHidBackend& backend, const std::shared_ptr<FakeHidDevice>& device,
+                                               std::size_t index) {
+    auto wheel = std::make_unique<WheelController>(device->device(), backend.create_transport(device->device()));
+    CHECK(wheel->initialize());
+    return std::make_unique<WheelOutputWorker>(std::move(wheel), index);
+}
+
+// Returns once the worker has taken everything queued and is inside a write
+void wait_until_writing(const WheelOutputWorker& worker) {
+    const auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (worker.stats().queue_depth > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+}
+
+void test_overflow_keeps_every_stop() {
+    FakeHidBackend backend;
+    auto device = backend.add_g923();
+    auto worker = make_worker(backend, device, 0);
+
+    std::atomic<int> stops{0};
+    device->set_write_observer([&stops](const std::uint8_t* data, std::size_t length, bool numbered) {
+        if (!numbered && length > 0 && data[0] == g923_commands::STOP_FORCES) {
+            ++stops;
+        }
+    });
+    device->set_service_time(10ms);
+
+    const WheelCommand first = WheelCommand::led_pattern(1);
+    worker->submit(&first, 1);
+    wait_until_writing(*worker);
+
+    // Stops keep constant forces from coalescing, so 20 pairs overflow the 32-command queue
+    constexpr int kPairs = 20;
+    std::vector<WheelCommand> commands;
+    for (int i = 0; i < kPairs; ++i) {
+        commands.push_back(WheelCommand::constant_force(static_cast<std::uint8_t>(i), 0));
+        commands.push_back(WheelCommand::stop_forces());
+    }
+    worker->submit(commands.data(), commands.size());
+    CHECK(worker->wait_idle(10s));
+
+    CHECK(stops.load() == kPairs);
+    CHECK(device->last_command().data[0] == g923_commands::STOP_FORCES);
+    CHECK(worker->stats().coalesced > 0);
+    device->set_write_observer(nullptr);
+}
+
+void test_back_to_back_stops_collapse() {
+    FakeHidBackend backend;
+    auto device = backend.add_g923();
+    auto worker = make_worker(backend, device, 0);
+    device->set_service_time(10ms);
+
+    const WheelCommand first = WheelCommand::led_pattern(1);
+    worker->submit(&first, 1);
+    wait_until_writing(*worker);
+
+    const WheelCommand stops[] = {WheelCommand::stop_forces(), WheelCommand::stop_forces(),
+                                  WheelCommand::stop_forces()};
+    worker->submit(stops, 3);
+    CHECK(worker->wait_idle(5s));
+    CHECK(worker->stats().commands == 2);
+    CHECK(worker->stats().coalesced == 2);
+}
+
+// A slow interface only delays its own queue
+void test_slow_interface_is_isolated() {
+    FakeHidBackend backend;
+    auto slow_device = backend.add_g923();
+    auto fast_device = backend.add_g923();
+    auto slow = make_worker(backend, slow_device, 0);
+    auto fast = make_worker(backend, fast_device, 1);
+    slow_device->set_service_time(200ms);
+
+    const WheelCommand commands[] = {WheelCommand::constant_force(200, 0),
+                                     WheelCommand::custom_spring(0, 0, 4, 4, 8, 8, 255)};
+    slow->submit(commands, 2);
+    fast->submit(commands, 2);
+
+    const auto start = std::chrono::steady_clock::now();
+    CHECK(fast->wait_idle(1s));
+    CHECK(std::chrono::steady_clock::now() - start < 150ms);
+    CHECK(!slow->wait_idle(0ms));
+    CHECK(fast_device->stats().writes >= slow_device->stats().writes + 2);
+
+    CHECK(slow->wait_idle(5s));
+    CHECK(slow->is_healthy());
+    CHECK(fast->is_healthy());
+}
+
+// A failing interface is marked unhealthy without affecting the other wheel
+void test_failing_interface_is_isolated() {
+    FakeHidBackend backend;
+    auto failing_device = backend.add_g923();
+    auto healthy_device = backend.add_g923();
+    auto failing = make_worker(backend, failing_device, 0);
+    auto healthy = make_worker(backend, healthy_device, 1);
+    failing_device->set_write_failure(true);
+
+    for (int i = 0; i < 5; ++i) {
+        const WheelCommand command = WheelCommand::constant_force(static_cast<std::uint8_t>(100 + i), 0);
+        failing->submit(&command, 1);
+        healthy->submit(&command, 1);
+        CHECK(failing->wait_idle(2s));
+        CHECK(healthy->wait_idle(2s));
+    }
+
+    CHECK(!failing->is_healthy());
+    CHECK(failing->stats().failures >= 3);
+    CHECK(healthy->is_healthy());
+    CHECK(healthy->stats().failures == 0);
+    CHECK(healthy_device->last_command().data[0] == g923_commands::SET_FORCE_EFFECT);
+
+    failing_device->set_write_failure(false);
+    const WheelCommand recovery = WheelCommand::constant_force(128, 0);
+    failing->submit(&recovery, 1);
+    CHECK(failing->wait_idle(2s));
+    CHECK(failing->is_healthy());
+}
+
+}  // namespace
+
+int main() {
+    Logger::set_enabled(false);
+    run_test("overflow_keeps_every_stop", test_overflow_keeps_every_stop);
+    run_test("back_to_back_stops_collapse", test_back_to_back_stops_collapse);
+    run_test("slow_interface_is_isolated", test_slow_interface_is_isolated);
+    run_test("failing_interface_is_isolated", test_failing_interface_is_isolated);
+    return check_result();
+}
@@ -0,0 +1,90 @@
+#include "check.hpp"
+#include "command_encoder.hpp"
+#include "fixed_ring.hpp"
+#include "wheel_simulator.hpp"
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+void test_fixed_ring_keeps_newest() {
+    FixedRing<int> ring(4);
+    CHECK(ring.empty());
+    CHECK(ring.capacity() == 4);
+
+    for (int i = 0; i < 3; ++i) {
+        ring.push(i);
+    }
+    CHECK(ring.size() == 3);
+    CHECK(ring.front() == 0);
+    CHECK(ring.back() == 2);
+    CHECK(ring.dropped() == 0);
+
+    for (int i = 3; i < 10; ++i) {
+        ring.push(i);
+    }
+    CHECK(ring.size() == 4);
+    CHECK(ring.dropped() == 6);
+    for (std::size_t i = 0; i < ring.size(); ++i) {
+        CHECK(ring[i] == static_cast<int>(6 + i));
+    }
+
+    ring.pop_front();
+    CHECK(ring.front() == 7);
+    ring.push(10);
+    CHECK(ring.size() == 4);
+    CHECK(ring.back() == 10);
+    CHECK(ring.dropped() == 6);
+
+    ring.clear();
+    CHECK(ring.empty());
+    CHECK(ring.dropped() == 0);
+    CHECK(ring.to_vector().empty());
+}
+
+void test_command_log_is_bounded() {
+    WheelSimulator::Config config;
+    config.command_capacity = 8;
+    WheelSimulator simulator(config);
+
+    for (int i = 0; i < 20; ++i) {
+        simulator.apply(CommandBuilder::create_constant_force(static_cast<std::uint8_t>(100 + i)));
+    }
+
+    const auto log = simulator.command_log();
+    CHECK(log.size() == 8);
+    const Command oldest = CommandBuilder::create_constant_force(112);
+    const Command newest = CommandBuilder::create_constant_force(119);
+    CHECK(std::memcmp(log.front().command.data, oldest.data, COMMAND_MAX_LENGTH) == 0);
+    CHECK(std::memcmp(log.back().command.data, newest.data, COMMAND_MAX_LENGTH) == 0);
+    CHECK(simulator.stats().commands == 20);
+    CHECK(simulator.stats().dropped_commands == 12);
+}
+
+void test_trace_is_bounded() {
+    WheelSimulator::Config config;
+    config.trace_capacity = 100;
+    config.trace_decimation = 1;
+    config.step = std::chrono::microseconds(500);
+    WheelSimulator simulator(config);
+
+    simulator.advance(std::chrono::milliseconds(100));
+    const auto trace = simulator.trace();
+    CHECK(trace.size() == 100);
+    CHECK(simulator.stats().dropped_samples == 100);
+    CHECK(trace.back().time_us == simulator.time_us());
+    CHECK(trace.front().time_us == simulator.time_us() - 99 * 500);
+
+    simulator.clear_trace();
+    CHECK(simulator.trace().empty());
+    CHECK(simulator.stats().dropped_samples == 0);
+}
+
+}  // namespace
+
+int main() {
+    run_test("fixed_ring_keeps_newest", test_fixed_ring_keeps_newest);
+    run_test("command_log_is_bounded", test_command_log_is_bounded);
+    run_test("trace_is_bounded", test_trace_is_bounded);
+    return check_result();
+}
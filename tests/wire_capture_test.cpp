@@ -0,0 +1,135 @@
+#include "check.hpp"
+#include "ffb_bridge_protocol.hpp"
+#include "logger.hpp"
+#include "wire_capture.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+std::string temporary_path() {
+    char path[] = "/tmp/g923_wire_capture_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd >= 0) {
+        close(fd);
+        unlink(path);
+    }
+    return path;
+}
+
+void record_states(WireCaptureWriter& writer, int count, std::uint8_t first_level) {
+    for (int i = 0; i < count; ++i) {
+        g923bridge::WheelStatePayload payload{};
+        payload.constant_force_magnitude = static_cast<std::int16_t>(first_level + i);
+        writer.record(static_cast<std::uint16_t>(g923bridge::MessageType::apply_wheel_state), &payload,
+                      sizeof(payload), std::chrono::steady_clock::now());
+    }
+}
+
+void test_sessions_are_marked() {
+    const std::string path = temporary_path();
+    WireCaptureWriter writer;
+    CHECK(writer.open(path));
+    record_states(writer, 3, 10);
+    writer.close();
+    CHECK(writer.open(path));
+    record_states(writer, 2, 20);
+    writer.close();
+
+    WireCaptureReader reader;
+    CHECK(reader.open(path));
+    const std::uint16_t expected_types[] = {
+        wire_capture::kSessionMarkerType, 10, 10, 10, wire_capture::kSessionMarkerType, 10, 10,
+    };
+    const std::uint8_t expected_levels[] = {0, 10, 11, 12, 0, 20, 21};
+
+    wire_capture::Record record;
+    std::size_t count = 0;
+    while (reader.next(record)) {
+        if (count < sizeof(expected_types) / sizeof(expected_types[0])) {
+            CHECK(record.type == expected_types[count]);
+            if (record.type == wire_capture::kSessionMarkerType) {
+                wire_capture::SessionMarker marker;
+                CHECK(record.payload_size == sizeof(marker));
+                std::memcpy(&marker, record.payload, sizeof(marker));
+                CHECK(marker.created_unix_ns > 0);
+            } else {
+                g923bridge::WheelStatePayload payload{};
+                CHECK(record.payload_size == sizeof(payload));
+                std::memcpy(&payload, record.payload, sizeof(payload));
+                CHECK(payload.constant_force_magnitude == expected_levels[count]);
+            }
+        }
+        ++count;
+    }
+    CHECK(count == 7);
+    reader.close();
+    unlink(path.c_str());
+}
+
+// Many buffers' worth of records reach the file through the writer thread
+void test_every_kept_record_is_written() {
+    constexpr int kRecords = 20000;
+    const std::string path = temporary_path();
+    WireCaptureWriter writer;
+    CHECK(writer.open(path));
+    for (int i = 0; i < kRecords / 100; ++i) {
+        record_states(writer, 100, 0);
+        writer.flush();
+    }
+    writer.close();
+    CHECK(writer.records_written() + writer.records_dropped() == kRecords);
+    CHECK(writer.records_written() > 0);
+
+    WireCaptureReader reader;
+    CHECK(reader.open(path));
+    wire_capture::Record record;
+    std::uint64_t states = 0;
+    while (reader.next(record)) {
+        if (record.type != wire_capture::kSessionMarkerType) {
+            ++states;
+        }
+    }
+    CHECK(states == writer.records_written());
+    reader.close();
+    unlink(path.c_str());
+}
+
+void test_replay_timeline() {
+    ReplayTimeline timeline;
+    timeline.start_session();
+    CHECK(timeline.offset_ns(1000) == 0);
+    CHECK(timeline.offset_ns(1500) == 500);
+    CHECK(timeline.offset_ns(3000) == 2000);
+
+    // The next session's clock restarted lower
+    timeline.start_session();
+    CHECK(timeline.offset_ns(100) == 2000);
+    CHECK(timeline.offset_ns(600) == 2500);
+
+    // A session recorded much later on the same clock does not replay the gap
+    timeline.start_session();
+    CHECK(timeline.offset_ns(1000000000000ull) == 2500);
+    CHECK(timeline.offset_ns(1000000000400ull) == 2900);
+
+    // Without a marker, a timestamp running backwards also starts a session
+    CHECK(timeline.offset_ns(50) == 2900);
+    CHECK(timeline.offset_ns(150) == 3000);
+
+    CHECK(timeline.sessions() == 4);
+    CHECK(timeline.recorded_ns() == 3000);
+}
+
+}  // namespace
+
+int main() {
+    Logger::set_enabled(false);
+    run_test("sessions_are_marked", test_sessions_are_marked);
+    run_test("every_kept_record_is_written", test_every_kept_record_is_written);
+    run_test("replay_timeline", test_replay_timeline);
+    return check_result();
+}
@@ -0,0 +1,611 @@
+#include "dinput_trace.hpp"
+#include "effect_engine.hpp"
+#include "utilities.hpp"
+#include "wire_capture.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <vector>
+
+// Replays a DirectInput trace recorded by the proxy (g923mac_proxy.trace) through the proxy's
+// effect engine and prints the WheelStatePayload stream it produces. The states the proxy
+// actually sent are in the trace too, so the replay also reports where the two disagree.
+// --output writes the stream as a wire capture that g923_replay can feed into a bridge.
+
+namespace {
+
+using dinput_trace::EffectType;
+using dinput_trace::EventType;
+using effect_engine::kNominalMax;
+using effect_engine::kPeriodicUpdateIntervalUs;
+
+constexpr std::uint32_t kCommandReset = 0x01;
+constexpr std::uint32_t kCommandStopAll = 0x02;
+constexpr std::uint32_t kCommandPause = 0x04;
+constexpr std::uint32_t kCommandContinue = 0x08;
+constexpr std::uint32_t kCommandActuatorsOn = 0x10;
+constexpr std::uint32_t kCommandActuatorsOff = 0x20;
+
+constexpr std::uint32_t kAutocenterOn = 1;
+
+effect_engine::EffectUpdate to_update(const dinput_trace::SetParametersEvent& event,
+                                      effect_engine::Envelope& envelope) {
+    effect_engine::EffectUpdate update;
+    update.flags = event.flags;
+    update.effect_flags = event.effect_flags;
+    update.gain = event.gain;
+    update.duration = event.duration;
+    update.start_delay = event.start_delay;
+    update.axis_count = event.axis_count;
+    update.has_direction = event.has_direction != 0;
+    update.direction[0] = event.direction[0];
+    update.direction[1] = event.direction[1];
+    if (event.has_envelope) {
+        envelope.attack_level = event.attack_level;
+        envelope.attack_time = event.attack_time;
+        envelope.fade_level = event.fade_level;
+        envelope.fade_time = event.fade_time;
+        update.envelope = &envelope;
+    }
+    if (event.has_type_specific) {
+        update.type_specific = event.type_specific;
+        update.type_specific_size = std::min(event.type_specific_size, dinput_trace::kMaxTypeSpecificBytes);
+    }
+    return update;
+}
+
+struct Output {
+    std::uint64_t timestamp_ns = 0;
+    bool stop_all = false;
+    g923bridge::WheelStatePayload payload{};
+};
+
+// Mirrors DeviceProxy::rebuild_and_send and its render thread; outputs queue up instead of going
+// to a socket
+class ReplayDevice {
+public:
+    std::vector<std::uint32_t> effect_ids;
+    std::deque<Output> pending;
+    std::deque<Output> unmatched;
+
+    // 0 when the proxy left time-varying effects to Poll instead of its render thread
+    std::uint64_t render_interval_us = 0;
+    std::uint32_t ff_gain = kNominalMax;
+    std::uint32_t autocenter_mode = kAutocenterOn;
+    bool paused = false;
+    bool actuators_off = false;
+
+    void reset_last_payload() { output_filter_.reset(); }
+
+    void send_stop_all(std::uint64_t timestamp_ns) {
+        Output output;
+        output.timestamp_ns = timestamp_ns;
+        output.stop_all = true;
+        pending.push_back(output);
+    }
+
+    bool poll_due(std::uint64_t now) const {
+        return last_periodic_rebuild_us_ == 0 || now - last_periodic_rebuild_us_ >= kPeriodicUpdateIntervalUs;
+    }
+
+    void mark_periodic_rebuild(std::uint64_t now) { last_periodic_rebuild_us_ = now; }
+
+    bool render_running() const { return render_running_; }
+
+    // Like DeviceProxy::publish_snapshot: the render thread runs while the last published batch
+    // has a time-varying force, and a suspended snapshot winds it down
+    void publish(std::map<std::uint32_t, effect_engine::Effect>& effects, std::uint64_t now,
+                 bool suspend_render = false) {
+        build_batch(effects, now, false);
+        render_running_ = render_interval_us != 0 && !suspend_render && batch_.has_time_varying_force(now);
+    }
+
+    void rebuild_and_send(std::map<std::uint32_t, effect_engine::Effect>& effects, std::uint64_t now,
+                          std::uint64_t timestamp_ns) {
+        build_batch(effects, now, true);
+        render_running_ = render_interval_us != 0 && batch_.has_time_varying_force(now);
+        send(now, timestamp_ns);
+    }
+
+    // One render thread tick: the batch as last published, evaluated at the tick's clock
+    void render(std::uint64_t now, std::uint64_t timestamp_ns) {
+        send(now, timestamp_ns);
+        if (!batch_.has_time_varying_force(now)) {
+            render_running_ = false;
+        }
+    }
+
+private:
+    effect_engine::EffectBatch batch_;
+    effect_engine::OutputFilter output_filter_;
+    std::uint64_t last_periodic_rebuild_us_ = 0;
+    bool render_running_ = false;
+
+    void build_batch(std::map<std::uint32_t, effect_engine::Effect>& effects, std::uint64_t now, bool refresh) {
+        batch_.clear();
+        for (const std::uint32_t id : effect_ids) {
+            const auto found = effects.find(id);
+            if (found != effects.end()) {
+                if (refresh) {
+                    found->second.refresh_runtime(now);
+                }
+                batch_.add(found->second, ff_gain);
+            }
+        }
+    }
+
+    void send(std::uint64_t now, std::uint64_t timestamp_ns) {
+        g923bridge::WheelStatePayload payload{};
+        batch_.evaluate(payload, now);
+
+        if (autocenter_mode == kAutocenterOn) {
+            effect_engine::apply_autocenter_fallback(payload, ff_gain);
+        }
+        if (paused || actuators_off) {
+            payload = g923bridge::WheelStatePayload{};
+        }
+
+        switch (output_filter_.filter(payload)) {
+            case effect_engine::OutputFilter::Action::send_state: {
+                Output output;
+                output.timestamp_ns = timestamp_ns;
+                output.payload = payload;
+                pending.push_back(output);
+                break;
+            }
+            case effect_engine::OutputFilter::Action::send_stop_all:
+                send_stop_all(timestamp_ns);
+                break;
+            case effect_engine::OutputFilter::Action::none:
+                break;
+        }
+    }
+};
+
+struct Options {
+    const char* trace_path = nullptr;
+    const char* output_path = nullptr;
+    bool csv = false;
+};
+
+struct ReplayStats {
+    std::uint64_t events = 0;
+    std::uint64_t unknown_events = 0;
+    std::uint64_t states = 0;
+    std::uint64_t stops = 0;
+    std::uint64_t recorded_outputs = 0;
+    std::uint64_t matched = 0;
+    std::uint64_t mismatched = 0;
+    std::uint64_t missing = 0;
+    std::uint64_t unrecorded = 0;
+    std::uint64_t peak_states_per_second = 0;
+    std::uint64_t dropped_records = 0;
+};
+
+class Replayer {
+public:
+    Replayer(const Options& options, WireCaptureWriter* output) : options_(options), output_(output) {}
+
+    void handle(const wire_capture::Record& record) {
+        ++stats_.events;
+        if (record.payload_size < sizeof(dinput_trace::EventHeader)) {
+            ++stats_.unknown_events;
+            return;
+        }
+
+        dinput_trace::EventHeader header;
+        std::memcpy(&header, record.payload, sizeof(header));
+        ReplayDevice& device = devices_[header.device_id];
+        const std::uint64_t now = header.clock_us;
+        const std::uint64_t timestamp = record.timestamp_ns;
+
+        switch (static_cast<EventType>(record.type)) {
+            case EventType::device_created:
+                // Traces from before the render thread carry a bare header
+                if (record.payload_size >= sizeof(dinput_trace::ValueEvent)) {
+                    dinput_trace::ValueEvent event;
+                    std::memcpy(&event, record.payload, sizeof(event));
+                    device.render_interval_us = event.value;
+                }
+                break;
+
+            case EventType::effect_created: {
+                dinput_trace::EffectCreatedEvent event;
+                if (!read_event(record, event)) {
+                    return;
+                }
+                effects_.erase(header.effect_id);
+                effects_.emplace(header.effect_id, effect_engine::Effect(static_cast<EffectType>(event.effect_type)));
+                break;
+            }
+
+            case EventType::effect_added:
+                device.effect_ids.push_back(header.effect_id);
+                break;
+
+            case EventType::effect_released: {
+                auto& ids = device.effect_ids;
+                const auto found = std::find(ids.begin(), ids.end(), header.effect_id);
+                if (found != ids.end()) {
+                    ids.erase(found);
+                }
+                effects_.erase(header.effect_id);
+                device.rebuild_and_send(effects_, now, timestamp);
+                break;
+            }
+
+            case EventType::set_parameters: {
+                dinput_trace::SetParametersEvent event;
+                if (!read_event(record, event)) {
+                    return;
+                }
+                const auto effect = effects_.find(header.effect_id);
+                if (effect != effects_.end()) {
+                    effect_engine::Envelope envelope;
+                    effect->second.set_parameters(to_update(event, envelope), now);
+                }
+                device.rebuild_and_send(effects_, now, timestamp);
+                break;
+            }
+
+            case EventType::start: {
+                dinput_trace::StartEvent event;
+                if (!read_event(record, event)) {
+                    return;
+                }
+                const auto effect = effects_.find(header.effect_id);
+                if (effect != effects_.end()) {
+                    effect->second.start(event.iterations, now);
+                }
+                device.rebuild_and_send(effects_, now, timestamp);
+                break;
+            }
+
+            case EventType::stop: {
+                const auto effect = effects_.find(header.effect_id);
+                if (effect != effects_.end()) {
+                    effect->second.stop();
+                }
+                device.rebuild_and_send(effects_, now, timestamp);
+                break;
+            }
+
+            case EventType::set_gain:
+            case EventType::set_autocenter: {
+                dinput_trace::ValueEvent event;
+                if (!read_event(record, event)) {
+                    return;
+                }
+                if (static_cast<EventType>(record.type) == EventType::set_gain) {
+                    device.ff_gain = std::min<std::uint32_t>(event.value, kNominalMax);
+                } else {
+                    device.autocenter_mode = event.value;
+                }
+                device.rebuild_and_send(effects_, now, timestamp);
+                break;
+            }
+
+            case EventType::ff_command: {
+                dinput_trace::ValueEvent event;
+                if (!read_event(record, event)) {
+                    return;
+                }
+                handle_command(device, event.value, now, timestamp);
+                break;
+            }
+
+            case EventType::unacquire:
+                device.publish(effects_, now, true);
+                device.send_stop_all(timestamp);
+                device.reset_last_payload();
+                break;
+
+            case EventType::poll:
+                if (!has_time_varying_effect(device)) {
+                    break;
+                }
+                if (device.render_interval_us != 0) {
+                    // The render thread keeps these effects moving; Poll only restarts it
+                    if (!device.render_running()) {
+                        device.rebuild_and_send(effects_, now, timestamp);
+                    }
+                } else if (device.poll_due(now)) {
+                    device.rebuild_and_send(effects_, now, timestamp);
+                    device.mark_periodic_rebuild(now);
+                }
+                break;
+
+            case EventType::render_tick:
+                device.render(now, timestamp);
+                break;
+
+            case EventType::state_sent: {
+                dinput_trace::StateSentEvent event;
+                if (!read_event(record, event)) {
+                    return;
+                }
+                compare(device, false, &event.payload);
+                break;
+            }
+
+            case EventType::stop_sent:
+                compare(device, true, nullptr);
+                break;
+
+            case EventType::records_dropped: {
+                dinput_trace::ValueEvent event;
+                if (!read_event(record, event)) {
+                    return;
+                }
+                stats_.dropped_records += event.value;
+                break;
+            }
+
+            default:
+                ++stats_.unknown_events;
+                return;
+        }
+
+        drain(device);
+    }
+
+    // Device and effect ids belong to one proxy session and may be reused by the next
+    void start_session() {
+        finish();
+        devices_.clear();
+        effects_.clear();
+    }
+
+    const ReplayStats& finish() {
+        for (auto& entry : devices_) {
+            drain(entry.second);
+            stats_.unrecorded += entry.second.unmatched.size();
+            entry.second.unmatched.clear();
+        }
+        return stats_;
+    }
+
+private:
+    static constexpr std::size_t kMaxUnmatched = 4096;
+
+    template <typename Event>
+    bool read_event(const wire_capture::Record& record, Event& event) {
+        if (record.payload_size < sizeof(event)) {
+            ++stats_.unknown_events;
+            return false;
+        }
+        std::memcpy(&event, record.payload, sizeof(event));
+        return true;
+    }
+
+    bool has_time_varying_effect(const ReplayDevice& device) const {
+        for (const std::uint32_t id : device.effect_ids) {
+            const auto found = effects_.find(id);
+            if (found != effects_.end() && found->second.has_time_varying_force()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void stop_all_effects(ReplayDevice& device) {
+        for (const std::uint32_t id : device.effect_ids) {
+            const auto found = effects_.find(id);
+            if (found != effects_.end()) {
+                found->second.stop();
+            }
+        }
+    }
+
+    void handle_command(ReplayDevice& device, std::uint32_t command, std::uint64_t now, std::uint64_t timestamp) {
+        switch (command) {
+            case kCommandReset:
+            case kCommandStopAll:
+                stop_all_effects(device);
+                device.paused = false;
+                device.publish(effects_, now);
+                device.send_stop_all(timestamp);
+                device.reset_last_payload();
+                break;
+            case kCommandPause:
+                device.paused = true;
+                device.publish(effects_, now);
+                break;
+            case kCommandContinue:
+                device.paused = false;
+                device.rebuild_and_send(effects_, now, timestamp);
+                break;
+            case kCommandActuatorsOn:
+                device.actuators_off = false;
+                device.rebuild_and_send(effects_, now, timestamp);
+                break;
+            case kCommandActuatorsOff:
+                stop_all_effects(device);
+                device.actuators_off = true;
+                device.publish(effects_, now);
+                device.send_stop_all(timestamp);
+                device.reset_last_payload();
+                break;
+            default:
+                break;
+        }
+    }
+
+    // The proxy records what it sent right after the call that produced it, so replayed outputs
+    // are matched against recorded ones in order
+    void compare(ReplayDevice& device, bool stop_all, const g923bridge::WheelStatePayload* payload) {
+        ++stats_.recorded_outputs;
+        if (device.unmatched.empty()) {
+            ++stats_.missing;
+            return;
+        }
+
+        const Output& replayed = device.unmatched.front();
+        const bool same = replayed.stop_all == stop_all &&
+                          (stop_all || std::memcmp(&replayed.payload, payload, sizeof(*payload)) == 0);
+        if (same) {
+            ++stats_.matched;
+        } else {
+            ++stats_.mismatched;
+        }
+        device.unmatched.pop_front();
+    }
+
+    void drain(ReplayDevice& device) {
+        while (!device.pending.empty()) {
+            emit(device.pending.front());
+            device.unmatched.push_back(device.pending.front());
+            device.pending.pop_front();
+        }
+        // Traces without recorded sends never consume the queue
+        while (device.unmatched.size() > kMaxUnmatched) {
+            device.unmatched.pop_front();
+            ++stats_.unrecorded;
+        }
+    }
+
+    void emit(const Output& output) {
+        if (output.stop_all) {
+            ++stats_.stops;
+        } else {
+            ++stats_.states;
+            track_rate(output.timestamp_ns);
+        }
+
+        if (output_) {
+            const std::chrono::steady_clock::time_point at{std::chrono::nanoseconds(output.timestamp_ns)};
+            if (output.stop_all) {
+                output_->record(static_cast<std::uint16_t>(g923bridge::MessageType::stop_all), nullptr, 0, at);
+            } else {
+                output_->record(static_cast<std::uint16_t>(g923bridge::MessageType::apply_wheel_state),
+                                &output.payload, sizeof(output.payload), at);
+            }
+        }
+
+        if (options_.csv) {
+            print_csv(output);
+        }
+    }
+
+    void track_rate(std::uint64_t timestamp_ns) {
+        const std::uint64_t second = timestamp_ns / 1000000000ULL;
+        if (second != rate_second_) {
+            rate_second_ = second;
+            rate_count_ = 0;
+        }
+        stats_.peak_states_per_second = std::max<std::uint64_t>(stats_.peak_states_per_second, ++rate_count_);
+    }
+
+    void print_csv(const Output& output) {
+        if (!csv_header_printed_) {
+            std::printf("time_ms,kind,autocenter,spring,k1,k2,sat1,sat2,clip,damper,damper_pos,damper_neg,"
+                        "constant,magnitude\n");
+            csv_header_printed_ = true;
+        }
+        if (first_output_ns_ == 0) {
+            first_output_ns_ = output.timestamp_ns;
+        }
+
+        const double time_ms = static_cast<double>(output.timestamp_ns - first_output_ns_) * 1e-6;
+        const g923bridge::WheelStatePayload& p = output.payload;
+        if (output.stop_all) {
+            std::printf("%.3f,stop_all,,,,,,,,,,,,\n", time_ms);
+            return;
+        }
+        std::printf("%.3f,state,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%d\n", time_ms, p.autocenter_enabled,
+                    p.custom_spring_enabled, p.spring_k1, p.spring_k2, p.spring_sat1, p.spring_sat2, p.spring_clip,
+                    p.damper_enabled, p.damper_force_positive, p.damper_force_negative, p.constant_force_enabled,
+                    static_cast<int>(p.constant_force_magnitude));
+    }
+
+    const Options& options_;
+    WireCaptureWriter* output_;
+    std::map<std::uint32_t, ReplayDevice> devices_;
+    std::map<std::uint32_t, effect_engine::Effect> effects_;
+    ReplayStats stats_;
+    std::uint64_t rate_second_ = 0;
+    std::uint64_t rate_count_ = 0;
+    std::uint64_t first_output_ns_ = 0;
+    bool csv_header_printed_ = false;
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--output") == 0 && has_value) {
+            options.output_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--csv") == 0) {
+            options.csv = true;
+        } else if (argv[i][0] != '-' && !options.trace_path) {
+            options.trace_path = argv[i];
+        } else {
+            return false;
+        }
+    }
+    return options.trace_path != nullptr;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s TRACE [--csv] [--output CAPTURE]\n", argv[0]);
+        return 2;
+    }
+
+    WireCaptureReader reader;
+    if (!reader.open(options.trace_path, dinput_trace::kFileMagic)) {
+        Logger::flush();
+        return 1;
+    }
+
+    WireCaptureWriter writer;
+    if (options.output_path && !writer.open(options.output_path)) {
+        Logger::flush();
+        return 1;
+    }
+
+    // Sessions appended to one trace replay back to back on one timeline
+    Replayer replayer(options, options.output_path ? &writer : nullptr);
+    ReplayTimeline timeline;
+    wire_capture::Record record;
+    while (reader.next(record)) {
+        if (record.type == wire_capture::kSessionMarkerType) {
+            timeline.start_session();
+            replayer.start_session();
+            continue;
+        }
+        record.timestamp_ns = timeline.offset_ns(record.timestamp_ns);
+        replayer.handle(record);
+    }
+    const ReplayStats& stats = replayer.finish();
+    writer.close();
+    Logger::flush();
+
+    const double seconds = static_cast<double>(timeline.recorded_ns()) * 1e-9;
+    std::FILE* out = options.csv ? stderr : stdout;
+    std::fprintf(out, "events %llu (%llu unknown) over %.3f s in %llu session(s)\n",
+                 static_cast<unsigned long long>(stats.events), static_cast<unsigned long long>(stats.unknown_events),
+                 seconds, static_cast<unsigned long long>(timeline.sessions()));
+    if (stats.dropped_records > 0) {
+        std::fprintf(out, "the proxy dropped %llu events while recording; sends after that may differ\n",
+                     static_cast<unsigned long long>(stats.dropped_records));
+    }
+    std::fprintf(out, "replayed %llu states, %llu stop_all, %.1f states/s, peak %llu/s\n",
+                 static_cast<unsigned long long>(stats.states), static_cast<unsigned long long>(stats.stops),
+                 seconds > 0.0 ? static_cast<double>(stats.states) / seconds : 0.0,
+                 static_cast<unsigned long long>(stats.peak_states_per_second));
+    if (stats.recorded_outputs > 0) {
+        std::fprintf(out, "recorded %llu sends: %llu matched, %llu differ, %llu not replayed, %llu extra\n",
+                     static_cast<unsigned long long>(stats.recorded_outputs),
+                     static_cast<unsigned long long>(stats.matched), static_cast<unsigned long long>(stats.mismatched),
+                     static_cast<unsigned long long>(stats.missing), static_cast<unsigned long long>(stats.unrecorded));
+    }
+    return 0;
+}
@@ -0,0 +1,232 @@
+#include "bridge_server.hpp"
+#include "fake_hid_backend.hpp"
+#include "utilities.hpp"
+#include "wire_capture.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+// Plays a capture written by BridgeServer::start_capture back into the bridge. By default the
+// messages go straight into the apply path of an in-process server with a fake wheel; --port
+// sends them to a running bridge over TCP instead. --speed scales the recorded gaps, with 0
+// replaying as fast as the target accepts messages. Sessions appended to one capture play back to
+// back, without the time that passed between them.
+
+namespace {
+
+struct Options {
+    const char* capture_path = nullptr;
+    double speed = 1.0;
+    std::uint16_t port = 0;
+    bool hidpp = false;
+};
+
+struct ReplayStats {
+    std::uint64_t messages = 0;
+    std::uint64_t applied = 0;
+    std::uint64_t failed = 0;
+    std::uint64_t skipped = 0;
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--speed") == 0 && has_value) {
+            options.speed = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--port") == 0 && has_value) {
+            options.port = static_cast<std::uint16_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--hidpp") == 0) {
+            options.hidpp = true;
+        } else if (argv[i][0] != '-' && !options.capture_path) {
+            options.capture_path = argv[i];
+        } else {
+            return false;
+        }
+    }
+    return options.capture_path && options.speed >= 0.0;
+}
+
+bool send_exact(int fd, const void* buffer, std::size_t size) {
+    const auto* data = static_cast<const std::uint8_t*>(buffer);
+    std::size_t sent = 0;
+
+    while (sent < size) {
+        const ssize_t chunk = send(fd, data + sent, size - sent, MSG_NOSIGNAL);
+        if (chunk < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        sent += static_cast<std::size_t>(chunk);
+    }
+
+    return true;
+}
+
+int connect_loopback(std::uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int no_delay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// The server answers hello and stats requests; drain replies so the socket never backs up
+void drain_replies(int fd) {
+    std::uint8_t scratch[1024];
+    while (recv(fd, scratch, sizeof(scratch), MSG_DONTWAIT) > 0) {
+    }
+}
+
+bool send_record(int fd, const wire_capture::Record& record) {
+    g923bridge::MessageHeader header{};
+    header.type = record.type;
+    header.payload_size = record.payload_size;
+    const bool sent = send_exact(fd, &header, sizeof(header)) &&
+                      (record.payload_size == 0 || send_exact(fd, record.payload, record.payload_size));
+    drain_replies(fd);
+    return sent;
+}
+
+bool apply_record(BridgeServer& server, const wire_capture::Record& record, ReplayStats& stats) {
+    switch (static_cast<g923bridge::MessageType>(record.type)) {
+        case g923bridge::MessageType::apply_wheel_state: {
+            if (record.payload_size != sizeof(g923bridge::WheelStatePayload)) {
+                return false;
+            }
+            g923bridge::WheelStatePayload payload{};
+            std::memcpy(&payload, record.payload, sizeof(payload));
+            return server.apply_wheel_state(payload);
+        }
+
+        case g923bridge::MessageType::set_led_pattern: {
+            if (record.payload_size != sizeof(g923bridge::LedPatternPayload)) {
+                return false;
+            }
+            g923bridge::LedPatternPayload payload{};
+            std::memcpy(&payload, record.payload, sizeof(payload));
+            return server.apply_led_pattern(payload.pattern);
+        }
+
+        case g923bridge::MessageType::stop_all:
+            server.stop_wheel_forces();
+            return true;
+
+        default:
+            // Handshakes, pings and stats requests have no effect on the wheel
+            ++stats.skipped;
+            return true;
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s CAPTURE [--speed X] [--port N] [--hidpp]\n"
+                     "       --speed 1 replays original timing, 0 replays as fast as possible\n", argv[0]);
+        return 2;
+    }
+
+    WireCaptureReader reader;
+    if (!reader.open(options.capture_path)) {
+        Logger::flush();
+        return 1;
+    }
+
+    int fd = -1;
+    std::unique_ptr<BridgeServer> server;
+    if (options.port != 0) {
+        fd = connect_loopback(options.port);
+        if (fd < 0) {
+            Logger::error("Failed to connect to bridge on port %hu", options.port);
+            Logger::flush();
+            return 1;
+        }
+    } else {
+        auto backend = std::make_unique<FakeHidBackend>();
+        backend->add_g923(options.hidpp);
+        server = std::make_unique<BridgeServer>(g923bridge::kDefaultPort,
+                                                options.hidpp ? WheelBackend::hidpp : WheelBackend::classic,
+                                                g923bridge::kDefaultStatsPort, std::move(backend));
+        if (!server->reconnect_wheel()) {
+            Logger::error("Failed to connect the fake wheel");
+            Logger::flush();
+            return 1;
+        }
+    }
+
+    ReplayStats stats;
+    wire_capture::Record record;
+    ReplayTimeline timeline;
+    const auto started_at = std::chrono::steady_clock::now();
+
+    while (reader.next(record)) {
+        if (record.type == wire_capture::kSessionMarkerType) {
+            timeline.start_session();
+            continue;
+        }
+        ++stats.messages;
+
+        const std::uint64_t offset_ns = timeline.offset_ns(record.timestamp_ns);
+        if (options.speed > 0.0) {
+            const auto offset = std::chrono::nanoseconds(
+                static_cast<std::int64_t>(static_cast<double>(offset_ns) / options.speed));
+            std::this_thread::sleep_until(started_at + offset);
+        }
+
+        const bool delivered = fd >= 0 ? send_record(fd, record) : apply_record(*server, record, stats);
+        if (!delivered) {
+            ++stats.failed;
+            if (fd >= 0) {
+                Logger::error("Bridge closed the connection after %llu messages", stats.messages);
+                break;
+            }
+            continue;
+        }
+        ++stats.applied;
+    }
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_at).count();
+    const double recorded = static_cast<double>(timeline.recorded_ns()) * 1e-9;
+
+    if (fd >= 0) {
+        close(fd);
+    }
+    server.reset();
+    Logger::flush();
+
+    std::printf("messages %llu  delivered %llu  failed %llu  skipped %llu\n",
+                static_cast<unsigned long long>(stats.messages), static_cast<unsigned long long>(stats.applied),
+                static_cast<unsigned long long>(stats.failed), static_cast<unsigned long long>(stats.skipped));
+    std::printf("sessions %llu  recorded %.3f s  replayed %.3f s  %.0f msgs/s\n",
+                static_cast<unsigned long long>(timeline.sessions()), recorded, elapsed,
+                elapsed > 0.0 ? static_cast<double>(stats.messages) / elapsed : 0.0);
+    return stats.failed == 0 ? 0 : 1;
+}
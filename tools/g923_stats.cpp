@@ -0,0 +1,222 @@
+#include "ffb_bridge_protocol.hpp"
+#include "latency_histogram.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+constexpr const char* kCommandNames[g923bridge::kStatsCommandTypes] = {
+    "spring", "damper", "ac_on", "ac_off", "ac_spring", "constant", "led", "stop",
+};
+
+struct Options {
+    std::uint16_t port = g923bridge::kDefaultStatsPort;
+    int interval_ms = 1000;
+    bool once = false;
+};
+
+bool recv_exact(int fd, void* buffer, std::size_t size) {
+    auto* out = static_cast<std::uint8_t*>(buffer);
+    std::size_t received = 0;
+
+    while (received < size) {
+        const ssize_t chunk = recv(fd, out + received, size - received, 0);
+        if (chunk == 0) {
+            return false;
+        }
+        if (chunk < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        received += static_cast<std::size_t>(chunk);
+    }
+
+    return true;
+}
+
+bool send_exact(int fd, const void* buffer, std::size_t size) {
+    const auto* data = static_cast<const std::uint8_t*>(buffer);
+    std::size_t sent = 0;
+
+    while (sent < size) {
+        const ssize_t chunk = send(fd, data + sent, size - sent, 0);
+        if (chunk < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        sent += static_cast<std::size_t>(chunk);
+    }
+
+    return true;
+}
+
+int connect_loopback(std::uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+bool request_stats(int fd, g923bridge::StatsReplyPayload& reply) {
+    g923bridge::MessageHeader request{};
+    request.type = static_cast<std::uint16_t>(g923bridge::MessageType::stats_request);
+    if (!send_exact(fd, &request, sizeof(request))) {
+        return false;
+    }
+
+    g923bridge::MessageHeader header{};
+    return recv_exact(fd, &header, sizeof(header)) && header.magic == g923bridge::kProtocolMagic &&
+           header.type == static_cast<std::uint16_t>(g923bridge::MessageType::stats_reply) &&
+           header.payload_size == sizeof(reply) && recv_exact(fd, &reply, sizeof(reply));
+}
+
+// Histogram of only the samples recorded since the previous reply
+LatencyHistogram::Snapshot interval_histogram(const g923bridge::StatsHistogram& current,
+                                              const g923bridge::StatsHistogram& previous) {
+    LatencyHistogram::Snapshot snapshot;
+    for (std::size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+        snapshot.buckets[i] = current.buckets[i] - previous.buckets[i];
+    }
+    snapshot.count = current.count - previous.count;
+    snapshot.total_ns = current.total_ns - previous.total_ns;
+    snapshot.max_ns = current.max_ns;
+    return snapshot;
+}
+
+void print_rate(const char* name, std::uint64_t current, std::uint64_t previous, double seconds) {
+    const double rate = seconds > 0.0 ? static_cast<double>(current - previous) / seconds : 0.0;
+    std::printf("  %-12s %10.1f/s %12llu\n", name, rate, static_cast<unsigned long long>(current));
+}
+
+void print_stage(const char* name, const g923bridge::StatsHistogram& current,
+                 const g923bridge::StatsHistogram& previous) {
+    const LatencyHistogram::Snapshot interval = interval_histogram(current, previous);
+    std::printf("  %-16s %8llu %10.1f %10.1f %10.1f %10.1f\n", name, static_cast<unsigned long long>(interval.count),
+                interval.mean_ns() / 1000.0, interval.percentile_ns(50.0) / 1000.0,
+                interval.percentile_ns(99.0) / 1000.0, current.max_ns / 1000.0);
+}
+
+void print_screen(const Options& options, const g923bridge::StatsReplyPayload& current,
+                  const g923bridge::StatsReplyPayload& previous) {
+    const double seconds = previous.server_time_ns != 0 && current.server_time_ns > previous.server_time_ns
+        ? static_cast<double>(current.server_time_ns - previous.server_time_ns) / 1e9
+        : 0.0;
+
+    if (!options.once) {
+        std::printf("\x1b[H\x1b[2J");
+    }
+
+    std::printf("g923_stats  localhost:%hu  every %d ms\n\n", options.port, options.interval_ms);
+    std::printf("  server %s   game %s   wheel %s (%u interfaces)\n\n",
+                current.listening ? "listening" : "offline",
+                current.client_connected ? current.client_name : "not connected",
+                current.wheel_connected ? current.wheel_name : "not connected",
+                static_cast<unsigned>(current.wheel_interfaces));
+
+    std::printf("  %-12s %12s %12s\n", "counter", "rate", "total");
+    print_rate("packets", current.packets_received, previous.packets_received, seconds);
+    print_rate("deduplicated", current.deduplicated_states, previous.deduplicated_states, seconds);
+    print_rate("batches", current.output_batches, previous.output_batches, seconds);
+    print_rate("commands", current.output_commands, previous.output_commands, seconds);
+    print_rate("coalesced", current.output_coalesced, previous.output_coalesced, seconds);
+    print_rate("deferrals", current.output_deferrals, previous.output_deferrals, seconds);
+    print_rate("hid errors", current.hid_errors, previous.hid_errors, seconds);
+
+    std::printf("\n  capacity %u Hz   force cap %u Hz   led cap %u Hz   queued %u\n\n",
+                current.device_capacity_hz, current.force_cap_hz, current.led_cap_hz, current.output_queue_depth);
+
+    std::printf("  %-16s %8s %10s %10s %10s %10s\n", "stage (us)", "samples", "mean", "p50", "p99", "max");
+    print_stage("receive->decode", current.receive_to_decode, previous.receive_to_decode);
+    print_stage("decode->apply", current.decode_to_apply, previous.decode_to_apply);
+    print_stage("hid write", current.hid_write, previous.hid_write);
+    print_stage("lock wait", current.lock_wait, previous.lock_wait);
+
+    std::printf("\n ");
+    for (std::size_t i = 0; i < g923bridge::kStatsCommandTypes; ++i) {
+        std::printf(" %s %llu", kCommandNames[i], static_cast<unsigned long long>(current.commands_sent[i]));
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--port") == 0 && has_value) {
+            options.port = static_cast<std::uint16_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--interval") == 0 && has_value) {
+            options.interval_ms = std::max(50, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--once") == 0) {
+            options.once = true;
+        } else {
+            return false;
+        }
+    }
+    return options.port != 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s [--port N] [--interval MS] [--once]\n", argv[0]);
+        return 2;
+    }
+
+    const int fd = connect_loopback(options.port);
+    if (fd < 0) {
+        std::fprintf(stderr, "g923_stats: cannot connect to localhost:%hu: %s\n", options.port, std::strerror(errno));
+        return 1;
+    }
+
+    // Zero-initialised previous reply makes the first screen show totals since server start
+    g923bridge::StatsReplyPayload previous{};
+    g923bridge::StatsReplyPayload current{};
+    bool ok = true;
+
+    while (true) {
+        if (!request_stats(fd, current)) {
+            std::fprintf(stderr, "g923_stats: server closed the connection\n");
+            ok = false;
+            break;
+        }
+
+        print_screen(options, current, previous);
+        if (options.once) {
+            break;
+        }
+
+        previous = current;
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.interval_ms));
+    }
+
+    close(fd);
+    return ok ? 0 : 1;
+}